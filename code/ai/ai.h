@@ -319,9 +319,9 @@ typedef struct pnode {
 	int		path_index;			//	index in original model path of point, ie in model_path, use verts[path_index]
 } pnode;
 
-#define	MAX_PATH_POINTS	1000
-extern pnode	Path_points[MAX_PATH_POINTS];
-extern pnode	*Ppfp;			//	Free pointer in path points.
+#define	PATH_POINTS_POOL_SIZE	1000		//	Path_points starts out this big, and grows if it has to
+extern SCP_vector<pnode>	Path_points;
+extern int	Num_path_points;		//	Records in use, from the start of Path_points.  The rest are free.
 
 // Goober5000 (based on the "you can only remember 7 things in short-term memory" assumption)
 #define MAX_IGNORE_NEW_OBJECTS	7
@@ -548,6 +548,12 @@ typedef struct ai_info {
 	int		ai_override_flags;			// flags for marking ai overrides from sexp or lua systems
 	control_info	ai_override_ci;		// ai override control info
 	int		ai_override_timestamp;		// mark for when to end the current override
+
+	// AI scheduling, see ai_sched_should_run()
+	int		sched_last_frame;			// Framecount when ai_frame() last ran, -1 if never
+	float		sched_skipped_time;			// frame time passed since ai_frame() last ran
+	int		sched_cost_us;				// running average of ai_frame() time, in microseconds
+	control_info	sched_ci;			// controls ai_frame() last set, reused on frames it doesn't run
 } ai_info;
 
 // Goober5000
@@ -613,6 +619,9 @@ void ai_object_init(object * obj, int ai_index);
 // Called once a frame
 void ai_process( object * obj, int ai_index, float frametime );
 
+// Called once a frame, before objects move, to sense enemies on the worker pool (-mt_ai)
+void ai_sense_frame();
+
 int get_wingnum(int objnum);
 
 void set_wingnum(int objnum, int wingnum);
@@ -676,6 +685,7 @@ extern void accelerate_ship(ai_info *aip, float accel);
 extern void turn_away_from_point(object *objp, vec3d *point, float bank_override);
 extern float ai_endangered_by_weapon(ai_info *aip);
 extern void update_aspect_lock_information(ai_info *aip, vec3d *vec_to_enemy, float dist_to_enemy, float enemy_radius);
+extern float ai_sched_frametime(ai_info *aip);
 extern void ai_chase_ct();
 extern void ai_find_path(object *pl_objp, int objnum, int path_num, int exit_flag, int subsys_path=0);
 extern float ai_path();
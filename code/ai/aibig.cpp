@@ -724,7 +724,7 @@ void ai_big_maybe_fire_weapons(float dist_to_enemy, float dot_to_enemy, vec3d *f
 	swp = &Ships[Pl_objp->instance].weapons;
 
 	if (dot_to_enemy > 0.95f - 0.5f * En_objp->radius/MAX(1.0f, En_objp->radius + dist_to_enemy)) {
-		aip->time_enemy_in_range += flFrametime;
+		aip->time_enemy_in_range += ai_sched_frametime(aip);
 		
 		//	Chance of hitting ship is based on dot product of firing ship's forward vector with vector to ship
 		//	and also the size of the target relative to distance to target.
@@ -824,8 +824,8 @@ void ai_big_maybe_fire_weapons(float dist_to_enemy, float dot_to_enemy, vec3d *f
 			}
 		}
 	} else {
-		if (flFrametime < 1.0f)
-			aip->time_enemy_in_range *= (1.0f - flFrametime);
+		if (ai_sched_frametime(aip) < 1.0f)
+			aip->time_enemy_in_range *= (1.0f - ai_sched_frametime(aip));
 		else
 			aip->time_enemy_in_range = 0;
 	}
@@ -943,7 +943,7 @@ void ai_big_chase()
 				aip->submode = SM_CONTINUOUS_TURN;
 				aip->submode_start_time = Missiontime - fl2f(2.75f);	//	This backdated start time allows immediate switchout.
 				if (dot_to_enemy > 0.0f)
-					aip->target_time += flFrametime * dot_to_enemy;
+					aip->target_time += ai_sched_frametime(aip) * dot_to_enemy;
 			}
 		break;
 	}
@@ -1146,8 +1146,8 @@ void ai_big_chase()
 	if (aip->mode != AIM_EVADE && aip->path_start == -1 ) {
 		ai_big_maybe_fire_weapons(dist_to_enemy, dot_to_enemy, &player_pos, &predicted_enemy_pos, &En_objp->phys_info.vel);
 	} else {
-		if (flFrametime < 1.0f)
-			aip->time_enemy_in_range *= (1.0f - flFrametime);
+		if (ai_sched_frametime(aip) < 1.0f)
+			aip->time_enemy_in_range *= (1.0f - ai_sched_frametime(aip));
 		else
 			aip->time_enemy_in_range = 0;
 	}
@@ -24,12 +24,14 @@
 #include "ai/aiinternal.h"
 #include "asteroid/asteroid.h"
 #include "autopilot/autopilot.h"
+#include "cmdline/cmdline.h"
 #include "cmeasure/cmeasure.h"
 #include "debugconsole/console.h"
 #include "freespace2/freespace.h"
 #include "gamesequence/gamesequence.h"
 #include "gamesnd/gamesnd.h"
 #include "globalincs/linklist.h"
+#include "globalincs/workerpool.h"
 #include "hud/hud.h"
 #include "hud/hudets.h"
 #include "hud/hudlock.h"
@@ -67,6 +69,7 @@
 #include "weapon/flak.h"
 #include "weapon/swarm.h"
 #include "weapon/weapon.h"
+#include <algorithm>
 #include <map>
 #include <limits.h>
 
@@ -260,8 +263,8 @@ const char *Skill_level_names(int level, int translate)
 
 #define	DELAY_TARGET_TIME	(12*1000)		//	time in milliseconds until a ship can target a new enemy after an order.
 
-pnode		Path_points[MAX_PATH_POINTS];
-pnode		*Ppfp;			//	Free pointer in path points.
+SCP_vector<pnode>	Path_points;
+int		Num_path_points = 0;
 
 float	AI_frametime;
 
@@ -395,25 +398,19 @@ void ai_init_secondary_info()
  *
  * Scans all objects, looking for used Path_points records.
  *	Compresses Path_points buffer, updating aip->path_start and aip->path_cur indices.
- *	Updates Ppfp to point to first free record.
+ *	Updates Num_path_points to the number of records still in use.
  *	This function is fairly fast.  Its worst-case running time is proportional to
- *	3*MAX_PATH_POINTS + MAX_OBJECTS
- *
- * @todo Things to do to optimize this function:
- *		1. if (t != 0) xlt++; can be replaced by xlt += t; assuming t can only be 0 or 1.
- *		2. When pp_xlate is getting stuffed the first time, note highest index and use that 
- *			instead of MAX_PATH_POINTS in following two for loops.
+ *	3*Num_path_points + MAX_OBJECTS
  */
 void garbage_collect_path_points()
 {
 	int	i;
-	int	pp_xlate[MAX_PATH_POINTS];
+	SCP_vector<int>	pp_xlate;
 	object	*A;
 	ship_obj	*so;
 
 	//	Scan all objects and create Path_points xlate table.
-	for (i=0; i<MAX_PATH_POINTS; i++)
-		pp_xlate[i] = 0;
+	pp_xlate.resize(Num_path_points, 0);
 
 	//	in pp_xlate, mark all used Path_point records
 	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
@@ -435,16 +432,12 @@ void garbage_collect_path_points()
 	//	Now, stuff xlate index in pp_xlate.  This is the number to translate any path_start
 	//	or path_cur index to.
 	int	xlt = 0;
-	for (i=0; i<MAX_PATH_POINTS; i++) {
+	for (i=0; i<Num_path_points; i++) {
 		int	t = pp_xlate[i];
 
 		pp_xlate[i] = xlt;
-		if (t != 0)
-			xlt++;
+		xlt += t;
 	}
-	
-	//	Update global Path_points free pointer.
-	Ppfp = &Path_points[xlt];
 
 	//	Now, using pp_xlate, fixup all aip->path_cur and aip->path_start indices
 	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
@@ -454,20 +447,22 @@ void garbage_collect_path_points()
 			ai_info	*aip = &Ai_info[shipp->ai_index];
 
 			if ((aip->path_length > 0) && (aip->path_start > -1)) {
-				Assert(aip->path_start < MAX_PATH_POINTS);
+				Assert(aip->path_start < Num_path_points);
 				aip->path_start = pp_xlate[aip->path_start];
 
-				Assert((aip->path_cur >= 0) && (aip->path_cur < MAX_PATH_POINTS));
+				Assert((aip->path_cur >= 0) && (aip->path_cur < Num_path_points));
 				aip->path_cur = pp_xlate[aip->path_cur];
 			}
 		}
 	}
 
 	//	Now, compress the buffer.
-	for (i=0; i<MAX_PATH_POINTS; i++)
+	for (i=0; i<Num_path_points; i++)
 		if (i != pp_xlate[i])
 			Path_points[pp_xlate[i]] = Path_points[i];
 
+	//	Update global Path_points free count.
+	Num_path_points = xlt;
 }
 
 /**
@@ -1907,6 +1902,191 @@ int is_ignore_object(ai_info *aip, int objnum, int just_the_original = 0)
 
 
 
+// Spatial index for AI target searches
+//
+// get_nearest_objnum(), find_nearby_threat(), num_nearby_fighters() and the turret target
+// search used to walk all of Ship_obj_list for every ship and every turret.  Now the ships
+// are indexed the first time one of them runs in a frame: split up by team and sorted
+// along x, so a search only looks at ships on the teams it wants that are within range
+// along x.
+//
+// Ships keep moving while the AI runs, so the x window is padded by the furthest any ship
+// can move in a frame, and each ship the window turns up is checked against where it is
+// now.  The ranges are also padded for vm_vec_dist_quick(), which can come out ~10% short,
+// and for the callers measuring to the edge of the ship rather than its center.  What
+// comes back is a superset of the ships the list walk would have accepted, in
+// Ship_obj_list order, so the searches settle ties the same way it does.
+
+#define AI_QUERY_RANGE_SLOP		1.2f		// covers vm_vec_dist_quick() coming out short
+#define AI_QUERY_RADIUS_SCALE	2.0f		// covers callers measuring to the ship's bounding box
+
+typedef struct ai_query_entry {
+	float	x;
+	float	radius;
+	int		objnum;
+	int		signature;
+	int		order;				// position in Ship_obj_list
+} ai_query_entry;
+
+typedef struct ai_query_team {
+	SCP_vector<ai_query_entry> entries;	// sorted by x
+	float	max_radius;
+} ai_query_team;
+
+static ai_query_team Ai_query_teams[MAX_IFFS];
+static int Ai_query_frame = -1;
+static int Ai_query_list_version = -1;
+static float Ai_query_max_move = 0.0f;
+
+int Ai_query_mode = AI_QUERY_INDEX;
+
+static int Ai_query_compare_searches = 0;
+static int Ai_query_compare_mismatches = 0;
+
+static bool ai_query_entry_compare(const ai_query_entry &a, const ai_query_entry &b)
+{
+	return a.x < b.x;
+}
+
+static void ai_query_build()
+{
+	ship_obj *so;
+	int i, order = 0;
+
+	if ( (Ai_query_frame == Framecount) && (Ai_query_list_version == Ship_obj_list_version) )
+		return;
+
+	Ai_query_frame = Framecount;
+	Ai_query_list_version = Ship_obj_list_version;
+	Ai_query_max_move = 0.0f;
+
+	for ( i = 0; i < MAX_IFFS; i++ ) {
+		Ai_query_teams[i].entries.clear();
+		Ai_query_teams[i].max_radius = 0.0f;
+	}
+
+	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+		object *objp = &Objects[so->objnum];
+		ship *shipp = &Ships[objp->instance];
+		physics_info *pi = &objp->phys_info;
+
+		ai_query_entry entry;
+		entry.x = objp->pos.xyz.x;
+		entry.radius = objp->radius;
+		entry.objnum = so->objnum;
+		entry.signature = objp->signature;
+		entry.order = order++;
+
+		Assert( (shipp->team >= 0) && (shipp->team < MAX_IFFS) );
+		ai_query_team *team = &Ai_query_teams[shipp->team];
+		team->entries.push_back(entry);
+		team->max_radius = MAX(team->max_radius, objp->radius);
+
+		float speed = MAX(vm_vec_mag(&pi->vel), vm_vec_mag(&pi->max_vel));
+		speed = MAX(speed, vm_vec_mag(&pi->afterburner_max_vel));
+		speed = MAX(speed, vm_vec_mag(&pi->booster_max_vel));
+		Ai_query_max_move = MAX(Ai_query_max_move, speed);
+	}
+
+	// twice a frame's worth, in case the frame time changes before the next build
+	Ai_query_max_move *= flFrametime * 2.0f;
+
+	for ( i = 0; i < MAX_IFFS; i++ ) {
+		std::sort(Ai_query_teams[i].entries.begin(), Ai_query_teams[i].entries.end(), ai_query_entry_compare);
+	}
+}
+
+static bool ai_query_order_compare(const std::pair<int, int> &a, const std::pair<int, int> &b)
+{
+	return a.first < b.first;
+}
+
+void ai_query_ships_in_range(SCP_vector<int> *objnums, int team_mask, vec3d *pos, float range)
+{
+	SCP_vector<std::pair<int, int> > found;	// order, objnum
+	float slop_range = range * AI_QUERY_RANGE_SLOP;
+	size_t i;
+
+	ai_query_build();
+
+	objnums->clear();
+
+	for ( int t = 0; t < Num_iffs; t++ ) {
+		ai_query_team *team = &Ai_query_teams[t];
+
+		if ( team->entries.empty() || !iff_matches_mask(t, team_mask) )
+			continue;
+
+		float window = slop_range + (team->max_radius * AI_QUERY_RADIUS_SCALE) + Ai_query_max_move;
+
+		ai_query_entry key;
+		key.x = pos->xyz.x - window;
+		SCP_vector<ai_query_entry>::iterator it = std::lower_bound(team->entries.begin(), team->entries.end(), key, ai_query_entry_compare);
+
+		for ( ; (it != team->entries.end()) && (it->x <= pos->xyz.x + window); ++it ) {
+			object *objp = &Objects[it->objnum];
+
+			if ( (objp->type != OBJ_SHIP) || (objp->signature != it->signature) )
+				continue;
+
+			vec3d to_obj;
+			vm_vec_sub(&to_obj, &objp->pos, pos);
+			float dist = vm_vec_mag(&to_obj);
+			float edge = objp->radius * AI_QUERY_RADIUS_SCALE;
+
+			if ( (dist - edge) > slop_range )
+				continue;
+
+			found.push_back(std::make_pair(it->order, it->objnum));
+		}
+	}
+
+	std::sort(found.begin(), found.end(), ai_query_order_compare);
+
+	for ( i = 0; i < found.size(); i++ ) {
+		objnums->push_back(found[i].second);
+	}
+}
+
+void ai_query_compare(const char *search, int brute_objnum, int index_objnum)
+{
+	Ai_query_compare_searches++;
+
+	if ( brute_objnum != index_objnum ) {
+		Ai_query_compare_mismatches++;
+		nprintf(("AI", "AI query %s mismatch: list walk found %d, index found %d\n", search, brute_objnum, index_objnum));
+	}
+}
+
+DCF(ai_query, "Selects how AI target searches find nearby ships (brute, index or compare)")
+{
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: ai_query [brute|index|compare]\n");
+		dc_printf("[brute]   -- walk every ship for every search\n");
+		dc_printf("[index]   -- use the per-frame spatial index (default)\n");
+		dc_printf("[compare] -- do both, use the list walk and count searches where they disagree\n");
+		dc_printf("with no parameters, prints the current mode and comparison stats\n");
+		return;
+	}
+
+	if (dc_optional_string("brute")) {
+		Ai_query_mode = AI_QUERY_BRUTE;
+	} else if (dc_optional_string("index")) {
+		Ai_query_mode = AI_QUERY_INDEX;
+	} else if (dc_optional_string("compare")) {
+		Ai_query_mode = AI_QUERY_COMPARE;
+		Ai_query_compare_searches = 0;
+		Ai_query_compare_mismatches = 0;
+	}
+
+	const char *modes[] = { "brute", "index", "compare" };
+	dc_printf("AI queries are: %s\n", modes[Ai_query_mode]);
+
+	if (Ai_query_compare_searches > 0) {
+		dc_printf("Compared %d searches, %d mismatches\n", Ai_query_compare_searches, Ai_query_compare_mismatches);
+	}
+}
+
 typedef struct eval_nearest_objnum {
 	int	objnum;
 	object *trial_objp;
@@ -2016,6 +2196,328 @@ void evaluate_object_as_nearest_objnum(eval_nearest_objnum *eno)
 }
 
 
+// Parallel enemy sensing (-mt_ai)
+//
+// Choosing a new enemy is most of what get_nearest_objnum() costs: every enemy in range gets
+// a nebula/stealth check, a distance (to the bounding box for big ships) and a count of the
+// ships already attacking it.  With -mt_ai, ai_sense_frame() does the parts of that which
+// only read the world, for every ship about to want a new enemy, on the worker pool before
+// any objects move.  Each job only fills in its own ship's list of visible enemies in range,
+// in Ship_obj_list order, and draws no random numbers, so the lists are the same whatever
+// the number of threads or however the jobs get split up.
+//
+// get_nearest_objnum() then commits on this thread, ship by ship in the usual order.  The
+// scaling by the number of ships already attacking an enemy, and the max_attackers limit,
+// depend on what the ships before it picked this frame, so they're applied there, exactly as
+// evaluate_object_as_nearest_objnum() applies them.  The distances are from the start of the
+// frame rather than the moment the ship thinks, which is at most a frame of movement apart.
+
+#define AI_SENSE_OFF		0
+#define AI_SENSE_ON			1
+#define AI_SENSE_VERIFY		2			// also redo every job on this thread and compare
+
+#define AI_SENSE_BATCH		4			// ships handed to a worker at a time
+
+typedef struct ai_sense_enemy {
+	float	dist;						// as get_nearest_objnum() measures it, halved for fighters and bombers,
+										// before it's scaled for attackers and players
+	int		objnum;
+	int		signature;
+	int		wingnum;
+	int		big;						// big and huge ships don't count max_attackers
+} ai_sense_enemy;
+
+typedef struct ai_sense_job {
+	int		objnum;
+	int		signature;
+	int		enemy_team_mask;
+	float	range;
+	SCP_vector<ai_sense_enemy> enemies;	// in Ship_obj_list order
+} ai_sense_job;
+
+static SCP_vector<ai_sense_job> Ai_sense_jobs;
+static int Ai_sense_num_jobs = 0;
+static int Ai_sense_job_of[MAX_AI_INFO];	// job for each ai_info this frame, or -1
+static int Ai_sense_frame = -1;
+static int Ai_sense_list_version = -1;
+static int Ai_sense_mismatches = 0;
+
+static void ai_sense_job_func(void *data, int index)
+{
+	ai_sense_job *job = &((ai_sense_job *)data)[index];
+	object *objp = &Objects[job->objnum];
+	ship *shipp = &Ships[objp->instance];
+	SCP_vector<int> objnums;
+
+	job->enemies.clear();
+
+	// fighters and bombers count at half distance, so look twice as far
+	ai_query_ships_in_range(&objnums, job->enemy_team_mask, &objp->pos, job->range * 2.0f);
+
+	for (size_t i = 0; i < objnums.size(); i++) {
+		object *trial_objp = &Objects[objnums[i]];
+		ship *trial_shipp = &Ships[trial_objp->instance];
+		ship_info *sip = &Ship_info[trial_shipp->ship_info_index];
+		float dist;
+
+		if (objnums[i] == job->objnum)
+			continue;
+
+		// the same tests as evaluate_object_as_nearest_objnum(), except for the ones about
+		// this ship's own state, which are left for the commit
+		if ( (trial_shipp->flags & (SF_DYING | SF_ARRIVING)) || (trial_objp->flags & OF_PROTECTED) )
+			continue;
+
+		if (sip->flags & (SIF_NO_SHIP_TYPE | SIF_NAVBUOY))
+			continue;
+
+		if ( !iff_matches_mask(trial_shipp->team, job->enemy_team_mask) )
+			continue;
+
+		if ( !object_is_targetable(trial_objp, shipp) ) {
+			if ( !((trial_shipp->flags2 & SF2_STEALTH) && ai_is_stealth_visible(objp, trial_objp)) ) {
+				continue;
+			}
+		}
+
+		if (sip->flags & (SIF_BIG_SHIP | SIF_HUGE_SHIP)) {
+			vec3d box_pt;
+			if (get_nearest_bbox_point(trial_objp, &objp->pos, &box_pt)) {
+				dist = 10.0f;
+			} else {
+				dist = vm_vec_dist_quick(&objp->pos, &box_pt);
+			}
+		} else {
+			dist = vm_vec_dist_quick(&objp->pos, &trial_objp->pos);
+		}
+
+		if (sip->flags & (SIF_FIGHTER | SIF_BOMBER)) {
+			dist = dist * 0.5f;
+		}
+
+		if (dist >= job->range)
+			continue;
+
+		ai_sense_enemy enemy;
+		enemy.dist = dist;
+		enemy.objnum = objnums[i];
+		enemy.signature = trial_objp->signature;
+		enemy.wingnum = trial_shipp->wingnum;
+		enemy.big = (sip->flags & (SIF_BIG_SHIP | SIF_HUGE_SHIP)) ? 1 : 0;
+		job->enemies.push_back(enemy);
+	}
+}
+
+int ai_need_new_target(object *pl_objp, int target_objnum);
+extern int ai_paused;
+
+/**
+ * Whether ai_frame() is likely to go looking for a new enemy for this ship this frame
+ */
+static bool ai_sense_wants_enemy(object *objp, ai_info *aip)
+{
+	ship *shipp = &Ships[objp->instance];
+	ship_info *sip = &Ship_info[shipp->ship_info_index];
+
+	if ( (objp->flags & OF_SHOULD_BE_DEAD) || (shipp->flags & SF_DYING) )
+		return false;
+
+	if ( (objp->flags & OF_PLAYER_SHIP) && !Player_use_ai )
+		return false;
+
+	if ( (sip->class_type < 0) || !(Ship_types[sip->class_type].ai_bools & STI_AI_AUTO_ATTACKS) )
+		return false;
+
+	if ( (aip->resume_goal_time != -1) || ((aip->mode != AIM_EVADE_WEAPON) && (aip->active_goal == AI_ACTIVE_GOAL_DYNAMIC)) )
+		return false;
+
+	if ( !timestamp_elapsed(aip->choose_enemy_timestamp) )
+		return false;
+
+	int target_objnum = aip->target_objnum;
+	if ( (target_objnum >= 0) && (Objects[target_objnum].signature != aip->target_signature) )
+		target_objnum = -1;
+
+	return ai_need_new_target(objp, target_objnum) != 0;
+}
+
+static void ai_sense_verify()
+{
+	ai_sense_job check;
+
+	for (int i = 0; i < Ai_sense_num_jobs; i++) {
+		ai_sense_job *job = &Ai_sense_jobs[i];
+
+		check.objnum = job->objnum;
+		check.signature = job->signature;
+		check.enemy_team_mask = job->enemy_team_mask;
+		check.range = job->range;
+		ai_sense_job_func(&check, 0);
+
+		size_t count = job->enemies.size();
+		if ( (check.enemies.size() != count) || ((count > 0) && memcmp(&check.enemies[0], &job->enemies[0], count * sizeof(ai_sense_enemy))) ) {
+			Ai_sense_mismatches++;
+			nprintf(("AI", "AI sensing for %s came out different on a worker thread\n", Ships[Objects[job->objnum].instance].ship_name));
+		}
+	}
+}
+
+/**
+ * Senses enemies, on the worker pool, for every ship that is about to want a new one
+ *
+ * Called once a frame, before objects move.
+ */
+void ai_sense_frame()
+{
+	ship_obj *so;
+	int i;
+
+	Ai_sense_num_jobs = 0;
+	Ai_sense_frame = -1;
+
+	// ai_process() isn't called while either is paused
+	if ( (Cmdline_mt_ai == AI_SENSE_OFF) || physics_paused || ai_paused )
+		return;
+
+	for (i = 0; i < MAX_AI_INFO; i++) {
+		Ai_sense_job_of[i] = -1;
+	}
+
+	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+		object *objp = &Objects[so->objnum];
+		ship *shipp = &Ships[objp->instance];
+
+		if ( (shipp->ai_index < 0) || !ai_sense_wants_enemy(objp, &Ai_info[shipp->ai_index]) )
+			continue;
+
+		if (Ai_sense_num_jobs == (int)Ai_sense_jobs.size()) {
+			Ai_sense_jobs.push_back(ai_sense_job());
+		}
+
+		ai_sense_job *job = &Ai_sense_jobs[Ai_sense_num_jobs];
+		job->objnum = so->objnum;
+		job->signature = objp->signature;
+		job->enemy_team_mask = iff_get_attackee_mask(obj_team(objp));
+		job->range = MAX_ENEMY_DISTANCE;
+
+		Ai_sense_job_of[shipp->ai_index] = Ai_sense_num_jobs++;
+	}
+
+	if (Ai_sense_num_jobs == 0)
+		return;
+
+	// the jobs only read the index, so it has to be built before they start
+	ai_query_build();
+
+	worker_pool_run(ai_sense_job_func, &Ai_sense_jobs[0], Ai_sense_num_jobs, AI_SENSE_BATCH);
+
+	if (Cmdline_mt_ai == AI_SENSE_VERIFY)
+		ai_sense_verify();
+
+	Ai_sense_frame = Framecount;
+	Ai_sense_list_version = Ship_obj_list_version;
+}
+
+/**
+ * Picks the enemy for a get_nearest_objnum() search from what ai_sense_frame() found
+ *
+ * @return true if it had the enemies for this search, false if the search has to be done here
+ */
+static bool ai_sense_commit(eval_nearest_objnum *eno)
+{
+	if ( (Ai_sense_frame != Framecount) || (Ai_sense_list_version != Ship_obj_list_version) )
+		return false;
+
+	object *objp = &Objects[eno->objnum];
+	ai_info *aip = &Ai_info[Ships[objp->instance].ai_index];
+	int job_index = Ai_sense_job_of[Ships[objp->instance].ai_index];
+
+	if (job_index < 0)
+		return false;
+
+	ai_sense_job *job = &Ai_sense_jobs[job_index];
+
+	if ( (job->objnum != eno->objnum) || (job->signature != objp->signature) || (job->enemy_team_mask != eno->enemy_team_mask) || (eno->range > job->range) )
+		return false;
+
+	for (size_t i = 0; i < job->enemies.size(); i++) {
+		ai_sense_enemy *enemy = &job->enemies[i];
+
+		// scaling only ever makes an enemy further away
+		if (enemy->dist >= eno->nearest_dist)
+			continue;
+
+		if ( (eno->enemy_wing != -1) && (enemy->wingnum != eno->enemy_wing) )
+			continue;
+
+		// anything that can have changed since the frame started
+		object *trial_objp = &Objects[enemy->objnum];
+		if ( (trial_objp->type != OBJ_SHIP) || (trial_objp->signature != enemy->signature) || (trial_objp->flags & OF_PROTECTED) )
+			continue;
+
+		ship *trial_shipp = &Ships[trial_objp->instance];
+		if ( (trial_shipp->flags & (SF_DYING | SF_ARRIVING)) || !iff_matches_mask(trial_shipp->team, eno->enemy_team_mask) )
+			continue;
+
+#ifndef NDEBUG
+		if (!Player_attacking_enabled && (trial_objp == Player_obj))
+			continue;
+#endif
+
+		if (is_ignore_object(aip, enemy->objnum))
+			continue;
+
+		int num_attacking = num_enemies_attacking(enemy->objnum);
+		if ( !enemy->big && (num_attacking >= eno->max_attackers) )
+			continue;
+
+		float dist = enemy->dist;
+
+		if (!enemy->big) {
+			dist *= (float) (num_attacking+2)/2.0f;				//	prevents lots of ships from attacking same target
+		}
+
+		if (trial_objp->flags & OF_PLAYER_SHIP) {
+			dist *= 1.0f + (NUM_SKILL_LEVELS - Game_skill_level - 1)/NUM_SKILL_LEVELS;	//	Favor attacking non-players based on skill level.
+		}
+
+		if (dist < eno->nearest_dist) {
+			eno->nearest_dist = dist;
+			eno->nearest_objnum = enemy->objnum;
+		}
+	}
+
+	return true;
+}
+
+DCF(mt_ai, "Senses AI enemies on worker threads (on, off or verify)")
+{
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: mt_ai [on|off|verify]\n");
+		dc_printf("[on]     -- ships sense their enemies on the worker pool before objects move\n");
+		dc_printf("[off]    -- ships search for enemies when they think, as in retail\n");
+		dc_printf("[verify] -- as on, but redo the sensing on this thread and count any differences\n");
+		dc_printf("with no parameters, prints the current mode\n");
+		return;
+	}
+
+	if (dc_optional_string("on")) {
+		Cmdline_mt_ai = AI_SENSE_ON;
+	} else if (dc_optional_string("off")) {
+		Cmdline_mt_ai = AI_SENSE_OFF;
+	} else if (dc_optional_string("verify")) {
+		Cmdline_mt_ai = AI_SENSE_VERIFY;
+		Ai_sense_mismatches = 0;
+	}
+
+	const char *modes[] = { "off", "on", "verify" };
+	dc_printf("AI sensing is %s, on %d worker thread(s)\n", modes[Cmdline_mt_ai], worker_pool_num_threads());
+
+	if (Cmdline_mt_ai == AI_SENSE_VERIFY) {
+		dc_printf("Differences found: %d\n", Ai_sense_mismatches);
+	}
+}
+
 /**
  * Given an object and an enemy team, return the index of the nearest enemy object.
  * Unless aip->targeted_subsys != NULL, don't allow to attack objects with OF_PROTECTED bit set.
@@ -2043,10 +2545,49 @@ int get_nearest_objnum(int objnum, int enemy_team_mask, int enemy_wing, float ra
 	eno.nearest_objnum = -1;
 	eno.check_danger_weapon_objnum = 0;
 
-	// go through the list of all ships and evaluate as potential targets
-	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
-		eno.trial_objp = &Objects[so->objnum];
-		evaluate_object_as_nearest_objnum(&eno);
+	bool sensed = ai_sense_commit(&eno);
+
+	if (sensed && (Ai_query_mode == AI_QUERY_COMPARE)) {
+		// the sensed distances are from the start of the frame, so ships that have moved since can
+		// still make the odd search come out differently
+		eval_nearest_objnum check = eno;
+
+		check.nearest_dist = range;
+		check.nearest_objnum = -1;
+
+		for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+			check.trial_objp = &Objects[so->objnum];
+			evaluate_object_as_nearest_objnum(&check);
+		}
+
+		ai_query_compare("ai_sense", check.nearest_objnum, eno.nearest_objnum);
+	}
+
+	if (!sensed && (Ai_query_mode != AI_QUERY_BRUTE)) {
+		// fighters and bombers count at half distance, so look twice as far
+		SCP_vector<int> objnums;
+		ai_query_ships_in_range(&objnums, enemy_team_mask, &Objects[objnum].pos, range * 2.0f);
+
+		for (size_t i = 0; i < objnums.size(); i++) {
+			eno.trial_objp = &Objects[objnums[i]];
+			evaluate_object_as_nearest_objnum(&eno);
+		}
+	}
+
+	if (!sensed && (Ai_query_mode != AI_QUERY_INDEX)) {
+		int index_objnum = eno.nearest_objnum;
+
+		eno.nearest_dist = range;
+		eno.nearest_objnum = -1;
+
+		// go through the list of all ships and evaluate as potential targets
+		for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+			eno.trial_objp = &Objects[so->objnum];
+			evaluate_object_as_nearest_objnum(&eno);
+		}
+
+		if (Ai_query_mode == AI_QUERY_COMPARE)
+			ai_query_compare("get_nearest_objnum", eno.nearest_objnum, index_objnum);
 	}
 
 	// check if danger_weapon_objnum has will show a stealth ship
@@ -2089,11 +2630,36 @@ int get_nearest_objnum(int objnum, int enemy_team_mask, int enemy_wing, float ra
  * Unlike find_enemy or find_nearest_objnum, this doesn't care about things like the protected flag or number of enemies attacking.
  * It is used to find the nearest enemy to determine things like whether to rearm.
  */
+static void evaluate_object_as_nearby_threat(object *objp, int objnum, int enemy_team_mask, float range, int *count, int *nearest_objnum, float *nearest_dist)
+{
+	if ( OBJ_INDEX(objp) != objnum ) {
+		if (Ships[objp->instance].flags & SF_DYING)
+			return;
+
+		if (Ship_info[Ships[objp->instance].ship_info_index].flags & (SIF_NO_SHIP_TYPE | SIF_NAVBUOY))
+			return;
+
+		if (iff_matches_mask(Ships[objp->instance].team, enemy_team_mask)) {
+			float	dist;
+
+			dist = vm_vec_dist_quick(&Objects[objnum].pos, &objp->pos) - objp->radius*0.75f;
+			
+			if (dist < range) {
+				(*count)++;
+
+				if (dist < *nearest_dist) {
+					*nearest_dist = dist;
+					*nearest_objnum = OBJ_INDEX(objp);
+				}
+			}
+		}
+	}
+}
+
 int find_nearby_threat(int objnum, int enemy_team_mask, float range, int *count)
 {
 	int		nearest_objnum;
 	float		nearest_dist;
-	object	*objp;
 	ship_obj	*so;
 
 	nearest_objnum = -1;
@@ -2101,31 +2667,28 @@ int find_nearby_threat(int objnum, int enemy_team_mask, float range, int *count)
 
 	*count = 0;
 
-	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
-		objp = &Objects[so->objnum];
-
-		if ( OBJ_INDEX(objp) != objnum ) {
-			if (Ships[objp->instance].flags & SF_DYING)
-				continue;
+	if (Ai_query_mode != AI_QUERY_BRUTE) {
+		SCP_vector<int> objnums;
+		ai_query_ships_in_range(&objnums, enemy_team_mask, &Objects[objnum].pos, range);
 
-			if (Ship_info[Ships[objp->instance].ship_info_index].flags & (SIF_NO_SHIP_TYPE | SIF_NAVBUOY))
-				continue;
+		for (size_t i = 0; i < objnums.size(); i++) {
+			evaluate_object_as_nearby_threat(&Objects[objnums[i]], objnum, enemy_team_mask, range, count, &nearest_objnum, &nearest_dist);
+		}
+	}
 
-			if (iff_matches_mask(Ships[objp->instance].team, enemy_team_mask)) {
-				float	dist;
+	if (Ai_query_mode != AI_QUERY_INDEX) {
+		int index_objnum = nearest_objnum;
 
-				dist = vm_vec_dist_quick(&Objects[objnum].pos, &objp->pos) - objp->radius*0.75f;
-				
-				if (dist < range) {
-					(*count)++;
+		nearest_objnum = -1;
+		nearest_dist = range;
+		*count = 0;
 
-					if (dist < nearest_dist) {
-						nearest_dist = dist;
-						nearest_objnum = OBJ_INDEX(objp);
-					}
-				}
-			}
+		for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+			evaluate_object_as_nearby_threat(&Objects[so->objnum], objnum, enemy_team_mask, range, count, &nearest_objnum, &nearest_dist);
 		}
+
+		if (Ai_query_mode == AI_QUERY_COMPARE)
+			ai_query_compare("find_nearby_threat", nearest_objnum, index_objnum);
 	}
 
 	return nearest_objnum;
@@ -2502,7 +3065,8 @@ void ai_ignore_wing(object *ignorer, int wingnum)
  * Add a path point in the global buffer Path_points.
  *
  * If modify_index == -1, then create a new point.
- * If a new point is created (ie, modify_index == -1), then Ppfp is updated.
+ * If a new point is created (ie, modify_index == -1), then Num_path_points is updated, and
+ * Path_points grows if it's full, so don't hold pointers into it across new points.
  *
  * @param pos			Position in vector space
  * @param path_num		Path numbers
@@ -2514,11 +3078,12 @@ void add_path_point(vec3d *pos, int path_num, int path_index, int modify_index)
 	pnode	*pnp;
 
 	if (modify_index == -1) {
-		Assert(Ppfp-Path_points < MAX_PATH_POINTS-1);
-		pnp = Ppfp;
-		Ppfp++;
+		if (Num_path_points == (int)Path_points.size())
+			Path_points.resize(Path_points.size() + PATH_POINTS_POOL_SIZE);
+
+		pnp = &Path_points[Num_path_points++];
 	} else {
-		Assert((modify_index >= 0) && (modify_index < MAX_PATH_POINTS-1));
+		Assert((modify_index >= 0) && (modify_index < Num_path_points));
 		pnp = &Path_points[modify_index];
 	}
 
@@ -2606,6 +3171,111 @@ void create_path_to_point(vec3d *curpos, vec3d *goalpos, object *curobjp, object
 
 }
 
+//	Cache of model paths already transformed into world space.
+//	Every ship docking with, or flying a path around, the same big ship globalizes the same
+//	points, and maybe_recreate_path redoes it whenever the big ship moves.  An entry is keyed
+//	by the object (and its signature, so a reused slot can't match) and path, and stays good
+//	for as long as the object hasn't moved or turned.  Paths on rotating submodels are only
+//	good for the frame they were built in.
+#define	MAX_PATH_XFORM_CACHE	64
+
+typedef struct path_xform_entry {
+	int		objnum;
+	int		signature;
+	int		modelnum;
+	int		path_num;
+	int		frame;				//	Framecount when built
+	int		last_used;			//	Framecount when last asked for, to pick an entry to evict
+	bool	rotating;			//	path hangs off a rotating submodel
+	vec3d	pos;				//	object position and orientation the points were built from
+	matrix	orient;
+	SCP_vector<vec3d>	verts;	//	world space, one for each mp->verts
+} path_xform_entry;
+
+static SCP_vector<path_xform_entry>	Path_xform_cache;
+
+static void path_xform_cache_clear()
+{
+	Path_xform_cache.clear();
+}
+
+/**
+ * Return the world space points of path path_num on objp's model, building them if the cached copy is stale.
+ * The returned pointer is good until the next call.
+ */
+static vec3d *path_xform_get(object *objp, model_path *mp, int path_num)
+{
+	int		i, modelnum;
+	polymodel	*pm;
+	path_xform_entry	*ent = NULL;
+	vec3d	submodel_offset, local_vert;
+
+	modelnum = Ship_info[Ships[objp->instance].ship_info_index].model_num;
+
+	for (i=0; i<(int)Path_xform_cache.size(); i++) {
+		path_xform_entry	*e = &Path_xform_cache[i];
+
+		if ((e->objnum == OBJ_INDEX(objp)) && (e->signature == objp->signature) && (e->modelnum == modelnum) && (e->path_num == path_num)) {
+			ent = e;
+			break;
+		}
+	}
+
+	if (ent != NULL) {
+		if ((ent->verts.size() == (size_t)mp->nverts) && (!ent->rotating || (ent->frame == Framecount))
+			&& !memcmp(&ent->pos, &objp->pos, sizeof(vec3d)) && !memcmp(&ent->orient, &objp->orient, sizeof(matrix))) {
+			ent->last_used = Framecount;
+			return ent->verts.empty() ? NULL : &ent->verts[0];
+		}
+	} else if (Path_xform_cache.size() < MAX_PATH_XFORM_CACHE) {
+		Path_xform_cache.push_back(path_xform_entry());
+		ent = &Path_xform_cache.back();
+	} else {
+		ent = &Path_xform_cache[0];
+		for (i=1; i<(int)Path_xform_cache.size(); i++)
+			if (Path_xform_cache[i].last_used < ent->last_used)
+				ent = &Path_xform_cache[i];
+	}
+
+	ent->objnum = OBJ_INDEX(objp);
+	ent->signature = objp->signature;
+	ent->modelnum = modelnum;
+	ent->path_num = path_num;
+	ent->frame = Framecount;
+	ent->last_used = Framecount;
+	ent->pos = objp->pos;
+	ent->orient = objp->orient;
+	ent->verts.resize(mp->nverts);
+
+	// Goober5000 - check for rotating submodels
+	pm = model_get(modelnum);
+	ent->rotating = (mp->parent_submodel >= 0) && (pm->submodel[mp->parent_submodel].movement_type >= 0);
+
+	if (ent->rotating) {
+		// start submodel calculation
+		ship_model_start(objp);
+
+		model_find_submodel_offset(&submodel_offset, modelnum, mp->parent_submodel);
+
+		// movement... find location of point like with docking code and spark generation
+		for (i=0; i<mp->nverts; i++) {
+			vm_vec_sub(&local_vert, &mp->verts[i].pos, &submodel_offset);
+			model_find_world_point(&ent->verts[i], &local_vert, modelnum, mp->parent_submodel, &objp->orient, &objp->pos);
+		}
+
+		// stop submodel calculation
+		ship_model_stop(objp);
+	} else {
+		// no movement... calculate as in original code
+		for (i=0; i<mp->nverts; i++) {
+			vm_vec_unrotate(&ent->verts[i], &mp->verts[i].pos, &objp->orient);
+			vm_vec_add2(&ent->verts[i], &objp->pos);
+		}
+	}
+
+	return ent->verts.empty() ? NULL : &ent->verts[0];
+}
+
 /**
  * Given an object and a model path, globalize the points on the model and copy into the global path list.
  * If pnp != NULL, then modify, in place, the path points.  This is used to create new globalized points when the base object has moved.
@@ -2620,13 +3290,11 @@ void create_path_to_point(vec3d *curpos, vec3d *goalpos, object *curobjp, object
  */
 void copy_xlate_model_path_points(object *objp, model_path *mp, int dir, int count, int path_num, pnode *pnp, int randomize_pnt)
 {
-	polymodel *pm;
-	int		i, modelnum;
+	int		i;
 	vec3d	v1;
+	vec3d	*world_verts;
 	int		pp_index;		//	index in Path_points at which to store point, if this is a modify-in-place (pnp ! NULL)
 	int		start_index, finish_index;
-	vec3d submodel_offset, local_vert;
-	bool rotating_submodel;
 	
 	//	Initialize pp_index.
 	//	If pnp == NULL, that means we're creating new points.  If not NULL, then modify in place.
@@ -2644,40 +3312,13 @@ void copy_xlate_model_path_points(object *objp, model_path *mp, int dir, int cou
 		finish_index = MAX(-1, mp->nverts-1-count);
 	}
 
-	// Goober5000 - check for rotating submodels
-	modelnum = Ship_info[Ships[objp->instance].ship_info_index].model_num;
-	pm = model_get(modelnum);
-	if ((mp->parent_submodel >= 0) && (pm->submodel[mp->parent_submodel].movement_type >= 0))
-	{
-		rotating_submodel = true;
-
-		// start submodel calculation
-		ship_model_start(objp);
-
-		model_find_submodel_offset(&submodel_offset, modelnum, mp->parent_submodel);
-	}
-	else
-	{
-		rotating_submodel = false;
-	}
+	//	Globalize the points, or reuse them if another ship already did.
+	world_verts = path_xform_get(objp, mp, path_num);
 
 	int offset = 0;
 	for (i=start_index; i != finish_index; i += dir)
 	{
-		//	Globalize the point.
-		// Goober5000 - handle rotating submodels
-		if (rotating_submodel)
-		{
-			// movement... find location of point like with docking code and spark generation
-			vm_vec_sub(&local_vert, &mp->verts[i].pos, &submodel_offset);
-			model_find_world_point(&v1, &local_vert, modelnum, mp->parent_submodel, &objp->orient, &objp->pos);			
-		}
-		else
-		{
-			// no movement... calculate as in original code
-			vm_vec_unrotate(&v1, &mp->verts[i].pos, &objp->orient);
-			vm_vec_add2(&v1, &objp->pos);
-		}
+		v1 = world_verts[i];
 
 		if ( randomize_pnt == i ) {
 			vec3d v_rand;
@@ -2687,17 +3328,11 @@ void copy_xlate_model_path_points(object *objp, model_path *mp, int dir, int cou
 		}
 
 		if (pp_index != -1)
-			pp_index = pnp-Path_points + offset;
+			pp_index = (int)(pnp - &Path_points[0]) + offset;
 
 		add_path_point(&v1, path_num, i, pp_index);
 		offset++;
 	}
-
-	// stop submodel calculation
-	if (!rotating_submodel)
-	{
-		ship_model_stop(objp);
-	}
 }
 
 
@@ -2718,26 +3353,20 @@ void create_model_path(object *pl_objp, object *mobjp, int path_num, int subsys_
 
 	ship_info	*osip = &Ship_info[Ships[mobjp->instance].ship_info_index];
 	polymodel	*pm = model_get(Ship_info[Ships[mobjp->instance].ship_info_index].model_num);
-	int			num_points;
 	model_path	*mp;
-	pnode			*ppfp_start = Ppfp;
 	vec3d		gp0;
 
 	Assert(path_num >= 0);
 
 	//	Do garbage collection if necessary.
-	if (Ppfp-Path_points + 64 > MAX_PATH_POINTS) {
+	if (Num_path_points + 64 > (int)Path_points.size()) {
 		garbage_collect_path_points();
-		ppfp_start = Ppfp;
 	}
 
-	aip->path_start = Ppfp - Path_points;
+	aip->path_start = Num_path_points;
 	Assert(path_num < pm->n_paths);
 	
 	mp = &pm->paths[path_num];
-	num_points = mp->nverts;
-
-	Assert(Ppfp-Path_points + num_points + 4 < MAX_PATH_POINTS);
 
 	vm_vec_unrotate(&gp0, &mp->verts[0].pos, &mobjp->orient);
 	vm_vec_add2(&gp0, &mobjp->pos);
@@ -2776,7 +3405,7 @@ void create_model_path(object *pl_objp, object *mobjp, int path_num, int subsys_
 	aip->path_dir = PD_FORWARD;
 	aip->path_objnum = OBJ_INDEX(mobjp);
 	aip->mp_index = path_num;
-	aip->path_length = Ppfp - ppfp_start;
+	aip->path_length = Num_path_points - aip->path_start;
 	aip->path_next_check_time = timestamp(1);
 
 	aip->path_goal_obj_hash = create_object_hash(&Objects[aip->path_objnum]);
@@ -2811,25 +3440,19 @@ void create_model_exit_path(object *pl_objp, object *mobjp, int path_num, int co
 	ai_info		*aip = &Ai_info[shipp->ai_index];
 
 	polymodel	*pm = model_get(Ship_info[Ships[mobjp->instance].ship_info_index].model_num);
-	int			num_points;
 	model_path	*mp;
-	pnode			*ppfp_start = Ppfp;
 
 	Assert(path_num >= 0);
 
 	//	Do garbage collection if necessary.
-	if (Ppfp-Path_points + 64 > MAX_PATH_POINTS) {
+	if (Num_path_points + 64 > (int)Path_points.size()) {
 		garbage_collect_path_points();
-		ppfp_start = Ppfp;
 	}
 
-	aip->path_start = Ppfp - Path_points;
+	aip->path_start = Num_path_points;
 	Assert(path_num < pm->n_paths);
 	
 	mp = &pm->paths[path_num];
-	num_points = mp->nverts;
-
-	Assert(Ppfp-Path_points + num_points + 4 < MAX_PATH_POINTS);
 
 	copy_xlate_model_path_points(mobjp, mp, -1, count, path_num, NULL);
 
@@ -2837,7 +3460,7 @@ void create_model_exit_path(object *pl_objp, object *mobjp, int path_num, int co
 	aip->path_dir = PD_FORWARD;
 	aip->path_objnum = OBJ_INDEX(mobjp);
 	aip->mp_index = path_num;
-	aip->path_length = Ppfp - ppfp_start;
+	aip->path_length = Num_path_points - aip->path_start;
 	aip->path_next_check_time = timestamp(1);
 
 	aip->ai_flags |= AIF_USE_EXIT_PATH;		// mark as exit path, referenced in maybe
@@ -3546,10 +4169,10 @@ void modify_model_path_points(object *objp)
 	pnode			*pnp;
 	int			path_num, dir;
 
-	Assert((aip->path_start >= 0) && (aip->path_start < MAX_PATH_POINTS));
+	Assert((aip->path_start >= 0) && (aip->path_start < Num_path_points));
 
 	pnp = &Path_points[aip->path_start];
-	while ((pnp->path_index == -1) && (pnp-Path_points - aip->path_start < aip->path_length))
+	while ((pnp->path_index == -1) && (pnp - &Path_points[aip->path_start] < aip->path_length))
 		pnp++;
 
 	path_num = pnp->path_num;
@@ -5770,22 +6393,43 @@ int ai_fire_primary_weapon(object *objp)
 //				threshold			=>	max distance from pos to be considered "near"
 //
 // exit:		number of ships within threshold units of pos
+static int is_nearby_fighter(object *ship_objp, int enemy_team_mask, vec3d *pos, float threshold)
+{
+	if (iff_matches_mask(Ships[ship_objp->instance].team, enemy_team_mask)) {
+		if (Ship_info[Ships[ship_objp->instance].ship_info_index].flags & (SIF_FIGHTER | SIF_BOMBER)) {
+			if (vm_vec_dist_quick(pos, &ship_objp->pos) < threshold)
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
 int num_nearby_fighters(int enemy_team_mask, vec3d *pos, float threshold)
 {
 	ship_obj	*so;
-	object	*ship_objp;
 	int		count = 0;
 
-	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+	if (Ai_query_mode != AI_QUERY_BRUTE) {
+		SCP_vector<int> objnums;
+		ai_query_ships_in_range(&objnums, enemy_team_mask, pos, threshold);
+
+		for (size_t i = 0; i < objnums.size(); i++) {
+			count += is_nearby_fighter(&Objects[objnums[i]], enemy_team_mask, pos, threshold);
+		}
+	}
 
-		ship_objp = &Objects[so->objnum];
+	if (Ai_query_mode != AI_QUERY_INDEX) {
+		int index_count = count;
 
-		if (iff_matches_mask(Ships[ship_objp->instance].team, enemy_team_mask)) {
-			if (Ship_info[Ships[ship_objp->instance].ship_info_index].flags & (SIF_FIGHTER | SIF_BOMBER)) {
-				if (vm_vec_dist_quick(pos, &ship_objp->pos) < threshold)
-					count++;
-			}
+		count = 0;
+
+		for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+			count += is_nearby_fighter(&Objects[so->objnum], enemy_team_mask, pos, threshold);
 		}
+
+		if (Ai_query_mode == AI_QUERY_COMPARE)
+			ai_query_compare("num_nearby_fighters", count, index_count);
 	}
 
 	return count;
@@ -6279,7 +6923,7 @@ void render_path_points(object *objp)
 			if (i != 0)
 				g3_draw_line(&v0, &prev_vertex);
 
-			if (pp-Path_points == aip->path_cur)
+			if (pp - &Path_points[0] == aip->path_cur)
 				gr_set_color(255,255,0);
 			
 			g3_draw_sphere( &v0, 4.5f);
@@ -7630,13 +8274,13 @@ void update_aspect_lock_information(ai_info *aip, vec3d *vec_to_enemy, float dis
 			(wip->wi_flags & WIF_HOMING_JAVELIN &&
 			(tshpp == NULL ||
 			ship_get_closest_subsys_in_sight(tshpp, SUBSYSTEM_ENGINE, &aiobjp->pos))))) {
-				aip->aspect_locked_time += flFrametime;
+				aip->aspect_locked_time += ai_sched_frametime(aip);
 				if (aip->aspect_locked_time >= wip->min_lock_time) {
 					aip->aspect_locked_time = wip->min_lock_time;
 					aip->current_target_is_locked = 1;
 				}
 		} else {
-			aip->aspect_locked_time -= flFrametime*2;
+			aip->aspect_locked_time -= ai_sched_frametime(aip)*2;
 			if (aip->aspect_locked_time < 0.0f)
 				aip->aspect_locked_time = 0.0f;
 		}
@@ -8745,11 +9389,11 @@ void ai_chase()
 			aip->submode != SM_GET_AWAY && aip->submode != AIS_CHASE_GLIDEATTACK && aip->submode != SM_FLY_AWAY && 
 			(!(aip->ai_flags & AIF_STEALTH_PURSUIT) || (ai_is_stealth_visible(Pl_objp, En_objp) == STEALTH_IN_FRUSTUM)))
 	{
-		aip->time_enemy_near += flFrametime;
+		aip->time_enemy_near += ai_sched_frametime(aip);
 	}
 	else
 	{
-		aip->time_enemy_near *= (1.0f - flFrametime);
+		aip->time_enemy_near *= (1.0f - ai_sched_frametime(aip));
 		if (aip->time_enemy_near < 0.0f)
 			aip->time_enemy_near = 0.0f;
 	}
@@ -8757,7 +9401,7 @@ void ai_chase()
 	//	Maybe fire primary weapon and update time_enemy_in_range
 	if (aip->mode != AIM_EVADE) {
 		if (dot_to_enemy > 0.95f - 0.5f * En_objp->radius/MAX(1.0f, En_objp->radius + dist_to_enemy)) {
-			aip->time_enemy_in_range += flFrametime;
+			aip->time_enemy_in_range += ai_sched_frametime(aip);
 			
 			//	Chance of hitting ship is based on dot product of firing ship's forward vector with vector to ship
 			//	and also the size of the target relative to distance to target.
@@ -8891,14 +9535,14 @@ void ai_chase()
 				}
 			}
 		} else {
-			if (flFrametime < 1.0f)
-				aip->time_enemy_in_range *= (1.0f - flFrametime);
+			if (ai_sched_frametime(aip) < 1.0f)
+				aip->time_enemy_in_range *= (1.0f - ai_sched_frametime(aip));
 			else
 				aip->time_enemy_in_range = 0;
 		}
 	} else {
-		if (flFrametime < 1.0f)
-			aip->time_enemy_in_range *= (1.0f - flFrametime);
+		if (ai_sched_frametime(aip) < 1.0f)
+			aip->time_enemy_in_range *= (1.0f - ai_sched_frametime(aip));
 		else
 			aip->time_enemy_in_range = 0;
 	}
@@ -11143,6 +11787,10 @@ void process_subobjects(int objnum)
 	int enemies_present = -1;
 
 	model_subsystem	*psub;
+
+	// the turrets below share their target searches
+	ai_turret_batch_begin(objnum);
+
 	for ( pss = GET_FIRST(&shipp->subsys_list); pss !=END_OF_LIST(&shipp->subsys_list); pss = GET_NEXT(pss) ) {
 		psub = pss->system_info;
 
@@ -11188,7 +11836,7 @@ void process_subobjects(int objnum)
 				}
 				//Only move turrets if enemies are present
 				if(enemies_present == 1 || pss->turret_enemy_objnum >= 0)
-					ai_fire_from_turret(shipp, pss, objnum);
+					PROFILE("Turret AI", ai_fire_from_turret(shipp, pss, objnum));
 			} else {
 				Warning( LOCATION, "Turret %s on ship %s has no firing points assigned to it.\nThis needs to be fixed in the model.\n", psub->name, shipp->ship_name );
 			}
@@ -12718,7 +13366,7 @@ int ai_acquire_emerge_path(object *pl_objp, int parent_objnum, int allowed_path_
 	create_model_exit_path(pl_objp, parent_objp, path_index, pm->paths[path_index].nverts);
 
 	// now return to the caller what the starting world pos and starting fvec for the ship will be
-	Assert((aip->path_start >= 0) && (aip->path_start < MAX_PATH_POINTS));
+	Assert((aip->path_start >= 0) && (aip->path_start < Num_path_points));
 	pnp = &Path_points[aip->path_start];
 	*pos = pnp->pos;
 
@@ -14237,6 +14885,183 @@ void ai_control_info_check( object *obj, ai_info *aip )
 	}
 }
 
+// AI scheduling
+//
+// Ships far from every player and out of the thick of things don't need to rethink what
+// they're doing every frame.  With -ai_sched, each ship gets an update interval from its mode,
+// its distance to the nearest player and whether it's fighting.  On the frames in between
+// ai_frame() doesn't run, and so nor do find_enemy(), the path code and the rest of its work;
+// the ship keeps flying on the controls it last chose (its rotational velocity is already in
+// phys_info) and its turrets still run every frame.  Without it every ship runs every frame.
+//
+// With -ai_budget as well, once ship AI has used that many microseconds in a frame, the ships that
+// are due but only need updating every few frames are put off, up to AI_SCHED_MAX_DEFER
+// frames late.
+
+#define AI_SCHED_NEAR_DIST			2000.0f		// ships this close to a player run every frame
+#define AI_SCHED_COMBAT_INTERVAL	2			// frames between updates for ships with a target or incoming fire
+#define AI_SCHED_IDLE_INTERVAL		4			// frames between updates for everything else
+#define AI_SCHED_MAX_DEFER			4			// frames a ship can be put off past its interval
+
+static int Ai_sched_frame = -1;
+static uint Ai_sched_time_us = 0;				// ai_frame() time so far this frame
+static int Ai_sched_run = 0;
+static int Ai_sched_skipped = 0;
+static int Ai_sched_deferred = 0;
+
+/**
+ * Distance from objp to the nearest player ship
+ */
+static float ai_sched_player_dist(object *objp)
+{
+	float nearest = 999999.0f;
+
+	if (Game_mode & GM_MULTIPLAYER) {
+		for (int i = 0; i < MAX_PLAYERS; i++) {
+			if ( MULTI_CONNECTED(Net_players[i]) && !MULTI_STANDALONE(Net_players[i]) && (Net_players[i].m_player != NULL) && (Net_players[i].m_player->objnum >= 0) ) {
+				nearest = MIN(nearest, vm_vec_dist_quick(&objp->pos, &Objects[Net_players[i].m_player->objnum].pos));
+			}
+		}
+	} else if (Player_obj != NULL) {
+		nearest = vm_vec_dist_quick(&objp->pos, &Player_obj->pos);
+	}
+
+	return nearest;
+}
+
+/**
+ * How many frames apart ai_frame() needs to run for this ship
+ */
+static int ai_sched_interval(object *objp, ai_info *aip)
+{
+	if (!Cmdline_ai_sched) {
+		return 1;
+	}
+
+	// player ships flown by the AI, and anything moving with another ship
+	if ( (objp->flags & OF_PLAYER_SHIP) || object_is_docked(objp) ) {
+		return 1;
+	}
+
+	// modes where a late update leaves the ship somewhere it shouldn't be
+	switch (aip->mode) {
+	case AIM_DOCK:
+	case AIM_WARP_OUT:
+	case AIM_BAY_EMERGE:
+	case AIM_BAY_DEPART:
+	case AIM_EVADE_WEAPON:
+		return 1;
+	default:
+		break;
+	}
+
+	if (aip->ai_flags & (AIF_FORMATION | AIF_AVOID_SHOCKWAVE | AIF_BIG_SHIP_COLLIDE_RECOVER_1 | AIF_BIG_SHIP_COLLIDE_RECOVER_2 | AIF_AWAITING_REPAIR | AIF_BEING_REPAIRED | AIF_REPAIRING | AIF_KAMIKAZE | AIF_TRYING_UNSUCCESSFULLY_TO_WARP)) {
+		return 1;
+	}
+
+	if (ai_sched_player_dist(objp) < AI_SCHED_NEAR_DIST) {
+		return 1;
+	}
+
+	if ( (aip->target_objnum >= 0) || (aip->danger_weapon_objnum >= 0) ) {
+		return AI_SCHED_COMBAT_INTERVAL;
+	}
+
+	return AI_SCHED_IDLE_INTERVAL;
+}
+
+/**
+ * Whether ai_frame() should run for this ship this frame
+ */
+static bool ai_sched_should_run(object *objp, ai_info *aip)
+{
+	if (Ai_sched_frame != Framecount) {
+		// show how the last frame went
+		profile_counter_set("AI ships run", Ai_sched_run);
+		profile_counter_set("AI ships skipped", Ai_sched_skipped);
+		profile_counter_set("AI ships deferred", Ai_sched_deferred);
+		profile_counter_set("AI time (us)", (int)Ai_sched_time_us, Cmdline_ai_budget);
+
+		Ai_sched_frame = Framecount;
+		Ai_sched_time_us = 0;
+		Ai_sched_run = 0;
+		Ai_sched_skipped = 0;
+		Ai_sched_deferred = 0;
+	}
+
+	if (aip->sched_last_frame < 0) {
+		return true;
+	}
+
+	int interval = ai_sched_interval(objp, aip);
+	int waited = Framecount - aip->sched_last_frame;
+
+	if (waited < interval) {
+		Ai_sched_skipped++;
+		return false;
+	}
+
+	if ( (interval > 1) && (Cmdline_ai_budget > 0) && (Ai_sched_time_us >= (uint)Cmdline_ai_budget) && (waited < interval + AI_SCHED_MAX_DEFER) ) {
+		Ai_sched_deferred++;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Counters that build up or wear off over time (locking, stalemates, time in range) advance by this
+ * rather than flFrametime, so a ship updated every few frames gets there as fast as one updated every frame.
+ */
+float ai_sched_frametime(ai_info *aip)
+{
+	return flFrametime + aip->sched_skipped_time;
+}
+
+static bool ai_sched_cost_compare(const std::pair<int, int> &a, const std::pair<int, int> &b)
+{
+	return a.first > b.first;
+}
+
+DCF(ai_sched, "Turns AI scheduling on or off, and lists the ships whose AI costs the most")
+{
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: ai_sched [on|off]\n");
+		dc_printf("[on]  -- ships far from players and out of combat update their AI every few frames\n");
+		dc_printf("[off] -- every ship updates its AI every frame (default, unless started with -ai_sched)\n");
+		dc_printf("with no parameters, prints the current setting and the ships with the most expensive AI\n");
+		return;
+	}
+
+	if (dc_optional_string("on")) {
+		Cmdline_ai_sched = 1;
+	} else if (dc_optional_string("off")) {
+		Cmdline_ai_sched = 0;
+	}
+
+	dc_printf("AI scheduling is %s, budget %d us\n", Cmdline_ai_sched ? "on" : "off", Cmdline_ai_budget);
+
+	SCP_vector<std::pair<int, int> > costs;	// cost, objnum
+	ship_obj *so;
+
+	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+		ship *shipp = &Ships[Objects[so->objnum].instance];
+
+		if (shipp->ai_index >= 0) {
+			costs.push_back(std::make_pair(Ai_info[shipp->ai_index].sched_cost_us, so->objnum));
+		}
+	}
+
+	std::sort(costs.begin(), costs.end(), ai_sched_cost_compare);
+
+	for (size_t i = 0; (i < costs.size()) && (i < 10); i++) {
+		object *objp = &Objects[costs[i].second];
+		ai_info *aip = &Ai_info[Ships[objp->instance].ai_index];
+
+		dc_printf("%-32s %5d us, every %d frame(s)\n", Ships[objp->instance].ship_name, costs[i].first, ai_sched_interval(objp, aip));
+	}
+}
+
 int Last_ai_obj = -1;
 
 void ai_process( object * obj, int ai_index, float frametime )
@@ -14261,15 +15086,41 @@ void ai_process( object * obj, int ai_index, float frametime )
 
 	memset( &AI_ci, 0, sizeof(AI_ci) );
 
-	ai_frame(OBJ_INDEX(obj));
+	ai_info	*aip = &Ai_info[ai_index];
+
+	if (ai_sched_should_run(obj, aip)) {
+		uint start_us = timer_get_high_res_microseconds();
+
+		aip->target_time += aip->sched_skipped_time;
+		ai_frame(OBJ_INDEX(obj));
+
+		AI_ci.pitch = 0.0f;
+		AI_ci.bank = 0.0f;
+		AI_ci.heading = 0.0f;
+
+		uint cost_us = timer_get_high_res_microseconds() - start_us;
+		Ai_sched_time_us += cost_us;
+		Ai_sched_run++;
+
+		aip->sched_cost_us = (aip->sched_cost_us * 7 + (int)cost_us) / 8;
+		aip->sched_ci = AI_ci;
+		aip->sched_skipped_time = 0.0f;
+
+		// spread out ships that start on the same frame
+		if (aip->sched_last_frame < 0)
+			aip->sched_last_frame = Framecount - (ai_index % AI_SCHED_IDLE_INTERVAL);
+		else
+			aip->sched_last_frame = Framecount;
+	} else {
+		AI_ci = aip->sched_ci;
+		aip->sched_skipped_time += frametime;
 
-	AI_ci.pitch = 0.0f;
-	AI_ci.bank = 0.0f;
-	AI_ci.heading = 0.0f;
+		// turrets still track and fire every frame
+		process_subobjects(OBJ_INDEX(obj));
+	}
 
 	// the ships maximum velocity now depends on the energy flowing to engines
 	obj->phys_info.max_vel.xyz.z = Ships[obj->instance].current_max_speed;
-	ai_info	*aip = &Ai_info[Ships[obj->instance].ai_index];
 
 	//	In certain circumstances, the AI says don't fly in the normal way.
 	//	One circumstance is in docking and undocking, when the ship is moving
@@ -14463,11 +15314,21 @@ void init_ai_object(int objnum)
 	aip->lethality = 0.0f;
 	aip->ai_override_flags = 0;
 	memset(&aip->ai_override_ci,0,sizeof(control_info));
+
+	aip->sched_last_frame = -1;
+	aip->sched_skipped_time = 0.0f;
+	aip->sched_cost_us = 0;
+	memset(&aip->sched_ci, 0, sizeof(control_info));
 }
 
 void init_ai_system()
 {
-	Ppfp = Path_points;
+	Num_path_points = 0;
+
+	if (Path_points.empty())
+		Path_points.resize(PATH_POINTS_POOL_SIZE);
+
+	path_xform_cache_clear();
 }
 
 int combine_flags(int base_flags, int override_flags, int override_set)
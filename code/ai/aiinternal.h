@@ -25,10 +25,26 @@ int object_is_targetable(object *target, ship *viewer);
 //Returns the number of enemy fighters within threshold of pos.
 int num_nearby_fighters(int enemy_team_mask, vec3d *pos, float threshold);
 
+//Spatial index of the ships in the mission, for AI target searches
+#define AI_QUERY_BRUTE		0		// walk Ship_obj_list, like retail
+#define AI_QUERY_INDEX		1		// use the index
+#define AI_QUERY_COMPARE	2		// do both, use the list walk and count the searches where they disagree
+
+extern int Ai_query_mode;
+
+//Ships of the teams in team_mask that may be within range of pos, in Ship_obj_list order.
+void ai_query_ships_in_range(SCP_vector<int> *objnums, int team_mask, vec3d *pos, float range);
+
+//Records the result of a search done both ways in AI_QUERY_COMPARE mode.
+void ai_query_compare(const char *search, int brute_objnum, int index_objnum);
+
 //Returns true if OK for *aip to fire its current weapon at its current target.
 int check_ok_to_fire(int objnum, int target_objnum, weapon_info *wip);
 
 //Does all the stuff needed to aim and fire a turret.
 void ai_fire_from_turret(ship *shipp, ship_subsys *ss, int parent_objnum);
 
+//Starts a new batch of turret target searches, for the turrets on parent_objnum.
+void ai_turret_batch_begin(int parent_objnum);
+
 #endif
@@ -857,6 +857,153 @@ int is_target_beam_valid(ship_weapon *swp, object *objp)
 	return 1;
 }
 
+// Turret target batches
+//
+// All of a ship's turrets search from about the same place for the same teams' ships.  So
+// the first time one of them looks for a ship to shoot at in a frame, the enemy ships any of
+// the turrets could reach are gathered once, and each turret only has to score the ones
+// inside its own weapon range and fov.  Their positions are kept as separate float arrays
+// so that pass is a plain loop over them.
+//
+// process_subobjects() starts a batch before running a ship's turrets.  Nothing else moves
+// while they run, so the stored positions stay right for the whole batch.
+//
+// Turrets that already have an enemy are also limited to a few new searches per ship per
+// frame; the rest keep their enemy and search again on a later frame.
+
+#define TURRET_BATCH_RANGE_SLOP		1.2f	// evaluate_obj_as_target() uses vm_vec_mag_quick(), which can come out short
+#define TURRET_BATCH_RETARGETS		4		// searches per ship per frame by turrets that already have an enemy
+
+typedef struct turret_batch {
+	int		parent_objnum;
+	int		parent_signature;
+	int		frame;								// Framecount it was built, -1 if not yet
+	int		retargets;
+
+	SCP_vector<int>		objnum;
+	SCP_vector<float>	x, y, z, radius;
+	SCP_vector<ubyte>	in_reach;				// per turret, whether objnum[i] is worth scoring
+} turret_batch;
+
+static turret_batch Turret_batch = { -1, -1, -1, 0 };
+
+void ai_turret_batch_begin(int parent_objnum)
+{
+	Turret_batch.parent_objnum = parent_objnum;
+	Turret_batch.parent_signature = Objects[parent_objnum].signature;
+	Turret_batch.frame = -1;
+	Turret_batch.retargets = 0;
+}
+
+/**
+ * Whether a turret can look for a new enemy this frame
+ */
+static bool turret_batch_may_search(ship_subsys *ss, int parent_objnum)
+{
+	// a turret without an enemy always gets to look for one
+	if ( (ss->turret_enemy_objnum == -1) || (Turret_batch.parent_objnum != parent_objnum) ) {
+		return true;
+	}
+
+	if (Turret_batch.retargets >= TURRET_BATCH_RETARGETS) {
+		return false;
+	}
+
+	Turret_batch.retargets++;
+	return true;
+}
+
+/**
+ * Gather the enemy ships any turret on the parent could target
+ */
+static void turret_batch_build(int parent_objnum, int enemy_team_mask)
+{
+	object *parent_objp = &Objects[parent_objnum];
+	ship *shipp = &Ships[parent_objp->instance];
+	ship_subsys *pss;
+	SCP_vector<int> objnums;
+	float reach = 0.0f;
+
+	if ( (Turret_batch.parent_objnum != parent_objnum) || (Turret_batch.parent_signature != parent_objp->signature) ) {
+		ai_turret_batch_begin(parent_objnum);
+	}
+
+	Turret_batch.frame = Framecount;
+	Turret_batch.objnum.clear();
+	Turret_batch.x.clear();
+	Turret_batch.y.clear();
+	Turret_batch.z.clear();
+	Turret_batch.radius.clear();
+
+	for ( pss = GET_FIRST(&shipp->subsys_list); pss != END_OF_LIST(&shipp->subsys_list); pss = GET_NEXT(pss) ) {
+		if (pss->system_info->type == SUBSYSTEM_TURRET) {
+			reach = MAX(reach, longest_turret_weapon_range(&pss->weapons));
+		}
+	}
+
+	// the turrets are somewhere within the parent's radius
+	ai_query_ships_in_range(&objnums, enemy_team_mask, &parent_objp->pos, (reach * TURRET_BATCH_RANGE_SLOP) + parent_objp->radius);
+
+	for (size_t i = 0; i < objnums.size(); i++) {
+		object *objp = &Objects[objnums[i]];
+
+		if ( !valid_turret_enemy(objp, parent_objp) ) {
+			continue;
+		}
+
+		Turret_batch.objnum.push_back(objnums[i]);
+		Turret_batch.x.push_back(objp->pos.xyz.x);
+		Turret_batch.y.push_back(objp->pos.xyz.y);
+		Turret_batch.z.push_back(objp->pos.xyz.z);
+		Turret_batch.radius.push_back(objp->radius);
+	}
+
+	Turret_batch.in_reach.resize(Turret_batch.objnum.size());
+}
+
+/**
+ * Mark which ships in the batch a turret could make its nearest attacker
+ *
+ * Errs on the side of marking a ship; evaluate_obj_as_target() makes the real decision.
+ *
+ * @param tpos          Position of turret (world coords)
+ * @param tvec          Forward vector of turret (world coords)
+ * @param range         Turret weapon range
+ * @param min_dot       Cosine of the turret fov, or -1.0f if the fov doesn't matter
+ */
+static void turret_batch_mark(vec3d *tpos, vec3d *tvec, float range, float min_dot)
+{
+	int count = (int)Turret_batch.objnum.size();
+
+	if (count == 0) {
+		return;
+	}
+
+	const float *x = &Turret_batch.x[0];
+	const float *y = &Turret_batch.y[0];
+	const float *z = &Turret_batch.z[0];
+	const float *radius = &Turret_batch.radius[0];
+	ubyte *in_reach = &Turret_batch.in_reach[0];
+
+	float px = tpos->xyz.x, py = tpos->xyz.y, pz = tpos->xyz.z;
+	float vx = tvec->xyz.x, vy = tvec->xyz.y, vz = tvec->xyz.z;
+	float reach = range * TURRET_BATCH_RANGE_SLOP;
+
+	for (int i = 0; i < count; i++) {
+		float dx = x[i] - px;
+		float dy = y[i] - py;
+		float dz = z[i] - pz;
+		float dist = sqrtf(dx*dx + dy*dy + dz*dz);
+		float dot = dx*vx + dy*vy + dz*vz;
+
+		// the fov test allows for the size of the target, up to a radius either side of the cone
+		bool near_enough = (dist - (2.0f * radius[i])) <= reach;
+		bool in_fov = (dist <= radius[i]) || (dot >= ((min_dot * dist) - (1.5f * radius[i])));
+
+		in_reach[i] = (ubyte)(near_enough & in_fov);
+	}
+}
+
 /**
  * Given an object and an enemy team, return the index of the nearest enemy object.
  *
@@ -1123,10 +1270,40 @@ int get_nearest_turret_objnum(int turret_parent_objnum, ship_subsys *turret_subs
 
 				case 1:
 					//Return if a ship is found
-					// Ship_used_list
-					for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
-						objp = &Objects[so->objnum];
-						evaluate_obj_as_target(objp, &eeo);
+					if (Ai_query_mode != AI_QUERY_BRUTE) {
+						eval_enemy_obj_struct brute_eeo = eeo;
+
+						if ( (Turret_batch.parent_objnum != turret_parent_objnum) || (Turret_batch.frame != Framecount) ) {
+							turret_batch_build(turret_parent_objnum, enemy_team_mask);
+						}
+
+						// only ships within weapon range can be attackers, and only those in the fov if it's needed
+						float min_dot = -1.0f;
+						if ((turret_subsys->flags & SSF_FOV_REQUIRED) || (current_enemy != -1))
+							min_dot = turret_subsys->system_info->turret_fov;
+
+						turret_batch_mark(tpos, tvec, eeo.weapon_travel_dist, min_dot);
+
+						for (size_t j = 0; j < Turret_batch.objnum.size(); j++) {
+							if (Turret_batch.in_reach[j]) {
+								evaluate_obj_as_target(&Objects[Turret_batch.objnum[j]], &eeo);
+							}
+						}
+
+						if (Ai_query_mode == AI_QUERY_COMPARE) {
+							for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+								evaluate_obj_as_target(&Objects[so->objnum], &brute_eeo);
+							}
+
+							ai_query_compare("get_nearest_turret_objnum", brute_eeo.nearest_attacker_objnum, eeo.nearest_attacker_objnum);
+							eeo = brute_eeo;
+						}
+					} else {
+						// Ship_used_list
+						for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+							objp = &Objects[so->objnum];
+							evaluate_obj_as_target(objp, &eeo);
+						}
 					}
 
 					Assert(eeo.nearest_attacker_objnum < 0 || is_target_beam_valid(swp, &Objects[eeo.nearest_attacker_objnum]));
@@ -2462,7 +2639,7 @@ void ai_fire_from_turret(ship *shipp, ship_subsys *ss, int parent_objnum)
 		ss->turret_enemy_objnum = -1;
 
 	//	Maybe pick a new enemy, unless targeting has been taken over by scripting
-	if ( turret_should_pick_new_target(ss) && !ss->scripting_target_override ) {
+	if ( turret_should_pick_new_target(ss) && !ss->scripting_target_override && turret_batch_may_search(ss, parent_objnum) ) {
 		Num_find_turret_enemy++;
 		int objnum = find_turret_enemy(ss, parent_objnum, &gpos, &gvec, ss->turret_enemy_objnum);
 		//Assert(objnum < 0 || is_target_beam_valid(tp, objnum));
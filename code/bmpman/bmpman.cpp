@@ -23,6 +23,7 @@
 #include "ddsutils/ddsutils.h"
 #include "debugconsole/console.h"
 #include "globalincs/systemvars.h"
+#include "globalincs/workerpool.h"
 #include "graphics/2d.h"
 #include "graphics/grinternal.h"
 #include "io/key.h"
@@ -78,6 +79,8 @@ void(*bm_set_components_32)(ubyte *pixel, ubyte *r, ubyte *g, ubyte *b, ubyte *a
 // --------------------------------------------------------------------------------------------------------------------
 // Declaration of protected variables (defined in cmdline.cpp).
 extern int Cmdline_cache_bitmaps;
+extern int Cmdline_mt_loading;
+extern int Cmdline_img2dds;
 
 // --------------------------------------------------------------------------------------------------------------------
 // Definition of public variables (declared as extern in bm_internal.h).
@@ -102,6 +105,57 @@ static int Bm_max_ram = 0;
 static int Bm_ignore_duplicates = 0;
 static int Bm_ignore_load_count = 0;
 
+/**
+ * Image data decoded on the worker pool during bm_page_in_stop(), waiting for bm_lock_*() to take it over.
+ *
+ * @details d_size is the bytes per pixel the image was decoded to, bpp what the reader reported back.
+ */
+typedef struct bm_decoded {
+	ubyte *data;
+	size_t size;
+	int d_size;
+	ubyte bpp;
+	bool ok;
+} bm_decoded;
+
+static bm_decoded Bm_decoded[MAX_BITMAPS];
+
+/**
+ * Texture residency bookkeeping, see bm_residency_touch()
+ *
+ * @details screen_size is the largest size in pixels the bitmap was drawn at during used_frame, or -1 if it was only
+ * used by something that doesn't know its size (the HUD, effects, etc.)
+ */
+typedef struct bm_residency_info {
+	int handle;
+	int used_frame;
+	float screen_size;
+} bm_residency_info;
+
+static bm_residency_info Bm_residency[MAX_BITMAPS];
+static int Bm_residency_frame = 1;
+
+/**
+ * A DDS file being read in the background for bm_residency_request()
+ *
+ * @details Everything the read needs is copied in when it's queued, so the bitmap can go away while it runs. Once done
+ * is set only the main thread touches it again.
+ */
+typedef struct bm_residency_load {
+	int handle;
+	int base_level;
+	char filename[MAX_FILENAME_LEN];
+	int dir_type;
+	size_t size;
+	ubyte *data;
+	bool ok;
+	bool done;
+} bm_residency_load;
+
+static SCP_vector<bm_residency_load *> Bm_residency_loads;
+static worker_mutex *Bm_residency_lock = NULL;
+static worker_queue *Bm_residency_queue = NULL;
+
 // --------------------------------------------------------------------------------------------------------------------
 // Declaration of private functions and templates(declared as static type func(type param);)
 
@@ -359,6 +413,9 @@ void bm_clean_slot(int n) {
 
 void bm_close() {
 	int i;
+
+	bm_residency_close();
+
 	if (bm_inited) {
 		for (i = 0; i<MAX_BITMAPS; i++) {
 			bm_free_data(i);			// clears flags, bbp, data, etc
@@ -1663,6 +1720,38 @@ void bm_lock_ani(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte
 	anim_free(the_anim);
 }
 
+/**
+ * Hands over the image data bm_page_in_stop() decoded ahead of time for bitmap n, provided it was decoded
+ * into a buffer of the size and pixel depth the caller is about to read it into.
+ *
+ * @returns the data, now owned by the bitmap, or NULL if the caller has to read the file itself
+ */
+static ubyte *bm_take_decoded(int n, size_t size, int d_size, ubyte *bpp) {
+	bm_decoded *dec = &Bm_decoded[n];
+	ubyte *data = dec->data;
+
+	if (data == NULL)
+		return NULL;
+
+	dec->data = NULL;
+
+	if (!dec->ok || (dec->size != size) || (dec->d_size != d_size)) {
+		vm_free(data);
+		return NULL;
+	}
+
+#ifdef BMPMAN_NDEBUG
+	Assert(bm_bitmaps[n].data_size == 0);
+	bm_bitmaps[n].data_size += size;
+	bm_texture_ram += size;
+#endif
+
+	if (bpp)
+		*bpp = dec->bpp;
+
+	return data;
+}
+
 void bm_lock_dds(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte bpp, ubyte flags) {
 	ubyte *data = NULL;
 	int error;
@@ -1675,18 +1764,24 @@ void bm_lock_dds(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte
 	Assert(be->mem_taken > 0);
 	Assert(&be->bm == bmp);
 
-	data = (ubyte*)bm_malloc(bitmapnum, be->mem_taken);
+	data = bm_take_decoded(bitmapnum, be->mem_taken, 0, &dds_bpp);
 
-	if (data == NULL)
-		return;
+	if (data != NULL) {
+		error = DDS_ERROR_NONE;
+	} else {
+		data = (ubyte*)bm_malloc(bitmapnum, be->mem_taken);
 
-	memset(data, 0, be->mem_taken);
+		if (data == NULL)
+			return;
 
-	// make sure we are using the correct filename in the case of an EFF.
-	// this will populate filename[] whether it's EFF or not
-	EFF_FILENAME_CHECK;
+		memset(data, 0, be->mem_taken);
 
-	error = dds_read_bitmap(filename, data, &dds_bpp, be->dir_type);
+		// make sure we are using the correct filename in the case of an EFF.
+		// this will populate filename[] whether it's EFF or not
+		EFF_FILENAME_CHECK;
+
+		error = dds_read_bitmap(filename, data, &dds_bpp, be->dir_type);
+	}
 
 #if BYTE_ORDER == BIG_ENDIAN
 	// same as with TGA, we need to byte swap 16 & 32-bit, uncompressed, DDS images
@@ -1738,12 +1833,18 @@ void bm_lock_jpg(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte
 
 	// allocate bitmap data
 	Assert(be->mem_taken > 0);
-	data = (ubyte*)bm_malloc(bitmapnum, be->mem_taken);
+	data = bm_take_decoded(bitmapnum, be->mem_taken, d_size, NULL);
 
-	if (data == NULL)
-		return;
+	if (data != NULL) {
+		jpg_error = JPEG_ERROR_NONE;
+	} else {
+		data = (ubyte*)bm_malloc(bitmapnum, be->mem_taken);
 
-	memset(data, 0, be->mem_taken);
+		if (data == NULL)
+			return;
+
+		memset(data, 0, be->mem_taken);
+	}
 
 	bmp->bpp = bpp;
 	bmp->data = (ptr_u)data;
@@ -1755,7 +1856,8 @@ void bm_lock_jpg(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte
 	// this will populate filename[] whether it's EFF or not
 	EFF_FILENAME_CHECK;
 
-	jpg_error = jpeg_read_bitmap(filename, data, NULL, d_size, be->dir_type);
+	if (jpg_error != JPEG_ERROR_NONE)
+		jpg_error = jpeg_read_bitmap(filename, data, NULL, d_size, be->dir_type);
 
 	if (jpg_error != JPEG_ERROR_NONE) {
 		bm_free_data(bitmapnum);
@@ -1827,10 +1929,15 @@ void bm_lock_png(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte
 	bmp->bpp = 32;
 	d_size = bmp->bpp >> 3;
 	//we waste memory if it turns out to be 24-bit, but the way this whole thing works is dodgy anyway
-	data = (ubyte*)bm_malloc(bitmapnum, bmp->w * bmp->h * d_size);
-	if (data == NULL)
-		return;
-	memset(data, 0, bmp->w * bmp->h * d_size);
+	data = bm_take_decoded(bitmapnum, bmp->w * bmp->h * d_size, d_size, &bmp->bpp);
+	if (data != NULL) {
+		png_error = PNG_ERROR_NONE;
+	} else {
+		data = (ubyte*)bm_malloc(bitmapnum, bmp->w * bmp->h * d_size);
+		if (data == NULL)
+			return;
+		memset(data, 0, bmp->w * bmp->h * d_size);
+	}
 	bmp->data = (ptr_u)data;
 	bmp->palette = NULL;
 
@@ -1841,7 +1948,8 @@ void bm_lock_png(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte
 	EFF_FILENAME_CHECK;
 
 	//bmp->bpp gets set correctly in here after reading into memory
-	png_error = png_read_bitmap(filename, data, &bmp->bpp, d_size, be->dir_type);
+	if (png_error != PNG_ERROR_NONE)
+		png_error = png_read_bitmap(filename, data, &bmp->bpp, d_size, be->dir_type);
 
 	if (png_error != PNG_ERROR_NONE) {
 		bm_free_data(bitmapnum);
@@ -1855,7 +1963,7 @@ void bm_lock_png(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte
 
 void bm_lock_tga(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte bpp, ubyte flags) {
 	ubyte *data = NULL;
-	int d_size, byte_size;
+	int d_size, byte_size, tga_error;
 	char filename[MAX_FILENAME_LEN];
 
 	// Unload any existing data
@@ -1873,13 +1981,17 @@ void bm_lock_tga(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte
 	Assert(byte_size);
 	Assert(be->mem_taken > 0);
 
-	data = (ubyte*)bm_malloc(bitmapnum, be->mem_taken);
+	d_size = byte_size;
+	data = bm_take_decoded(bitmapnum, be->mem_taken, d_size, NULL);
+	tga_error = (data != NULL) ? TARGA_ERROR_NONE : TARGA_ERROR_READING;
+
+	if (data == NULL) {
+		data = (ubyte*)bm_malloc(bitmapnum, be->mem_taken);
+
+		if (data == NULL)
+			return;
 
-	if (data) {
 		memset(data, 0, be->mem_taken);
-		d_size = byte_size;
-	} else {
-		return;
 	}
 
 	bmp->bpp = bpp;
@@ -1891,13 +2003,12 @@ void bm_lock_tga(int handle, int bitmapnum, bitmap_entry *be, bitmap *bmp, ubyte
 	Assert(be->data_size > 0);
 #endif
 
-	int tga_error;
-
 	// make sure we are using the correct filename in the case of an EFF.
 	// this will populate filename[] whether it's EFF or not
 	EFF_FILENAME_CHECK;
 
-	tga_error = targa_read_bitmap(filename, data, NULL, d_size, be->dir_type);
+	if (tga_error != TARGA_ERROR_NONE)
+		tga_error = targa_read_bitmap(filename, data, NULL, d_size, be->dir_type);
 
 	if (tga_error != TARGA_ERROR_NONE) {
 		bm_free_data(bitmapnum);
@@ -2076,8 +2187,131 @@ void bm_page_in_start() {
 	gr_bm_page_in_start();
 }
 
+static void bm_page_in_decode_job(void *data, int index) {
+	int n = (*(SCP_vector<int> *)data)[index];
+	bitmap_entry *be = &bm_bitmaps[n];
+	bm_decoded *dec = &Bm_decoded[n];
+
+	switch (be->type) {
+	case BM_TYPE_TGA:
+		dec->ok = (targa_read_bitmap(be->filename, dec->data, NULL, dec->d_size, be->dir_type) == TARGA_ERROR_NONE);
+		break;
+
+	case BM_TYPE_PNG:
+		dec->ok = (png_read_bitmap(be->filename, dec->data, &dec->bpp, dec->d_size, be->dir_type) == PNG_ERROR_NONE);
+		break;
+
+	case BM_TYPE_JPG:
+		dec->ok = (jpeg_read_bitmap(be->filename, dec->data, NULL, dec->d_size, be->dir_type) == JPEG_ERROR_NONE);
+		break;
+
+	default:
+		dec->ok = (dds_read_bitmap(be->filename, dec->data, &dec->bpp, be->dir_type) == DDS_ERROR_NONE);
+		break;
+	}
+}
+
+// bm_page_in_stop() decodes this many textures, or this much data, at a time, so only one batch
+// of decoded images is ever held in memory waiting to be uploaded
+#define BM_PAGE_IN_BATCH_COUNT	64
+#define BM_PAGE_IN_BATCH_BYTES	(64 * 1024 * 1024)
+
+/**
+ * Decodes the image files of the next batch of textures about to be preloaded on the worker pool, so
+ * that all the main thread has left to do in bm_page_in_stop() is convert and upload them.
+ *
+ * @details Buffers are sized the way bm_lock_*() will ask for them, assuming the 16 bpp request the
+ * texture cache makes for normal textures.  Anything locked differently just reads its file as usual.
+ *
+ * @param first The first bitmap slot to look at
+ * @returns One past the last slot in the batch, always more than first
+ */
+static int bm_page_in_decode(int first) {
+	SCP_vector<int> jobs;
+	size_t batch_bytes = 0;
+	int i;
+
+	for (i = first; i < MAX_BITMAPS; i++) {
+		if ( !jobs.empty() && ((jobs.size() >= BM_PAGE_IN_BATCH_COUNT) || (batch_bytes >= BM_PAGE_IN_BATCH_BYTES)) )
+			break;
+
+
+		bitmap_entry *be = &bm_bitmaps[i];
+		bm_decoded *dec = &Bm_decoded[i];
+
+		// interface graphics (preloaded == 2) are locked as 8 bit alpha and are small anyway
+		if ((be->preloaded != 1) || (be->bm.data != 0))
+			continue;
+
+		ubyte true_bpp = MAX(be->bm.true_bpp, 16);
+
+		switch (be->type) {
+		case BM_TYPE_TGA:
+		case BM_TYPE_JPG:
+			// -img2dds compresses these from its own read
+			if (Cmdline_img2dds)
+				continue;
+
+			dec->size = be->mem_taken;
+			dec->d_size = true_bpp >> 3;
+			break;
+
+		case BM_TYPE_PNG:
+			dec->size = be->bm.w * be->bm.h * 4;
+			dec->d_size = 4;
+			break;
+
+		case BM_TYPE_DDS:
+		case BM_TYPE_DXT1:
+		case BM_TYPE_DXT3:
+		case BM_TYPE_DXT5:
+		case BM_TYPE_CUBEMAP_DDS:
+		case BM_TYPE_CUBEMAP_DXT1:
+		case BM_TYPE_CUBEMAP_DXT3:
+		case BM_TYPE_CUBEMAP_DXT5:
+			dec->size = be->mem_taken;
+			dec->d_size = 0;
+			break;
+
+		default:
+			continue;
+		}
+
+		if (dec->size == 0)
+			continue;
+
+		dec->data = (ubyte *)vm_malloc(dec->size);
+		memset(dec->data, 0, dec->size);
+		dec->bpp = 0;
+		dec->ok = false;
+
+		jobs.push_back(i);
+		batch_bytes += dec->size;
+	}
+
+	if (!jobs.empty())
+		worker_pool_run(bm_page_in_decode_job, &jobs, (int)jobs.size());
+
+	return MAX(i, first + 1);
+}
+
+// frees whatever bm_page_in_decode() decoded in [first, last) that nothing locked
+static void bm_page_in_decode_free(int first, int last) {
+	int i;
+
+	for (i = first; i < last; i++) {
+		if (Bm_decoded[i].data != NULL) {
+			vm_free(Bm_decoded[i].data);
+			Bm_decoded[i].data = NULL;
+		}
+	}
+}
+
 void bm_page_in_stop() {
 	int i;
+	uint start, decode_start, decode_us = 0;
+	bool decode = (Cmdline_mt_loading && !Is_standalone);
+	int batch_first = 0, batch_last = 0;
 
 #ifndef NDEBUG
 	char busy_text[60];
@@ -2085,12 +2319,24 @@ void bm_page_in_stop() {
 
 	nprintf(("BmpInfo", "BMPMAN: Loading all used bitmaps.\n"));
 
+	start = timer_get_high_res_microseconds();
+
 	// Load all the ones that are supposed to be loaded for this level.
 	int n = 0;
 
 	int bm_preloading = 1;
 
 	for (i = 0; i < MAX_BITMAPS; i++) {
+		// the last batch has been uploaded, so drop what it didn't use and decode the next one
+		if (decode && (i == batch_last)) {
+			bm_page_in_decode_free(batch_first, batch_last);
+
+			decode_start = timer_get_high_res_microseconds();
+			batch_first = i;
+			batch_last = bm_page_in_decode(i);
+			decode_us += timer_get_high_res_microseconds() - decode_start;
+		}
+
 		if ((bm_bitmaps[i].type != BM_TYPE_NONE) && (bm_bitmaps[i].type != BM_TYPE_RENDER_TARGET_DYNAMIC) && (bm_bitmaps[i].type != BM_TYPE_RENDER_TARGET_STATIC)) {
 			if (bm_bitmaps[i].preloaded) {
 				if (bm_preloading) {
@@ -2128,6 +2374,10 @@ void bm_page_in_stop() {
 		}
 	}
 
+	bm_page_in_decode_free(0, MAX_BITMAPS);
+
+	load_stats_add(LOAD_STATS_TEXTURES, n, decode_us, timer_get_high_res_microseconds() - start - decode_us);
+
 	nprintf(("BmpInfo", "BMPMAN: Loaded %d bitmaps that are marked as used for this level.\n", n));
 
 	int total_bitmaps = 0;
@@ -2404,6 +2654,179 @@ int bm_reload(int bitmap_handle, const char* filename) {
 	return bitmap_handle;
 }
 
+static void bm_residency_load_job(void *data, int /*index*/) {
+	bm_residency_load *load = (bm_residency_load *)data;
+
+	load->ok = (dds_read_bitmap(load->filename, load->data, NULL, load->dir_type) == DDS_ERROR_NONE);
+
+	worker_mutex_lock(Bm_residency_lock);
+	load->done = true;
+	worker_mutex_unlock(Bm_residency_lock);
+}
+
+void bm_residency_close() {
+	size_t i;
+
+	if (Bm_residency_queue == NULL) {
+		return;
+	}
+
+	// waits for the read in progress, the rest never start
+	worker_queue_destroy(Bm_residency_queue);
+	Bm_residency_queue = NULL;
+
+	for (i = 0; i < Bm_residency_loads.size(); i++) {
+		vm_free(Bm_residency_loads[i]->data);
+		delete Bm_residency_loads[i];
+	}
+
+	Bm_residency_loads.clear();
+
+	worker_mutex_destroy(Bm_residency_lock);
+	Bm_residency_lock = NULL;
+}
+
+bool bm_residency_collect(int *handle, int *base_level, ubyte **data) {
+	size_t i;
+
+	worker_mutex_lock(Bm_residency_lock);
+
+	for (i = 0; i < Bm_residency_loads.size(); i++) {
+		bm_residency_load *load = Bm_residency_loads[i];
+
+		if ( !load->done ) {
+			continue;
+		}
+
+		Bm_residency_loads.erase(Bm_residency_loads.begin() + i);
+		i--;
+
+		// the bitmap may have been released or reused while the file was read
+		if ( !load->ok || (bm_bitmaps[load->handle % MAX_BITMAPS].handle != load->handle) ) {
+			vm_free(load->data);
+			delete load;
+			continue;
+		}
+
+		worker_mutex_unlock(Bm_residency_lock);
+
+		*handle = load->handle;
+		*base_level = load->base_level;
+		*data = load->data;
+
+		delete load;
+
+		return true;
+	}
+
+	worker_mutex_unlock(Bm_residency_lock);
+
+	return false;
+}
+
+int bm_residency_frame() {
+	return Bm_residency_frame;
+}
+
+void bm_residency_get(int handle, int *used_frame, float *screen_size) {
+	int n = handle % MAX_BITMAPS;
+
+	Assert(n >= 0);
+
+	if (Bm_residency[n].handle != handle) {
+		*used_frame = -1;
+		*screen_size = -1.0f;
+		return;
+	}
+
+	*used_frame = Bm_residency[n].used_frame;
+	*screen_size = Bm_residency[n].screen_size;
+}
+
+void bm_residency_next_frame() {
+	Bm_residency_frame++;
+}
+
+int bm_residency_pending() {
+	int pending;
+
+	worker_mutex_lock(Bm_residency_lock);
+	pending = (int)Bm_residency_loads.size();
+	worker_mutex_unlock(Bm_residency_lock);
+
+	return pending;
+}
+
+bool bm_residency_request(int handle, int base_level) {
+	int n = handle % MAX_BITMAPS;
+	size_t i;
+
+	Assert(n >= 0);
+	Assert(bm_bitmaps[n].handle == handle);
+
+	switch (bm_bitmaps[n].type) {
+	case BM_TYPE_DDS:
+	case BM_TYPE_DXT1:
+	case BM_TYPE_DXT3:
+	case BM_TYPE_DXT5:
+		break;
+
+	default:
+		return false;
+	}
+
+	if (Bm_residency_queue == NULL) {
+		Bm_residency_lock = worker_mutex_create();
+		Bm_residency_queue = worker_queue_create();
+	}
+
+	worker_mutex_lock(Bm_residency_lock);
+
+	for (i = 0; i < Bm_residency_loads.size(); i++) {
+		if (Bm_residency_loads[i]->handle == handle) {
+			worker_mutex_unlock(Bm_residency_lock);
+			return false;
+		}
+	}
+
+	bm_residency_load *load = new bm_residency_load;
+
+	load->handle = handle;
+	load->base_level = base_level;
+	strcpy_s(load->filename, bm_bitmaps[n].filename);
+	load->dir_type = bm_bitmaps[n].dir_type;
+	load->size = bm_bitmaps[n].mem_taken;
+	load->data = (ubyte *)vm_malloc(load->size);
+	load->ok = false;
+	load->done = false;
+
+	Bm_residency_loads.push_back(load);
+
+	worker_mutex_unlock(Bm_residency_lock);
+
+	worker_queue_push(Bm_residency_queue, bm_residency_load_job, load);
+
+	return true;
+}
+
+void bm_residency_touch(int handle, float screen_size) {
+	int n = handle % MAX_BITMAPS;
+
+	if (n < 0) {
+		return;
+	}
+
+	bm_residency_info *info = &Bm_residency[n];
+
+	if ( (info->handle != handle) || (info->used_frame != Bm_residency_frame) ) {
+		info->handle = handle;
+		info->used_frame = Bm_residency_frame;
+		info->screen_size = screen_size;
+	} else if (screen_size > info->screen_size) {
+		info->screen_size = screen_size;
+	}
+}
+
 void BM_SELECT_ALPHA_TEX_FORMAT() {
 	Gr_current_red = &Gr_ta_red;
 	Gr_current_green = &Gr_ta_green;
@@ -656,6 +656,67 @@ int bm_is_render_target(int handle);
  */
 bool bm_set_render_target(int handle, int face = -1);
 
+/**
+ * @brief Records that a bitmap was drawn this frame, for the texture residency manager
+ *
+ * @param[in] handle      The bitmap
+ * @param[in] screen_size About how many pixels across it covers on screen, or -1 if the caller doesn't know
+ *
+ * @details The graphics code uses this to decide how many mip levels of a texture to keep resident, see
+ * bm_residency_request()
+ */
+void bm_residency_touch(int handle, float screen_size = -1.0f);
+
+/**
+ * @brief Gets the last frame a bitmap was touched in and the largest screen size it was touched with in that frame
+ *
+ * @details used_frame is -1 if it was never touched
+ */
+void bm_residency_get(int handle, int *used_frame, float *screen_size);
+
+/**
+ * @brief Gets the current residency frame number
+ */
+int bm_residency_frame();
+
+/**
+ * @brief Starts a new residency frame, called by the graphics code once every frame
+ */
+void bm_residency_next_frame();
+
+/**
+ * @brief Starts reading the file of a DDS bitmap on the background thread
+ *
+ * @param[in] handle     The bitmap
+ * @param[in] base_level The first mip level the graphics code wants to upload, handed back by bm_residency_collect()
+ *
+ * @returns true if the read was queued, or
+ * @returns false if the bitmap isn't a DDS or a read is already pending for it
+ */
+bool bm_residency_request(int handle, int base_level);
+
+/**
+ * @brief Takes one finished bm_residency_request() read
+ *
+ * @param[out] handle     The bitmap
+ * @param[out] base_level The level passed to bm_residency_request()
+ * @param[out] data       The file data, laid out as bm_lock() would return it. The caller must vm_free() it.
+ *
+ * @returns true if a read was taken, or
+ * @returns false if none are finished. Reads of bitmaps released in the meantime are dropped.
+ */
+bool bm_residency_collect(int *handle, int *base_level, ubyte **data);
+
+/**
+ * @brief Gets the number of reads queued or not yet collected
+ */
+int bm_residency_pending();
+
+/**
+ * @brief Stops the background thread and drops all pending reads
+ */
+void bm_residency_close();
+
 /**
  * @brief Loads and parses an .EFF
  *
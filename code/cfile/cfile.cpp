@@ -26,11 +26,13 @@
 #include <sys/stat.h>
 #include <glob.h>
 #include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 #include "cfile/cfile.h"
 #include "cfile/cfilearchive.h"
 #include "cfile/cfilesystem.h"
+#include "globalincs/workerpool.h"
 #include "osapi/osapi.h"
 #include "parse/encrypt.h"
 
@@ -77,7 +79,7 @@ cf_pathtype Pathtypes[CF_MAX_PATH_TYPES]  = {
 	{ CF_TYPE_SQUAD_IMAGES,			"data" DIR_SEPARATOR_STR "players" DIR_SEPARATOR_STR "squads",				".pcx .png .dds",						CF_TYPE_PLAYERS	},
 	{ CF_TYPE_SINGLE_PLAYERS,		"data" DIR_SEPARATOR_STR "players" DIR_SEPARATOR_STR "single",				".pl2 .cs2 .plr .csg .css",			CF_TYPE_PLAYERS	},
 	{ CF_TYPE_MULTI_PLAYERS,		"data" DIR_SEPARATOR_STR "players" DIR_SEPARATOR_STR "multi",				".plr",								CF_TYPE_PLAYERS	},
-	{ CF_TYPE_CACHE,				"data" DIR_SEPARATOR_STR "cache",											".clr .tmp .bx",					CF_TYPE_DATA	}, 	//clr=cached color
+	{ CF_TYPE_CACHE,				"data" DIR_SEPARATOR_STR "cache",											".clr .tmp .bx .mcc .pcm",					CF_TYPE_DATA	}, 	//clr=cached color
 	{ CF_TYPE_MULTI_CACHE,			"data" DIR_SEPARATOR_STR "multidata",										".pcx .png .dds .fs2 .txt",				CF_TYPE_DATA	},
 	{ CF_TYPE_MISSIONS,				"data" DIR_SEPARATOR_STR "missions",										".fs2 .fc2 .ntl .ssv",				CF_TYPE_DATA	},
 	{ CF_TYPE_CONFIG,				"data" DIR_SEPARATOR_STR "config",											".cfg",								CF_TYPE_DATA	},
@@ -99,6 +101,9 @@ char Cfile_stack[CFILE_STACK_MAX][CFILE_ROOT_DIRECTORY_LEN];
 Cfile_block Cfile_block_list[MAX_CFILE_BLOCKS];
 CFILE Cfile_list[MAX_CFILE_BLOCKS];
 
+// guards claiming and releasing Cfile_block_list entries, so worker jobs can open files too
+static worker_mutex *Cfile_block_lock = NULL;
+
 const char *Cfile_cdrom_dir = NULL;
 
 //
@@ -109,9 +114,9 @@ CFILE *cf_open_fill_cfblock(FILE * fp, int type);
 CFILE *cf_open_packed_cfblock(FILE *fp, int type, int offset, int size);
 
 #if defined _WIN32
-CFILE *cf_open_mapped_fill_cfblock(HANDLE hFile, int type);
+CFILE *cf_open_mapped_fill_cfblock(HANDLE hFile, int type, int offset = 0, int size = 0);
 #elif defined SCP_UNIX
-CFILE *cf_open_mapped_fill_cfblock(FILE *fp, int type);
+CFILE *cf_open_mapped_fill_cfblock(FILE *fp, int type, int offset = 0, int size = 0);
 #endif
 
 void cf_chksum_long_init();
@@ -119,6 +124,9 @@ void cf_chksum_long_init();
 void cfile_close()
 {
 	cf_free_secondary_filelist();
+
+	worker_mutex_destroy(Cfile_block_lock);
+	Cfile_block_lock = NULL;
 }
 
 // determine if the given path is in a root directory (c:\  or  c:\freespace2.exe  or  c:\fred2.exe   etc)
@@ -182,6 +190,8 @@ int cfile_init(const char *exe_dir, const char *cdrom_dir)
 
 		cfile_inited = 1;
 
+		Cfile_block_lock = worker_mutex_create();
+
 		memset(buf, 0, CFILE_ROOT_DIRECTORY_LEN);
 		strncpy(buf, exe_dir, CFILE_ROOT_DIRECTORY_LEN - 1);
 		i = strlen(buf);
@@ -737,23 +747,21 @@ CFILE *cfopen(const char *file_path, const char *mode, int type, int dir_type, b
 		
 		if ( type & CFILE_MEMORY_MAPPED ) {
 		
-			// Can't open memory mapped files out of pack files
-			if ( offset == 0 )	{
+			// files in a pack file get a view of just their part of the pack file
 #if defined _WIN32
-				HANDLE hFile;
+			HANDLE hFile;
 
-				hFile = CreateFile(longname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			hFile = CreateFile(longname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 
-				if (hFile != INVALID_HANDLE_VALUE)	{
-					return cf_open_mapped_fill_cfblock(hFile, dir_type);
-				}
+			if (hFile != INVALID_HANDLE_VALUE)	{
+				return cf_open_mapped_fill_cfblock(hFile, dir_type, offset, size);
+			}
 #elif defined SCP_UNIX
-				FILE *fp = fopen( longname, "rb" );
-				if (fp) {
-					return cf_open_mapped_fill_cfblock(fp, dir_type);
-				}
+			FILE *fp = fopen( longname, "rb" );
+			if (fp) {
+				return cf_open_mapped_fill_cfblock(fp, dir_type, offset, size);
+			}
 #endif
-			} 
 
 		} else {
 
@@ -851,16 +859,22 @@ int cfget_cfile_block()
 	int i;
 	Cfile_block *cb;
 
+	worker_mutex_lock(Cfile_block_lock);
+
 	for ( i = 0; i < MAX_CFILE_BLOCKS; i++ ) {
 		cb = &Cfile_block_list[i];
 		if ( cb->type == CFILE_BLOCK_UNUSED ) {
 			cb->data = NULL;
+			cb->data_offset = 0;
 			cb->fp = NULL;
 			cb->type = CFILE_BLOCK_USED;
+			worker_mutex_unlock(Cfile_block_lock);
 			return i;
 		}
 	}
 
+	worker_mutex_unlock(Cfile_block_lock);
+
 	// If we've reached this point, a free Cfile_block could not be found
 	nprintf(("Warning","A free Cfile_block could not be found.\n"));
 	Assert(0);	// out of free cfile blocks
@@ -886,7 +900,7 @@ int cfclose( CFILE * cfile )
 	if ( cb->data ) {
 		// close memory mapped file
 #if defined _WIN32
-		result = UnmapViewOfFile((void*)cb->data);
+		result = UnmapViewOfFile((void*)((ubyte*)cb->data - cb->data_offset));
 		Assert(result);
 		result = CloseHandle(cb->hInFile);		
 		Assert(result);	// Ensure file handle is closed properly
@@ -897,7 +911,7 @@ int cfclose( CFILE * cfile )
 		// FIXME: result is wrong after munmap() but it is successful
 		//result = munmap(cb->data, cb->data_length);
 		//Assert(result);
-		munmap(cb->data, cb->data_length);
+		munmap((ubyte*)cb->data - cb->data_offset, cb->data_length);
 		if ( cb->fp != NULL)
 			result = fclose(cb->fp);
 #endif
@@ -909,7 +923,10 @@ int cfclose( CFILE * cfile )
 		// VP  do nothing
 	}
 
+	worker_mutex_lock(Cfile_block_lock);
 	cb->type = CFILE_BLOCK_UNUSED;
+	worker_mutex_unlock(Cfile_block_lock);
+
 	return result;
 }
 
@@ -1011,12 +1028,14 @@ CFILE *cf_open_packed_cfblock(FILE *fp, int type, int offset, int size)
 // cf_open_mapped_fill_cfblock() will fill up a Cfile_block element in the Cfile_block_list[] array
 // for the case of a file being opened by cf_open_mapped();
 //
+// If offset is non-zero, only the 'size' bytes at 'offset' (a file inside a pack file) are mapped.
+//
 // returns:   ptr CFILE structure.  
 //
 #if defined _WIN32
-CFILE *cf_open_mapped_fill_cfblock(HANDLE hFile, int type)
+CFILE *cf_open_mapped_fill_cfblock(HANDLE hFile, int type, int offset, int size)
 #elif defined SCP_UNIX
-CFILE *cf_open_mapped_fill_cfblock(FILE *fp, int type)
+CFILE *cf_open_mapped_fill_cfblock(FILE *fp, int type, int offset, int size)
 #endif
 {
 	int cfile_block_index;
@@ -1044,27 +1063,67 @@ CFILE *cf_open_mapped_fill_cfblock(FILE *fp, int type)
 		cfbp->dir_type = type;
 
 		cf_init_lowlevel_read_code(cfp, 0, 0, 0 );
+
+		// a view has to start on an allocation boundary, so a packed file is mapped from the
+		// boundary before it and data points past the gap
+		size_t view_start, view_length;
 #if defined _WIN32
+		SYSTEM_INFO sys_info;
+		GetSystemInfo(&sys_info);
+
+		view_start = (size_t)offset - ((size_t)offset % sys_info.dwAllocationGranularity);
+		view_length = (offset) ? ((size_t)offset - view_start + size) : 0;
+
+		if ( !offset )
+			size = (int)GetFileSize(cfbp->hInFile, NULL);
+
 		cfbp->hMapFile = CreateFileMapping(cfbp->hInFile, NULL, PAGE_READONLY, 0, 0, NULL);
 		if (cfbp->hMapFile == NULL) { 
 			nprintf(("Error", "Could not create file-mapping object.\n")); 
+			CloseHandle(cfbp->hInFile);
+			cfbp->type = CFILE_BLOCK_UNUSED;
 			return NULL;
 		} 
 	
-		cfbp->data = (ubyte*)MapViewOfFile(cfbp->hMapFile, FILE_MAP_READ, 0, 0, 0);
-		Assert( cfbp->data != NULL );		
+		void *view = MapViewOfFile(cfbp->hMapFile, FILE_MAP_READ, 0, (DWORD)view_start, view_length);
+		if (view == NULL) {
+			nprintf(("Error", "Could not map view of file.\n"));
+			CloseHandle(cfbp->hMapFile);
+			CloseHandle(cfbp->hInFile);
+			cfbp->type = CFILE_BLOCK_UNUSED;
+			return NULL;
+		}
 #elif defined SCP_UNIX
+		size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+		view_start = (size_t)offset - ((size_t)offset % page_size);
+
+		if ( !offset )
+			size = filelength( fileno(fp) );
+
+		view_length = (size_t)offset - view_start + size;
+
 		cfbp->fp = fp;
-		cfbp->data_length = filelength( fileno(fp) );
-		cfbp->data = mmap(NULL,						// start
-								cfbp->data_length,	// length
+		cfbp->data_length = view_length;
+		void *view = mmap(NULL,						// start
+								view_length,			// length
 								PROT_READ,				// prot
 								MAP_SHARED,				// flags
 								fileno(fp),				// fd
-								0);						// offset
-		Assert( cfbp->data != NULL );		
+								(off_t)view_start);	// offset
+		if (view == MAP_FAILED) {
+			nprintf(("Error", "Could not memory map file.\n"));
+			fclose(fp);
+			cfbp->fp = NULL;
+			cfbp->type = CFILE_BLOCK_UNUSED;
+			return NULL;
+		}
 #endif
 
+		cfbp->data_offset = (size_t)offset - view_start;
+		cfbp->data = (ubyte*)view + cfbp->data_offset;
+		cfbp->size = size;
+
 		return cfp;
 	}
 }
@@ -1369,8 +1428,9 @@ int cfilelength( CFILE * cfile )
 	Assert(cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
 	cb = &Cfile_block_list[cfile->id];	
 
-	// TODO: return length of memory mapped file
-	Assert( !cb->data );
+	// memory mapped files know their size too
+	if ( cb->data )
+		return cb->size;
 
 	Assert(cb->fp != NULL);
 
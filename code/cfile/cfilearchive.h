@@ -27,6 +27,7 @@ typedef struct Cfile_block {
 	int		dir_type;		// directory location
 	FILE		*fp;				// File pointer if opening an individual file
 	void		*data;			// Pointer for memory-mapped file access.  NULL if not mem-mapped.
+	size_t	data_offset;	// How far data is into the mapped view (packed files are mapped from a page boundary)
 #ifdef _WIN32
 	HANDLE	hInFile;			// Handle from CreateFile()
 	HANDLE	hMapFile;		// Handle from CreateFileMapping()
@@ -83,6 +83,7 @@ typedef struct cf_file {
 	time_t	write_time;										// When it was last written
 	int		size;												// How big it is in bytes
 	int		pack_offset;									// For pack files, where it is at.   0 if not in a pack file.  This can be used to tell if in a pack file.
+	int		next_same_name;								// Next file (by precedence) with the same name, -1 if none.  See File_index.
 } cf_file;
 
 #define CF_NUM_FILES_PER_BLOCK   512
@@ -95,6 +96,10 @@ typedef struct cf_file_block {
 static uint Num_files = 0;
 static cf_file_block  *File_blocks[CF_MAX_FILE_BLOCKS];
 
+// Lowercased filename -> index of the first (highest precedence) file with that name.  The
+// rest are chained through cf_file::next_same_name in precedence order.  Built by cf_build_file_list().
+static SCP_unordered_map<SCP_string, int> File_index;
+
 
 // Return a pointer to to file 'index'.
 cf_file *cf_get_file(int index)
@@ -123,6 +128,35 @@ cf_file *cf_create_file()
 	return &File_blocks[block]->files[offset];
 }
 
+static void cf_index_key(SCP_string &key, const char *filename)
+{
+	key = filename;
+
+	for (SCP_string::iterator ch = key.begin(); ch != key.end(); ++ch)
+		*ch = (char)tolower(*ch);
+}
+
+// Return the index of the first file named 'filename' (any case) in 'pathtype', or -1 if there isn't one.
+static int cf_index_find(const char *filename, int pathtype)
+{
+	SCP_string key;
+	SCP_unordered_map<SCP_string, int>::iterator it;
+	int index;
+
+	cf_index_key(key, filename);
+
+	it = File_index.find(key);
+	if (it == File_index.end())
+		return -1;
+
+	for (index = it->second; index >= 0; index = cf_get_file(index)->next_same_name) {
+		if ( (pathtype == CF_TYPE_ANY) || (pathtype == cf_get_file(index)->pathtype_index) )
+			return index;
+	}
+
+	return -1;
+}
+
 extern int cfile_inited;
 
 // Create a new root and return a pointer to it.  The structure is assumed unitialized.
@@ -154,6 +188,33 @@ cf_root *cf_create_root()
 	return &Root_blocks[block]->roots[offset];
 }
 
+// Fill in the cf_find_file_location() outputs for a file in the list
+static void cf_get_file_location(cf_file *f, int max_out, char *pack_filename, int *size, int *offset)
+{
+	if (size)
+		*size = f->size;
+
+	if (offset)
+		*offset = f->pack_offset;
+
+	if (pack_filename) {
+		cf_root *r = cf_get_root(f->root_index);
+
+		strncpy( pack_filename, r->path, max_out );
+
+		if (f->pack_offset < 1) {
+			if ( strlen(Pathtypes[f->pathtype_index].path) ) {
+				strcat_s( pack_filename, max_out, Pathtypes[f->pathtype_index].path );
+
+				if ( pack_filename[strlen(pack_filename)-1] != DIR_SEPARATOR_CHAR )
+					strcat_s( pack_filename, max_out, DIR_SEPARATOR_STR );
+			}
+
+			strcat_s( pack_filename, max_out, f->name_ext );
+		}
+	}
+}
+
 // return the # of packfiles which exist
 int cf_get_packfile_count(cf_root *root)
 {
@@ -750,6 +811,31 @@ void cf_search_root_pack(int root_index)
 
 
 
+// Index the files by name.  Going backwards means each chain ends up in precedence order.
+static void cf_build_file_index()
+{
+	SCP_string key;
+	int i;
+
+	File_index.clear();
+
+	for (i = (int)Num_files - 1; i >= 0; i--) {
+		cf_file *f = cf_get_file(i);
+
+		cf_index_key(key, f->name_ext);
+
+		SCP_unordered_map<SCP_string, int>::iterator it = File_index.find(key);
+
+		if (it == File_index.end()) {
+			f->next_same_name = -1;
+			File_index.insert(std::make_pair(key, i));
+		} else {
+			f->next_same_name = it->second;
+			it->second = i;
+		}
+	}
+}
+
 void cf_build_file_list()
 {
 	int i;
@@ -766,6 +852,7 @@ void cf_build_file_list()
 		}
 	}
 
+	cf_build_file_index();
 }
 
 
@@ -819,6 +906,8 @@ void cf_free_secondary_filelist()
 		}
 	}
 	Num_files = 0;
+
+	File_index.clear();
 }
 
 /**
@@ -954,73 +1043,24 @@ int cf_find_file_location( const char *filespec, int pathtype, int max_out, char
 	}
 
 	// Search the pak files and CD-ROM.
-	for (ui = 0; ui < Num_files; ui++ )	{
-		cf_file *f = cf_get_file(ui);
-
-		// only search paths we're supposed to...
-		if ( (pathtype != CF_TYPE_ANY) && (pathtype != f->pathtype_index) )
-			continue;
+	int file_index = cf_index_find(filespec, pathtype);
 
+	if (localize) {
+		// create localized filespec
+		strncpy(longname, filespec, MAX_PATH_LEN - 1);
 
-		if (localize) {
-			// create localized filespec
-			strncpy(longname, filespec, MAX_PATH_LEN - 1);
+		// a localized version wins unless the plain one comes first in the search order
+		if ( lcl_add_dir_to_path_with_filename(longname, MAX_PATH_LEN - 1) ) {
+			int localized_index = cf_index_find(longname, pathtype);
 
-			if ( lcl_add_dir_to_path_with_filename(longname, MAX_PATH_LEN - 1) ) {
-				if ( !stricmp(longname, f->name_ext) ) {
-					if (size)
-						*size = f->size;
-
-					if (offset)
-						*offset = f->pack_offset;
-
-					if (pack_filename) {
-						cf_root *r = cf_get_root(f->root_index);
-
-						strncpy( pack_filename, r->path, max_out );
-
-						if (f->pack_offset < 1) {
-							strcat_s( pack_filename, max_out, Pathtypes[f->pathtype_index].path );
-
-							if ( pack_filename[strlen(pack_filename)-1] != DIR_SEPARATOR_CHAR )
-								strcat_s( pack_filename, max_out, DIR_SEPARATOR_STR );
-
-							strcat_s( pack_filename, max_out, f->name_ext );
-						}
-					}
-
-					return 1;
-				}
-			}
+			if ( (localized_index >= 0) && ((file_index < 0) || (localized_index < file_index)) )
+				file_index = localized_index;
 		}
+	}
 
-		// file either not localized or localized version not found
-		if ( !stricmp(filespec, f->name_ext) ) {
-			if (size)
-				*size = f->size;
-
-			if (offset)
-				*offset = f->pack_offset;
-
-			if (pack_filename) {
-				cf_root *r = cf_get_root(f->root_index);
-
-				strcpy( pack_filename, r->path );
-
-				if (f->pack_offset < 1) {
-					if ( strlen(Pathtypes[f->pathtype_index].path) ) {
-						strcat_s( pack_filename, max_out, Pathtypes[f->pathtype_index].path );
-
-						if ( pack_filename[strlen(pack_filename)-1] != DIR_SEPARATOR_CHAR )
-							strcat_s( pack_filename, max_out, DIR_SEPARATOR_STR );
-					}
-
-					strcat_s( pack_filename, max_out, f->name_ext );
-				}
-			}
-
-			return 1;
-		}
+	if (file_index >= 0) {
+		cf_get_file_location(cf_get_file(file_index), max_out, pack_filename, size, offset);
+		return 1;
 	}
 		
 	return 0;
@@ -1185,38 +1225,43 @@ int cf_find_file_location_ext( const char *filename, const int ext_num, const ch
 	uint filespec_len_big = filespec_len + strlen(ext_list[0]);
 
 	SCP_vector< cf_file* > file_list_index;
+	SCP_vector< int > candidates;
 	int last_root_index = -1;
 	int last_path_index = -1;
 
 	file_list_index.reserve( MIN(ext_num * 4, (int)Num_files) );
 
-	// next, run though and pick out base matches
-	for (ui = 0; ui < Num_files; ui++) {
-		cf_file *f = cf_get_file(ui);
-
-		// ... only search paths that we're supposed to
-		if ( (num_search_dirs == 1) && (pathtype != f->pathtype_index) )
-			continue;
-
+	// next, pick out the base matches for each extension from the file index
+	for (cur_ext = 0; cur_ext < ext_num; cur_ext++) {
 		// ... check that our names are the same length (accounting for the missing extension on our own name)
-		if ( strlen(f->name_ext) != filespec_len_big )
+		if ( (filespec_len + strlen(ext_list[cur_ext])) != filespec_len_big )
 			continue;
 
-		// ... check that we match the base filename
-		if ( strnicmp(f->name_ext, filespec, filespec_len) )
-			continue;
+		strcat_s( filespec, ext_list[cur_ext] );
 
-		// ... make sure that it's one of our supported types
-		bool found_one = false;
-		for (cur_ext = 0; cur_ext < ext_num; cur_ext++) {
-			if ( stristr(f->name_ext, ext_list[cur_ext]) ) {
-				found_one = true;
-				break;
+		SCP_string key;
+		cf_index_key(key, filespec);
+
+		SCP_unordered_map<SCP_string, int>::iterator it = File_index.find(key);
+
+		if (it != File_index.end()) {
+			for (int index = it->second; index >= 0; index = cf_get_file(index)->next_same_name) {
+				// ... only search paths that we're supposed to
+				if ( (num_search_dirs == 1) && (pathtype != cf_get_file(index)->pathtype_index) )
+					continue;
+
+				candidates.push_back(index);
 			}
 		}
 
-		if ( !found_one )
-			continue;
+		filespec[filespec_len] = 0;
+	}
+
+	// put them back into search order
+	std::sort(candidates.begin(), candidates.end());
+
+	for (SCP_vector<int>::iterator ci = candidates.begin(); ci != candidates.end(); ++ci) {
+		cf_file *f = cf_get_file(*ci);
 
 		// ... we check based on location, so if location changes after the first find then bail
 		if (last_root_index == -1) {
@@ -349,11 +349,23 @@ cmdline_parm cache_bitmaps_arg("-cache_bitmaps", NULL, AT_NONE);	// Cmdline_cach
 cmdline_parm img2dds_arg("-img2dds", NULL, AT_NONE);			// Cmdline_img2dds
 cmdline_parm no_fpscap("-no_fps_capping", "Don't limit frames-per-second", AT_NONE);	// Cmdline_NoFPSCap
 cmdline_parm no_vsync_arg("-no_vsync", NULL, AT_NONE);		// Cmdline_no_vsync
+cmdline_parm model_cache_arg("-model_cache", "Keep processed model collision data in data/cache", AT_NONE);	// Cmdline_model_cache
+cmdline_parm sound_cache_arg("-sound_cache", "Keep decoded OGG sounds in data/cache", AT_NONE);	// Cmdline_sound_cache
+cmdline_parm texture_budget_arg("-texture_budget", "Texture memory budget in MB, 0 keeps every texture at full size", AT_INT);	// Cmdline_texture_budget
+cmdline_parm lua_gc_budget_arg("-lua_gc_budget", "Microseconds per frame for script garbage collection, 0 leaves it to Lua", AT_INT);	// Cmdline_lua_gc_budget
+cmdline_parm ai_budget_arg("-ai_budget", "Microseconds per frame for ship AI before distant ships are put off, 0 for no limit", AT_INT);	// Cmdline_ai_budget
+cmdline_parm ai_sched_arg("-ai_sched", "Update the AI of ships far from players and out of combat every few frames", AT_NONE);	// Cmdline_ai_sched
 
 int Cmdline_cache_bitmaps = 0;	// caching of bitmaps between missions (faster loads, can hit swap on reload with <512 Meg RAM though) - taylor
 int Cmdline_img2dds = 0;
 int Cmdline_NoFPSCap = 0; // Disable FPS capping - kazan
 int Cmdline_no_vsync = 0;
+int Cmdline_model_cache = 0;
+int Cmdline_sound_cache = 0;
+int Cmdline_texture_budget = 0;
+int Cmdline_lua_gc_budget = 0;
+int Cmdline_ai_budget = 0;
+int Cmdline_ai_sched = 0;
 
 // HUD related
 cmdline_parm ballistic_gauge("-ballistic_gauge", NULL, AT_NONE);	// Cmdline_ballistic_gauge
@@ -430,6 +442,12 @@ cmdline_parm no_di_mouse_arg("-disable_di_mouse", "Disable DirectInput mouse cod
 cmdline_parm no_drawrangeelements("-use_gldrawelements", NULL, AT_NONE); // Cmdline_drawelements -- Uses glDrawElements instead of glDrawRangeElements
 cmdline_parm keyboard_layout("-keyboard_layout", "Specify keyboard layout (qwertz or azerty)", AT_STRING);
 cmdline_parm old_collision_system("-old_collision", NULL, AT_NONE); // Cmdline_old_collision_sys
+cmdline_parm collision_grid_arg("-collision_grid", NULL, AT_NONE); // Cmdline_collision_grid
+cmdline_parm collision_bvh_arg("-collision_bvh", NULL, AT_NONE); // Cmdline_collision_bvh
+cmdline_parm mt_collisions_arg("-mt_collisions", NULL, AT_NONE); // Cmdline_mt_collisions
+cmdline_parm mt_loading_arg("-mt_loading", "Decode textures, sounds and model collision data on worker threads during mission load", AT_NONE); // Cmdline_mt_loading
+cmdline_parm mt_ai_arg("-mt_ai", "Sense AI enemies on worker threads", AT_NONE); // Cmdline_mt_ai
+cmdline_parm worker_threads_arg("-worker_threads", "Number of worker threads, or -1 to pick one per extra CPU", AT_INT); // Cmdline_worker_threads
 cmdline_parm gl_finish ("-gl_finish", NULL, AT_NONE);
 cmdline_parm no_geo_sdr_effects("-no_geo_effects", NULL, AT_NONE);
 cmdline_parm set_cpu_affinity("-set_cpu_affinity", NULL, AT_NONE);
@@ -481,10 +499,20 @@ cmdline_parm frame_profile_arg("-profile_frame_time", NULL, AT_NONE); //Cmdline_
 cmdline_parm frame_profile_write_file("-profile_write_file", NULL, AT_NONE); // Cmdline_profile_write_file
 cmdline_parm no_unfocused_pause_arg("-no_unfocused_pause", NULL, AT_NONE); //Cmdline_no_unfocus_pause
 cmdline_parm benchmark_mode_arg("-benchmark_mode", NULL, AT_NONE); //Cmdline_benchmark_mode
+cmdline_parm benchmark_mission_arg("-benchmark_mission", "Simulate this mission headless with profiling, then quit", AT_STRING); // Cmdline_benchmark_mission
+cmdline_parm benchmark_frames_arg("-benchmark_frames", "Number of frames -benchmark_mission simulates", AT_INT); // Cmdline_benchmark_frames
+cmdline_parm benchmark_fps_arg("-benchmark_fps", "Fixed framerate -benchmark_mission simulates at", AT_INT); // Cmdline_benchmark_fps
+cmdline_parm benchmark_output_arg("-benchmark_output", "File -benchmark_mission writes its timings to, .csv (default benchmark.csv) or .json", AT_STRING); // Cmdline_benchmark_output
 
 
 char *Cmdline_start_mission = NULL;
 int Cmdline_old_collision_sys = 0;
+int Cmdline_collision_grid = 0;
+int Cmdline_collision_bvh = 0;
+int Cmdline_mt_collisions = 0;
+int Cmdline_mt_loading = 0;
+int Cmdline_mt_ai = 0;
+int Cmdline_worker_threads = -1;
 int Cmdline_dis_collisions = 0;
 int Cmdline_dis_weapons = 0;
 int Cmdline_noparseerrors = 0;
@@ -510,6 +538,10 @@ bool Cmdline_frame_profile = false;
 bool Cmdline_profile_write_file = false;
 bool Cmdline_no_unfocus_pause = false;
 bool Cmdline_benchmark_mode = false;
+char *Cmdline_benchmark_mission = NULL;
+int Cmdline_benchmark_frames = 1000;
+int Cmdline_benchmark_fps = 60;
+char *Cmdline_benchmark_output = NULL;
 
 // Other
 cmdline_parm get_flags_arg("-get_flags", "Output the launcher flags file", AT_NONE);
@@ -1648,9 +1680,51 @@ bool SetCmdlineParams()
 		Cmdline_cache_bitmaps = 1;
 	}
 
+	if ( model_cache_arg.found() ) {
+		Cmdline_model_cache = 1;
+	}
+
+	if ( sound_cache_arg.found() ) {
+		Cmdline_sound_cache = 1;
+	}
+
+	if ( texture_budget_arg.found() ) {
+		Cmdline_texture_budget = MAX(texture_budget_arg.get_int(), 0);
+	}
+
+	if ( lua_gc_budget_arg.found() ) {
+		Cmdline_lua_gc_budget = MAX(lua_gc_budget_arg.get_int(), 0);
+	}
+
+	if ( ai_budget_arg.found() ) {
+		Cmdline_ai_budget = MAX(ai_budget_arg.get_int(), 0);
+	}
+
+	if ( ai_sched_arg.found() ) {
+		Cmdline_ai_sched = 1;
+	}
+
 	if(old_collision_system.found())
 		Cmdline_old_collision_sys = 1;
 
+	if(collision_grid_arg.found())
+		Cmdline_collision_grid = 1;
+
+	if(collision_bvh_arg.found())
+		Cmdline_collision_bvh = 1;
+
+	if(mt_collisions_arg.found())
+		Cmdline_mt_collisions = 1;
+
+	if(mt_loading_arg.found())
+		Cmdline_mt_loading = 1;
+
+	if(mt_ai_arg.found())
+		Cmdline_mt_ai = 1;
+
+	if(worker_threads_arg.found())
+		Cmdline_worker_threads = worker_threads_arg.get_int();
+
 	if(dis_collisions.found())
 		Cmdline_dis_collisions = 1;
 
@@ -1774,6 +1848,31 @@ bool SetCmdlineParams()
 		Cmdline_benchmark_mode = true;
 	}
 
+	if (benchmark_mission_arg.found())
+	{
+		Cmdline_benchmark_mission = benchmark_mission_arg.str();
+
+		// the timings come from the frame profiler, and there is nothing to hear
+		Cmdline_frame_profile = true;
+		Cmdline_freespace_no_sound = 1;
+		Cmdline_freespace_no_music = 1;
+	}
+
+	if (benchmark_frames_arg.found())
+	{
+		Cmdline_benchmark_frames = MAX(benchmark_frames_arg.get_int(), 1);
+	}
+
+	if (benchmark_fps_arg.found())
+	{
+		Cmdline_benchmark_fps = MAX(benchmark_fps_arg.get_int(), 1);
+	}
+
+	if (benchmark_output_arg.found())
+	{
+		Cmdline_benchmark_output = benchmark_output_arg.str();
+	}
+
 	//Deprecated flags - CommanderDJ
 	if( deprecated_spec_arg.found() )
 	{
@@ -86,6 +86,12 @@ extern int Cmdline_cache_bitmaps;
 extern int Cmdline_img2dds;
 extern int Cmdline_NoFPSCap;
 extern int Cmdline_no_vsync;
+extern int Cmdline_model_cache;
+extern int Cmdline_sound_cache;
+extern int Cmdline_texture_budget;
+extern int Cmdline_lua_gc_budget;
+extern int Cmdline_ai_budget;
+extern int Cmdline_ai_sched;
 
 // HUD related
 extern int Cmdline_ballistic_gauge;
@@ -141,6 +147,12 @@ extern bool Cmdline_set_cpu_affinity;
 // Developer/Testing related
 extern char *Cmdline_start_mission;
 extern int Cmdline_old_collision_sys;
+extern int Cmdline_collision_grid;
+extern int Cmdline_collision_bvh;
+extern int Cmdline_mt_collisions;
+extern int Cmdline_mt_loading;
+extern int Cmdline_mt_ai;
+extern int Cmdline_worker_threads;
 extern int Cmdline_dis_collisions;
 extern int Cmdline_dis_weapons;
 extern int Cmdline_noparseerrors;
@@ -162,5 +174,9 @@ extern bool Cmdline_frame_profile;
 extern bool Cmdline_profile_write_file;
 extern bool Cmdline_no_unfocus_pause;
 extern bool Cmdline_benchmark_mode;
+extern char *Cmdline_benchmark_mission;
+extern int Cmdline_benchmark_frames;
+extern int Cmdline_benchmark_fps;
+extern char *Cmdline_benchmark_output;
 
 #endif
@@ -48,6 +48,7 @@
 #include "globalincs/alphacolors.h"
 #include "globalincs/mspdb_callstack.h"
 #include "globalincs/version.h"
+#include "globalincs/workerpool.h"
 #include "graphics/font.h"
 #include "graphics/shadows.h"
 #include "hud/hud.h"
@@ -222,6 +223,8 @@ typedef struct big_expl_flash {
 #define DEFAULT_SKILL_LEVEL	1
 int	Game_skill_level = DEFAULT_SKILL_LEVEL;
 
+#define BENCHMARK_LEVEL_SEED	1	// random seed used by -benchmark_mission
+
 #define EXE_FNAME			("fs2.exe")
 
 #define LAUNCHER_FNAME	("Launcher.exe")
@@ -1262,6 +1265,11 @@ void game_loading_callback_close()
 {
 	Assert( Game_loading_callback_inited==1 );
 
+	// with -lua_gc_budget, do a full collection of script garbage now, rather than a bit of it every frame of the mission
+	if (Cmdline_lua_gc_budget > 0) {
+		Script_system.CollectGarbage();
+	}
+
 	// Make sure bar shows all the way over.
 	game_loading_callback(COUNT_ESTIMATE);
 	
@@ -1431,6 +1439,8 @@ int game_start_mission()
 
 	int s1 __UNUSED = timer_get_milliseconds();
 
+	load_stats_reset();
+
 	// clear post processing settings
 	gr_post_process_set_defaults();
 
@@ -1439,7 +1449,8 @@ int game_start_mission()
 	if ( !(Game_mode & GM_STANDALONE_SERVER) )
 		game_loading_callback_init();
 
-	game_level_init();
+	// a headless benchmark always rolls the same random numbers
+	game_level_init(Cmdline_benchmark_mission ? BENCHMARK_LEVEL_SEED : -1);
 	
 	if (Game_mode & GM_MULTIPLAYER) {
 		Player->flags |= PLAYER_FLAGS_IS_MULTI;
@@ -1451,7 +1462,10 @@ int game_start_mission()
 	game_busy( NOX("** starting mission_load() **") );
 	load_mission_load = (uint) time(NULL);
 	if (mission_load(Game_current_mission_filename)) {
-		if ( !(Game_mode & GM_MULTIPLAYER) ) {
+		if (Cmdline_benchmark_mission) {
+			// nobody is around to dismiss a popup
+			mprintf(("Benchmark: failed to load mission '%s'\n", Game_current_mission_filename));
+		} else if ( !(Game_mode & GM_MULTIPLAYER) ) {
 			popup(PF_BODY_BIG | PF_USE_AFFIRMATIVE_ICON, 1, POPUP_OK, XSTR( "Attempt to load the mission failed", 169));
 			gameseq_post_event(GS_EVENT_MAIN_MENU);
 		} else {
@@ -1490,6 +1504,8 @@ int game_start_mission()
 
 	mprintf(("Level load took %f seconds.\n", (e1 - s1) / 1000.0f ));
 
+	load_stats_report();
+
 	return 1;
 }
 
@@ -1800,6 +1816,7 @@ void game_init()
 	strcat_s(whee, EXE_FNAME);
 
 	profile_init();
+	worker_pool_init(Cmdline_worker_threads);
 	//Initialize the libraries
 	s1 = timer_get_milliseconds();
 
@@ -4115,9 +4132,10 @@ void game_simulation_frame()
 		}
 		
 		// move all the objects now
+		PROFILE("AI Sense", ai_sense_frame());
 		PROFILE("Move Objects - Master", obj_move_all(flFrametime));
 
-		mission_eval_goals();
+		PROFILE("Mission Goals", mission_eval_goals());
 	}
 
 	// always check training objectives, even in multiplayer missions. we need to do this so that the directives gauge works properly on clients
@@ -4449,7 +4467,9 @@ void game_frame(bool paused)
 #endif
 	// start timing frame
 	timing_frame_start();
-	profile_begin("Main Frame");
+
+	static int main_frame_zone = profile_register_zone("Main Frame");
+	profile_begin(main_frame_zone);
 
 	DEBUG_GET_TIME( total_time1 )
 
@@ -4639,7 +4659,7 @@ void game_frame(bool paused)
 	// process lightning (nebula only)
 	nebl_process();
 
-	profile_end("Main Frame");
+	profile_end(main_frame_zone);
 	profile_dump_output();
 
 	DEBUG_GET_TIME( total_time2 )
@@ -7048,6 +7068,102 @@ DCF(pofspew, "Spews POF info without shutting down the game")
 	game_spew_pof_info();
 }
 
+// Fixed length frame for -benchmark_mission, so that every run simulates exactly the same thing
+static void game_set_benchmark_frametime()
+{
+	Frametime = MIN(F1_0 / Cmdline_benchmark_fps, MAX_FRAMETIME);
+	flRealframetime = f2fl(Frametime);
+
+	Last_frame_timestamp = timestamp();
+
+	flFrametime = f2fl(Frametime);
+	timestamp_inc(flFrametime);
+
+	// wrap overall frametime if needed
+	if ( FrametimeOverall > (INT_MAX - F1_0) )
+		FrametimeOverall = 0;
+
+	FrametimeOverall += Frametime;
+}
+
+/**
+ * Runs -benchmark_mission: loads the mission without a window, sound or pilot and simulates it for
+ * -benchmark_frames frames of a fixed length, with the AI flying the player's ship.  Nothing is rendered.
+ * The totals from the frame profiler are written to -benchmark_output, and a trace of the last frames to
+ * benchmark_trace.json.
+ *
+ * @return 0 on success, 1 if the mission couldn't be loaded or the output couldn't be written.  game_main
+ *         passes this back as the process exit code.
+ */
+int game_benchmark_run()
+{
+	const char *output = (Cmdline_benchmark_output != NULL) ? Cmdline_benchmark_output : "benchmark.csv";
+
+	// a blank player, so nothing carries over from a pilot file
+	Player_num = 0;
+	Player = &Players[0];
+	Player->reset();
+	Player->flags |= PLAYER_FLAGS_STRUCTURE_IN_USE;
+	strcpy_s(Player->callsign, "Benchmark");
+
+	Game_mode = GM_NORMAL;
+
+	// nobody is at the controls
+	Player_use_ai = 1;
+
+	strcpy_s(Game_current_mission_filename, Cmdline_benchmark_mission);
+
+	if ( !game_start_mission() ) {
+		return 1;
+	}
+
+	set_current_hud();
+	Game_mode |= GM_IN_MISSION;
+
+	mprintf(("Benchmark: simulating '%s' for %d frames at %d fps\n", Game_current_mission_filename, Cmdline_benchmark_frames, Cmdline_benchmark_fps));
+
+	int start_time = timer_get_milliseconds();
+
+	// drop whatever was profiled while loading
+	profile_dump_output();
+	profile_totals_begin();
+
+	for (int frame = 0; frame < Cmdline_benchmark_frames; frame++) {
+		game_set_benchmark_frametime();
+		game_update_missiontime();
+
+		static int main_frame_zone = profile_register_zone("Main Frame");
+		profile_begin(main_frame_zone);
+
+		if (Missiontime > Entry_delay_time) {
+			Pre_player_entry = 0;
+		}
+
+		shield_frame_init();
+		light_reset();
+
+		PROFILE("Simulation", game_simulation_frame());
+
+		profile_end(main_frame_zone);
+		profile_dump_output();
+
+		Framecount++;
+	}
+
+	profile_totals_end();
+
+	mprintf(("Benchmark: %d frames took %d ms\n", Cmdline_benchmark_frames, timer_get_milliseconds() - start_time));
+
+	bool written = profile_totals_write(output, Cmdline_benchmark_frames, flRealframetime);
+
+	// and the last few frames in full, for looking at spikes
+	profile_trace_write("benchmark_trace.json", 60);
+
+	freespace_stop_mission();
+
+	return written ? 0 : 1;
+}
+
 // returns:
 //		0 on an error
 //		1 on a clean exit
@@ -7168,6 +7284,12 @@ int game_main(char *cmdline)
 		return 0;
 	}
 
+	if (Cmdline_benchmark_mission) {
+		int rval = game_benchmark_run();
+		game_shutdown();
+		return rval;
+	}
+
 	if (!Is_standalone) {
 		movie_play( NOX("intro.mve") );
 	}
@@ -7387,6 +7509,7 @@ void game_shutdown(void)
 {
 	gTirDll_TrackIR.Close( );
 	profile_deinit();
+	worker_pool_close();
 
 	fsspeech_deinit();
 #ifdef FS2_VOICER
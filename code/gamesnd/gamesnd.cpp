@@ -512,15 +512,21 @@ void gamesnd_preload_common_sounds()
 	if ( !Sound_enabled )
 		return;
 
+	SCP_vector<game_snd *> batch;
+
 	Assert( Snds.size() <= INT_MAX );
 	for (SCP_vector<game_snd>::iterator gs = Snds.begin(); gs != Snds.end(); ++gs) {
 		if ( gs->filename[0] != 0 && strnicmp(gs->filename, NOX("none.wav"), 4) ) {
 			if ( gs->preload ) {
-				game_busy( NOX("** preloading common game sounds **") );	// Animate loading cursor... does nothing if loading screen not active.
-				gs->id = snd_load(&(*gs));
+				batch.push_back(&(*gs));
 			}
 		}
 	}
+
+	if ( !batch.empty() ) {
+		game_busy( NOX("** preloading common game sounds **") );	// Animate loading cursor... does nothing if loading screen not active.
+		snd_load_batch(&batch[0], (int)batch.size());
+	}
 }
 
 /**
@@ -531,15 +537,21 @@ void gamesnd_load_gameplay_sounds()
 	if ( !Sound_enabled )
 		return;
 
+	SCP_vector<game_snd *> batch;
+
 	Assert( Snds.size() <= INT_MAX );
 	for (SCP_vector<game_snd>::iterator gs = Snds.begin(); gs != Snds.end(); ++gs) {
 		if ( gs->filename[0] != 0 && strnicmp(gs->filename, NOX("none.wav"), 4) ) {
 			if ( !gs->preload ) { // don't try to load anything that's already preloaded
-				game_busy( NOX("** preloading gameplay sounds **") );		// Animate loading cursor... does nothing if loading screen not active.
-				gs->id = snd_load(&(*gs));
+				batch.push_back(&(*gs));
 			}
 		}
 	}
+
+	if ( !batch.empty() ) {
+		game_busy( NOX("** preloading gameplay sounds **") );		// Animate loading cursor... does nothing if loading screen not active.
+		snd_load_batch(&batch[0], (int)batch.size());
+	}
 }
 
 /**
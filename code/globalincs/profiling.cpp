@@ -8,31 +8,125 @@
 */ 
 
 #include "cmdline/cmdline.h"
+#include "debugconsole/console.h"
 #include "globalincs/pstypes.h"
 #include "globalincs/systemvars.h"
 #include "io/timer.h"
 
 #include <fstream>
+#include <limits.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
 //======================CODE TO PROFILE PERFORMANCE=====================
 
 /*
  * Usage information:
  * In order to gather profiling data for a single function call, you can use the PROFILE macro as defined in
- * pstypes.h.
+ * systemvars.h.
  * Example:
  * PROFILE("Render", game_render_frame( cid ));
  * 
  * If you want to profile a block of function calls, you will need to use the profile_begin()/profile_end() calls.
+ * Register the zone once and keep its id, since looking a zone up by name costs a hash lookup every time.
  * Example:
- * profile_begin("Some Code");
+ * static int zone = profile_register_zone("Some Code");
+ * profile_begin(zone);
  * ...some code...
- * profile_end("Some Code");
- * Note that the parameter passed MUST be globally unique across all instances of profiling invocations.
+ * profile_end(zone);
+ * Note that the name passed MUST be globally unique across all instances of profiling invocations.
  *
  * Profiling invocations can be nested as deep as necessary; this will show up in the readout as indentations.
+ *
+ * Every begin and end is also stamped into a ring buffer belonging to the calling thread, which can be written
+ * out for the last few frames with profile_trace_write() and viewed in Chrome's about:tracing.  Only the main
+ * thread feeds the readout and the totals.
  */
 
+#define PROFILE_MAX_THREADS		32
+#define PROFILE_RING_SIZE		(1 << 16)		// events kept per thread, must be a power of two
+#define PROFILE_FRAME_HISTORY	256				// frame boundaries kept for profile_trace_write()
+
+#define PROFILE_EVENT_BEGIN		0
+#define PROFILE_EVENT_END		1
+
+typedef struct profile_event {
+	uint time;			// in microseconds
+	ushort zone;
+	ushort type;
+} profile_event;
+
+// Written only by its own thread, so recording needs no locking.  Readers should only look at it while the
+// owning thread isn't profiling anything, e.g. between frames.
+typedef struct profile_thread_ring {
+	profile_event events[PROFILE_RING_SIZE];
+	volatile uint head;		// number of events ever written
+} profile_thread_ring;
+
+static profile_thread_ring *Profile_rings[PROFILE_MAX_THREADS];
+static volatile long Profile_num_rings = 0;
+
+// -1 until the thread first records something, -2 if there was no ring left for it
+static SCP_THREAD_LOCAL int Profile_ring_index = -1;
+
+typedef struct profile_counter {
+	int value;
+	int limit;
+} profile_counter;
+
+// main thread only, like the readout itself
+static SCP_map<SCP_string, profile_counter> Profile_counters;
+
+static uint Profile_frame_ends[PROFILE_FRAME_HISTORY];
+static uint Profile_frame_count = 0;
+
+// zone names, registered from any thread
+static volatile long Profile_zone_lock = 0;
+
+static SCP_vector<SCP_string> &profile_zone_names()
+{
+	// constructed on first use, since zones may be registered during static initialization
+	static SCP_vector<SCP_string> names;
+	return names;
+}
+
+static SCP_unordered_map<SCP_string, int> &profile_zone_lookup()
+{
+	static SCP_unordered_map<SCP_string, int> lookup;
+	return lookup;
+}
+
+static long profile_atomic_increment(volatile long *value)
+{
+#ifdef _WIN32
+	return InterlockedIncrement(value);
+#else
+	return __sync_add_and_fetch(value, 1);
+#endif
+}
+
+static void profile_lock_zones()
+{
+#ifdef _WIN32
+	while (InterlockedExchange(&Profile_zone_lock, 1) != 0)
+		;
+#else
+	while (__sync_lock_test_and_set(&Profile_zone_lock, 1) != 0)
+		;
+#endif
+}
+
+static void profile_unlock_zones()
+{
+#ifdef _WIN32
+	InterlockedExchange(&Profile_zone_lock, 0);
+#else
+	__sync_lock_release(&Profile_zone_lock);
+#endif
+}
+
 SCP_vector<profile_sample> samples;
 SCP_vector<profile_sample_history> history;
 
@@ -42,6 +136,56 @@ uint end_profile_time = 0;
 SCP_string profile_output;
 std::ofstream profiling_file;
 
+bool Profile_totals_active = false;
+SCP_vector<profile_sample_total> profile_totals;
+SCP_map<SCP_string, int> profile_totals_lookup;
+
+static void profile_totals_accumulate();
+
+/**
+ * Gets the ring buffer for the calling thread, claiming one the first time through.
+ * @return NULL if every ring is taken
+ */
+static profile_thread_ring *profile_get_thread_ring()
+{
+	if (Profile_ring_index == -1) {
+		long index = profile_atomic_increment(&Profile_num_rings) - 1;
+
+		if (index < PROFILE_MAX_THREADS) {
+			profile_thread_ring *ring = (profile_thread_ring *) vm_malloc(sizeof(profile_thread_ring));
+			ring->head = 0;
+
+			Profile_rings[index] = ring;
+			Profile_ring_index = (int) index;
+		} else {
+			Profile_ring_index = -2;
+		}
+	}
+
+	if (Profile_ring_index < 0) {
+		return NULL;
+	}
+
+	return Profile_rings[Profile_ring_index];
+}
+
+static void profile_record_event(int zone, int type, uint time)
+{
+	profile_thread_ring *ring = profile_get_thread_ring();
+
+	if (ring == NULL) {
+		return;
+	}
+
+	profile_event *event = &ring->events[ring->head & (PROFILE_RING_SIZE - 1)];
+
+	event->time = time;
+	event->zone = (ushort) zone;
+	event->type = (ushort) type;
+
+	ring->head++;
+}
+
 /**
  * @brief Called once at engine initialization to set the timer
  */
@@ -49,6 +193,13 @@ void profile_init()
 {
 	start_profile_time = timer_get_high_res_microseconds();
 
+	// the main thread always gets the first ring
+	if (Cmdline_frame_profile)
+	{
+		profile_get_thread_ring();
+		Assertion(Profile_ring_index == 0, "profile_init() must be called before anything else is profiled!");
+	}
+
 	if (Cmdline_profile_write_file)
 	{
 		profiling_file.open("profiling.csv");
@@ -70,17 +221,68 @@ void profile_deinit()
 			profiling_file.close();
 		}
 	}
+
+	for (int i = 0; i < PROFILE_MAX_THREADS; i++) {
+		if (Profile_rings[i] != NULL) {
+			vm_free(Profile_rings[i]);
+			Profile_rings[i] = NULL;
+		}
+	}
 }
 
 /**
- * Used to start profiling a section of code. A section started by profile_begin needs to be closed off by calling
- * profile_end with the same argument.
+ * Gets the id for a profile zone, registering it if it's new. Safe to call from any thread.
  * @param name A globally unique string that will be displayed in the HUD readout
  */
-void profile_begin(const char* name)
+int profile_register_zone(const char* name)
+{
+	profile_lock_zones();
+
+	SCP_unordered_map<SCP_string, int> &lookup = profile_zone_lookup();
+	SCP_unordered_map<SCP_string, int>::iterator it = lookup.find(name);
+	int zone;
+
+	if (it != lookup.end()) {
+		zone = it->second;
+	} else {
+		zone = (int) profile_zone_names().size();
+		Assertion(zone <= USHRT_MAX, "Too many profile zones!");
+
+		profile_zone_names().push_back(name);
+		lookup[name] = zone;
+	}
+
+	profile_unlock_zones();
+
+	return zone;
+}
+
+static SCP_string profile_zone_name(int zone)
+{
+	profile_lock_zones();
+	SCP_string name(profile_zone_names()[zone]);
+	profile_unlock_zones();
+
+	return name;
+}
+
+/**
+ * Used to start profiling a section of code. A section started by profile_begin needs to be closed off by calling
+ * profile_end with the same zone.
+ * @param zone A zone id from profile_register_zone()
+ */
+void profile_begin(int zone)
 {
 	if (Cmdline_frame_profile)
 	{
+		uint time = timer_get_high_res_microseconds();
+
+		profile_record_event(zone, PROFILE_EVENT_BEGIN, time);
+
+		if (Profile_ring_index != 0) {
+			return;
+		}
+
 		int parent = -1;
 		for (int i = 0; i < (int)samples.size(); i++) {
 			if ( !samples[i].open_profiles ) {
@@ -96,11 +298,11 @@ void profile_begin(const char* name)
 		}
 
 		for(int i = 0; i < (int)samples.size(); i++) {
-			if( !strcmp(samples[i].name.c_str(), name) && samples[i].parent == parent ) {
+			if( (samples[i].zone == zone) && (samples[i].parent == parent) ) {
 				// found the profile sample
 				samples[i].open_profiles++;
 				samples[i].profile_instances++;
-				samples[i].start_time = timer_get_high_res_microseconds();
+				samples[i].start_time = time;
 				Assert(samples[i].open_profiles == 1); // max 1 open at once
 				return;
 			}
@@ -109,11 +311,12 @@ void profile_begin(const char* name)
 		// create a new profile sample
 		profile_sample new_sample;
 
-		new_sample.name = SCP_string(name);
+		new_sample.zone = zone;
+		new_sample.name = profile_zone_name(zone);
 		new_sample.open_profiles = 1;
 		new_sample.profile_instances = 1;
 		new_sample.accumulator = 0;
-		new_sample.start_time = timer_get_high_res_microseconds();
+		new_sample.start_time = time;
 		new_sample.children_sample_time = 0;
 		new_sample.num_children = 0;
 		new_sample.parent = parent;
@@ -123,13 +326,33 @@ void profile_begin(const char* name)
 }
 
 /**
- * Used to end profiling of a section of code. Note that the parameter given MUST match that of the preceding call
- * to profile_begin
+ * Used to start profiling a section of code, looking the zone up by name.
  * @param name A globally unique string that will be displayed in the HUD readout
  */
-void profile_end(const char* name)
+void profile_begin(const char* name)
+{
+	if (Cmdline_frame_profile)
+	{
+		profile_begin(profile_register_zone(name));
+	}
+}
+
+/**
+ * Used to end profiling of a section of code. Note that the zone given MUST match that of the preceding call
+ * to profile_begin
+ * @param zone A zone id from profile_register_zone()
+ */
+void profile_end(int zone)
 {
 	if (Cmdline_frame_profile) {
+		uint end_time = timer_get_high_res_microseconds();
+
+		profile_record_event(zone, PROFILE_EVENT_END, end_time);
+
+		if (Profile_ring_index != 0) {
+			return;
+		}
+
 		int num_parents = 0;
 		int child_of = -1;
 
@@ -142,10 +365,9 @@ void profile_end(const char* name)
 		}
 
 		for ( int i = 0; i < (int)samples.size(); i++ ) {
-			if ( !strcmp(samples[i].name.c_str(), name) && samples[i].parent == child_of ) {
+			if ( (samples[i].zone == zone) && samples[i].parent == child_of ) {
 				int inner = 0;
 				int parent = -1;
-				uint end_time = timer_get_high_res_microseconds();
 				samples[i].open_profiles--;
 
 				// count all parents and find the immediate parent
@@ -190,6 +412,36 @@ void profile_end(const char* name)
 	}
 }
 
+/**
+ * Used to end profiling of a section of code, looking the zone up by name.
+ * @param name A globally unique string that will be displayed in the HUD readout
+ */
+void profile_end(const char* name)
+{
+	if (Cmdline_frame_profile)
+	{
+		profile_end(profile_register_zone(name));
+	}
+}
+
+/**
+ * Sets a named counter shown alongside the profiler readout.
+ * @param name A globally unique string that will be displayed in the HUD readout
+ * @param value The counter's value for this frame
+ * @param limit The value the counter shouldn't go over, or 0 for none
+ */
+void profile_counter_set(const char *name, int value, int limit)
+{
+	if ( !Cmdline_frame_profile ) {
+		return;
+	}
+
+	profile_counter &counter = Profile_counters[name];
+
+	counter.value = value;
+	counter.limit = limit;
+}
+
 /**
  * Builds the output text.
  */
@@ -198,6 +450,9 @@ void profile_dump_output()
 	if (Cmdline_frame_profile) {
 		end_profile_time = timer_get_high_res_microseconds();
 
+		Profile_frame_ends[Profile_frame_count % PROFILE_FRAME_HISTORY] = end_profile_time;
+		Profile_frame_count++;
+
 		if (Cmdline_profile_write_file)
 		{
 			profiling_file << end_profile_time << ";" << (end_profile_time - start_profile_time) << std::endl;
@@ -249,11 +504,165 @@ void profile_dump_output()
 			profile_output += line + indented_name + "\n";
 		}
 
+		if ( !Profile_counters.empty() ) {
+			profile_output += "----------------------------------------\n";
+
+			for (SCP_map<SCP_string, profile_counter>::iterator it = Profile_counters.begin(); it != Profile_counters.end(); ++it) {
+				char line[256];
+
+				if (it->second.limit > 0) {
+					sprintf(line, "%d / %d (%d%%) : ", it->second.value, it->second.limit, (int)(100.0f * i2fl(it->second.value) / i2fl(it->second.limit)));
+				} else {
+					sprintf(line, "%d : ", it->second.value);
+				}
+
+				profile_output += line + it->first + "\n";
+			}
+		}
+
+		if (Profile_totals_active) {
+			profile_totals_accumulate();
+		}
+
 		samples.clear();
 		start_profile_time = timer_get_high_res_microseconds();
 	}
 }
 
+/**
+ * Adds this frame's samples into the running totals. Samples are told apart by their whole path rather than just
+ * their name, so the same name used under two different parents gets two entries.
+ */
+static void profile_totals_accumulate()
+{
+	for (int i = 0; i < (int)samples.size(); i++) {
+		SCP_string path(samples[i].name);
+
+		for (int parent = samples[i].parent; parent >= 0; parent = samples[parent].parent) {
+			path = samples[parent].name + "/" + path;
+		}
+
+		SCP_map<SCP_string, int>::iterator it = profile_totals_lookup.find(path);
+		profile_sample_total *total;
+
+		if (it == profile_totals_lookup.end()) {
+			profile_sample_total new_total;
+
+			new_total.path = path;
+			new_total.num_parents = samples[i].num_parents;
+			new_total.frames = 0;
+			new_total.calls = 0;
+			new_total.total_micro_sec = 0;
+			new_total.self_micro_sec = 0;
+			new_total.min_micro_sec = UINT_MAX;
+			new_total.max_micro_sec = 0;
+
+			profile_totals_lookup[path] = (int)profile_totals.size();
+			profile_totals.push_back(new_total);
+
+			total = &profile_totals.back();
+		} else {
+			total = &profile_totals[it->second];
+		}
+
+		total->frames++;
+		total->calls += samples[i].profile_instances;
+		total->total_micro_sec += samples[i].accumulator;
+		total->self_micro_sec += samples[i].accumulator - samples[i].children_sample_time;
+		total->min_micro_sec = MIN(total->min_micro_sec, samples[i].accumulator);
+		total->max_micro_sec = MAX(total->max_micro_sec, samples[i].accumulator);
+	}
+}
+
+/**
+ * Starts keeping totals of every profile sample across frames, until profile_totals_end() is called. Only has an
+ * effect when frame profiling is enabled.
+ */
+void profile_totals_begin()
+{
+	profile_totals.clear();
+	profile_totals_lookup.clear();
+	Profile_totals_active = true;
+}
+
+/**
+ * Stops keeping totals. The totals so far are kept until the next profile_totals_begin().
+ */
+void profile_totals_end()
+{
+	Profile_totals_active = false;
+}
+
+static SCP_string profile_json_escape(const SCP_string &str)
+{
+	SCP_string out;
+
+	for (size_t i = 0; i < str.size(); i++) {
+		if ((str[i] == '"') || (str[i] == '\\')) {
+			out += '\\';
+		}
+
+		out += str[i];
+	}
+
+	return out;
+}
+
+/**
+ * Writes the totals gathered since profile_totals_begin(). The file is written as JSON if its name ends in ".json"
+ * and as CSV otherwise.
+ * @param filename The file to write, relative to the working directory
+ * @param num_frames How many frames the totals cover, used for the per frame averages
+ * @param frametime Length of each frame in seconds, just recorded in the output
+ * @return false if the file couldn't be opened
+ */
+bool profile_totals_write(const char *filename, int num_frames, float frametime)
+{
+	std::ofstream out(filename);
+
+	if (!out.good()) {
+		mprintf(("Failed to open profile totals file '%s'!\n", filename));
+		return false;
+	}
+
+	size_t len = strlen(filename);
+	bool json = (len >= 5) && !stricmp(filename + len - 5, ".json");
+	num_frames = MAX(num_frames, 1);
+
+	if (json) {
+		out << "{" << std::endl;
+		out << "\t\"frames\": " << num_frames << "," << std::endl;
+		out << "\t\"frametime\": " << frametime << "," << std::endl;
+		out << "\t\"samples\": [" << std::endl;
+	} else {
+		out << "path,depth,frames,calls,total_us,self_us,avg_us,min_us,max_us" << std::endl;
+	}
+
+	for (int i = 0; i < (int)profile_totals.size(); i++) {
+		profile_sample_total *total = &profile_totals[i];
+		ulonglong avg = total->total_micro_sec / num_frames;
+
+		if (json) {
+			out << "\t\t{ \"path\": \"" << profile_json_escape(total->path) << "\", \"depth\": " << total->num_parents
+				<< ", \"frames\": " << total->frames << ", \"calls\": " << total->calls
+				<< ", \"total_us\": " << total->total_micro_sec << ", \"self_us\": " << total->self_micro_sec
+				<< ", \"avg_us\": " << avg << ", \"min_us\": " << total->min_micro_sec << ", \"max_us\": " << total->max_micro_sec
+				<< " }" << ((i + 1 < (int)profile_totals.size()) ? "," : "") << std::endl;
+		} else {
+			out << "\"" << total->path << "\"," << total->num_parents << "," << total->frames << "," << total->calls << ","
+				<< total->total_micro_sec << "," << total->self_micro_sec << "," << avg << ","
+				<< total->min_micro_sec << "," << total->max_micro_sec << std::endl;
+		}
+	}
+
+	if (json) {
+		out << "\t]" << std::endl;
+		out << "}" << std::endl;
+	}
+
+	return true;
+}
+
 /**
  * Stores profile data in in the profile history lookup. This is used internally by the profiling code and should
  * not be called outside of it.
@@ -338,4 +747,148 @@ void get_profile_from_history(SCP_string &name, float* avg, float* min, float* m
 	}
 
 	*avg = *min = *max = 0.0f;
-}
\ No newline at end of file
+}
+/**
+ * Writes what every thread recorded over the last few frames as Chrome trace_event JSON, which can be loaded
+ * into about:tracing. Should be called from the main thread between frames, while nothing else is profiling.
+ * @param filename The file to write, relative to the working directory
+ * @param num_frames How many of the most recent frames to write, up to PROFILE_FRAME_HISTORY
+ * @return false if the file couldn't be opened
+ */
+bool profile_trace_write(const char *filename, int num_frames)
+{
+	std::ofstream out(filename);
+
+	if (!out.good()) {
+		mprintf(("Failed to open profile trace file '%s'!\n", filename));
+		return false;
+	}
+
+	// everything since the end of the frame before the first one wanted
+	uint start_time = 0;
+	num_frames = MIN(MAX(num_frames, 1), PROFILE_FRAME_HISTORY - 1);
+
+	if (Profile_frame_count > (uint) num_frames) {
+		start_time = Profile_frame_ends[(Profile_frame_count - num_frames - 1) % PROFILE_FRAME_HISTORY];
+	}
+
+	int num_rings = MIN((int) Profile_num_rings, PROFILE_MAX_THREADS);
+	bool first = true;
+
+	out << "{ \"traceEvents\": [" << std::endl;
+
+	for (int i = 0; i < num_rings; i++) {
+		profile_thread_ring *ring = Profile_rings[i];
+
+		if (ring == NULL) {
+			continue;
+		}
+
+		out << (first ? "" : ",\n") << "{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i
+			<< ", \"args\": { \"name\": \"" << ((i == 0) ? "Main" : "Worker") << " " << i << "\" } }";
+		first = false;
+
+		uint head = ring->head;
+		uint tail = (head > PROFILE_RING_SIZE) ? (head - PROFILE_RING_SIZE) : 0;
+		int depth = 0;
+
+		for (uint j = tail; j < head; j++) {
+			profile_event *event = &ring->events[j & (PROFILE_RING_SIZE - 1)];
+
+			if (event->time < start_time) {
+				continue;
+			}
+
+			// the begin of this one was before the window, or already overwritten
+			if (event->type == PROFILE_EVENT_END) {
+				if (depth == 0) {
+					continue;
+				}
+
+				depth--;
+			} else {
+				depth++;
+			}
+
+			out << ",\n{ \"name\": \"" << profile_json_escape(profile_zone_name(event->zone)) << "\", \"ph\": \""
+				<< ((event->type == PROFILE_EVENT_BEGIN) ? "B" : "E") << "\", \"ts\": " << event->time
+				<< ", \"pid\": 1, \"tid\": " << i << " }";
+		}
+	}
+
+	out << std::endl << "], \"displayTimeUnit\": \"ms\" }" << std::endl;
+
+	return true;
+}
+
+DCF(profile_trace, "Writes the last few profiled frames to profile_trace.json")
+{
+	int num_frames = 60;
+
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: profile_trace [frames]\n");
+		dc_printf("Writes the last [frames] frames (default 60, at most %d) recorded by the frame profiler to\n", PROFILE_FRAME_HISTORY - 1);
+		dc_printf("profile_trace.json, in the trace format read by Chrome's about:tracing.\n");
+		return;
+	}
+
+	dc_maybe_stuff_int(&num_frames);
+
+	if (!Cmdline_frame_profile) {
+		dc_printf("Nothing is recorded without -profile_frame_time\n");
+		return;
+	}
+
+	if (profile_trace_write("profile_trace.json", num_frames)) {
+		dc_printf("Wrote profile_trace.json\n");
+	}
+}
+
+typedef struct load_stats_entry {
+	int count;
+	uint worker_us;
+	uint main_us;
+} load_stats_entry;
+
+static load_stats_entry Load_stats[NUM_LOAD_STATS];
+
+static const char *Load_stats_names[NUM_LOAD_STATS] = {
+	"Models",
+	"Textures",
+	"Sounds",
+};
+
+/**
+ * @brief Clears the per asset class load timings, called as a mission starts loading
+ */
+void load_stats_reset()
+{
+	memset(Load_stats, 0, sizeof(Load_stats));
+}
+
+/**
+ * @brief Adds to the load timings of an asset class.  Main thread only.
+ */
+void load_stats_add(int load_class, int count, uint worker_us, uint main_us)
+{
+	Assert((load_class >= 0) && (load_class < NUM_LOAD_STATS));
+
+	Load_stats[load_class].count += count;
+	Load_stats[load_class].worker_us += worker_us;
+	Load_stats[load_class].main_us += main_us;
+}
+
+/**
+ * @brief Prints the load timings gathered since load_stats_reset() to the log
+ */
+void load_stats_report()
+{
+	int i;
+
+	mprintf(("Asset load times (worker = decoding on the worker pool, main = main thread):\n"));
+
+	for (i = 0; i < NUM_LOAD_STATS; i++) {
+		mprintf(("  %-10s %5d loaded, worker %8.1f ms, main %8.1f ms\n", Load_stats_names[i], Load_stats[i].count,
+			Load_stats[i].worker_us / 1000.0f, Load_stats[i].main_us / 1000.0f));
+	}
+}
@@ -197,6 +197,7 @@ int current_detail_level();
 // Functions to profile frame performance
 
 typedef struct profile_sample {
+	int zone;
 	uint profile_instances;
 	int open_profiles;
 	//char name[256];
@@ -221,34 +222,67 @@ typedef struct profile_sample_history {
 	uint max_micro_sec;
 } profile_sample_history;
 
+// Totals for one profile sample over a run of frames, see profile_totals_begin()
+typedef struct profile_sample_total {
+	SCP_string path;		// the sample's name, prefixed by those of its parents and separated by '/'
+	uint num_parents;
+	uint frames;			// number of frames the sample was hit in
+	uint calls;
+	ulonglong total_micro_sec;		// including children
+	ulonglong self_micro_sec;		// excluding children
+	uint min_micro_sec;				// per frame, including children
+	uint max_micro_sec;
+} profile_sample_total;
+
 extern SCP_string profile_output;
 
 void profile_init();
 void profile_deinit();
+int profile_register_zone(const char* name);
+void profile_begin(int zone);
 void profile_begin(const char* name);
 void profile_begin(SCP_string &output_handle, const char* name);
+void profile_end(int zone);
 void profile_end(const char* name);
 void profile_dump_output();
 void store_profile_in_history(SCP_string &name, float percent, uint time);
 void get_profile_from_history(SCP_string &name, float* avg, float* min, float* max, uint *avg_micro_sec, uint *min_micro_sec, uint *max_micro_sec);
+void profile_totals_begin();
+void profile_totals_end();
+bool profile_totals_write(const char *filename, int num_frames, float frametime);
+bool profile_trace_write(const char *filename, int num_frames);
+// a value shown below the frame profile, e.g. how much of a memory budget is in use; set it every frame
+void profile_counter_set(const char *name, int value, int limit = 0);
+
+// Time spent loading each class of asset during a mission load, printed by load_stats_report()
+#define LOAD_STATS_MODELS		0
+#define LOAD_STATS_TEXTURES		1
+#define LOAD_STATS_SOUNDS		2
+#define NUM_LOAD_STATS			3
+
+void load_stats_reset();
+// count assets of load_class took worker_us (wall clock) on the worker pool, then main_us on the main thread
+void load_stats_add(int load_class, int count, uint worker_us, uint main_us);
+void load_stats_report();
 
 class profile_auto
 {
-	SCP_string name;
+	int zone;
 public:
-	profile_auto(const char* profile_name): name(profile_name)
+	profile_auto(const char* profile_name): zone(profile_register_zone(profile_name))
 	{
-		profile_begin(profile_name);
+		profile_begin(zone);
 	}
 
 	~profile_auto()
 	{
-		profile_end(name.c_str());
+		profile_end(zone);
 	}
 };
 
 // Helper macro to encapsulate a single function call in a profile_begin()/profile_end() pair.
-#define PROFILE(name, function) { profile_begin(name); function; profile_end(name); }
+// The zone is looked up the first time through and remembered after that.
+#define PROFILE(name, function) { static int _profile_zone = profile_register_zone(name); profile_begin(_profile_zone); function; profile_end(_profile_zone); }
 
 //====================================================================================
 // Memory stuff from WinDebug.cpp
@@ -29,6 +29,15 @@
  */
 #define SCP_FORMAT_STRING_ARGS(formatArg,varArgs)
 
+/**
+ * @brief Marks a variable with static storage duration as thread local
+ *
+ * @details Each thread gets its own copy of the variable. Only use this on
+ *          plain old data types, since not every compiler supports dynamic
+ *          initialization of thread local variables.
+ */
+#define SCP_THREAD_LOCAL
+
 /**
  * @brief Format specifier for a @c size_t argument
  *
@@ -22,6 +22,7 @@
 
 #define __UNUSED __attribute__((__unused__))
 #define __ALIGNED(x)  __attribute__((__aligned__(x)))
+#define SCP_THREAD_LOCAL  __thread
 
 #ifdef NO_RESTRICT_USE
 #   define RESTRICT
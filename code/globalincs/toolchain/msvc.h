@@ -25,6 +25,7 @@
 #define __attribute__(x)
 #define __UNUSED
 #define __ALIGNED(x)  __declspec(align(x))
+#define SCP_THREAD_LOCAL  __declspec(thread)
 
 #ifdef NO_RESTRICT_USE
 #   define RESTRICT
@@ -30,6 +30,7 @@
 #include "osapi/osapi.h"
 #include "globalincs/pstypes.h"
 #include "globalincs/systemvars.h"
+#include "globalincs/workerpool.h"
 #include "cmdline/cmdline.h"
 #include "parse/lua.h"
 #include "parse/parselo.h"
@@ -1578,6 +1579,7 @@ void getmem()
 #ifndef NDEBUG
 
 int TotalRam = 0;
+static worker_mutex *TotalRam_lock = NULL;		// for TotalRam and the malloc registry, since worker jobs allocate too
 #define nNoMansLandSize 4
 
 typedef struct _CrtMemBlockHeader
@@ -1658,6 +1660,9 @@ int vm_init(int min_heap_size)
 {
 	#ifndef NDEBUG
 	TotalRam = 0;
+
+	if (TotalRam_lock == NULL)
+		TotalRam_lock = worker_mutex_create();
 	#endif
 
 	return 1;
@@ -1923,10 +1928,12 @@ void *_vm_malloc( int size, int quiet )
 		Error(LOCATION, "Malloc Failed!\n");
 	}
 #ifndef NDEBUG
+	worker_mutex_lock(TotalRam_lock);
 	TotalRam += size;
 
 	if(Cmdline_show_mem_usage)
 		register_malloc(size, filename, line, ptr);
+	worker_mutex_unlock(TotalRam_lock);
 #endif
 	return ptr;
 }
@@ -1985,9 +1992,11 @@ void _vm_free( void *ptr )
 	_CrtMemBlockHeader *phd = pHdr(ptr);
 	int nSize = phd->nDataSize;
 
+	worker_mutex_lock(TotalRam_lock);
 	TotalRam -= nSize;
 	if(Cmdline_show_mem_usage)
 		unregister_malloc(filename, nSize, ptr);
+	worker_mutex_unlock(TotalRam_lock);
 #endif
 
 	_free_dbg(ptr,_NORMAL_BLOCK);
@@ -2014,9 +2023,11 @@ void *_vm_realloc( void *ptr, int size, int quiet )
 	_CrtMemBlockHeader *phd = pHdr(ptr);
 	int nSize = phd->nDataSize;
 
+	worker_mutex_lock(TotalRam_lock);
 	TotalRam -= nSize;
 	if(Cmdline_show_mem_usage)
 		unregister_malloc(filename, nSize, ptr);
+	worker_mutex_unlock(TotalRam_lock);
 #endif
 
 	ret_ptr = _realloc_dbg(ptr, size,  _NORMAL_BLOCK, __FILE__, __LINE__ );
@@ -2033,11 +2044,13 @@ void *_vm_realloc( void *ptr, int size, int quiet )
 			"virtual memory size, or installing more physical RAM.\n");
 	}
 #ifndef	NDEBUG 
+	worker_mutex_lock(TotalRam_lock);
 	TotalRam += size;
 
 	// register this allocation
 	if(Cmdline_show_mem_usage)
 		register_malloc(size, filename, line, ret_ptr);
+	worker_mutex_unlock(TotalRam_lock);
 #endif
 	return ret_ptr;
 }
@@ -0,0 +1,544 @@
+/*
+ * Copyright (C) Freespace Open 2015.  All rights reserved.
+ *
+ * All source code herein is the property of Freespace Open. You may not sell 
+ * or otherwise commercially exploit the source or things you created based on the 
+ * source.
+ *
+*/ 
+
+#include "globalincs/pstypes.h"
+#include "globalincs/workerpool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+
+static int Worker_num_threads = 0;
+static bool Worker_shutdown = false;
+
+// the job currently being run
+static worker_job_func Worker_func = NULL;
+static void *Worker_data = NULL;
+static int Worker_count = 0;
+static int Worker_next = 0;
+static int Worker_batch_size = 1;
+
+#ifdef _WIN32
+static HANDLE Worker_threads[MAX_WORKER_THREADS];
+static HANDLE Worker_start_sem = NULL;
+static HANDLE Worker_done_sem = NULL;
+static CRITICAL_SECTION Worker_lock;
+
+#define WORKER_LOCK()		EnterCriticalSection(&Worker_lock)
+#define WORKER_UNLOCK()		LeaveCriticalSection(&Worker_lock)
+#define WORKER_WAIT(sem)	WaitForSingleObject(sem, INFINITE)
+#define WORKER_POST(sem)	ReleaseSemaphore(sem, 1, NULL)
+#else
+static SDL_Thread *Worker_threads[MAX_WORKER_THREADS];
+static SDL_sem *Worker_start_sem = NULL;
+static SDL_sem *Worker_done_sem = NULL;
+static SDL_mutex *Worker_lock = NULL;
+
+#define WORKER_LOCK()		SDL_LockMutex(Worker_lock)
+#define WORKER_UNLOCK()		SDL_UnlockMutex(Worker_lock)
+#define WORKER_WAIT(sem)	SDL_SemWait(sem)
+#define WORKER_POST(sem)	SDL_SemPost(sem)
+#endif
+
+
+// hands out the next batch of indices, returns false when there are none left
+static bool worker_pool_next_batch(int *first, int *last)
+{
+	WORKER_LOCK();
+
+	*first = Worker_next;
+	*last = MIN(Worker_next + Worker_batch_size, Worker_count);
+	Worker_next = *last;
+
+	WORKER_UNLOCK();
+
+	return (*first < *last);
+}
+
+static void worker_pool_do_jobs()
+{
+	int first, last, i;
+
+	while ( worker_pool_next_batch(&first, &last) ) {
+		for ( i = first; i < last; i++ ) {
+			Worker_func(Worker_data, i);
+		}
+	}
+}
+
+static int worker_thread_main(void * /*unused*/)
+{
+	for (;;) {
+		WORKER_WAIT(Worker_start_sem);
+
+		if ( Worker_shutdown ) {
+			break;
+		}
+
+		worker_pool_do_jobs();
+
+		WORKER_POST(Worker_done_sem);
+	}
+
+	return 0;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_thread_win32(LPVOID param)
+{
+	return (DWORD)worker_thread_main(param);
+}
+#endif
+
+static int worker_pool_cpu_count()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+
+	return (int)info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (count > 0) ? (int)count : 1;
+#endif
+}
+
+void worker_pool_init(int num_threads)
+{
+	int i;
+
+	if ( Worker_num_threads > 0 ) {
+		worker_pool_close();
+	}
+
+	if ( num_threads < 0 ) {
+		num_threads = worker_pool_cpu_count() - 1;
+	}
+
+	CLAMP(num_threads, 0, MAX_WORKER_THREADS);
+
+	if ( num_threads == 0 ) {
+		return;
+	}
+
+	Worker_shutdown = false;
+
+#ifdef _WIN32
+	InitializeCriticalSection(&Worker_lock);
+	Worker_start_sem = CreateSemaphore(NULL, 0, MAX_WORKER_THREADS, NULL);
+	Worker_done_sem = CreateSemaphore(NULL, 0, MAX_WORKER_THREADS, NULL);
+#else
+	Worker_lock = SDL_CreateMutex();
+	Worker_start_sem = SDL_CreateSemaphore(0);
+	Worker_done_sem = SDL_CreateSemaphore(0);
+#endif
+
+	for ( i = 0; i < num_threads; i++ ) {
+#ifdef _WIN32
+		Worker_threads[i] = CreateThread(NULL, 0, worker_thread_win32, NULL, 0, NULL);
+#else
+		Worker_threads[i] = SDL_CreateThread(worker_thread_main, NULL);
+#endif
+
+		if ( Worker_threads[i] == NULL ) {
+			mprintf(("Unable to create worker thread %d, continuing with %d\n", i, i));
+			break;
+		}
+
+		Worker_num_threads++;
+	}
+
+	mprintf(("Started %d worker threads\n", Worker_num_threads));
+}
+
+void worker_pool_close()
+{
+	int i;
+
+	if ( Worker_num_threads == 0 ) {
+		return;
+	}
+
+	Worker_shutdown = true;
+
+	for ( i = 0; i < Worker_num_threads; i++ ) {
+		WORKER_POST(Worker_start_sem);
+	}
+
+	for ( i = 0; i < Worker_num_threads; i++ ) {
+#ifdef _WIN32
+		WaitForSingleObject(Worker_threads[i], INFINITE);
+		CloseHandle(Worker_threads[i]);
+#else
+		SDL_WaitThread(Worker_threads[i], NULL);
+#endif
+		Worker_threads[i] = NULL;
+	}
+
+#ifdef _WIN32
+	CloseHandle(Worker_start_sem);
+	CloseHandle(Worker_done_sem);
+	DeleteCriticalSection(&Worker_lock);
+#else
+	SDL_DestroySemaphore(Worker_start_sem);
+	SDL_DestroySemaphore(Worker_done_sem);
+	SDL_DestroyMutex(Worker_lock);
+	Worker_lock = NULL;
+#endif
+
+	Worker_start_sem = NULL;
+	Worker_done_sem = NULL;
+	Worker_num_threads = 0;
+}
+
+int worker_pool_num_threads()
+{
+	return Worker_num_threads;
+}
+
+void worker_pool_run(worker_job_func func, void *data, int count, int batch_size)
+{
+	int i;
+
+	Assert( func != NULL );
+	Assert( batch_size > 0 );
+
+	if ( count <= 0 ) {
+		return;
+	}
+
+	// not worth waking anyone up for
+	if ( (Worker_num_threads == 0) || (count <= batch_size) ) {
+		for ( i = 0; i < count; i++ ) {
+			func(data, i);
+		}
+
+		return;
+	}
+
+	Worker_func = func;
+	Worker_data = data;
+	Worker_count = count;
+	Worker_next = 0;
+	Worker_batch_size = batch_size;
+
+	for ( i = 0; i < Worker_num_threads; i++ ) {
+		WORKER_POST(Worker_start_sem);
+	}
+
+	worker_pool_do_jobs();
+
+	for ( i = 0; i < Worker_num_threads; i++ ) {
+		WORKER_WAIT(Worker_done_sem);
+	}
+
+	Worker_func = NULL;
+	Worker_data = NULL;
+}
+
+struct worker_mutex {
+#ifdef _WIN32
+	CRITICAL_SECTION lock;
+#else
+	SDL_mutex *lock;
+#endif
+};
+
+worker_mutex *worker_mutex_create()
+{
+	worker_mutex *mutex = new worker_mutex;
+
+#ifdef _WIN32
+	InitializeCriticalSection(&mutex->lock);
+#else
+	mutex->lock = SDL_CreateMutex();
+#endif
+
+	return mutex;
+}
+
+void worker_mutex_destroy(worker_mutex *mutex)
+{
+	if ( mutex == NULL ) {
+		return;
+	}
+
+#ifdef _WIN32
+	DeleteCriticalSection(&mutex->lock);
+#else
+	SDL_DestroyMutex(mutex->lock);
+#endif
+
+	delete mutex;
+}
+
+void worker_mutex_lock(worker_mutex *mutex)
+{
+	if ( mutex == NULL ) {
+		return;
+	}
+
+#ifdef _WIN32
+	EnterCriticalSection(&mutex->lock);
+#else
+	SDL_LockMutex(mutex->lock);
+#endif
+}
+
+void worker_mutex_unlock(worker_mutex *mutex)
+{
+	if ( mutex == NULL ) {
+		return;
+	}
+
+#ifdef _WIN32
+	LeaveCriticalSection(&mutex->lock);
+#else
+	SDL_UnlockMutex(mutex->lock);
+#endif
+}
+
+typedef struct worker_queue_job {
+	worker_job_func func;
+	void *data;
+	int index;
+} worker_queue_job;
+
+struct worker_queue {
+	SCP_deque<worker_queue_job> jobs;
+	worker_mutex *lock;
+	int running;
+	void *running_data;
+	int waiters;				// threads in worker_queue_wait() for the running job to finish
+	bool shutdown;
+
+#ifdef _WIN32
+	HANDLE thread;
+	HANDLE sem;
+	HANDLE done_sem;
+#else
+	SDL_Thread *thread;
+	SDL_sem *sem;
+	SDL_sem *done_sem;
+#endif
+};
+
+static int worker_queue_main(void *param)
+{
+	worker_queue *queue = (worker_queue *)param;
+	worker_queue_job job;
+	int waiters;
+
+	for (;;) {
+		WORKER_WAIT(queue->sem);
+
+		worker_mutex_lock(queue->lock);
+
+		if ( queue->shutdown ) {
+			worker_mutex_unlock(queue->lock);
+			break;
+		}
+
+		if ( queue->jobs.empty() ) {
+			worker_mutex_unlock(queue->lock);
+			continue;
+		}
+
+		job = queue->jobs.front();
+		queue->jobs.pop_front();
+		queue->running = 1;
+		queue->running_data = job.data;
+
+		worker_mutex_unlock(queue->lock);
+
+		job.func(job.data, job.index);
+
+		worker_mutex_lock(queue->lock);
+		queue->running = 0;
+		queue->running_data = NULL;
+		waiters = queue->waiters;
+		queue->waiters = 0;
+		worker_mutex_unlock(queue->lock);
+
+		// everyone waiting looks again, the job they're after may still be queued
+		while ( waiters-- > 0 ) {
+			WORKER_POST(queue->done_sem);
+		}
+	}
+
+	return 0;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_queue_win32(LPVOID param)
+{
+	return (DWORD)worker_queue_main(param);
+}
+#endif
+
+worker_queue *worker_queue_create()
+{
+	worker_queue *queue = new worker_queue;
+
+	queue->lock = worker_mutex_create();
+	queue->running = 0;
+	queue->running_data = NULL;
+	queue->waiters = 0;
+	queue->shutdown = false;
+
+#ifdef _WIN32
+	queue->sem = CreateSemaphore(NULL, 0, INT_MAX, NULL);
+	queue->done_sem = CreateSemaphore(NULL, 0, INT_MAX, NULL);
+	queue->thread = CreateThread(NULL, 0, worker_queue_win32, queue, 0, NULL);
+#else
+	queue->sem = SDL_CreateSemaphore(0);
+	queue->done_sem = SDL_CreateSemaphore(0);
+	queue->thread = SDL_CreateThread(worker_queue_main, queue);
+#endif
+
+	if ( queue->thread == NULL ) {
+		mprintf(("Unable to create background worker thread, its jobs will run in place\n"));
+	}
+
+	return queue;
+}
+
+void worker_queue_destroy(worker_queue *queue)
+{
+	if ( queue == NULL ) {
+		return;
+	}
+
+	if ( queue->thread != NULL ) {
+		worker_mutex_lock(queue->lock);
+		queue->shutdown = true;
+		worker_mutex_unlock(queue->lock);
+
+		WORKER_POST(queue->sem);
+
+#ifdef _WIN32
+		WaitForSingleObject(queue->thread, INFINITE);
+		CloseHandle(queue->thread);
+#else
+		SDL_WaitThread(queue->thread, NULL);
+#endif
+	}
+
+#ifdef _WIN32
+	CloseHandle(queue->sem);
+	CloseHandle(queue->done_sem);
+#else
+	SDL_DestroySemaphore(queue->sem);
+	SDL_DestroySemaphore(queue->done_sem);
+#endif
+
+	worker_mutex_destroy(queue->lock);
+
+	delete queue;
+}
+
+void worker_queue_push(worker_queue *queue, worker_job_func func, void *data, int index)
+{
+	Assert( queue != NULL );
+	Assert( func != NULL );
+
+	// no thread to hand it to
+	if ( queue->thread == NULL ) {
+		func(data, index);
+		return;
+	}
+
+	worker_queue_job job;
+
+	job.func = func;
+	job.data = data;
+	job.index = index;
+
+	worker_mutex_lock(queue->lock);
+	queue->jobs.push_back(job);
+	worker_mutex_unlock(queue->lock);
+
+	WORKER_POST(queue->sem);
+}
+
+int worker_queue_pending(worker_queue *queue)
+{
+	int pending;
+
+	Assert( queue != NULL );
+
+	worker_mutex_lock(queue->lock);
+	pending = (int)queue->jobs.size() + queue->running;
+	worker_mutex_unlock(queue->lock);
+
+	return pending;
+}
+
+// whether a job with this data is queued or running, with the queue locked
+static bool worker_queue_has_data(worker_queue *queue, void *data)
+{
+	if ( queue->running && (queue->running_data == data) ) {
+		return true;
+	}
+
+	for (SCP_deque<worker_queue_job>::iterator it = queue->jobs.begin(); it != queue->jobs.end(); ++it) {
+		if ( it->data == data ) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void worker_queue_wait(worker_queue *queue, void *data)
+{
+	Assert( queue != NULL );
+
+	// jobs ran as they were pushed
+	if ( queue->thread == NULL ) {
+		return;
+	}
+
+	for (;;) {
+		worker_mutex_lock(queue->lock);
+
+		if ( !worker_queue_has_data(queue, data) ) {
+			worker_mutex_unlock(queue->lock);
+			break;
+		}
+
+		queue->waiters++;
+		worker_mutex_unlock(queue->lock);
+
+		WORKER_WAIT(queue->done_sem);
+	}
+}
+
+void worker_memory_barrier()
+{
+#ifdef _WIN32
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+long worker_atomic_add(volatile long *value, long amount)
+{
+#ifdef _WIN32
+	return InterlockedExchangeAdd(value, amount) + amount;
+#else
+	return __sync_add_and_fetch(value, amount);
+#endif
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) Freespace Open 2015.  All rights reserved.
+ *
+ * All source code herein is the property of Freespace Open. You may not sell 
+ * or otherwise commercially exploit the source or things you created based on the 
+ * source.
+ *
+*/ 
+
+#ifndef _WORKERPOOL_H
+#define _WORKERPOOL_H
+
+/*
+ * A small pool of worker threads for splitting independent jobs across CPUs.
+ *
+ * worker_pool_run() calls func(data, index) once for every index in [0, count)
+ * and returns once all of them are done.  The calling thread works on the jobs
+ * too, so with no worker threads everything simply runs in order on the caller.
+ * Jobs must not touch shared game state that anything else is writing to at the
+ * same time; the usual pattern is for every job to only write to its own slot in
+ * an output array that the caller then processes serially.
+ */
+
+#define MAX_WORKER_THREADS		16
+
+typedef void (*worker_job_func)(void *data, int index);
+
+// starts num_threads worker threads, or one less than the number of CPUs if num_threads < 0
+void worker_pool_init(int num_threads = -1);
+void worker_pool_close();
+
+// number of worker threads running, not counting the main thread
+int worker_pool_num_threads();
+
+// runs func for all indices in [0, count), handing out batch_size indices at a time
+void worker_pool_run(worker_job_func func, void *data, int count, int batch_size = 1);
+
+// a plain lock for the few things jobs have to share, e.g. the debug allocator's totals or the open file list.
+// locking a NULL mutex does nothing, so users can be set up before the mutex is.
+struct worker_mutex;
+
+worker_mutex *worker_mutex_create();
+void worker_mutex_destroy(worker_mutex *mutex);
+void worker_mutex_lock(worker_mutex *mutex);
+void worker_mutex_unlock(worker_mutex *mutex);
+
+// a single background thread running queued jobs one at a time, in the order they were
+// pushed, for work that should overlap the frame rather than hold it up (e.g. streaming
+// texture data in).  worker_queue_push() returns at once; the job reports back through
+// its own data.  Destroying a queue waits for the running job but drops the queued ones.
+struct worker_queue;
+
+worker_queue *worker_queue_create();
+void worker_queue_destroy(worker_queue *queue);
+void worker_queue_push(worker_queue *queue, worker_job_func func, void *data, int index = 0);
+
+// number of jobs queued or running
+int worker_queue_pending(worker_queue *queue);
+
+// waits until no job pushed with this data is queued or running
+void worker_queue_wait(worker_queue *queue, void *data);
+
+// for data handed between threads without a lock: makes sure writes before the barrier
+// are seen by other threads before writes after it
+void worker_memory_barrier();
+
+// adds amount to value as a single step, returns the new value
+long worker_atomic_add(volatile long *value, long amount);
+
+#endif // _WORKERPOOL_H
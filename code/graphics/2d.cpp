@@ -882,7 +882,7 @@ static bool gr_init_sub(int mode, int width, int height, int depth, float center
 
 #ifdef WIN32
 	// FRED doesn't need this
-	if ( !Fred_running && !Is_standalone ) {
+	if ( !Fred_running && !Is_standalone && !Cmdline_benchmark_mission ) {
 		// for Windows, we need to do this just before the *_init() calls
 		extern void win32_create_window(int width, int height);
 		win32_create_window( width, height );
@@ -1002,8 +1002,8 @@ bool gr_init(int d_mode, int d_width, int d_height, int d_depth)
 		}
 	}
 
-	// if we are in standalone mode then just use special defaults
-	if (Is_standalone) {
+	// if we are in standalone mode, or simulating a benchmark headless, then just use special defaults
+	if (Is_standalone || Cmdline_benchmark_mission) {
 		mode = GR_STUB;
 		width = 640;
 		height = 480;
@@ -2116,14 +2116,15 @@ void gr_flip()
 	// m!m avoid running CHA_ONFRAME when the "Quit mission" popup is shown. See mantis 2446 for reference
 	if (!quit_mission_popup_shown)
 	{
-		profile_begin("LUA On Frame");
+		static int lua_on_frame_zone = profile_register_zone("LUA On Frame");
+		profile_begin(lua_on_frame_zone);
 		//WMC - Evaluate global hook if not override.
 		Script_system.RunBytecode(Script_globalhook);
 		//WMC - Do conditional hooks. Yippee!
 		Script_system.RunCondition(CHA_ONFRAME);
 		//WMC - Do scripting reset stuff
 		Script_system.EndFrame();
-		profile_end("LUA On Frame");
+		profile_end(lua_on_frame_zone);
 	}
 
 	gr_screen.gf_flip();
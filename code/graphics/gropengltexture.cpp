@@ -11,6 +11,8 @@
 #include <windows.h>
 #endif
 
+#include <algorithm>
+
 #include "bmpman/bmpman.h"
 #include "cmdline/cmdline.h"
 #include "ddsutils/ddsutils.h"
@@ -52,7 +54,20 @@ extern int ENVMAP;
 extern int Interp_multitex_cloakmap;
 
 
+// Texture residency: with -texture_budget, compressed textures with mipmaps only get as many mip levels
+// uploaded as they need for how big they were last drawn, and more are streamed in from their DDS file
+// on a background thread as they get closer.  See opengl_residency_frame().
+#define OPENGL_RESIDENCY_IDLE_FRAMES		120		// frames a texture must go undrawn before it is evicted to meet the budget
+#define OPENGL_RESIDENCY_MIN_SIZE			64		// don't drop mip levels below this many pixels across
+#define OPENGL_RESIDENCY_MAX_PRESSURE		4		// most extra mip levels dropped while over budget
+#define OPENGL_RESIDENCY_PRESSURE_FRAMES	30		// frames between pressure changes
+#define OPENGL_RESIDENCY_MAX_PENDING		4		// background reads in flight at once
+
+static int GL_residency_pressure = 0;			// extra mip levels dropped from sized textures while over budget
+static int GL_residency_pressure_timer = 0;
+
 // forward declarations
+void opengl_residency_frame();
 int opengl_free_texture(tcache_slot_opengl *t);
 void opengl_free_texture_with_handle(int handle);
 void opengl_tcache_get_adjusted_texture_size(int w_in, int h_in, int *w_out, int *h_out);
@@ -256,6 +271,8 @@ void opengl_tcache_frame()
 
 	// make all textures as not used
 	memset( Tex_used_this_frame, 0, MAX_BITMAPS * sizeof(int) );
+
+	opengl_residency_frame();
 }
 
 extern bool GL_initted;
@@ -857,6 +874,57 @@ int opengl_create_texture_sub(int bitmap_handle, int bitmap_type, int bmap_w, in
 	return ret_val;
 }
 
+// whether the residency manager picks how many mip levels of this texture are uploaded
+static bool opengl_residency_streamable(int bitmap_handle, int bitmap_type, int max_levels)
+{
+	if ( (Cmdline_texture_budget <= 0) || (bitmap_type != TCACHE_TYPE_COMPRESSED) || (max_levels <= 1) ) {
+		return false;
+	}
+
+	switch ( bm_is_compressed(bitmap_handle) ) {
+		case DDS_DXT1:
+		case DDS_DXT3:
+		case DDS_DXT5:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+// the first mip level of a streamable texture worth uploading, given how big it was last drawn
+static int opengl_residency_wanted_level(int bitmap_handle, int max_levels)
+{
+	int used_frame, w, h, dim;
+	int level = 0;
+	float screen_size;
+
+	bm_residency_get(bitmap_handle, &used_frame, &screen_size);
+
+	// nothing to go on, e.g. effects and HUD graphics
+	if (screen_size < 0.0f) {
+		return 0;
+	}
+
+	bm_get_info(bitmap_handle, &w, &h);
+	dim = MAX(w, h);
+
+	// keep the smallest level that is still at least as big as the texture is on screen
+	while ( (level < max_levels - 1) && (i2fl(dim >> (level + 1)) >= screen_size) ) {
+		level++;
+	}
+
+	level += GL_residency_pressure;
+
+	while ( (level > 0) && ((dim >> level) < OPENGL_RESIDENCY_MIN_SIZE) ) {
+		level--;
+	}
+
+	CLAMP(level, 0, max_levels - 1);
+
+	return level;
+}
+
 int opengl_create_texture(int bitmap_handle, int bitmap_type, tcache_slot_opengl *tslot)
 {
 	ubyte flags;
@@ -975,6 +1043,10 @@ int opengl_create_texture(int bitmap_handle, int bitmap_type, tcache_slot_opengl
 		}
 	}
 
+	if ( opengl_residency_streamable(bitmap_handle, bitmap_type, max_levels) ) {
+		base_level = MAX(base_level, opengl_residency_wanted_level(bitmap_handle, max_levels));
+	}
+
 	// get final texture size
 	opengl_tcache_get_adjusted_texture_size(max_w, max_h, &final_w, &final_h);
 
@@ -1012,6 +1084,10 @@ int opengl_create_texture(int bitmap_handle, int bitmap_type, tcache_slot_opengl
 	// call the helper
 	int ret_val = opengl_create_texture_sub(bitmap_handle, bitmap_type, bmp->w, bmp->h, final_w, final_h, (ubyte*)bmp->data, tslot, base_level, resize, reload);
 
+	if (ret_val) {
+		tslot->base_level = (ubyte)base_level;
+	}
+
 	// unlock the bitmap
 	bm_unlock(bitmap_handle);
 
@@ -1027,6 +1103,155 @@ int opengl_create_texture(int bitmap_handle, int bitmap_type, tcache_slot_opengl
 	return ret_val;
 }
 
+// re-creates a texture from a bm_residency_request() read, starting at a different mip level
+static void opengl_residency_upload(int bitmap_handle, int base_level, ubyte *data)
+{
+	int n = bm_get_cache_slot(bitmap_handle, 1);
+	tcache_slot_opengl *t = &Textures[n];
+	int max_levels, w, h;
+	ubyte bpp;
+
+	// dropped or already changed since the read was asked for
+	if ( (t->bitmap_handle != bitmap_handle) || (t->texture_id == 0) || (t->base_level == base_level) ) {
+		return;
+	}
+
+	max_levels = bm_get_num_mipmaps(bitmap_handle);
+
+	if (base_level >= max_levels) {
+		return;
+	}
+
+	bm_get_info(bitmap_handle, &w, &h);
+
+	bpp = t->bpp;
+
+	if ( !opengl_free_texture(t) ) {
+		return;
+	}
+
+	t->bpp = bpp;
+	t->mipmap_levels = (ubyte)(max_levels - base_level);
+
+	if ( opengl_create_texture_sub(bitmap_handle, TCACHE_TYPE_COMPRESSED, w, h, w, h, data, t, base_level, 0, 0) ) {
+		t->base_level = (ubyte)base_level;
+	}
+}
+
+struct opengl_residency_lru_less {
+	bool operator()(const std::pair<int, int> &a, const std::pair<int, int> &b) const
+	{
+		return a.first < b.first;
+	}
+};
+
+/**
+ * Keeps texture memory under the -texture_budget, called once a frame after Tex_used_this_frame is cleared.
+ *
+ * Finished background reads are uploaded first.  While over budget, textures that haven't been drawn for a while are
+ * evicted (least recently drawn first) and, if that isn't enough, sized textures are asked to drop mip levels.
+ * Then every streamable texture drawn this frame gets more (or fewer) mip levels read in if its wanted level changed
+ * and the budget has room for it.
+ */
+void opengl_residency_frame()
+{
+	int i, handle, base_level, used_frame;
+	float screen_size;
+	ubyte *data;
+
+	if ( (Cmdline_texture_budget <= 0) || (Textures == NULL) ) {
+		return;
+	}
+
+	int budget = MIN(Cmdline_texture_budget, 2047) * 1024 * 1024;
+	int frame = bm_residency_frame();
+
+	while ( bm_residency_collect(&handle, &base_level, &data) ) {
+		opengl_residency_upload(handle, base_level, data);
+		vm_free(data);
+	}
+
+	if (GL_textures_in > budget) {
+		SCP_vector< std::pair<int, int> > idle;
+
+		for (i = 0; i < MAX_BITMAPS; i++) {
+			tcache_slot_opengl *t = &Textures[i];
+
+			if ( (t->texture_id == 0) || !bm_is_valid(t->bitmap_handle) || bm_is_render_target(t->bitmap_handle) ) {
+				continue;
+			}
+
+			bm_residency_get(t->bitmap_handle, &used_frame, &screen_size);
+
+			if ( (used_frame >= 0) && ((frame - used_frame) < OPENGL_RESIDENCY_IDLE_FRAMES) ) {
+				continue;
+			}
+
+			idle.push_back(std::make_pair(used_frame, i));
+		}
+
+		std::sort(idle.begin(), idle.end(), opengl_residency_lru_less());
+
+		for (i = 0; (i < (int)idle.size()) && (GL_textures_in > budget); i++) {
+			opengl_free_texture(&Textures[idle[i].second]);
+		}
+	}
+
+	if (--GL_residency_pressure_timer <= 0) {
+		GL_residency_pressure_timer = OPENGL_RESIDENCY_PRESSURE_FRAMES;
+
+		if ( (GL_textures_in > budget) && (GL_residency_pressure < OPENGL_RESIDENCY_MAX_PRESSURE) ) {
+			GL_residency_pressure++;
+		} else if ( (GL_textures_in < (budget / 4) * 3) && (GL_residency_pressure > 0) ) {
+			GL_residency_pressure--;
+		}
+	}
+
+	for (i = 0; (i < MAX_BITMAPS) && (bm_residency_pending() < OPENGL_RESIDENCY_MAX_PENDING); i++) {
+		tcache_slot_opengl *t = &Textures[i];
+
+		if ( (t->texture_id == 0) || (t->texture_target != GL_TEXTURE_2D) || !bm_is_valid(t->bitmap_handle) ) {
+			continue;
+		}
+
+		handle = t->bitmap_handle;
+
+		bm_residency_get(handle, &used_frame, &screen_size);
+
+		if (used_frame != frame) {
+			continue;
+		}
+
+		int max_levels = bm_get_num_mipmaps(handle);
+
+		if ( !opengl_residency_streamable(handle, bm_get_tcache_type(handle), max_levels) ) {
+			continue;
+		}
+
+		int wanted = opengl_residency_wanted_level(handle, max_levels);
+
+		if (wanted < t->base_level) {
+			// each level up is four times the size of the one below it
+			float growth = i2fl(t->size) * (powf(4.0f, i2fl(t->base_level - wanted)) - 1.0f);
+
+			if (i2fl(GL_textures_in) + growth > i2fl(budget)) {
+				continue;
+			}
+		} else if ( (wanted == t->base_level) || (GL_textures_in < (budget / 4) * 3) ) {
+			// only bother giving memory back when it's getting tight
+			continue;
+		}
+
+		bm_residency_request(handle, wanted);
+	}
+
+	profile_counter_set("Texture memory (KB)", GL_textures_in / 1024, budget / 1024);
+	profile_counter_set("Texture mip levels dropped", GL_residency_pressure, OPENGL_RESIDENCY_MAX_PRESSURE);
+	profile_counter_set("Texture reads pending", bm_residency_pending());
+
+	bm_residency_next_frame();
+}
+
 // WARNING:  Needs to match what is in bm_internal.h!!!!!
 #define RENDER_TARGET_DYNAMIC	17
 
@@ -1071,6 +1296,8 @@ int gr_opengl_tcache_set_internal(int bitmap_handle, int bitmap_type, float *u_s
 		}
 
 		Tex_used_this_frame[n]++;
+
+		bm_residency_touch(bitmap_handle);
 	}
 	// gah
 	else {
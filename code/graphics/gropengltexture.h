@@ -26,11 +26,12 @@ typedef struct tcache_slot_opengl {
 	ushort w, h;
 	ubyte bpp;
 	ubyte mipmap_levels;
+	ubyte base_level;	// first mip level of the bitmap that was uploaded
 
 	tcache_slot_opengl() :
 		texture_id(0), texture_target(GL_TEXTURE_2D), wrap_mode(GL_REPEAT),
 		u_scale(1.0f), v_scale(1.0f), bitmap_handle(-1), size(0), w(0), h(0),
-		bpp(0), mipmap_levels(0)
+		bpp(0), mipmap_levels(0), base_level(0)
 	{
 	}
 
@@ -47,6 +48,7 @@ typedef struct tcache_slot_opengl {
 		h = 0;
 		bpp = 0;
 		mipmap_levels = 0;
+		base_level = 0;
 	}
 } tcache_slot_opengl;
 
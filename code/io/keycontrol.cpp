@@ -1581,6 +1581,7 @@ void game_process_cheats(int k)
 			if ( (ship_name_lookup(name) == -1) && (ship_find_exited_ship_by_name(name) == -1) )
 			{
 				strcpy_s(shipp->ship_name, name);
+				Ship_lookup_generation++;
 				break;
 			}
 
@@ -38,19 +38,20 @@ typedef struct {
 } cfile_source_mgr;
 
 typedef cfile_source_mgr *cfile_src_ptr;
-struct jpeg_decompress_struct jpeg_info;
-struct jpeg_error_mgr jpeg_err;
+static SCP_THREAD_LOCAL struct jpeg_decompress_struct jpeg_info;
+static SCP_THREAD_LOCAL struct jpeg_error_mgr jpeg_err;
 
 #define INPUT_BUF_SIZE  4096	// choose an efficiently read'able size
 
-static int jpeg_error_code;
+static SCP_THREAD_LOCAL int jpeg_error_code;
 
 // set current error
 #define Jpeg_Set_Error(x)	{ jpeg_error_code = x; }
 
 // error handler stuff, rather than the default, which will screw us
+// (per thread, like the structs above, so bmpman can decode on the worker pool)
 //
-jmp_buf FSJpegError;
+static SCP_THREAD_LOCAL jmp_buf FSJpegError;
 
 // error (exit) handler
 void jpg_error_exit(j_common_ptr cinfo)
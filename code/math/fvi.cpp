@@ -12,6 +12,23 @@
 #include "math/fvi.h"
 #include "math/vecmat.h"
 
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64)
+#include <emmintrin.h>
+#define FVI_USE_SSE2
+
+// the AVX kernel is compiled for its own function only and picked at runtime
+#if defined(_MSC_VER) && (_MSC_VER >= 1700)
+#include <immintrin.h>
+#include <intrin.h>
+#define FVI_USE_AVX
+#define FVI_TARGET_AVX
+#elif defined(__GNUC__) && !defined(__clang__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#include <immintrin.h>
+#define FVI_USE_AVX
+#define FVI_TARGET_AVX	__attribute__((target("avx")))
+#endif
+#endif
+
 
 #define	SMALL_NUM	1E-6
 
@@ -1140,3 +1157,211 @@ int project_point_onto_bbox(const vec3d *mins, const vec3d *maxs, const vec3d *s
 
 	return inside;
 }
+
+void fvi_tri_block_set(fvi_tri_block *block, int lane, const vec3d *v0, const vec3d *v1, const vec3d *v2)
+{
+	Assert((lane >= 0) && (lane < FVI_TRI_BLOCK_SIZE));
+
+	block->v0_x[lane] = v0->xyz.x;
+	block->v0_y[lane] = v0->xyz.y;
+	block->v0_z[lane] = v0->xyz.z;
+	block->e1_x[lane] = v1->xyz.x - v0->xyz.x;
+	block->e1_y[lane] = v1->xyz.y - v0->xyz.y;
+	block->e1_z[lane] = v1->xyz.z - v0->xyz.z;
+	block->e2_x[lane] = v2->xyz.x - v0->xyz.x;
+	block->e2_y[lane] = v2->xyz.y - v0->xyz.y;
+	block->e2_z[lane] = v2->xyz.z - v0->xyz.z;
+}
+
+// Moller-Trumbore, one lane at a time
+static int fvi_ray_triangle_block_scalar(const vec3d *p0, const vec3d *dir, const fvi_tri_block *b, float min_t, float max_t, float edge_tol)
+{
+	int i, mask = 0;
+
+	for (i = 0; i < FVI_TRI_BLOCK_SIZE; i++) {
+		// pvec = dir x e2
+		float px = dir->xyz.y * b->e2_z[i] - dir->xyz.z * b->e2_y[i];
+		float py = dir->xyz.z * b->e2_x[i] - dir->xyz.x * b->e2_z[i];
+		float pz = dir->xyz.x * b->e2_y[i] - dir->xyz.y * b->e2_x[i];
+
+		float det = b->e1_x[i] * px + b->e1_y[i] * py + b->e1_z[i] * pz;
+		if (det == 0.0f)
+			continue;
+
+		float inv_det = 1.0f / det;
+
+		float tx = p0->xyz.x - b->v0_x[i];
+		float ty = p0->xyz.y - b->v0_y[i];
+		float tz = p0->xyz.z - b->v0_z[i];
+
+		float u = (tx * px + ty * py + tz * pz) * inv_det;
+
+		// qvec = tvec x e1
+		float qx = ty * b->e1_z[i] - tz * b->e1_y[i];
+		float qy = tz * b->e1_x[i] - tx * b->e1_z[i];
+		float qz = tx * b->e1_y[i] - ty * b->e1_x[i];
+
+		float v = (dir->xyz.x * qx + dir->xyz.y * qy + dir->xyz.z * qz) * inv_det;
+		float t = (b->e2_x[i] * qx + b->e2_y[i] * qy + b->e2_z[i] * qz) * inv_det;
+
+		if ((u >= -edge_tol) && (v >= -edge_tol) && (u + v <= 1.0f + edge_tol) && (t >= min_t) && (t <= max_t))
+			mask |= (1 << i);
+	}
+
+	return mask;
+}
+
+#ifdef FVI_USE_SSE2
+// four lanes starting at 'first'; returns the lane bits already shifted into place
+static int fvi_ray_triangle_block_sse2(const vec3d *p0, const vec3d *dir, const fvi_tri_block *b, int first, float min_t, float max_t, float edge_tol)
+{
+	const __m128 dx = _mm_set1_ps(dir->xyz.x);
+	const __m128 dy = _mm_set1_ps(dir->xyz.y);
+	const __m128 dz = _mm_set1_ps(dir->xyz.z);
+
+	const __m128 e1x = _mm_loadu_ps(&b->e1_x[first]);
+	const __m128 e1y = _mm_loadu_ps(&b->e1_y[first]);
+	const __m128 e1z = _mm_loadu_ps(&b->e1_z[first]);
+	const __m128 e2x = _mm_loadu_ps(&b->e2_x[first]);
+	const __m128 e2y = _mm_loadu_ps(&b->e2_y[first]);
+	const __m128 e2z = _mm_loadu_ps(&b->e2_z[first]);
+
+	const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+	const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+	const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+	const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+	const __m128 valid = _mm_cmpneq_ps(det, _mm_setzero_ps());
+
+	// zero lanes give inf/nan here but are masked off by 'valid'
+	const __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+	const __m128 tx = _mm_sub_ps(_mm_set1_ps(p0->xyz.x), _mm_loadu_ps(&b->v0_x[first]));
+	const __m128 ty = _mm_sub_ps(_mm_set1_ps(p0->xyz.y), _mm_loadu_ps(&b->v0_y[first]));
+	const __m128 tz = _mm_sub_ps(_mm_set1_ps(p0->xyz.z), _mm_loadu_ps(&b->v0_z[first]));
+
+	const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inv_det);
+
+	const __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+	const __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+	const __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+
+	const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv_det);
+	const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv_det);
+
+	const __m128 neg_tol = _mm_set1_ps(-edge_tol);
+	__m128 hit = _mm_and_ps(valid, _mm_cmpge_ps(u, neg_tol));
+	hit = _mm_and_ps(hit, _mm_cmpge_ps(v, neg_tol));
+	hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f + edge_tol)));
+	hit = _mm_and_ps(hit, _mm_cmpge_ps(t, _mm_set1_ps(min_t)));
+	hit = _mm_and_ps(hit, _mm_cmple_ps(t, _mm_set1_ps(max_t)));
+
+	return _mm_movemask_ps(hit) << first;
+}
+#endif
+
+#ifdef FVI_USE_AVX
+FVI_TARGET_AVX
+static int fvi_ray_triangle_block_avx(const vec3d *p0, const vec3d *dir, const fvi_tri_block *b, float min_t, float max_t, float edge_tol)
+{
+	const __m256 dx = _mm256_set1_ps(dir->xyz.x);
+	const __m256 dy = _mm256_set1_ps(dir->xyz.y);
+	const __m256 dz = _mm256_set1_ps(dir->xyz.z);
+
+	const __m256 e1x = _mm256_loadu_ps(b->e1_x);
+	const __m256 e1y = _mm256_loadu_ps(b->e1_y);
+	const __m256 e1z = _mm256_loadu_ps(b->e1_z);
+	const __m256 e2x = _mm256_loadu_ps(b->e2_x);
+	const __m256 e2y = _mm256_loadu_ps(b->e2_y);
+	const __m256 e2z = _mm256_loadu_ps(b->e2_z);
+
+	const __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+	const __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+	const __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+
+	const __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+	const __m256 valid = _mm256_cmp_ps(det, _mm256_setzero_ps(), _CMP_NEQ_UQ);
+	const __m256 inv_det = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+
+	const __m256 tx = _mm256_sub_ps(_mm256_set1_ps(p0->xyz.x), _mm256_loadu_ps(b->v0_x));
+	const __m256 ty = _mm256_sub_ps(_mm256_set1_ps(p0->xyz.y), _mm256_loadu_ps(b->v0_y));
+	const __m256 tz = _mm256_sub_ps(_mm256_set1_ps(p0->xyz.z), _mm256_loadu_ps(b->v0_z));
+
+	const __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, px), _mm256_mul_ps(ty, py)), _mm256_mul_ps(tz, pz)), inv_det);
+
+	const __m256 qx = _mm256_sub_ps(_mm256_mul_ps(ty, e1z), _mm256_mul_ps(tz, e1y));
+	const __m256 qy = _mm256_sub_ps(_mm256_mul_ps(tz, e1x), _mm256_mul_ps(tx, e1z));
+	const __m256 qz = _mm256_sub_ps(_mm256_mul_ps(tx, e1y), _mm256_mul_ps(ty, e1x));
+
+	const __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), inv_det);
+	const __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inv_det);
+
+	const __m256 neg_tol = _mm256_set1_ps(-edge_tol);
+	__m256 hit = _mm256_and_ps(valid, _mm256_cmp_ps(u, neg_tol, _CMP_GE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(v, neg_tol, _CMP_GE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f + edge_tol), _CMP_LE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, _mm256_set1_ps(min_t), _CMP_GE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, _mm256_set1_ps(max_t), _CMP_LE_OQ));
+
+	return _mm256_movemask_ps(hit);
+}
+
+static bool fvi_cpu_has_avx()
+{
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 1);
+
+	// the CPU must support AVX and the OS must save the ymm registers
+	if ( !(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) )
+		return false;
+
+	return (_xgetbv(0) & 6) == 6;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx") != 0;
+#endif
+}
+#endif
+
+enum { FVI_KERNEL_UNKNOWN = 0, FVI_KERNEL_SCALAR, FVI_KERNEL_SSE2, FVI_KERNEL_AVX };
+static int Fvi_tri_kernel = FVI_KERNEL_UNKNOWN;
+
+static void fvi_pick_tri_kernel()
+{
+	Fvi_tri_kernel = FVI_KERNEL_SCALAR;
+
+#ifdef FVI_USE_SSE2
+	Fvi_tri_kernel = FVI_KERNEL_SSE2;
+#endif
+
+#ifdef FVI_USE_AVX
+	if (fvi_cpu_has_avx())
+		Fvi_tri_kernel = FVI_KERNEL_AVX;
+#endif
+
+	nprintf(("Physics", "FVI: using %s ray-triangle kernel\n", (Fvi_tri_kernel == FVI_KERNEL_AVX) ? "AVX" : (Fvi_tri_kernel == FVI_KERNEL_SSE2) ? "SSE2" : "scalar"));
+}
+
+int fvi_ray_triangle_block(const vec3d *p0, const vec3d *dir, const fvi_tri_block *block, float min_t, float max_t, float edge_tol)
+{
+	// benign if two threads race here, they both pick the same kernel
+	if (Fvi_tri_kernel == FVI_KERNEL_UNKNOWN)
+		fvi_pick_tri_kernel();
+
+	switch (Fvi_tri_kernel) {
+#ifdef FVI_USE_AVX
+		case FVI_KERNEL_AVX:
+			return fvi_ray_triangle_block_avx(p0, dir, block, min_t, max_t, edge_tol);
+#endif
+
+#ifdef FVI_USE_SSE2
+		case FVI_KERNEL_SSE2:
+			return fvi_ray_triangle_block_sse2(p0, dir, block, 0, min_t, max_t, edge_tol) | fvi_ray_triangle_block_sse2(p0, dir, block, 4, min_t, max_t, edge_tol);
+#endif
+
+		default:
+			return fvi_ray_triangle_block_scalar(p0, dir, block, min_t, max_t, edge_tol);
+	}
+}
@@ -132,4 +132,27 @@ void fvi_two_lines_in_3space(const vec3d *p1, const vec3d *v1, const vec3d *p2,
 // return: 1 if inside, 0 otherwise.
 int project_point_onto_bbox(const vec3d *mins, const vec3d *maxs, const vec3d *start, vec3d *box_pt);
 
+// Structure-of-arrays block of triangles for fvi_ray_triangle_block().
+// Each lane holds a triangle as one vertex and the two edges leaving it
+// (v1 - v0 and v2 - v0).  Unused lanes must be zeroed; a degenerate
+// triangle never reports a hit.
+#define FVI_TRI_BLOCK_SIZE	8
+
+typedef struct fvi_tri_block {
+	float v0_x[FVI_TRI_BLOCK_SIZE], v0_y[FVI_TRI_BLOCK_SIZE], v0_z[FVI_TRI_BLOCK_SIZE];
+	float e1_x[FVI_TRI_BLOCK_SIZE], e1_y[FVI_TRI_BLOCK_SIZE], e1_z[FVI_TRI_BLOCK_SIZE];
+	float e2_x[FVI_TRI_BLOCK_SIZE], e2_y[FVI_TRI_BLOCK_SIZE], e2_z[FVI_TRI_BLOCK_SIZE];
+} fvi_tri_block;
+
+// Stores triangle v0,v1,v2 in the given lane of a block
+void fvi_tri_block_set(fvi_tri_block *block, int lane, const vec3d *v0, const vec3d *v1, const vec3d *v2);
+
+// Tests the ray P = p0 + t*dir against every triangle in a block at once.
+// Triangles are two-sided.  A lane hits when the ray crosses the triangle
+// with min_t <= t <= max_t; edge_tol widens the triangle by that fraction of
+// its barycentric range so callers can use this as a conservative filter.
+// Returns a bitmask with bit n set if lane n was hit.
+// Uses AVX when the CPU supports it, otherwise SSE2, otherwise plain C.
+int fvi_ray_triangle_block(const vec3d *p0, const vec3d *dir, const fvi_tri_block *block, float min_t, float max_t, float edge_tol);
+
 #endif
@@ -173,6 +173,14 @@ int Num_mission_events;
 int Num_goals = 0;								// number of goals for this mission
 int Event_index = -1;  // used by sexp code to tell what event it came from
 bool Log_event = false;
+
+// skip event and goal formulas that were false last time when nothing they read has changed since;
+// the check mode evaluates them anyway and complains if the result is different
+bool Skip_unchanged_formulas = true;
+bool Check_unchanged_formulas = false;
+
+DCF_BOOL(skip_unchanged_formulas, Skip_unchanged_formulas);
+DCF_BOOL(check_unchanged_formulas, Check_unchanged_formulas);
 bool Snapshot_all_events = false;
 int Mission_goal_timestamp;
 
@@ -370,6 +378,8 @@ void mission_init_goals()
 		Mission_goals[i].satisfied = GOAL_INCOMPLETE;
 		Mission_goals[i].flags = 0;
 		Mission_goals[i].team = 0;
+		Mission_goals[i].dependencies = -1;
+		Mission_goals[i].dependency_stamp = -1;
 	}
 
 	Num_mission_events = 0;
@@ -381,6 +391,8 @@ void mission_init_goals()
 		Mission_events[i].born_on_date = 0;
 		Mission_events[i].team = -1;
 		Mission_events[i].mission_log_flags = 0;
+		Mission_events[i].dependencies = -1;
+		Mission_events[i].dependency_stamp = -1;
 	}
 
 	Mission_goal_timestamp = timestamp(GOAL_TIMESTAMP);
@@ -878,6 +890,21 @@ void mission_event_unset_directive_special(int event)
 	Mission_directive_special_timestamp = timestamp(-1);
 }
 
+/**
+ * Returns the dependency stamp for the formula, or -1 if it reads state that isn't tracked and
+ * always has to be evaluated
+ */
+static int mission_formula_stamp(int formula, int *dependencies)
+{
+	if (*dependencies < 0)
+		*dependencies = sexp_query_dependencies(formula);
+
+	if (*dependencies & SEXP_DEP_UNTRACKED)
+		return -1;
+
+	return sexp_dependency_stamp(*dependencies);
+}
+
 // function which evaluates and processes the given event
 void mission_process_event( int event )
 {
@@ -886,8 +913,9 @@ void mission_process_event( int event )
 	int store_result = Mission_events[event].result;
 	int store_count = Mission_events[event].count;
 
-	int result, sindex;
+	int result, sindex, stamp = -1;
 	bool bump_timestamp = false; 
+	bool unchanged = false;
 	Log_event = false;
 
 	Directive_count = 0;
@@ -919,6 +947,18 @@ void mission_process_event( int event )
 		}
 	}
 
+	// if the formula was false last time and nothing it reads has changed, it's still false
+	if ((sindex >= 0) && (Skip_unchanged_formulas || Check_unchanged_formulas)) {
+		stamp = mission_formula_stamp(sindex, &Mission_events[event].dependencies);
+
+		if (!result && (stamp >= 0) && (stamp == Mission_events[event].dependency_stamp) && !Snapshot_all_events && (Mission_events[event].mission_log_flags == 0)) {
+			if (Check_unchanged_formulas)
+				unchanged = true;
+			else
+				sindex = -1;  // bypass evaluation
+		}
+	}
+
 	if (sindex >= 0) {
 		Sexp_useful_number = 1;
 		if (Snapshot_all_events || Mission_events[event].mission_log_flags != 0) {
@@ -930,6 +970,11 @@ void mission_process_event( int event )
 		}
 		result = eval_sexp(sindex);
 
+		if (unchanged && result) {
+			Warning(LOCATION, "Event '%s' became true although nothing its formula depends on has changed!", Mission_events[event].name);
+		}
+		Mission_events[event].dependency_stamp = result ? -1 : stamp;
+
 		// if the directive count is a special value, deal with that first.  Mark the event as a special
 		// event, and unmark it when the directive is true again.
 		if ( (Directive_count == DIRECTIVE_WING_ZERO) && !(Mission_events[event].flags & MEF_DIRECTIVE_SPECIAL) ) {			
@@ -1060,7 +1105,27 @@ void mission_eval_goals()
 		}
 
 		if (Mission_goals[i].satisfied == GOAL_INCOMPLETE) {
+			int stamp = -1;
+			bool unchanged = false;
+
+			// same as for events -- a goal that was false stays false until something it reads changes
+			if (Skip_unchanged_formulas || Check_unchanged_formulas) {
+				stamp = mission_formula_stamp(Mission_goals[i].formula, &Mission_goals[i].dependencies);
+
+				if ((stamp >= 0) && (stamp == Mission_goals[i].dependency_stamp)) {
+					if (!Check_unchanged_formulas)
+						continue;
+					unchanged = true;
+				}
+			}
+
 			result = eval_sexp(Mission_goals[i].formula);
+
+			if (unchanged && result) {
+				Warning(LOCATION, "Goal '%s' became true although nothing its formula depends on has changed!", Mission_goals[i].name);
+			}
+			Mission_goals[i].dependency_stamp = result ? -1 : stamp;
+
 			if ( Sexp_nodes[Mission_goals[i].formula].value == SEXP_KNOWN_FALSE ) {
 				mission_goal_status_change( i, GOAL_FAILED );
 
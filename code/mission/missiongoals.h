@@ -61,6 +61,8 @@ typedef struct mission_goal {
 	int	score;							// score for this goal
 	int	flags;							// MGF_
 	int	team;								// which team is this objective for.
+	int	dependencies;					// SEXP_DEP_* flags for the formula, or -1 if not worked out yet
+	int	dependency_stamp;				// sexp_dependency_stamp() when the formula last evaluated false, or -1
 } mission_goal;
 
 extern mission_goal Mission_goals[MAX_GOALS];	// structure for the goals of this mission
@@ -124,6 +126,9 @@ typedef struct mission_event {
 	SCP_vector<SCP_string> backup_log_buffer;
 	int	previous_result;		// result of previous evaluation of event
 
+	int	dependencies;			// SEXP_DEP_* flags for the formula, or -1 if not worked out yet
+	int	dependency_stamp;		// sexp_dependency_stamp() when the formula last evaluated false, or -1
+
 } mission_event;
 
 extern int Num_mission_events;
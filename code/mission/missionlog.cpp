@@ -69,9 +69,13 @@ static fix Log_line_timestamps[MAX_LOG_LINES];
 log_entry log_entries[MAX_LOG_ENTRIES];	// static array because John says....
 int last_entry;
 
+// bumped whenever an entry is added, so sexps that only read the log can tell it hasn't changed
+int Mission_log_generation = 0;
+
 void mission_log_init()
 {
 	last_entry = 0;
+	Mission_log_generation++;
 
 	// zero out all the memory so we don't get bogus information when playing across missions!
 	memset( log_entries, 0, sizeof(log_entries) );
@@ -193,6 +197,7 @@ void mission_log_add_entry(int type, char *pname, char *sname, int info_index)
 	}
 
 	last_entry_save = last_entry;
+	Mission_log_generation++;
 
 	// mark any entries as obsolete.  Part of the pruning is done based on the type (and name) passed
 	// for a new entry
@@ -398,6 +403,8 @@ void mission_log_add_entry_multi( int type, char *pname, char *sname, int index,
 	Assert ( Game_mode & GM_MULTIPLAYER );
 	Assert ( !(Net_player->flags & NETINFO_FLAG_AM_MASTER) );
 
+	Mission_log_generation++;
+
 	// mark any entries as obsolete.  Part of the pruning is done based on the type (and name) passed
 	// for a new entry
 	mission_log_obsolete_entries(type, pname);
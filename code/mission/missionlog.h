@@ -59,6 +59,7 @@ typedef struct {
 
 extern log_entry log_entries[];
 extern int last_entry;
+extern int Mission_log_generation;
 extern int Num_log_lines;
 
 // function prototypes
@@ -1849,6 +1849,7 @@ int parse_create_object_sub(p_object *p_objp)
 	shipp->group = p_objp->group;
 	shipp->team = p_objp->team;
 	strcpy_s(shipp->ship_name, p_objp->name);
+	Ship_lookup_generation++;
 	shipp->escort_priority = p_objp->escort_priority;
 	shipp->use_special_explosion = p_objp->use_special_explosion;
 	shipp->special_exp_damage = p_objp->special_exp_damage;
@@ -5867,6 +5868,9 @@ void post_process_mission()
 		multi_respawn_build_points();
 	}	
 
+	// look up the ships and wings named in the mission's sexps now that they all exist
+	sexp_resolve_handles();
+
 	// maybe reset hotkey defaults when loading new mission
 	if ( Last_file_checksum != Current_file_checksum ){
 		mission_hotkey_reset_saved();
@@ -279,6 +279,39 @@ struct bsp_collision_leaf {
 	int next;
 };
 
+// Flattened bounding volume hierarchy over the polys of a bsp_collision_tree, used
+// instead of the tree's own nodes when -collision_bvh is set.  Nodes are stored
+// breadth first and each one keeps the boxes of up to four children side by side
+// so they can be tested together.
+#define BVH_COLLISION_WIDTH		4
+
+struct bvh_collision_node {
+	float min_x[BVH_COLLISION_WIDTH];
+	float min_y[BVH_COLLISION_WIDTH];
+	float min_z[BVH_COLLISION_WIDTH];
+	float max_x[BVH_COLLISION_WIDTH];
+	float max_y[BVH_COLLISION_WIDTH];
+	float max_z[BVH_COLLISION_WIDTH];
+
+	int first[BVH_COLLISION_WIDTH];		// child node, or first poly if this child is a leaf
+	int count[BVH_COLLISION_WIDTH];		// number of polys in a leaf, -1 for a child node, 0 if unused
+
+	int tri_block[BVH_COLLISION_WIDTH];		// first triangle block of a leaf
+	int num_tri_blocks[BVH_COLLISION_WIDTH];
+	float tri_min_height[BVH_COLLISION_WIDTH];	// shortest altitude of a leaf's triangles, 0 if the kernel can't be trusted on it
+};
+
+struct bvh_collision_poly {
+	vec3d plane_pnt;
+	vec3d plane_norm;
+	float face_rad;
+	int vert_start;						// index into bvh_point_list and bvh_uv_list
+	ubyte num_verts;
+	ubyte tmap_num;
+
+	int leaf;							// the bsp_collision_leaf this poly came from
+};
+
 struct bsp_collision_tree {
 	bsp_collision_node *node_list;
 	int n_nodes;
@@ -291,6 +324,22 @@ struct bsp_collision_tree {
 
 	int n_verts;
 	bool used;
+	bool mapped;						// the lists above point into a model cache file and aren't ours to free
+
+	// optional flattened hierarchy, NULL unless model_collide_build_bvh() was called
+	bvh_collision_node *bvh_node_list;
+	int n_bvh_nodes;
+
+	bvh_collision_poly *bvh_poly_list;
+	int n_bvh_polys;
+
+	vec3d *bvh_point_list;				// poly vertices, stored in poly order
+	uv_pair *bvh_uv_list;
+
+	// each leaf's polys fanned out into triangles, for testing rays a block at a time
+	struct fvi_tri_block *bvh_tri_block_list;
+	ubyte *bvh_tri_poly_list;			// for each triangle, its poly's offset within the leaf (0xff if unused)
+	int n_bvh_tri_blocks;
 };
 
 class bsp_info
@@ -1228,12 +1277,62 @@ inline void mc_info_init(mc_info *mc)
 */
 
 int model_collide(mc_info *mc_info_obj);
+
+// Runs several queries against the same model instance, such as the entry and
+// exit checks of a beam.  results[i] gets what model_collide() would have
+// returned for queries[i].  Plain ray and segment checks of the model's polys
+// are traced together, so the submodels and collision trees are walked once for
+// all of them; anything else goes through model_collide() on its own.  Returns
+// the number of queries that hit.
+int model_collide_batch(mc_info **queries, int *results, int count);
+
+// A model_collide() query evaluated ahead of time, usually on a worker thread.
+// The inputs and the model instance state are copied by value so the entry
+// doesn't depend on anything the caller might change afterwards.
+typedef struct mc_memo_entry {
+	mc_info	before;				// the query as it was handed to model_collide
+	mc_info	after;				// the query once model_collide returned
+	matrix	orient;
+	vec3d	pos;
+	vec3d	p0;
+	vec3d	p1;
+	int		root_blown_off;
+	SCP_vector<submodel_instance> instance_state;
+	int		result;
+} mc_memo_entry;
+
+// While entries is non-NULL, every model_collide() call made on this thread
+// against a model instance is also appended to entries.  Pass NULL to stop.
+// Safe to use from any thread as long as nothing modifies the model instances
+// being checked at the same time.
+void model_collide_memo_record(SCP_vector<mc_memo_entry> *entries);
+
+// Makes a recorded entry available to model_collide().  A later query which
+// matches the entry exactly (inputs, prior outputs and model instance state)
+// gets the recorded result instead of walking the model again.  Main thread only.
+void model_collide_memo_add(const mc_memo_entry *entry);
+
+// Drops all stored entries.  Main thread only.
+void model_collide_memo_clear();
+
 void model_collide_parse_bsp(bsp_collision_tree *tree, void *model_ptr, int version);
 
+void model_collide_build_bvh(bsp_collision_tree *tree);
+void model_collide_free_bvh(bsp_collision_tree *tree);
+
 bsp_collision_tree *model_get_bsp_collision_tree(int tree_index);
 void model_remove_bsp_collision_tree(int tree_index);
 int model_create_bsp_collision_tree();
 
+// -model_cache: collision trees, vertex buffers and octants stored in data/cache, keyed by POF checksum
+bool model_cache_open(polymodel *pm, uint checksum);
+bool model_cache_load_vertex_buffer(polymodel *pm, int mn);
+void model_cache_keep_vertex_buffer(polymodel *pm, int mn);
+bool model_cache_load_octants(polymodel *pm);
+bool model_cache_load_collision(polymodel *pm);
+void model_cache_save(polymodel *pm, uint checksum);
+void model_cache_release(polymodel *pm);
+
 void model_collide_preprocess(matrix *orient, int model_instance_num, int detail = 0);
 
 // Sets the submodel instance data in a submodel
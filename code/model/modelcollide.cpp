@@ -13,12 +13,21 @@
 #define MODEL_LIB
 
 #include "cmdline/cmdline.h"
+#include "debugconsole/console.h"
 #include "graphics/tmapper.h"
+#include "io/timer.h"
 #include "math/fvi.h"
 #include "math/vecmat.h"
 #include "model/model.h"
 #include "model/modelsinc.h"
 
+#include <algorithm>
+
+#if defined(__SSE__) || (_M_IX86_FP >= 1) || defined(_M_X64)
+	#include <xmmintrin.h>
+	#define MC_BVH_USE_SSE
+#endif
+
 
 
 #define TOL		1E-4
@@ -26,27 +35,29 @@
 
 // Some global variables that get set by model_collide and are used internally for
 // checking a collision rather than passing a bunch of parameters around. These are
-// not persistant between calls to model_collide
+// not persistant between calls to model_collide, and are per thread so that
+// collisions can be evaluated on worker threads (see model_collide_memo_run)
 
-static mc_info		*Mc;				// The mc_info passed into model_collide
+static SCP_THREAD_LOCAL mc_info		*Mc;				// The mc_info passed into model_collide
 	
-static polymodel	*Mc_pm;			// The polygon model we're checking
-static int			Mc_submodel;	// The current submodel we're checking
+static SCP_THREAD_LOCAL polymodel	*Mc_pm;			// The polygon model we're checking
+static SCP_THREAD_LOCAL int			Mc_submodel;	// The current submodel we're checking
 
-static polymodel_instance *Mc_pmi;
+static SCP_THREAD_LOCAL polymodel_instance *Mc_pmi;
 
-static matrix		Mc_orient;		// A matrix to rotate a world point into the current
+static SCP_THREAD_LOCAL matrix		Mc_orient;		// A matrix to rotate a world point into the current
 											// submodel's frame of reference.
-static vec3d		Mc_base;			// A point used along with Mc_orient.
+static SCP_THREAD_LOCAL vec3d		Mc_base;			// A point used along with Mc_orient.
 
-static vec3d		Mc_p0;			// The ray origin rotated into the current submodel's frame of reference
-static vec3d		Mc_p1;			// The ray end rotated into the current submodel's frame of reference
-static float		Mc_mag;			// The length of the ray
-static vec3d		Mc_direction;	// A vector from the ray's origin to its end, in the current submodel's frame of reference
+static SCP_THREAD_LOCAL vec3d		Mc_p0;			// The ray origin rotated into the current submodel's frame of reference
+static SCP_THREAD_LOCAL vec3d		Mc_p1;			// The ray end rotated into the current submodel's frame of reference
+static SCP_THREAD_LOCAL float		Mc_mag;			// The length of the ray
+static SCP_THREAD_LOCAL vec3d		Mc_direction;	// A vector from the ray's origin to its end, in the current submodel's frame of reference
 
 static vec3d 		**Mc_point_list = NULL;		// A pointer to the current submodel's vertex list
+													// (old collision code only, which always runs on the main thread)
 
-static float		Mc_edge_time;
+static SCP_THREAD_LOCAL float		Mc_edge_time;
 
 
 void model_collide_free_point_list()
@@ -368,7 +379,9 @@ void model_collide_defpoints(ubyte * p)
 	} 
 }
 
-int model_collide_parse_bsp_defpoints(ubyte * p)
+// Copies the vertices of a defpoints chunk into tree->point_list.  Unlike model_collide_defpoints()
+// this doesn't touch Mc_point_list, so trees can be parsed on worker threads.
+int model_collide_parse_bsp_defpoints(bsp_collision_tree *tree, ubyte * p)
 {
 	int n;
 	int nverts = w(p+8);	
@@ -377,12 +390,15 @@ int model_collide_parse_bsp_defpoints(ubyte * p)
 	ubyte * normcount = p+20;
 	vec3d *src = vp(p+offset);
 
-	model_collide_allocate_point_list(nverts);
+	if ( nverts <= 0 ) {
+		tree->point_list = NULL;
+		return nverts;
+	}
 
-	Assert( Mc_point_list != NULL );
+	tree->point_list = (vec3d*)vm_malloc(sizeof(vec3d) * nverts);
 
 	for (n=0; n<nverts; n++ ) {
-		Mc_point_list[n] = src;
+		tree->point_list[n] = *src;
 
 		src += normcount[n]+1;
 	} 
@@ -741,10 +757,19 @@ void model_collide_parse_bsp(bsp_collision_tree *tree, void *model_ptr, int vers
 
 	Assert(chunk_type == OP_DEFPOINTS);
 
-	int n_verts = model_collide_parse_bsp_defpoints(p);
+	tree->bvh_node_list = NULL;
+	tree->n_bvh_nodes = 0;
+	tree->bvh_poly_list = NULL;
+	tree->n_bvh_polys = 0;
+	tree->bvh_point_list = NULL;
+	tree->bvh_uv_list = NULL;
+	tree->bvh_tri_block_list = NULL;
+	tree->bvh_tri_poly_list = NULL;
+	tree->n_bvh_tri_blocks = 0;
+
+	int n_verts = model_collide_parse_bsp_defpoints(tree, p);
 
 	if ( n_verts <= 0) {
-		tree->point_list = NULL;
 		tree->n_verts = 0;
 
 		tree->n_nodes = 0;
@@ -878,15 +903,6 @@ void model_collide_parse_bsp(bsp_collision_tree *tree, void *model_ptr, int vers
 		}
 	}
 
-	// copy point list
-	Assert(n_verts != -1);
-
-	tree->point_list = (vec3d*)vm_malloc(sizeof(vec3d) * n_verts);
-
-	for ( i = 0; i < (size_t)n_verts; ++i ) {
-		tree->point_list[i] = *Mc_point_list[i];
-	}
-
 	tree->n_verts = n_verts;
 
 	// copy node info. this might be a good time to organize the nodes into a cache efficient tree layout.
@@ -907,259 +923,1138 @@ void model_collide_parse_bsp(bsp_collision_tree *tree, void *model_ptr, int vers
 	vert_buffer.clear();
 }
 
-bool mc_shield_check_common(shield_tri	*tri)
-{
-	vec3d * points[3];
-	vec3d hitpoint;
-	 
-	float dist;
-	float sphere_check_closest_shield_dist = FLT_MAX;
+#define BVH_COLLISION_LEAF_SIZE		4		// most polys a leaf can hold before it gets split
+#define BVH_COLLISION_STACK_SIZE	256
 
-	// Check to see if Mc_pmly is facing away from ray.  If so, don't bother
-	// checking it.
-	if (vm_vec_dot(&Mc_direction,&tri->norm) > 0.0f)	{
-		return false;
-	}
-	// get the vertices in the form the next function wants them
-	for (int j = 0; j < 3; j++ )
-		points[j] = &Mc_pm->shield.verts[tri->verts[j]].pos;
+typedef struct bvh_build_poly {
+	int leaf;
+	vec3d min;
+	vec3d max;
+	vec3d center;
+} bvh_build_poly;
 
-	if (!(Mc->flags & MC_CHECK_SPHERELINE) ) {	// Don't do this test for sphere colliding against shields
-		// Find the intersection of this ray with the plane that the Mc_pmly
-		// lies in
-		dist = fvi_ray_plane(NULL, points[0],&tri->norm,&Mc_p0,&Mc_direction,0.0f);
+typedef struct bvh_build_range {
+	int first;
+	int count;
+} bvh_build_range;
 
-		if ( dist < 0.0f ) return false; // If the ray is behind the plane there is no collision
-		if ( !(Mc->flags & MC_CHECK_RAY) && (dist > 1.0f) ) return false; // The ray isn't long enough to intersect the plane
+struct bvh_build_poly_less {
+	int axis;
 
-		// Find the hit Mc_pmint
-		vm_vec_scale_add( &hitpoint, &Mc_p0, &Mc_direction, dist );
-	
-		// Check to see if the Mc_pmint of intersection is on the plane.  If so, this
-		// also finds the uv's where the ray hit.
-		if ( fvi_point_face(&hitpoint, 3, points, &tri->norm, NULL,NULL,NULL ) )	{
-			Mc->hit_dist = dist;
-			Mc->shield_hit_tri = tri - Mc_pm->shield.tris;
-			Mc->hit_point = hitpoint;
-			Mc->hit_normal = tri->norm;
-			Mc->hit_submodel = -1;
-			Mc->num_hits++;
-			return true;		// We hit, so we're done
+	bvh_build_poly_less(int _axis) : axis(_axis) {}
+
+	bool operator()(const bvh_build_poly &a, const bvh_build_poly &b) const
+	{
+		return a.center.a1d[axis] < b.center.a1d[axis];
+	}
+};
+
+static void bvh_range_bounds(SCP_vector<bvh_build_poly> *polys, bvh_build_range *range, vec3d *min, vec3d *max)
+{
+	*min = (*polys)[range->first].min;
+	*max = (*polys)[range->first].max;
+
+	for ( int i = range->first + 1; i < range->first + range->count; ++i ) {
+		for ( int k = 0; k < 3; ++k ) {
+			min->a1d[k] = MIN(min->a1d[k], (*polys)[i].min.a1d[k]);
+			max->a1d[k] = MAX(max->a1d[k], (*polys)[i].max.a1d[k]);
 		}
-	} else {		// Sphere check against shield
-					// This needs to look at *all* shield tris and not just return after the first hit
+	}
+}
 
-		// HACK HACK!! The 10000.0 is the face radius, I didn't know this,
-		// so I'm assume 10000 would be as big as ever.
-		mc_check_sphereline_face(3, points, points[0], 10000.0f, &tri->norm, NULL, 0, NULL, NULL);
-		if (Mc->num_hits && Mc->hit_dist < sphere_check_closest_shield_dist) {
+// Splits a range in two at the median poly along the axis its centers are most spread out on
+static void bvh_split_range(SCP_vector<bvh_build_poly> *polys, bvh_build_range *range, bvh_build_range *front, bvh_build_range *back)
+{
+	vec3d min = (*polys)[range->first].center;
+	vec3d max = min;
+	int i, k, axis = 0;
+
+	for ( i = range->first + 1; i < range->first + range->count; ++i ) {
+		for ( k = 0; k < 3; ++k ) {
+			min.a1d[k] = MIN(min.a1d[k], (*polys)[i].center.a1d[k]);
+			max.a1d[k] = MAX(max.a1d[k], (*polys)[i].center.a1d[k]);
+		}
+	}
 
-			// same behavior whether face or edge
-			// normal, edge_hit, hit_point all updated thru sphereline_face
-			sphere_check_closest_shield_dist = Mc->hit_dist;
-			Mc->shield_hit_tri = tri - Mc_pm->shield.tris;
-			Mc->hit_submodel = -1;
-			Mc->num_hits++;
-			return true;		// We hit, so we're done
+	for ( k = 1; k < 3; ++k ) {
+		if ( (max.a1d[k] - min.a1d[k]) > (max.a1d[axis] - min.a1d[axis]) ) {
+			axis = k;
 		}
-	} // Mc->flags & MC_CHECK_SPHERELINE else
+	}
 
-	return false;
+	SCP_vector<bvh_build_poly>::iterator start = polys->begin() + range->first;
+	int half = range->count / 2;
+
+	std::nth_element(start, start + half, start + range->count, bvh_build_poly_less(axis));
+
+	front->first = range->first;
+	front->count = half;
+	back->first = range->first + half;
+	back->count = range->count - half;
 }
 
-bool mc_check_sldc(int offset)
+// The axis fvi_point_face() drops when it flattens a poly, so the triangles given to the
+// kernel can be made to line up with what it tests
+static int bvh_tri_projection_axis(const vec3d *norm)
 {
-	if (offset > Mc_pm->sldc_size-5) //no way is this big enough
-		return false;
-	char *type_p = (char *)(Mc_pm->shield_collision_tree+offset);
-	
-	// not used
-	//int *size_p = (int *)(Mc_pm->shield_collision_tree+offset+1);
-	// split and polygons
-	vec3d *minbox_p = (vec3d*)(Mc_pm->shield_collision_tree+offset+5);
-	vec3d *maxbox_p = (vec3d*)(Mc_pm->shield_collision_tree+offset+17);
+	float x = fl_abs(norm->xyz.x);
+	float y = fl_abs(norm->xyz.y);
+	float z = fl_abs(norm->xyz.z);
 
-	// split
-	unsigned int *front_offset_p = (unsigned int*)(Mc_pm->shield_collision_tree+offset+29);
-	unsigned int *back_offset_p = (unsigned int*)(Mc_pm->shield_collision_tree+offset+33);
+	if ( x > y ) {
+		return (x > z) ? 0 : 2;
+	}
 
-	// polygons
-	unsigned int *num_polygons_p = (unsigned int*)(Mc_pm->shield_collision_tree+offset+29);
+	return (y > z) ? 1 : 2;
+}
 
-	unsigned int *shld_polys = (unsigned int*)(Mc_pm->shield_collision_tree+offset+33);
+// Moves a poly vertex along axis i0 onto the poly's plane.  The ray meets the resulting
+// triangle exactly where mc_check_face() finds it meeting the plane, and the triangle has
+// the same shape as the one fvi_point_face() tests, so a warped poly can't slip past it.
+static void bvh_tri_project(vec3d *out, const vec3d *v, const bsp_collision_leaf *leaf, int i0)
+{
+	vec3d d;
 
+	vm_vec_sub(&d, v, &leaf->plane_pnt);
 
+	*out = *v;
+	out->a1d[i0] -= vm_vec_dot(&d, &leaf->plane_norm) / leaf->plane_norm.a1d[i0];
+}
 
-	// see if it fits inside our bbox
-	if (!mc_ray_boundingbox( minbox_p, maxbox_p, &Mc_p0, &Mc_direction, NULL ))	{
-		return false;
-	}
+// Shortest altitude of a triangle once axis i0 is dropped, as fvi_point_face() sees it
+static float bvh_tri_height(const vec3d *v0, const vec3d *v1, const vec3d *v2, int i0)
+{
+	int i1 = (i0 + 1) % 3;
+	int i2 = (i0 + 2) % 3;
 
-	if (*type_p == 0) // SPLIT
-	{
-			return mc_check_sldc(offset+*front_offset_p) || mc_check_sldc(offset+*back_offset_p);
-	}
-	else
-	{
-		// poly list
-		shield_tri	* tri;
-		for (unsigned int i = 0; i < *num_polygons_p; i++)
-		{
-			tri = &Mc_pm->shield.tris[shld_polys[i]];
-						
-			mc_shield_check_common(tri);
+	float u1 = v1->a1d[i1] - v0->a1d[i1], w1 = v1->a1d[i2] - v0->a1d[i2];
+	float u2 = v2->a1d[i1] - v0->a1d[i1], w2 = v2->a1d[i2] - v0->a1d[i2];
+	float u3 = u2 - u1, w3 = w2 - w1;
 
-		} // for (unsigned int i = 0; i < leaf->num_polygons; i++)
+	float longest = fl_sqrt(MAX(MAX(u1*u1 + w1*w1, u2*u2 + w2*w2), u3*u3 + w3*w3));
+
+	if ( longest <= 0.0f ) {
+		return 0.0f;
 	}
 
-	// shouldn't be reached
-	return false;
+	return fl_abs(u1*w2 - u2*w1) / longest;
 }
 
-// checks a vector collision against a ships shield (if it has shield points defined).
-void mc_check_shield()
+void model_collide_build_bvh(bsp_collision_tree *tree)
 {
-	int i;
+	SCP_vector<bvh_build_poly> polys;
+	SCP_vector<bvh_collision_node> nodes;
+	SCP_vector<bvh_build_range> queue;
+	int i, j, k;
 
+	model_collide_free_bvh(tree);
 
-	if ( Mc_pm->shield.ntris < 1 )
+	if ( (tree->n_leaves <= 0) || (tree->leaf_list == NULL) ) {
 		return;
-	if (Mc_pm->shield_collision_tree)
-	{
-		mc_check_sldc(0); // see if we hit the SLDC
 	}
-	else
-	{
-		int o;
-		for (o=0; o<8; o++ )	{
-			model_octant * poct1 = &Mc_pm->octants[o];
 
-			if (!mc_ray_boundingbox( &poct1->min, &poct1->max, &Mc_p0, &Mc_direction, NULL ))	{
-				continue;
-			}
-			
-			for (i = 0; i < poct1->nshield_tris; i++) {
-				shield_tri	* tri = poct1->shield_tris[i];
-				mc_shield_check_common(tri);
-			}
-		}
-	}//model has shield_collsion_tree
-}
+	// every leaf in the bsp tree holds a single poly
+	polys.reserve(tree->n_leaves);
 
+	int n_points = 0;
 
-// This function recursively checks a submodel and its children
-// for a collision with a vector.
-void mc_check_subobj( int mn )
-{
-	vec3d tempv;
-	vec3d hitpt;		// used in bounding box check
-	bsp_info * sm;
-	int i;
+	for ( i = 0; i < tree->n_leaves; ++i ) {
+		bsp_collision_leaf *leaf = &tree->leaf_list[i];
 
-	Assert( mn >= 0 );
-	Assert( mn < Mc_pm->n_models );
-	if ( (mn < 0) || (mn>=Mc_pm->n_models) ) return;
-	
-	sm = &Mc_pm->submodel[mn];
-	if (sm->no_collisions) return; // don't do collisions
-	if (sm->nocollide_this_only) goto NoHit; // Don't collide for this model, but keep checking others
+		// nothing can hit these anyway
+		if ( leaf->num_verts < 3 ) {
+			continue;
+		}
 
-	// Rotate the world check points into the current subobject's 
-	// frame of reference.
-	// After this block, Mc_p0, Mc_p1, Mc_direction, and Mc_mag are correct
-	// and relative to this subobjects' frame of reference.
-	vm_vec_sub(&tempv, Mc->p0, &Mc_base);
-	vm_vec_rotate(&Mc_p0, &tempv, &Mc_orient);
+		polys.push_back(bvh_build_poly());
 
-	vm_vec_sub(&tempv, Mc->p1, &Mc_base);
-	vm_vec_rotate(&Mc_p1, &tempv, &Mc_orient);
-	vm_vec_sub(&Mc_direction, &Mc_p1, &Mc_p0);
+		bvh_build_poly *poly = &polys.back();
 
-	// bail early if no ray exists
-	if ( IS_VEC_NULL(&Mc_direction) ) {
-		return;
-	}
+		poly->leaf = i;
+		poly->min = poly->max = tree->point_list[tree->vert_list[leaf->vert_start].vertnum];
 
-	if (Mc_pm->detail[0] == mn)	{
-		// Quickly bail if we aren't inside the full model bbox
-		if (!mc_ray_boundingbox( &Mc_pm->mins, &Mc_pm->maxs, &Mc_p0, &Mc_direction, NULL))	{
-			return;
-		}
+		for ( j = 1; j < leaf->num_verts; ++j ) {
+			vec3d *pnt = &tree->point_list[tree->vert_list[leaf->vert_start + j].vertnum];
 
-		// If we are checking the root submodel, then we might want to check	
-		// the shield at this point
-		if ((Mc->flags & MC_CHECK_SHIELD) && (Mc_pm->shield.ntris > 0 )) {
-			mc_check_shield();
-			return;
+			for ( k = 0; k < 3; ++k ) {
+				poly->min.a1d[k] = MIN(poly->min.a1d[k], pnt->a1d[k]);
+				poly->max.a1d[k] = MAX(poly->max.a1d[k], pnt->a1d[k]);
+			}
 		}
+
+		vm_vec_avg(&poly->center, &poly->min, &poly->max);
+
+		n_points += leaf->num_verts;
 	}
 
-	if (!(Mc->flags & MC_CHECK_MODEL)) {
+	if ( polys.empty() ) {
 		return;
 	}
-	
-	Mc_submodel = mn;
 
-	// Check if the ray intersects this subobject's bounding box
-	if ( mc_ray_boundingbox(&sm->min, &sm->max, &Mc_p0, &Mc_direction, &hitpt) ) {
-		if (Mc->flags & MC_ONLY_BOUND_BOX) {
-			float dist = vm_vec_dist( &Mc_p0, &hitpt );
+	// lay the nodes out breadth first; each queue entry is the poly range covered by the node with the same index
+	bvh_build_range root;
 
-			// If the ray is behind the plane there is no collision
-			if (dist < 0.0f) {
-				goto NoHit;
-			}
+	root.first = 0;
+	root.count = (int)polys.size();
 
-			// The ray isn't long enough to intersect the plane
-			if ( !(Mc->flags & MC_CHECK_RAY) && (dist > Mc_mag) ) {
-				goto NoHit;
+	queue.push_back(root);
+	nodes.resize(1);
+
+	for ( size_t n = 0; n < queue.size(); ++n ) {
+		bvh_build_range children[BVH_COLLISION_WIDTH];
+		int n_children = 1;
+
+		children[0] = queue[n];
+
+		// keep splitting the biggest child until there are enough of them or they are all small
+		while ( n_children < BVH_COLLISION_WIDTH ) {
+			int biggest = -1;
+
+			for ( i = 0; i < n_children; ++i ) {
+				if ( (children[i].count > BVH_COLLISION_LEAF_SIZE) && ((biggest < 0) || (children[i].count > children[biggest].count)) ) {
+					biggest = i;
+				}
 			}
 
-			// If the ray hits, but a closer intersection has already been found, return
-			if ( Mc->num_hits && (dist >= Mc->hit_dist) ) {
-				goto NoHit;
+			if ( biggest < 0 ) {
+				break;
 			}
 
-			Mc->hit_dist = dist;
-			Mc->hit_point = hitpt;
-			Mc->hit_submodel = Mc_submodel;
-			Mc->hit_bitmap = -1;
-			Mc->num_hits++;
-		} else {
-			// The ray intersects this bounding box, so we have to check all the
-			// polygons in this submodel.
-			if ( Cmdline_old_collision_sys ) {
-				model_collide_sub(sm->bsp_data);
+			bvh_build_range range = children[biggest];
+
+			bvh_split_range(&polys, &range, &children[biggest], &children[n_children]);
+			n_children++;
+		}
+
+		bvh_collision_node node;
+		memset(&node, 0, sizeof(node));
+
+		for ( i = 0; i < n_children; ++i ) {
+			vec3d min, max;
+
+			bvh_range_bounds(&polys, &children[i], &min, &max);
+
+			node.min_x[i] = min.xyz.x;
+			node.min_y[i] = min.xyz.y;
+			node.min_z[i] = min.xyz.z;
+			node.max_x[i] = max.xyz.x;
+			node.max_y[i] = max.xyz.y;
+			node.max_z[i] = max.xyz.z;
+
+			if ( children[i].count > BVH_COLLISION_LEAF_SIZE ) {
+				node.first[i] = (int)queue.size();
+				node.count[i] = -1;
+
+				queue.push_back(children[i]);
+				nodes.resize(nodes.size() + 1);
 			} else {
-				if (Mc->lod > 0 && sm->num_details > 0) {
-					bsp_info *lod_sm = sm;
+				node.first[i] = children[i].first;
+				node.count[i] = children[i].count;
+			}
+		}
 
-					for (i = Mc->lod - 1; i >= 0; i--) {
-						if (sm->details[i] != -1) {
-							lod_sm = &Mc_pm->submodel[sm->details[i]];
+		nodes[n] = node;
+	}
 
-							//mprintf(("Checking %s collision for %s using %s instead\n", Mc_pm->filename, sm->name, lod_sm->name));
-							break;
-						}
+	// fan each leaf's polys out into triangle blocks for the ray kernel
+	SCP_vector<fvi_tri_block> tri_blocks;
+	SCP_vector<ubyte> tri_polys;
+
+	for ( size_t n = 0; n < nodes.size(); ++n ) {
+		bvh_collision_node *node = &nodes[n];
+
+		for ( i = 0; i < BVH_COLLISION_WIDTH; ++i ) {
+			node->tri_block[i] = (int)tri_blocks.size();
+			node->num_tri_blocks[i] = 0;
+			node->tri_min_height[i] = 0.0f;
+
+			if ( node->count[i] <= 0 ) {
+				continue;
+			}
+
+			int lane = FVI_TRI_BLOCK_SIZE;
+			float min_height = FLT_MAX;
+
+			for ( j = node->first[i]; j < node->first[i] + node->count[i]; ++j ) {
+				bsp_collision_leaf *leaf = &tree->leaf_list[polys[j].leaf];
+				int i0 = bvh_tri_projection_axis(&leaf->plane_norm);
+
+				// a poly without a proper plane can't be filtered
+				if ( (leaf->num_verts < 3) || (leaf->plane_norm.a1d[i0] == 0.0f) ) {
+					min_height = 0.0f;
+					continue;
+				}
+
+				vec3d v0, v1, v2;
+				bvh_tri_project(&v0, &tree->point_list[tree->vert_list[leaf->vert_start].vertnum], leaf, i0);
+
+				for ( k = 1; k < leaf->num_verts - 1; ++k ) {
+					if ( lane == FVI_TRI_BLOCK_SIZE ) {
+						tri_blocks.push_back(fvi_tri_block());
+						memset(&tri_blocks.back(), 0, sizeof(fvi_tri_block));
+						tri_polys.resize(tri_polys.size() + FVI_TRI_BLOCK_SIZE, 0xff);
+						lane = 0;
 					}
 
-					model_collide_bsp(model_get_bsp_collision_tree(lod_sm->collision_tree_index), 0);
-				} else {
-					model_collide_bsp(model_get_bsp_collision_tree(sm->collision_tree_index), 0);
+					bvh_tri_project(&v1, &tree->point_list[tree->vert_list[leaf->vert_start + k].vertnum], leaf, i0);
+					bvh_tri_project(&v2, &tree->point_list[tree->vert_list[leaf->vert_start + k + 1].vertnum], leaf, i0);
+
+					fvi_tri_block_set(&tri_blocks.back(), lane, &v0, &v1, &v2);
+					tri_polys[(tri_blocks.size() - 1) * FVI_TRI_BLOCK_SIZE + lane] = (ubyte)(j - node->first[i]);
+					lane++;
+
+					min_height = MIN(min_height, bvh_tri_height(&v0, &v1, &v2, i0));
 				}
 			}
+
+			node->num_tri_blocks[i] = (int)tri_blocks.size() - node->tri_block[i];
+			node->tri_min_height[i] = (min_height == FLT_MAX) ? 0.0f : min_height;
 		}
 	}
 
-NoHit:
+	// copy out the polys in their final order, along with their verts
+	tree->n_bvh_nodes = (int)nodes.size();
+	tree->bvh_node_list = (bvh_collision_node *)vm_malloc(sizeof(bvh_collision_node) * nodes.size());
+	memcpy(tree->bvh_node_list, &nodes[0], sizeof(bvh_collision_node) * nodes.size());
 
-	// If we're only checking one submodel, return
-	if (Mc->flags & MC_SUBMODEL)	{
-		return;
+	tree->n_bvh_polys = (int)polys.size();
+	tree->bvh_poly_list = (bvh_collision_poly *)vm_malloc(sizeof(bvh_collision_poly) * polys.size());
+	tree->bvh_point_list = (vec3d *)vm_malloc(sizeof(vec3d) * n_points);
+	tree->bvh_uv_list = (uv_pair *)vm_malloc(sizeof(uv_pair) * n_points);
+
+	tree->n_bvh_tri_blocks = (int)tri_blocks.size();
+
+	if ( !tri_blocks.empty() ) {
+		tree->bvh_tri_block_list = (fvi_tri_block *)vm_malloc(sizeof(fvi_tri_block) * tri_blocks.size());
+		tree->bvh_tri_poly_list = (ubyte *)vm_malloc(sizeof(ubyte) * tri_polys.size());
+		memcpy(tree->bvh_tri_block_list, &tri_blocks[0], sizeof(fvi_tri_block) * tri_blocks.size());
+		memcpy(tree->bvh_tri_poly_list, &tri_polys[0], sizeof(ubyte) * tri_polys.size());
 	}
 
-	
-	// If this subobject doesn't have any children, we're done checking it.
+	int vert_start = 0;
+
+	for ( i = 0; i < tree->n_bvh_polys; ++i ) {
+		bsp_collision_leaf *leaf = &tree->leaf_list[polys[i].leaf];
+		bvh_collision_poly *poly = &tree->bvh_poly_list[i];
+
+		poly->plane_pnt = leaf->plane_pnt;
+		poly->plane_norm = leaf->plane_norm;
+		poly->face_rad = leaf->face_rad;
+		poly->vert_start = vert_start;
+		poly->num_verts = leaf->num_verts;
+		poly->tmap_num = leaf->tmap_num;
+		poly->leaf = polys[i].leaf;
+
+		for ( j = 0; j < leaf->num_verts; ++j ) {
+			model_tmap_vert *vert = &tree->vert_list[leaf->vert_start + j];
+
+			tree->bvh_point_list[vert_start + j] = tree->point_list[vert->vertnum];
+			tree->bvh_uv_list[vert_start + j].u = vert->u;
+			tree->bvh_uv_list[vert_start + j].v = vert->v;
+		}
+
+		vert_start += leaf->num_verts;
+	}
+}
+
+void model_collide_free_bvh(bsp_collision_tree *tree)
+{
+	if ( tree->bvh_node_list ) {
+		vm_free(tree->bvh_node_list);
+		tree->bvh_node_list = NULL;
+	}
+
+	if ( tree->bvh_poly_list ) {
+		vm_free(tree->bvh_poly_list);
+		tree->bvh_poly_list = NULL;
+	}
+
+	if ( tree->bvh_point_list ) {
+		vm_free(tree->bvh_point_list);
+		tree->bvh_point_list = NULL;
+	}
+
+	if ( tree->bvh_uv_list ) {
+		vm_free(tree->bvh_uv_list);
+		tree->bvh_uv_list = NULL;
+	}
+
+	if ( tree->bvh_tri_block_list ) {
+		vm_free(tree->bvh_tri_block_list);
+		tree->bvh_tri_block_list = NULL;
+	}
+
+	if ( tree->bvh_tri_poly_list ) {
+		vm_free(tree->bvh_tri_poly_list);
+		tree->bvh_tri_poly_list = NULL;
+	}
+
+	tree->n_bvh_nodes = 0;
+	tree->n_bvh_polys = 0;
+	tree->n_bvh_tri_blocks = 0;
+}
+
+// Tests the ray (or sphere, if MC_CHECK_SPHERELINE) against all four boxes of a node.  Returns a bit
+// for every child that is touched no later than max_t, where t runs from 0 at Mc_p0 to 1 at Mc_p1.
+static int mc_bvh_check_boxes(bvh_collision_node *node, vec3d *inv_dir, float max_t)
+{
+	float rad = (Mc->flags & MC_CHECK_SPHERELINE) ? Mc->radius : 0.0f;
+
+#ifdef MC_BVH_USE_SSE
+	__m128 rad4 = _mm_set1_ps(rad);
+
+	__m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(node->min_x), rad4), _mm_set1_ps(Mc_p0.xyz.x)), _mm_set1_ps(inv_dir->xyz.x));
+	__m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(node->max_x), rad4), _mm_set1_ps(Mc_p0.xyz.x)), _mm_set1_ps(inv_dir->xyz.x));
+	__m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(node->min_y), rad4), _mm_set1_ps(Mc_p0.xyz.y)), _mm_set1_ps(inv_dir->xyz.y));
+	__m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(node->max_y), rad4), _mm_set1_ps(Mc_p0.xyz.y)), _mm_set1_ps(inv_dir->xyz.y));
+	__m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(node->min_z), rad4), _mm_set1_ps(Mc_p0.xyz.z)), _mm_set1_ps(inv_dir->xyz.z));
+	__m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(node->max_z), rad4), _mm_set1_ps(Mc_p0.xyz.z)), _mm_set1_ps(inv_dir->xyz.z));
+
+	__m128 t_near = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_max_ps(_mm_min_ps(t0z, t1z), _mm_setzero_ps()));
+	__m128 t_far = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_max_ps(t0z, t1z));
+
+	__m128 hit = _mm_and_ps(_mm_cmple_ps(t_near, t_far), _mm_cmple_ps(t_near, _mm_set1_ps(max_t)));
+
+	return _mm_movemask_ps(hit);
+#else
+	int mask = 0;
+
+	for ( int i = 0; i < BVH_COLLISION_WIDTH; ++i ) {
+		float t0x = (node->min_x[i] - rad - Mc_p0.xyz.x) * inv_dir->xyz.x;
+		float t1x = (node->max_x[i] + rad - Mc_p0.xyz.x) * inv_dir->xyz.x;
+		float t0y = (node->min_y[i] - rad - Mc_p0.xyz.y) * inv_dir->xyz.y;
+		float t1y = (node->max_y[i] + rad - Mc_p0.xyz.y) * inv_dir->xyz.y;
+		float t0z = (node->min_z[i] - rad - Mc_p0.xyz.z) * inv_dir->xyz.z;
+		float t1z = (node->max_z[i] + rad - Mc_p0.xyz.z) * inv_dir->xyz.z;
+
+		float t_near = MAX(MAX(MIN(t0x, t1x), MIN(t0y, t1y)), MAX(MIN(t0z, t1z), 0.0f));
+		float t_far = MIN(MIN(MAX(t0x, t1x), MAX(t0y, t1y)), MAX(t0z, t1z));
+
+		if ( (t_near <= t_far) && (t_near <= max_t) ) {
+			mask |= (1 << i);
+		}
+	}
+
+	return mask;
+#endif
+}
+
+// Whether rays run the triangle kernel over a leaf before the proper face checks.  The
+// kernel only throws out polys the ray can't hit, so results stay the same; the
+// collision_tri_kernel command turns it off, and collision_bvh_bench counts any
+// query whose result it changes.
+static bool Mc_bvh_tri_kernel = true;
+
+// Polys whose plane is within this of being parallel to the ray are always checked
+// properly, since the point where the ray meets the plane is too poorly defined there.
+#define MC_TRI_GRAZING_COS		0.05f
+
+// how far outside a triangle (in barycentric terms) the kernel always counts a hit
+#define MC_TRI_EDGE_TOLERANCE	0.01f
+
+// Rounding in the kernel and in mc_check_face() can move where a ray meets a poly by
+// about this much per unit of coordinate size, more for rays close to grazing
+#define MC_TRI_ROUNDING			(16.0f * FLT_EPSILON)
+
+// fvi_point_face() treats an edge within 0.0001 of an axis as lying on it, which can
+// move its answer by up to about this much
+#define MC_TRI_POINT_FACE_SLOP	0.001f
+
+// Past this much tolerance the kernel would hardly throw anything out
+#define MC_TRI_MAX_TOLERANCE	0.25f
+
+// How far outside its triangles the kernel has to accept hits on the polys of a leaf so
+// that it never drops one mc_check_face() would find.  Errors in position are turned into
+// barycentric terms by the leaf's shortest triangle altitude.  Returns a negative number
+// if the leaf can't be filtered.
+static float mc_tri_tolerance(bvh_collision_node *node, int slot)
+{
+	float height = node->tri_min_height[slot];
+
+	if ( height <= 0.0f ) {
+		return -1.0f;
+	}
+
+	float scale = MAX(MAX(fl_abs(Mc_p0.xyz.x), fl_abs(Mc_p0.xyz.y)), fl_abs(Mc_p0.xyz.z));
+
+	scale += MAX(MAX(MAX(fl_abs(node->min_x[slot]), fl_abs(node->max_x[slot])), MAX(fl_abs(node->min_y[slot]), fl_abs(node->max_y[slot]))),
+		MAX(fl_abs(node->min_z[slot]), fl_abs(node->max_z[slot])));
+
+	float tol = MC_TRI_EDGE_TOLERANCE + (MC_TRI_ROUNDING * scale / MC_TRI_GRAZING_COS + MC_TRI_POINT_FACE_SLOP) / height;
+
+	return (tol < MC_TRI_MAX_TOLERANCE) ? tol : -1.0f;
+}
+
+static void mc_check_bvh_polys(bsp_collision_tree *tree, bvh_collision_node *node, int slot, float dir_mag)
+{
+	vec3d *points[TMAP_MAX_VERTS];
+	int first = node->first[slot];
+	int count = node->count[slot];
+	int candidates = (1 << count) - 1;
+	bool filtered = false;
+
+	// rays can skip the polys none of whose triangles they cross; the kernel ignores
+	// the length of the ray, the proper check below sorts that out
+	if ( !(Mc->flags & MC_CHECK_SPHERELINE) && (node->num_tri_blocks[slot] > 0) && Mc_bvh_tri_kernel ) {
+		float tol = mc_tri_tolerance(node, slot);
+
+		if ( tol >= 0.0f ) {
+			candidates = 0;
+			filtered = true;
+
+			for ( int b = node->tri_block[slot]; b < node->tri_block[slot] + node->num_tri_blocks[slot]; ++b ) {
+				int lanes = fvi_ray_triangle_block(&Mc_p0, &Mc_direction, &tree->bvh_tri_block_list[b], -FLT_MAX, FLT_MAX, tol);
+
+				for ( int lane = 0; lanes != 0; ++lane, lanes >>= 1 ) {
+					if ( lanes & 1 ) {
+						candidates |= (1 << tree->bvh_tri_poly_list[b * FVI_TRI_BLOCK_SIZE + lane]);
+					}
+				}
+			}
+		}
+	}
+
+	for ( int i = first; i < first + count; ++i ) {
+		bvh_collision_poly *poly = &tree->bvh_poly_list[i];
+		uv_pair *uvlist = NULL;
+		int ntmap = -1;
+
+		if ( filtered && !(candidates & (1 << (i - first))) ) {
+			// mc_check_face() throws out back facing polys itself, so only grazing ones need a second look
+			if ( vm_vec_dot(&Mc_direction, &poly->plane_norm) < -MC_TRI_GRAZING_COS * dir_mag ) {
+				continue;
+			}
+		}
+
+		if ( poly->tmap_num < MAX_MODEL_TEXTURES ) {
+			if ( (!(Mc->flags & MC_CHECK_INVISIBLE_FACES)) && (Mc_pm->maps[poly->tmap_num].textures[TM_BASE_TYPE].GetTexture() < 0) )	{
+				// Don't check invisible polygons.
+				//SUSHI: Unless $collide_invisible is set.
+				if (!(Mc_pm->submodel[Mc_submodel].collide_invisible))
+					continue;
+			}
+
+			uvlist = &tree->bvh_uv_list[poly->vert_start];
+			ntmap = poly->tmap_num;
+		}
+
+		for ( int j = 0; j < poly->num_verts; ++j ) {
+			points[j] = &tree->bvh_point_list[poly->vert_start + j];
+		}
+
+		if ( Mc->flags & MC_CHECK_SPHERELINE ) {
+			mc_check_sphereline_face(poly->num_verts, points, &poly->plane_pnt, poly->face_rad, &poly->plane_norm, uvlist, ntmap, NULL, &tree->leaf_list[poly->leaf]);
+		} else {
+			mc_check_face(poly->num_verts, points, &poly->plane_pnt, poly->face_rad, &poly->plane_norm, uvlist, ntmap, NULL, &tree->leaf_list[poly->leaf]);
+		}
+	}
+}
+
+static void mc_bvh_inverse_direction(vec3d *inv_dir, vec3d *dir)
+{
+	for ( int i = 0; i < 3; ++i ) {
+		// keep the slab math finite for axis aligned rays
+		if ( fl_abs(dir->a1d[i]) > 1e-30f ) {
+			inv_dir->a1d[i] = 1.0f / dir->a1d[i];
+		} else {
+			inv_dir->a1d[i] = (dir->a1d[i] < 0.0f) ? -1e30f : 1e30f;
+		}
+	}
+}
+
+// nothing past the closest hit so far can replace it
+static float mc_bvh_max_t()
+{
+	float max_t = (Mc->flags & MC_CHECK_RAY) ? FLT_MAX : 1.0f;
+
+	if ( Mc->num_hits && (Mc->hit_dist < max_t) ) {
+		max_t = Mc->hit_dist;
+	}
+
+	return max_t;
+}
+
+static void model_collide_bvh(bsp_collision_tree *tree)
+{
+	int stack[BVH_COLLISION_STACK_SIZE];
+	int stack_size = 0;
+	vec3d inv_dir;
+	float dir_mag = vm_vec_mag(&Mc_direction);
+	int i;
+
+	mc_bvh_inverse_direction(&inv_dir, &Mc_direction);
+
+	stack[stack_size++] = 0;
+
+	while ( stack_size > 0 ) {
+		bvh_collision_node *node = &tree->bvh_node_list[stack[--stack_size]];
+
+		int mask = mc_bvh_check_boxes(node, &inv_dir, mc_bvh_max_t());
+
+		for ( i = 0; i < BVH_COLLISION_WIDTH; ++i ) {
+			if ( !(mask & (1 << i)) || (node->count[i] == 0) ) {
+				continue;
+			}
+
+			if ( node->count[i] < 0 ) {
+				Assertion( stack_size < BVH_COLLISION_STACK_SIZE, "Collision BVH is too deep!" );
+				stack[stack_size++] = node->first[i];
+			} else {
+				mc_check_bvh_polys(tree, node, i, dir_mag);
+			}
+		}
+	}
+}
+
+// Most rays model_collide_batch() traces together
+#define MC_BATCH_MAX_RAYS	8
+
+// A ray of a batch, with its copy of what mc_check_subobj() keeps in globals
+typedef struct mc_batch_ray {
+	mc_info *mc;
+	vec3d p0;				// relative to the current submodel, like Mc_p0
+	vec3d p1;
+	vec3d direction;
+	vec3d inv_dir;
+	float dir_mag;
+} mc_batch_ray;
+
+// Points the globals the face checks use at one ray of a batch
+static void mc_batch_select(mc_batch_ray *ray)
+{
+	Mc = ray->mc;
+	Mc_p0 = ray->p0;
+	Mc_p1 = ray->p1;
+	Mc_direction = ray->direction;
+}
+
+// model_collide_bvh() for the rays of a batch in ray_mask.  The rays go down the
+// hierarchy together, so each node is visited once for all the rays that reach it,
+// and each leaf only gets the rays that hit its box.
+static void model_collide_bvh_batch(bsp_collision_tree *tree, mc_batch_ray *rays, int ray_mask)
+{
+	int stack[BVH_COLLISION_STACK_SIZE];
+	int stack_rays[BVH_COLLISION_STACK_SIZE];
+	int stack_size = 0;
+	int i, r;
+
+	stack[stack_size] = 0;
+	stack_rays[stack_size++] = ray_mask;
+
+	while ( stack_size > 0 ) {
+		stack_size--;
+
+		bvh_collision_node *node = &tree->bvh_node_list[stack[stack_size]];
+		int active = stack_rays[stack_size];
+		int slot_rays[BVH_COLLISION_WIDTH];
+
+		for ( i = 0; i < BVH_COLLISION_WIDTH; ++i ) {
+			slot_rays[i] = 0;
+		}
+
+		for ( r = 0; r < MC_BATCH_MAX_RAYS; ++r ) {
+			if ( !(active & (1 << r)) ) {
+				continue;
+			}
+
+			mc_batch_select(&rays[r]);
+
+			int mask = mc_bvh_check_boxes(node, &rays[r].inv_dir, mc_bvh_max_t());
+
+			for ( i = 0; i < BVH_COLLISION_WIDTH; ++i ) {
+				if ( mask & (1 << i) ) {
+					slot_rays[i] |= (1 << r);
+				}
+			}
+		}
+
+		for ( i = 0; i < BVH_COLLISION_WIDTH; ++i ) {
+			if ( !slot_rays[i] || (node->count[i] == 0) ) {
+				continue;
+			}
+
+			if ( node->count[i] < 0 ) {
+				Assertion( stack_size < BVH_COLLISION_STACK_SIZE, "Collision BVH is too deep!" );
+				stack[stack_size] = node->first[i];
+				stack_rays[stack_size++] = slot_rays[i];
+				continue;
+			}
+
+			for ( r = 0; r < MC_BATCH_MAX_RAYS; ++r ) {
+				if ( slot_rays[i] & (1 << r) ) {
+					mc_batch_select(&rays[r]);
+					mc_check_bvh_polys(tree, node, i, rays[r].dir_mag);
+				}
+			}
+		}
+	}
+}
+
+// set by the collision_bvh_bench command to time the bsp trees
+static bool Mc_bvh_disabled = false;
+
+// Checks the polys of a submodel with whichever structure was built for it
+static void mc_check_collision_tree(bsp_collision_tree *tree)
+{
+	if ( (tree->bvh_node_list != NULL) && !Mc_bvh_disabled ) {
+		model_collide_bvh(tree);
+	} else {
+		model_collide_bsp(tree, 0);
+	}
+}
+
+// Whether two results of the same query differ, for collision_bvh_bench
+static bool mc_bvh_benchmark_differs(mc_info *a, mc_info *b)
+{
+	if ( (a->num_hits > 0) != (b->num_hits > 0) ) {
+		return true;
+	}
+
+	return (a->num_hits > 0) && (fl_abs(a->hit_dist - b->hit_dist) > 0.0001f);
+}
+
+// Fires the same set of rays and spheres at a model using the bsp trees, the flattened
+// hierarchy, and the flattened hierarchy with the triangle kernel.  Returns the number
+// of queries whose results differed from the bsp trees without the kernel, and puts the
+// number that the kernel changed in *tri_mismatches.
+static int mc_bvh_benchmark_model(polymodel *pm, int num_rays, int *bsp_us, int *bvh_us, int *tri_us, int *tri_mismatches)
+{
+	SCP_vector<int> built;
+	SCP_vector<mc_info> bsp_results, bvh_results;
+	SCP_vector<vec3d> points;
+	uint seed = 12345;
+	int i, pass, mismatches = 0;
+	bool tri_kernel = Mc_bvh_tri_kernel;
+
+	*tri_mismatches = 0;
+
+	// the hierarchy may not have been built at load time
+	for ( i = 0; i < pm->n_models; ++i ) {
+		bsp_collision_tree *tree = model_get_bsp_collision_tree(pm->submodel[i].collision_tree_index);
+
+		if ( tree->bvh_node_list == NULL ) {
+			model_collide_build_bvh(tree);
+			built.push_back(i);
+		}
+	}
+
+	points.resize(num_rays * 2);
+
+	for ( i = 0; i < num_rays * 2; ++i ) {
+		vec3d rnd;
+
+		for ( int k = 0; k < 3; ++k ) {
+			seed = seed * 1664525 + 1013904223;
+			rnd.a1d[k] = (float)(seed >> 8) / 16777216.0f;
+		}
+
+		if ( i & 1 ) {
+			// aim somewhere inside the bounding box, and carry on out the other side
+			vec3d target;
+
+			target.xyz.x = pm->mins.xyz.x + rnd.xyz.x * (pm->maxs.xyz.x - pm->mins.xyz.x);
+			target.xyz.y = pm->mins.xyz.y + rnd.xyz.y * (pm->maxs.xyz.y - pm->mins.xyz.y);
+			target.xyz.z = pm->mins.xyz.z + rnd.xyz.z * (pm->maxs.xyz.z - pm->mins.xyz.z);
+
+			vm_vec_scale_add(&points[i], &points[i - 1], &target, 2.0f);
+			vm_vec_scale_add2(&points[i], &points[i - 1], -2.0f);
+		} else {
+			// start somewhere on a sphere around the model
+			for ( int k = 0; k < 3; ++k ) {
+				rnd.a1d[k] = rnd.a1d[k] * 2.0f - 1.0f;
+			}
+
+			if ( vm_vec_normalize_safe(&rnd) == 0.0f ) {
+				rnd = vmd_z_vector;
+			}
+
+			vm_vec_copy_scale(&points[i], &rnd, pm->rad * 2.0f);
+		}
+	}
+
+	bsp_results.resize(num_rays);
+	bvh_results.resize(num_rays);
+
+	for ( pass = 0; pass < 3; ++pass ) {
+		Mc_bvh_disabled = (pass == 0);
+		Mc_bvh_tri_kernel = (pass == 2);
+
+		int start = timer_get_microseconds();
+
+		for ( i = 0; i < num_rays; ++i ) {
+			mc_info mc;
+
+			mc_info_init(&mc);
+
+			mc.model_num = pm->id;
+			mc.orient = &vmd_identity_matrix;
+			mc.pos = &vmd_zero_vector;
+			mc.p0 = &points[i * 2];
+			mc.p1 = &points[i * 2 + 1];
+			mc.flags = MC_CHECK_MODEL;
+
+			// every other query sweeps a sphere
+			if ( i & 1 ) {
+				mc.flags |= MC_CHECK_SPHERELINE;
+				mc.radius = MAX(pm->rad * 0.01f, 0.5f);
+			}
+
+			model_collide(&mc);
+
+			if ( pass == 0 ) {
+				bsp_results[i] = mc;
+			} else if ( pass == 1 ) {
+				bvh_results[i] = mc;
+
+				if ( mc_bvh_benchmark_differs(&mc, &bsp_results[i]) ) {
+					mismatches++;
+				}
+			} else if ( mc_bvh_benchmark_differs(&mc, &bvh_results[i]) ) {
+				(*tri_mismatches)++;
+			}
+		}
+
+		if ( pass == 0 ) {
+			*bsp_us = timer_get_microseconds() - start;
+		} else if ( pass == 1 ) {
+			*bvh_us = timer_get_microseconds() - start;
+		} else {
+			*tri_us = timer_get_microseconds() - start;
+		}
+	}
+
+	Mc_bvh_disabled = false;
+	Mc_bvh_tri_kernel = tri_kernel;
+
+	for ( i = 0; i < (int)built.size(); ++i ) {
+		model_collide_free_bvh(model_get_bsp_collision_tree(pm->submodel[built[i]].collision_tree_index));
+	}
+
+	return mismatches;
+}
+
+DCF(collision_bvh_bench, "Times model collisions against the bsp trees and the flattened hierarchy")
+{
+	extern polymodel *Polygon_models[MAX_POLYGON_MODELS];
+	int num_rays = 2000;
+
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: collision_bvh_bench [rays]\n");
+		dc_printf("Fires [rays] segments and spheres (default 2000) at every loaded model, first using the\n");
+		dc_printf("bsp collision trees, then the flattened hierarchy, then the flattened hierarchy with\n");
+		dc_printf("the triangle kernel, and reports the timings along with the number of queries whose\n");
+		dc_printf("results differ from the bsp trees, and the number the triangle kernel changes.\n");
+		return;
+	}
+
+	dc_maybe_stuff_int(&num_rays);
+
+	if ( Cmdline_old_collision_sys ) {
+		dc_printf("No collision trees are built with -old_collision\n");
+		return;
+	}
+
+	if ( num_rays <= 0 ) {
+		dc_printf("Need at least one ray\n");
+		return;
+	}
+
+	int total_bsp_us = 0, total_bvh_us = 0, total_tri_us = 0, total_mismatches = 0, total_tri_mismatches = 0;
+
+	for ( int i = 0; i < MAX_POLYGON_MODELS; ++i ) {
+		polymodel *pm = Polygon_models[i];
+
+		if ( pm == NULL ) {
+			continue;
+		}
+
+		int bsp_us, bvh_us, tri_us, tri_mismatches;
+		int mismatches = mc_bvh_benchmark_model(pm, num_rays, &bsp_us, &bvh_us, &tri_us, &tri_mismatches);
+
+		dc_printf("%s: bsp %d us, bvh %d us, bvh+tri %d us, %d mismatches, %d changed by the triangle kernel\n", pm->filename, bsp_us, bvh_us, tri_us, mismatches, tri_mismatches);
+
+		total_bsp_us += bsp_us;
+		total_bvh_us += bvh_us;
+		total_tri_us += tri_us;
+		total_mismatches += mismatches;
+		total_tri_mismatches += tri_mismatches;
+	}
+
+	dc_printf("Total: bsp %d us, bvh %d us, bvh+tri %d us, %d mismatches, %d changed by the triangle kernel\n", total_bsp_us, total_bvh_us, total_tri_us, total_mismatches, total_tri_mismatches);
+}
+
+DCF(collision_tri_kernel, "Runs rays through the triangle kernel before the face checks (on or off)")
+{
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: collision_tri_kernel [on|off]\n");
+		dc_printf("[on]  -- rays only get the full face check on polys whose triangles they cross, or at grazing angles (the default)\n");
+		dc_printf("[off] -- rays get the full face check on every poly in the leaves they reach\n");
+		dc_printf("with no parameters, prints the current setting. Use collision_bvh_bench to see what it changes.\n");
+		return;
+	}
+
+	if (dc_optional_string("on")) {
+		Mc_bvh_tri_kernel = true;
+	} else if (dc_optional_string("off")) {
+		Mc_bvh_tri_kernel = false;
+	}
+
+	dc_printf("Triangle kernel is %s\n", Mc_bvh_tri_kernel ? "on" : "off");
+}
+
+bool mc_shield_check_common(shield_tri	*tri)
+{
+	vec3d * points[3];
+	vec3d hitpoint;
+	 
+	float dist;
+	float sphere_check_closest_shield_dist = FLT_MAX;
+
+	// Check to see if Mc_pmly is facing away from ray.  If so, don't bother
+	// checking it.
+	if (vm_vec_dot(&Mc_direction,&tri->norm) > 0.0f)	{
+		return false;
+	}
+	// get the vertices in the form the next function wants them
+	for (int j = 0; j < 3; j++ )
+		points[j] = &Mc_pm->shield.verts[tri->verts[j]].pos;
+
+	if (!(Mc->flags & MC_CHECK_SPHERELINE) ) {	// Don't do this test for sphere colliding against shields
+		// Find the intersection of this ray with the plane that the Mc_pmly
+		// lies in
+		dist = fvi_ray_plane(NULL, points[0],&tri->norm,&Mc_p0,&Mc_direction,0.0f);
+
+		if ( dist < 0.0f ) return false; // If the ray is behind the plane there is no collision
+		if ( !(Mc->flags & MC_CHECK_RAY) && (dist > 1.0f) ) return false; // The ray isn't long enough to intersect the plane
+
+		// Find the hit Mc_pmint
+		vm_vec_scale_add( &hitpoint, &Mc_p0, &Mc_direction, dist );
+	
+		// Check to see if the Mc_pmint of intersection is on the plane.  If so, this
+		// also finds the uv's where the ray hit.
+		if ( fvi_point_face(&hitpoint, 3, points, &tri->norm, NULL,NULL,NULL ) )	{
+			Mc->hit_dist = dist;
+			Mc->shield_hit_tri = tri - Mc_pm->shield.tris;
+			Mc->hit_point = hitpoint;
+			Mc->hit_normal = tri->norm;
+			Mc->hit_submodel = -1;
+			Mc->num_hits++;
+			return true;		// We hit, so we're done
+		}
+	} else {		// Sphere check against shield
+					// This needs to look at *all* shield tris and not just return after the first hit
+
+		// HACK HACK!! The 10000.0 is the face radius, I didn't know this,
+		// so I'm assume 10000 would be as big as ever.
+		mc_check_sphereline_face(3, points, points[0], 10000.0f, &tri->norm, NULL, 0, NULL, NULL);
+		if (Mc->num_hits && Mc->hit_dist < sphere_check_closest_shield_dist) {
+
+			// same behavior whether face or edge
+			// normal, edge_hit, hit_point all updated thru sphereline_face
+			sphere_check_closest_shield_dist = Mc->hit_dist;
+			Mc->shield_hit_tri = tri - Mc_pm->shield.tris;
+			Mc->hit_submodel = -1;
+			Mc->num_hits++;
+			return true;		// We hit, so we're done
+		}
+	} // Mc->flags & MC_CHECK_SPHERELINE else
+
+	return false;
+}
+
+bool mc_check_sldc(int offset)
+{
+	if (offset > Mc_pm->sldc_size-5) //no way is this big enough
+		return false;
+	char *type_p = (char *)(Mc_pm->shield_collision_tree+offset);
+	
+	// not used
+	//int *size_p = (int *)(Mc_pm->shield_collision_tree+offset+1);
+	// split and polygons
+	vec3d *minbox_p = (vec3d*)(Mc_pm->shield_collision_tree+offset+5);
+	vec3d *maxbox_p = (vec3d*)(Mc_pm->shield_collision_tree+offset+17);
+
+	// split
+	unsigned int *front_offset_p = (unsigned int*)(Mc_pm->shield_collision_tree+offset+29);
+	unsigned int *back_offset_p = (unsigned int*)(Mc_pm->shield_collision_tree+offset+33);
+
+	// polygons
+	unsigned int *num_polygons_p = (unsigned int*)(Mc_pm->shield_collision_tree+offset+29);
+
+	unsigned int *shld_polys = (unsigned int*)(Mc_pm->shield_collision_tree+offset+33);
+
+
+
+	// see if it fits inside our bbox
+	if (!mc_ray_boundingbox( minbox_p, maxbox_p, &Mc_p0, &Mc_direction, NULL ))	{
+		return false;
+	}
+
+	if (*type_p == 0) // SPLIT
+	{
+			return mc_check_sldc(offset+*front_offset_p) || mc_check_sldc(offset+*back_offset_p);
+	}
+	else
+	{
+		// poly list
+		shield_tri	* tri;
+		for (unsigned int i = 0; i < *num_polygons_p; i++)
+		{
+			tri = &Mc_pm->shield.tris[shld_polys[i]];
+						
+			mc_shield_check_common(tri);
+
+		} // for (unsigned int i = 0; i < leaf->num_polygons; i++)
+	}
+
+	// shouldn't be reached
+	return false;
+}
+
+// checks a vector collision against a ships shield (if it has shield points defined).
+void mc_check_shield()
+{
+	int i;
+
+
+	if ( Mc_pm->shield.ntris < 1 )
+		return;
+	if (Mc_pm->shield_collision_tree)
+	{
+		mc_check_sldc(0); // see if we hit the SLDC
+	}
+	else
+	{
+		int o;
+		for (o=0; o<8; o++ )	{
+			model_octant * poct1 = &Mc_pm->octants[o];
+
+			if (!mc_ray_boundingbox( &poct1->min, &poct1->max, &Mc_p0, &Mc_direction, NULL ))	{
+				continue;
+			}
+			
+			for (i = 0; i < poct1->nshield_tris; i++) {
+				shield_tri	* tri = poct1->shield_tris[i];
+				mc_shield_check_common(tri);
+			}
+		}
+	}//model has shield_collsion_tree
+}
+
+
+// This function recursively checks a submodel and its children
+// for a collision with a vector.
+void mc_check_subobj( int mn )
+{
+	vec3d tempv;
+	vec3d hitpt;		// used in bounding box check
+	bsp_info * sm;
+	int i;
+
+	Assert( mn >= 0 );
+	Assert( mn < Mc_pm->n_models );
+	if ( (mn < 0) || (mn>=Mc_pm->n_models) ) return;
+	
+	sm = &Mc_pm->submodel[mn];
+	if (sm->no_collisions) return; // don't do collisions
+	if (sm->nocollide_this_only) goto NoHit; // Don't collide for this model, but keep checking others
+
+	// Rotate the world check points into the current subobject's 
+	// frame of reference.
+	// After this block, Mc_p0, Mc_p1, Mc_direction, and Mc_mag are correct
+	// and relative to this subobjects' frame of reference.
+	vm_vec_sub(&tempv, Mc->p0, &Mc_base);
+	vm_vec_rotate(&Mc_p0, &tempv, &Mc_orient);
+
+	vm_vec_sub(&tempv, Mc->p1, &Mc_base);
+	vm_vec_rotate(&Mc_p1, &tempv, &Mc_orient);
+	vm_vec_sub(&Mc_direction, &Mc_p1, &Mc_p0);
+
+	// bail early if no ray exists
+	if ( IS_VEC_NULL(&Mc_direction) ) {
+		return;
+	}
+
+	if (Mc_pm->detail[0] == mn)	{
+		// Quickly bail if we aren't inside the full model bbox
+		if (!mc_ray_boundingbox( &Mc_pm->mins, &Mc_pm->maxs, &Mc_p0, &Mc_direction, NULL))	{
+			return;
+		}
+
+		// If we are checking the root submodel, then we might want to check	
+		// the shield at this point
+		if ((Mc->flags & MC_CHECK_SHIELD) && (Mc_pm->shield.ntris > 0 )) {
+			mc_check_shield();
+			return;
+		}
+	}
+
+	if (!(Mc->flags & MC_CHECK_MODEL)) {
+		return;
+	}
+	
+	Mc_submodel = mn;
+
+	// Check if the ray intersects this subobject's bounding box
+	if ( mc_ray_boundingbox(&sm->min, &sm->max, &Mc_p0, &Mc_direction, &hitpt) ) {
+		if (Mc->flags & MC_ONLY_BOUND_BOX) {
+			float dist = vm_vec_dist( &Mc_p0, &hitpt );
+
+			// If the ray is behind the plane there is no collision
+			if (dist < 0.0f) {
+				goto NoHit;
+			}
+
+			// The ray isn't long enough to intersect the plane
+			if ( !(Mc->flags & MC_CHECK_RAY) && (dist > Mc_mag) ) {
+				goto NoHit;
+			}
+
+			// If the ray hits, but a closer intersection has already been found, return
+			if ( Mc->num_hits && (dist >= Mc->hit_dist) ) {
+				goto NoHit;
+			}
+
+			Mc->hit_dist = dist;
+			Mc->hit_point = hitpt;
+			Mc->hit_submodel = Mc_submodel;
+			Mc->hit_bitmap = -1;
+			Mc->num_hits++;
+		} else {
+			// The ray intersects this bounding box, so we have to check all the
+			// polygons in this submodel.
+			if ( Cmdline_old_collision_sys ) {
+				model_collide_sub(sm->bsp_data);
+			} else {
+				if (Mc->lod > 0 && sm->num_details > 0) {
+					bsp_info *lod_sm = sm;
+
+					for (i = Mc->lod - 1; i >= 0; i--) {
+						if (sm->details[i] != -1) {
+							lod_sm = &Mc_pm->submodel[sm->details[i]];
+
+							//mprintf(("Checking %s collision for %s using %s instead\n", Mc_pm->filename, sm->name, lod_sm->name));
+							break;
+						}
+					}
+
+					mc_check_collision_tree(model_get_bsp_collision_tree(lod_sm->collision_tree_index));
+				} else {
+					mc_check_collision_tree(model_get_bsp_collision_tree(sm->collision_tree_index));
+				}
+			}
+		}
+	}
+
+NoHit:
+
+	// If we're only checking one submodel, return
+	if (Mc->flags & MC_SUBMODEL)	{
+		return;
+	}
+
+	
+	// If this subobject doesn't have any children, we're done checking it.
 	if ( sm->num_children < 1 ) return;
 	
 	// Save instance (Mc_orient, Mc_base, Mc_point_base)
@@ -1224,10 +2119,8 @@ NoHit:
 
 MONITOR(NumFVI)
 
-// See model.h for usage.   I don't want to put the
-// usage here because you need to see the #defines and structures
-// this uses while reading the help.   
-int model_collide(mc_info *mc_info_obj)
+// Does the actual work for model_collide(), without consulting the memo
+static int mc_collide_query(mc_info *mc_info_obj)
 {
 	Mc = mc_info_obj;
 
@@ -1350,6 +2243,412 @@ int model_collide(mc_info *mc_info_obj)
 
 }
 
+// Precomputed queries, see model_collide_memo_add()
+static SCP_vector<mc_memo_entry> Mc_memo;
+static SCP_unordered_map<uint, SCP_vector<int> > Mc_memo_index;
+
+// Where model_collide() records queries on this thread, see model_collide_memo_record()
+static SCP_THREAD_LOCAL SCP_vector<mc_memo_entry> *Mc_memo_recording = NULL;
+
+#define MC_MEMO_SAME(a, b)	(memcmp(&(a), &(b), sizeof(a)) == 0)
+
+static inline uint mc_memo_hash_bytes(uint hash, const void *data, size_t size)
+{
+	const ubyte *bytes = (const ubyte *)data;
+
+	// FNV-1a
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static uint mc_memo_hash(const mc_info *mc, const vec3d *p0, const vec3d *p1)
+{
+	uint hash = 2166136261u;
+
+	hash = mc_memo_hash_bytes(hash, &mc->model_instance_num, sizeof(int));
+	hash = mc_memo_hash_bytes(hash, &mc->flags, sizeof(int));
+	hash = mc_memo_hash_bytes(hash, p0, sizeof(vec3d));
+	hash = mc_memo_hash_bytes(hash, p1, sizeof(vec3d));
+
+	return hash;
+}
+
+// Everything model_collide() reads from the instance and the model which can
+// change while a mission is running
+static void mc_memo_snapshot(mc_memo_entry *entry, const mc_info *mc)
+{
+	polymodel *pm = model_get(mc->model_num);
+	polymodel_instance *pmi = model_get_instance(mc->model_instance_num);
+
+	entry->root_blown_off = pm->submodel[pm->detail[0]].blown_off;
+	entry->instance_state.assign(pmi->submodel, pmi->submodel + pm->n_models);
+}
+
+static bool mc_memo_matches(const mc_memo_entry *entry, const mc_info *mc)
+{
+	const mc_info *b = &entry->before;
+
+	// the query itself
+	if ( (mc->model_instance_num != b->model_instance_num) || (mc->model_num != b->model_num)
+		|| (mc->submodel_num != b->submodel_num) || (mc->flags != b->flags) || (mc->lod != b->lod) ) {
+		return false;
+	}
+
+	if ( !MC_MEMO_SAME(mc->radius, b->radius) || !MC_MEMO_SAME(*mc->orient, entry->orient) || !MC_MEMO_SAME(*mc->pos, entry->pos)
+		|| !MC_MEMO_SAME(*mc->p0, entry->p0) || !MC_MEMO_SAME(*mc->p1, entry->p1) ) {
+		return false;
+	}
+
+	// model_collide() leaves some of the outputs alone when nothing is hit, so
+	// the caller has to start from the same values for the results to be the same
+	if ( (mc->num_hits != b->num_hits) || !MC_MEMO_SAME(mc->hit_dist, b->hit_dist) || !MC_MEMO_SAME(mc->hit_point, b->hit_point)
+		|| !MC_MEMO_SAME(mc->hit_point_world, b->hit_point_world) || (mc->hit_submodel != b->hit_submodel)
+		|| (mc->hit_bitmap != b->hit_bitmap) || !MC_MEMO_SAME(mc->hit_u, b->hit_u) || !MC_MEMO_SAME(mc->hit_v, b->hit_v)
+		|| (mc->shield_hit_tri != b->shield_hit_tri) || !MC_MEMO_SAME(mc->hit_normal, b->hit_normal) || (mc->edge_hit != b->edge_hit)
+		|| (mc->f_poly != b->f_poly) || (mc->t_poly != b->t_poly) || (mc->bsp_leaf != b->bsp_leaf) ) {
+		return false;
+	}
+
+	// and the model has to be in the same state as when the entry was made
+	polymodel *pm = model_get(mc->model_num);
+	polymodel_instance *pmi = model_get_instance(mc->model_instance_num);
+
+	if ( (pm->submodel[pm->detail[0]].blown_off != entry->root_blown_off) || ((int)entry->instance_state.size() != pm->n_models) ) {
+		return false;
+	}
+
+	return memcmp(pmi->submodel, &entry->instance_state[0], sizeof(submodel_instance) * pm->n_models) == 0;
+}
+
+static bool mc_memo_lookup(mc_info *mc, int *result)
+{
+	SCP_unordered_map<uint, SCP_vector<int> >::iterator it = Mc_memo_index.find(mc_memo_hash(mc, mc->p0, mc->p1));
+
+	if ( it == Mc_memo_index.end() ) {
+		return false;
+	}
+
+	for (size_t i = 0; i < it->second.size(); i++) {
+		mc_memo_entry *entry = &Mc_memo[it->second[i]];
+
+		if ( !mc_memo_matches(entry, mc) ) {
+			continue;
+		}
+
+		// copy the results, but keep pointing at the caller's inputs
+		matrix *orient = mc->orient;
+		vec3d *pos = mc->pos;
+		vec3d *p0 = mc->p0;
+		vec3d *p1 = mc->p1;
+
+		*mc = entry->after;
+
+		mc->orient = orient;
+		mc->pos = pos;
+		mc->p0 = p0;
+		mc->p1 = p1;
+
+		*result = entry->result;
+		return true;
+	}
+
+	return false;
+}
+
+static void mc_memo_forget_inputs(mc_info *mc)
+{
+	mc->orient = NULL;
+	mc->pos = NULL;
+	mc->p0 = NULL;
+	mc->p1 = NULL;
+}
+
+// Runs the query and appends it to Mc_memo_recording
+static int mc_memo_record(mc_info *mc)
+{
+	mc_memo_entry entry;
+
+	entry.before = *mc;
+	entry.orient = *mc->orient;
+	entry.pos = *mc->pos;
+	entry.p0 = *mc->p0;
+	entry.p1 = *mc->p1;
+	mc_memo_snapshot(&entry, mc);
+
+	entry.result = mc_collide_query(mc);
+	entry.after = *mc;
+
+	// entries get copied around, so don't hang on to the caller's pointers;
+	// the inputs are always read from the copies above
+	mc_memo_forget_inputs(&entry.before);
+	mc_memo_forget_inputs(&entry.after);
+
+	Mc_memo_recording->push_back(entry);
+
+	return entry.result;
+}
+
+// See model.h for usage.   I don't want to put the
+// usage here because you need to see the #defines and structures
+// this uses while reading the help.   
+int model_collide(mc_info *mc_info_obj)
+{
+	int result;
+
+	if ( mc_info_obj->model_instance_num >= 0 ) {
+		if ( Mc_memo_recording ) {
+			return mc_memo_record(mc_info_obj);
+		}
+
+		if ( !Mc_memo_index.empty() && mc_memo_lookup(mc_info_obj, &result) ) {
+			MONITOR_INC(NumFVI,1);
+			return result;
+		}
+	}
+
+	return mc_collide_query(mc_info_obj);
+}
+
+// mc_check_subobj() for the rays of a batch in ray_mask.  All the rays are against the
+// same instance, so the submodel transforms in Mc_orient and Mc_base are shared, and
+// each submodel's collision tree is walked once for every ray that hits its box.
+static void mc_batch_check_subobj(int mn, mc_batch_ray *rays, int ray_mask)
+{
+	vec3d tempv;
+	bsp_info *sm;
+	int i, r;
+	int child_rays = 0;		// rays that go on to the children
+	int box_rays = 0;		// rays that hit this submodel's bounding box
+
+	Assert( (mn >= 0) && (mn < Mc_pm->n_models) );
+
+	sm = &Mc_pm->submodel[mn];
+	if (sm->no_collisions) return; // don't do collisions
+
+	for ( r = 0; r < MC_BATCH_MAX_RAYS; ++r ) {
+		if ( !(ray_mask & (1 << r)) ) {
+			continue;
+		}
+
+		// Don't collide for this model, but keep checking others
+		if ( sm->nocollide_this_only ) {
+			child_rays |= (1 << r);
+			continue;
+		}
+
+		mc_batch_ray *ray = &rays[r];
+
+		vm_vec_sub(&tempv, ray->mc->p0, &Mc_base);
+		vm_vec_rotate(&ray->p0, &tempv, &Mc_orient);
+
+		vm_vec_sub(&tempv, ray->mc->p1, &Mc_base);
+		vm_vec_rotate(&ray->p1, &tempv, &Mc_orient);
+		vm_vec_sub(&ray->direction, &ray->p1, &ray->p0);
+
+		// no ray exists, so neither this submodel nor its children get checked
+		if ( IS_VEC_NULL(&ray->direction) ) {
+			continue;
+		}
+
+		// Quickly bail if we aren't inside the full model bbox
+		if ( (Mc_pm->detail[0] == mn) && !mc_ray_boundingbox(&Mc_pm->mins, &Mc_pm->maxs, &ray->p0, &ray->direction, NULL) ) {
+			continue;
+		}
+
+		child_rays |= (1 << r);
+
+		if ( mc_ray_boundingbox(&sm->min, &sm->max, &ray->p0, &ray->direction, NULL) ) {
+			mc_bvh_inverse_direction(&ray->inv_dir, &ray->direction);
+			ray->dir_mag = vm_vec_mag(&ray->direction);
+			box_rays |= (1 << r);
+		}
+	}
+
+	if ( box_rays ) {
+		bsp_info *lod_sm = sm;
+		int lod = rays[0].mc->lod;
+
+		Mc_submodel = mn;
+
+		if (lod > 0 && sm->num_details > 0) {
+			for (i = lod - 1; i >= 0; i--) {
+				if (sm->details[i] != -1) {
+					lod_sm = &Mc_pm->submodel[sm->details[i]];
+					break;
+				}
+			}
+		}
+
+		bsp_collision_tree *tree = model_get_bsp_collision_tree(lod_sm->collision_tree_index);
+
+		if ( (tree->bvh_node_list != NULL) && !Mc_bvh_disabled ) {
+			model_collide_bvh_batch(tree, rays, box_rays);
+		} else {
+			for ( r = 0; r < MC_BATCH_MAX_RAYS; ++r ) {
+				if ( box_rays & (1 << r) ) {
+					mc_batch_select(&rays[r]);
+					model_collide_bsp(tree, 0);
+				}
+			}
+		}
+	}
+
+	if ( !child_rays ) {
+		return;
+	}
+
+	// Save instance (Mc_orient, Mc_base)
+	matrix saved_orient = Mc_orient;
+	vec3d saved_base = Mc_base;
+
+	// Check all of this subobject's children
+	i = sm->first_child;
+	while ( i >= 0 )	{
+		bsp_info *csm = &Mc_pm->submodel[i];
+
+		// Don't check it or its children if it is destroyed
+		// or if it's set to no collision
+		if ( !Mc_pmi->submodel[i].blown_off && !Mc_pmi->submodel[i].collision_checked && !csm->no_collisions )	{
+			Mc_orient = Mc_pmi->submodel[i].mc_orient;
+			Mc_base = Mc_pmi->submodel[i].mc_base;
+			vm_vec_add2(&Mc_base, rays[0].mc->pos);
+
+			mc_batch_check_subobj(i, rays, child_rays);
+		}
+
+		i = csm->next_sibling;
+	}
+
+	Mc_orient = saved_orient;
+	Mc_base = saved_base;
+}
+
+// Whether model_collide_batch() can trace a query along with the first one it took:
+// a plain ray or segment check of the polys, against the same instance in the same spot
+static bool mc_batch_can_trace(mc_info *mc, mc_info *lead)
+{
+	if ( (mc->model_instance_num < 0) || Mc_memo_recording || Cmdline_old_collision_sys ) {
+		return false;
+	}
+
+	if ( !(mc->flags & MC_CHECK_MODEL) || (mc->flags & (MC_CHECK_SHIELD | MC_ONLY_SPHERE | MC_ONLY_BOUND_BOX | MC_CHECK_SPHERELINE | MC_SUBMODEL | MC_SUBMODEL_INSTANCE)) ) {
+		return false;
+	}
+
+	if ( lead == NULL ) {
+		return true;
+	}
+
+	return (mc->model_num == lead->model_num) && (mc->model_instance_num == lead->model_instance_num) && (mc->lod == lead->lod)
+		&& MC_MEMO_SAME(*mc->orient, *lead->orient) && MC_MEMO_SAME(*mc->pos, *lead->pos);
+}
+
+int model_collide_batch(mc_info **queries, int *results, int count)
+{
+	mc_batch_ray rays[MC_BATCH_MAX_RAYS];
+	int ray_query[MC_BATCH_MAX_RAYS];
+	int num_rays = 0;
+	int ray_mask = 0;
+	int i, r, num_hit = 0;
+
+	for ( i = 0; i < count; ++i ) {
+		mc_info *mc = queries[i];
+
+		if ( (num_rays == MC_BATCH_MAX_RAYS) || !mc_batch_can_trace(mc, (num_rays > 0) ? rays[0].mc : NULL) ) {
+			results[i] = model_collide(mc);
+			continue;
+		}
+
+		// a precomputed result still wins
+		if ( !Mc_memo_index.empty() && mc_memo_lookup(mc, &results[i]) ) {
+			MONITOR_INC(NumFVI,1);
+			continue;
+		}
+
+		ray_query[num_rays] = i;
+		rays[num_rays++].mc = mc;
+	}
+
+	if ( num_rays > 0 ) {
+		mc_info *lead = rays[0].mc;
+
+		Mc_pm = model_get(lead->model_num);
+		Mc_pmi = model_get_instance(lead->model_instance_num);
+		Mc_orient = *lead->orient;
+		Mc_base = *lead->pos;
+		Mc_edge_time = FLT_MAX;
+
+		// the bounding sphere check, as in mc_collide_query()
+		for ( r = 0; r < num_rays; ++r ) {
+			Mc = rays[r].mc;
+
+			MONITOR_INC(NumFVI,1);
+
+			Mc->num_hits = 0;
+			Mc->shield_hit_tri = -1;
+			Mc->hit_bitmap = -1;
+			Mc->edge_hit = 0;
+
+			int hit;
+
+			if ( Mc->flags & MC_CHECK_RAY ) {
+				hit = fvi_ray_sphere(&Mc->hit_point_world, Mc->p0, Mc->p1, Mc->pos, Mc_pm->rad);
+			} else {
+				hit = fvi_segment_sphere(&Mc->hit_point_world, Mc->p0, Mc->p1, Mc->pos, Mc_pm->rad);
+			}
+
+			if ( hit ) {
+				ray_mask |= (1 << r);
+			}
+		}
+
+		// Don't check it or its children if it is destroyed
+		if ( ray_mask && !Mc_pm->submodel[Mc_pm->detail[0]].blown_off ) {
+			mc_batch_check_subobj(Mc_pm->detail[0], rays, ray_mask);
+		}
+
+		for ( r = 0; r < num_rays; ++r ) {
+			Mc = rays[r].mc;
+
+			// If we found a hit, then rotate it into world coordinates
+			if ( Mc->num_hits ) {
+				model_instance_find_world_point(&Mc->hit_point_world, &Mc->hit_point, Mc->model_num, Mc->model_instance_num, Mc->hit_submodel, Mc->orient, Mc->pos);
+			}
+
+			results[ray_query[r]] = Mc->num_hits;
+		}
+	}
+
+	for ( i = 0; i < count; ++i ) {
+		if ( results[i] ) {
+			num_hit++;
+		}
+	}
+
+	return num_hit;
+}
+
+void model_collide_memo_record(SCP_vector<mc_memo_entry> *entries)
+{
+	Mc_memo_recording = entries;
+}
+
+void model_collide_memo_add(const mc_memo_entry *entry)
+{
+	Mc_memo.push_back(*entry);
+	Mc_memo_index[mc_memo_hash(&entry->before, &entry->p0, &entry->p1)].push_back((int)Mc_memo.size() - 1);
+}
+
+void model_collide_memo_clear()
+{
+	Mc_memo.clear();
+	Mc_memo_index.clear();
+}
+
 void model_collide_preprocess_subobj(vec3d *pos, matrix *orient, polymodel *pm,  polymodel_instance *pmi, int subobj_num)
 {
 	submodel_instance *smi = &pmi->submodel[subobj_num];
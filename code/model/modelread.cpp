@@ -25,6 +25,8 @@
 #include "freespace2/freespace.h"		// For flFrameTime
 #include "gamesnd/gamesnd.h"
 #include "globalincs/linklist.h"
+#include "globalincs/systemvars.h"
+#include "globalincs/workerpool.h"
 #include "io/key.h"
 #include "io/timer.h"
 #include "math/fvi.h"
@@ -244,6 +246,8 @@ void model_unload(int modelnum, int force)
 		delete[] pm->submodel;
 	}
 
+	model_cache_release(pm);
+
 	if ( !Cmdline_nohtl ) {
 		gr_destroy_buffer(pm->vertex_buffer_id);
 	}
@@ -742,7 +746,9 @@ void create_vertex_buffer(polymodel *pm)
 
 	// determine the size and configuration of each buffer segment
 	for (i = 0; i < pm->n_models; i++) {
-		interp_configure_vertex_buffers(pm, i);
+		if ( !model_cache_load_vertex_buffer(pm, i) ) {
+			interp_configure_vertex_buffers(pm, i);
+		}
 	}
 
 	// figure out which vertices are transparent
@@ -783,6 +789,8 @@ void create_vertex_buffer(polymodel *pm)
 	for (i = 0; i < pm->n_models; i++) {
 		interp_pack_vertex_buffers(pm, i);
 
+		model_cache_keep_vertex_buffer(pm, i);
+
 		// release temporary memory
 		pm->submodel[i].buffer.release();
 		pm->submodel[i].trans_buffer.release();
@@ -2427,6 +2435,28 @@ void model_load_texture(polymodel *pm, int i, char *file)
 	}
 }
 
+typedef struct model_collision_build_data {
+	polymodel *pm;
+	bool parse;
+} model_collision_build_data;
+
+// Builds the collision tree of one submodel.  Each submodel writes only its own tree, so with
+// -mt_loading model_load() runs these on the worker pool.
+static void model_collision_build_job(void *data, int index)
+{
+	model_collision_build_data *build_data = (model_collision_build_data *)data;
+	polymodel *pm = build_data->pm;
+	bsp_collision_tree *tree = model_get_bsp_collision_tree(pm->submodel[index].collision_tree_index);
+
+	if ( build_data->parse ) {
+		model_collide_parse_bsp(tree, pm->submodel[index].bsp_data, pm->version);
+	}
+
+	if ( Cmdline_collision_bvh ) {
+		model_collide_build_bvh(tree);
+	}
+}
+
 //returns the number of this model
 int model_load(char *filename, int n_subsystems, model_subsystem *subsystems, int ferror, int duplicate)
 {
@@ -2463,6 +2493,9 @@ int model_load(char *filename, int n_subsystems, model_subsystem *subsystems, in
 
 	mprintf(( "Loading model '%s'\n", filename ));
 
+	uint load_start = timer_get_high_res_microseconds();
+	uint load_worker_us = 0;
+
 	pm = new polymodel;	
 	Polygon_models[num] = pm;
 
@@ -2560,6 +2593,9 @@ int model_load(char *filename, int n_subsystems, model_subsystem *subsystems, in
 
 	create_family_tree(pm);
 
+	// with -model_cache, whatever the cache file has for this POF doesn't need building again
+	bool cached = Cmdline_model_cache && !Cmdline_old_collision_sys && model_cache_open(pm, Global_checksum);
+
 	// maybe generate vertex buffers
 	create_vertex_buffer(pm);
 
@@ -2665,14 +2701,38 @@ int model_load(char *filename, int n_subsystems, model_subsystem *subsystems, in
 	}
 
 
-	model_octant_create( pm );
+	if ( !cached || !model_cache_load_octants(pm) ) {
+		model_octant_create( pm );
+	}
 
 	if ( !Cmdline_old_collision_sys ) {
-		for ( i = 0; i < pm->n_models; ++i ) {
-			pm->submodel[i].collision_tree_index = model_create_bsp_collision_tree();
-			bsp_collision_tree *tree = model_get_bsp_collision_tree(pm->submodel[i].collision_tree_index);
+		uint build_start = timer_get_high_res_microseconds();
+
+		// the tree list may grow here, so slots are handed out before any parsing starts
+		if ( cached ) {
+			model_cache_load_collision(pm);
+		} else {
+			for ( i = 0; i < pm->n_models; ++i ) {
+				pm->submodel[i].collision_tree_index = model_create_bsp_collision_tree();
+			}
+		}
+
+		model_collision_build_data build_data;
+
+		build_data.pm = pm;
+		build_data.parse = !cached;
+
+		if ( Cmdline_mt_loading && (pm->n_models > 1) ) {
+			worker_pool_run(model_collision_build_job, &build_data, pm->n_models);
+			load_worker_us = timer_get_high_res_microseconds() - build_start;
+		} else {
+			for ( i = 0; i < pm->n_models; ++i ) {
+				model_collision_build_job(&build_data, i);
+			}
+		}
 
-			model_collide_parse_bsp(tree, pm->submodel[i].bsp_data, pm->version);
+		if ( Cmdline_model_cache && !cached ) {
+			model_cache_save(pm, Global_checksum);
 		}
 	}
 
@@ -2707,6 +2767,8 @@ int model_load(char *filename, int n_subsystems, model_subsystem *subsystems, in
 	model_set_subsys_path_nums(pm, n_subsystems, subsystems);
 	model_set_bay_path_nums(pm);
 
+	load_stats_add(LOAD_STATS_MODELS, 1, load_worker_us, timer_get_high_res_microseconds() - load_start - load_worker_us);
+
 	return pm->id;
 }
 
@@ -5064,6 +5126,7 @@ int model_create_bsp_collision_tree()
 
 	if ( slot_found ) {
 		Bsp_collision_tree_list[i].used = true;
+		Bsp_collision_tree_list[i].mapped = false;
 
 		return (int)i;
 	}
@@ -5071,6 +5134,7 @@ int model_create_bsp_collision_tree()
 	bsp_collision_tree tree;
 
 	tree.used = true;
+	tree.mapped = false;
 	Bsp_collision_tree_list.push_back(tree);
 
 	return Bsp_collision_tree_list.size() - 1;
@@ -5088,20 +5152,699 @@ void model_remove_bsp_collision_tree(int tree_index)
 {
 	Bsp_collision_tree_list[tree_index].used = false;
 
-	if ( Bsp_collision_tree_list[tree_index].node_list ) {
-		vm_free(Bsp_collision_tree_list[tree_index].node_list);
+	// trees loaded from the model cache point into its mapping, which model_cache_release() closes
+	if ( !Bsp_collision_tree_list[tree_index].mapped ) {
+		if ( Bsp_collision_tree_list[tree_index].node_list ) {
+			vm_free(Bsp_collision_tree_list[tree_index].node_list);
+		}
+
+		if ( Bsp_collision_tree_list[tree_index].leaf_list ) {
+			vm_free(Bsp_collision_tree_list[tree_index].leaf_list);
+		}
+		
+		if ( Bsp_collision_tree_list[tree_index].point_list ) {
+			vm_free( Bsp_collision_tree_list[tree_index].point_list );
+		}
+		
+		if ( Bsp_collision_tree_list[tree_index].vert_list ) {
+			vm_free( Bsp_collision_tree_list[tree_index].vert_list);
+		}
 	}
 
-	if ( Bsp_collision_tree_list[tree_index].leaf_list ) {
-		vm_free(Bsp_collision_tree_list[tree_index].leaf_list);
+	model_collide_free_bvh(&Bsp_collision_tree_list[tree_index]);
+}
+
+//=========================== MODEL CACHE ================================
+//
+// With -model_cache the work model_load() does on a POF that doesn't depend on anything but
+// the POF is written to data/cache/<model>.mcc after the model is loaded: the collision trees
+// built by model_collide_parse_bsp(), the vertex and index data interp_configure_vertex_buffers()
+// builds for each submodel, and the face and shield lists of the octants.  Later loads of the
+// same POF map that file and point the trees straight into it, copy the vertex data into the
+// submodel buffers and turn the stored octant offsets back into pointers, instead of walking
+// the BSP data again.  The file is only trusted if its header matches the POF's checksum and
+// the layout and vertex format of this build.
+
+#define MODEL_CACHE_ID			0x3143434d		// "MCC1"
+#define MODEL_CACHE_VERSION		2
+#define MODEL_CACHE_BYTE_ORDER	0x01020304
+#define MODEL_CACHE_ALIGN		8
+#define MODEL_CACHE_OCTANTS		8
+
+// what's in the vertex data, see model_cache_fill_header()
+#define MODEL_CACHE_VERTS		(1<<0)
+#define MODEL_CACHE_TSB			(1<<1)
+#define MODEL_CACHE_MODEL_ID	(1<<2)
+
+typedef struct model_cache_header {
+	int id;
+	int version;
+	int byte_order;
+	uint pof_checksum;
+	int n_models;
+	int vertex_flags;
+
+	// record the layout of what follows, so a cache written by another build is rejected
+	int node_size;
+	int leaf_size;
+	int tmap_vert_size;
+	int point_size;
+	int vertex_size;
+	int tsb_size;
+} model_cache_header;
+
+// all offsets are from the start of the file and MODEL_CACHE_ALIGN aligned
+typedef struct model_cache_submodel {
+	// collision tree
+	int n_verts;
+	int n_nodes;
+	int n_leaves;
+	int n_tmap_verts;
+
+	int point_offset;
+	int node_offset;
+	int leaf_offset;
+	int tmap_vert_offset;
+
+	// vertex buffer; no model list if n_buffer_verts is 0
+	int n_buffer_verts;
+	int n_tex_bufs;
+	int n_outline_verts;
+
+	int buffer_vert_offset;
+	int buffer_norm_offset;
+	int buffer_tsb_offset;
+	int buffer_id_offset;
+	int tex_buf_offset;					// n_tex_bufs model_cache_tex_buf
+	int outline_offset;
+} model_cache_submodel;
+
+typedef struct model_cache_tex_buf {
+	int texture;
+	int flags;
+	int n_verts;
+	int index_offset;					// n_verts uints
+} model_cache_tex_buf;
+
+typedef struct model_cache_octant {
+	vec3d min, max;
+	int nverts;
+	int nshield_tris;
+	int vert_offset;					// nverts ints, offsets of the face centers into the bsp_data of detail 0
+	int shield_tri_offset;				// nshield_tris ints, indexes into pm->shield.tris
+} model_cache_octant;
+
+// open cache mappings, by model slot
+static CFILE *Model_cache_files[MAX_POLYGON_MODELS];
+
+// the vertex buffer of one submodel, kept from create_vertex_buffer() for model_cache_save()
+typedef struct model_cache_vertex_data {
+	SCP_vector<vertex> verts;
+	SCP_vector<vec3d> norms;
+	SCP_vector<tsb_t> tsbs;
+	SCP_vector<int> model_ids;
+	SCP_vector<model_cache_tex_buf> tex_bufs;
+	SCP_vector< SCP_vector<uint> > indices;
+} model_cache_vertex_data;
+
+// vertex buffers of the model being loaded, by submodel
+static SCP_vector<model_cache_vertex_data> Model_cache_buffers;
+
+static void model_cache_filename(char *out, size_t out_size, polymodel *pm)
+{
+	char *p;
+
+	strncpy(out, pm->filename, out_size - 5);
+	out[out_size - 5] = '\0';
+
+	p = strrchr(out, '.');
+	if (p != NULL)
+		*p = '\0';
+
+	strcat(out, ".mcc");
+}
+
+static void model_cache_fill_header(model_cache_header *hdr, polymodel *pm, uint checksum)
+{
+	memset(hdr, 0, sizeof(model_cache_header));
+
+	hdr->id = MODEL_CACHE_ID;
+	hdr->version = MODEL_CACHE_VERSION;
+	hdr->byte_order = MODEL_CACHE_BYTE_ORDER;
+	hdr->pof_checksum = checksum;
+	hdr->n_models = pm->n_models;
+
+	// same conditions as create_vertex_buffer() and poly_list::allocate()
+	if ( !Cmdline_nohtl && !Is_standalone ) {
+		hdr->vertex_flags |= MODEL_CACHE_VERTS;
+
+		if (Cmdline_normal)
+			hdr->vertex_flags |= MODEL_CACHE_TSB;
+
+		if (Use_GLSL >= 3)
+			hdr->vertex_flags |= MODEL_CACHE_MODEL_ID;
 	}
-	
-	if ( Bsp_collision_tree_list[tree_index].point_list ) {
-		vm_free( Bsp_collision_tree_list[tree_index].point_list );
+
+	hdr->node_size = sizeof(bsp_collision_node);
+	hdr->leaf_size = sizeof(bsp_collision_leaf);
+	hdr->tmap_vert_size = sizeof(model_tmap_vert);
+	hdr->point_size = sizeof(vec3d);
+	hdr->vertex_size = sizeof(vertex);
+	hdr->tsb_size = sizeof(tsb_t);
+}
+
+static int model_cache_align(int offset)
+{
+	return (offset + MODEL_CACHE_ALIGN - 1) & ~(MODEL_CACHE_ALIGN - 1);
+}
+
+static bool model_cache_range_ok(int offset, int count, int elem_size, int size)
+{
+	return (offset >= 0) && (count >= 0) && (offset + count * elem_size <= size);
+}
+
+// the tree doesn't keep the length of its vert list, so work it out from the leaves
+static int model_cache_count_tmap_verts(bsp_collision_tree *tree)
+{
+	int i, count = 0;
+
+	for (i = 0; i < tree->n_leaves; i++)
+		count = MAX(count, tree->leaf_list[i].vert_start + tree->leaf_list[i].num_verts);
+
+	return count;
+}
+
+static model_cache_submodel *model_cache_get_submodels(polymodel *pm)
+{
+	return (model_cache_submodel *)((ubyte *)cf_returndata(Model_cache_files[pm->id % MAX_POLYGON_MODELS]) + sizeof(model_cache_header));
+}
+
+/**
+ * Map the cache file of pm, if there is one that's valid for this POF and build.  The model_cache_load_*()
+ * functions take what they need from it, and it stays mapped until model_cache_release().
+ *
+ * @return true if the cache is valid, false if everything still needs building
+ */
+bool model_cache_open(polymodel *pm, uint checksum)
+{
+	char filename[MAX_FILENAME_LEN];
+	CFILE *fp;
+	ubyte *data;
+	int i, j, size;
+	model_cache_header hdr, *file_hdr;
+	model_cache_submodel *sub;
+	model_cache_octant *oct;
+	int num = pm->id % MAX_POLYGON_MODELS;
+
+	Assert(Model_cache_files[num] == NULL);
+
+	Model_cache_buffers.clear();
+
+	model_cache_filename(filename, sizeof(filename), pm);
+
+	fp = cfopen(filename, "rb", CFILE_MEMORY_MAPPED, CF_TYPE_CACHE);
+	if (fp == NULL)
+		return false;
+
+	data = (ubyte *)cf_returndata(fp);
+	size = cfilelength(fp);
+
+	model_cache_fill_header(&hdr, pm, checksum);
+	file_hdr = (model_cache_header *)data;
+
+	if ( ((size_t)data & (MODEL_CACHE_ALIGN - 1))
+		|| !model_cache_range_ok(0, 1, sizeof(model_cache_header) + sizeof(model_cache_submodel) * pm->n_models + sizeof(model_cache_octant) * MODEL_CACHE_OCTANTS, size)
+		|| memcmp(file_hdr, &hdr, sizeof(model_cache_header)) ) {
+		nprintf(("Model", "Model cache '%s' is stale, rebuilding\n", filename));
+		cfclose(fp);
+		return false;
 	}
-	
-	if ( Bsp_collision_tree_list[tree_index].vert_list ) {
-		vm_free( Bsp_collision_tree_list[tree_index].vert_list);
+
+	sub = (model_cache_submodel *)(data + sizeof(model_cache_header));
+	oct = (model_cache_octant *)(sub + pm->n_models);
+
+	// check every range before anything is handed out
+	bool ok = true;
+
+	for (i = 0; ok && (i < pm->n_models); i++) {
+		ok = model_cache_range_ok(sub[i].point_offset, sub[i].n_verts, sizeof(vec3d), size)
+			&& model_cache_range_ok(sub[i].node_offset, sub[i].n_nodes, sizeof(bsp_collision_node), size)
+			&& model_cache_range_ok(sub[i].leaf_offset, sub[i].n_leaves, sizeof(bsp_collision_leaf), size)
+			&& model_cache_range_ok(sub[i].tmap_vert_offset, sub[i].n_tmap_verts, sizeof(model_tmap_vert), size);
+
+		if ( !ok || !(hdr.vertex_flags & MODEL_CACHE_VERTS) )
+			continue;
+
+		ok = model_cache_range_ok(sub[i].buffer_vert_offset, sub[i].n_buffer_verts, sizeof(vertex), size)
+			&& model_cache_range_ok(sub[i].buffer_norm_offset, sub[i].n_buffer_verts, sizeof(vec3d), size)
+			&& model_cache_range_ok(sub[i].tex_buf_offset, sub[i].n_tex_bufs, sizeof(model_cache_tex_buf), size)
+			&& model_cache_range_ok(sub[i].outline_offset, sub[i].n_outline_verts, sizeof(vertex), size);
+
+		if ( ok && (hdr.vertex_flags & MODEL_CACHE_TSB) )
+			ok = model_cache_range_ok(sub[i].buffer_tsb_offset, sub[i].n_buffer_verts, sizeof(tsb_t), size);
+
+		if ( ok && (hdr.vertex_flags & MODEL_CACHE_MODEL_ID) )
+			ok = model_cache_range_ok(sub[i].buffer_id_offset, sub[i].n_buffer_verts, sizeof(int), size);
+
+		for (j = 0; ok && (j < sub[i].n_tex_bufs); j++) {
+			model_cache_tex_buf *tb = (model_cache_tex_buf *)(data + sub[i].tex_buf_offset) + j;
+
+			ok = model_cache_range_ok(tb->index_offset, tb->n_verts, sizeof(uint), size);
+		}
+	}
+
+	for (i = 0; ok && (i < MODEL_CACHE_OCTANTS); i++) {
+		ok = model_cache_range_ok(oct[i].vert_offset, oct[i].nverts, sizeof(int), size)
+			&& model_cache_range_ok(oct[i].shield_tri_offset, oct[i].nshield_tris, sizeof(int), size);
+	}
+
+	if ( !ok ) {
+		nprintf(("Model", "Model cache '%s' is truncated, rebuilding\n", filename));
+		cfclose(fp);
+		return false;
+	}
+
+	Model_cache_files[num] = fp;
+
+	return true;
+}
+
+/**
+ * Fill in the vertex buffer of submodel mn from the open cache, in place of interp_configure_vertex_buffers().
+ *
+ * @return true if it was filled in and configured, false if there's no cache open for pm
+ */
+bool model_cache_load_vertex_buffer(polymodel *pm, int mn)
+{
+	int i, j;
+	CFILE *fp = Model_cache_files[pm->id % MAX_POLYGON_MODELS];
+
+	if (fp == NULL)
+		return false;
+
+	ubyte *data = (ubyte *)cf_returndata(fp);
+	model_cache_submodel *sub = &model_cache_get_submodels(pm)[mn];
+	bsp_info *model = &pm->submodel[mn];
+
+	if (sub->n_outline_verts > 0) {
+		model->n_verts_outline = sub->n_outline_verts;
+		model->outline_buffer = (vertex *)vm_malloc(sizeof(vertex) * model->n_verts_outline);
+		memcpy(model->outline_buffer, data + sub->outline_offset, sizeof(vertex) * model->n_verts_outline);
+	}
+
+	if (sub->n_buffer_verts < 1)
+		return true;
+
+	poly_list *model_list = new(std::nothrow) poly_list;
+
+	if ( !model_list ) {
+		Error( LOCATION, "Unable to allocate memory for poly_list!\n" );
+	}
+
+	model->buffer.model_list = model_list;
+
+	model_list->allocate(sub->n_buffer_verts);
+	model_list->n_verts = sub->n_buffer_verts;
+
+	memcpy(model_list->vert, data + sub->buffer_vert_offset, sizeof(vertex) * model_list->n_verts);
+	memcpy(model_list->norm, data + sub->buffer_norm_offset, sizeof(vec3d) * model_list->n_verts);
+
+	int vertex_flags = (VB_FLAG_POSITION | VB_FLAG_NORMAL | VB_FLAG_UV1);
+
+	if (model_list->tsb != NULL) {
+		memcpy(model_list->tsb, data + sub->buffer_tsb_offset, sizeof(tsb_t) * model_list->n_verts);
+		vertex_flags |= VB_FLAG_TANGENT;
+	}
+
+	if (model_list->submodels != NULL) {
+		memcpy(model_list->submodels, data + sub->buffer_id_offset, sizeof(int) * model_list->n_verts);
+		vertex_flags |= VB_FLAG_MODEL_ID;
+	}
+
+	model->buffer.flags = vertex_flags;
+
+	model_cache_tex_buf *tb = (model_cache_tex_buf *)(data + sub->tex_buf_offset);
+
+	for (i = 0; i < sub->n_tex_bufs; i++) {
+		uint *index = (uint *)(data + tb[i].index_offset);
+
+		model->buffer.tex_buf.push_back( buffer_data(tb[i].n_verts) );
+
+		buffer_data &new_buffer = model->buffer.tex_buf.back();
+
+		for (j = 0; j < tb[i].n_verts; j++)
+			new_buffer.assign(j, index[j]);
+
+		new_buffer.texture = tb[i].texture;
+		new_buffer.flags = tb[i].flags;
+	}
+
+	if ( !gr_config_buffer(pm->vertex_buffer_id, &model->buffer, false) ) {
+		Error( LOCATION, "Unable to configure vertex buffer for '%s'\n", pm->filename );
+	}
+
+	return true;
+}
+
+/**
+ * Keep a copy of the vertex buffer of submodel mn for model_cache_save(), before create_vertex_buffer()
+ * releases it.  Does nothing if the model came from the cache.
+ */
+void model_cache_keep_vertex_buffer(polymodel *pm, int mn)
+{
+	int i;
+
+	if ( !Cmdline_model_cache || Cmdline_old_collision_sys || (Model_cache_files[pm->id % MAX_POLYGON_MODELS] != NULL) )
+		return;
+
+	// create_vertex_buffer() goes through the submodels in order
+	if (mn == 0) {
+		Model_cache_buffers.clear();
+		Model_cache_buffers.resize(pm->n_models);
+	}
+
+	vertex_buffer *src = &pm->submodel[mn].buffer;
+	poly_list *model_list = src->model_list;
+	model_cache_vertex_data *dest = &Model_cache_buffers[mn];
+
+	if (model_list == NULL)
+		return;
+
+	dest->verts.assign(model_list->vert, model_list->vert + model_list->n_verts);
+	dest->norms.assign(model_list->norm, model_list->norm + model_list->n_verts);
+
+	if (model_list->tsb != NULL)
+		dest->tsbs.assign(model_list->tsb, model_list->tsb + model_list->n_verts);
+
+	if (model_list->submodels != NULL)
+		dest->model_ids.assign(model_list->submodels, model_list->submodels + model_list->n_verts);
+
+	dest->tex_bufs.resize(src->tex_buf.size());
+	dest->indices.resize(src->tex_buf.size());
+
+	for (i = 0; i < (int)src->tex_buf.size(); i++) {
+		buffer_data *tb = &src->tex_buf[i];
+
+		dest->tex_bufs[i].texture = tb->texture;
+		dest->tex_bufs[i].flags = tb->flags;
+		dest->tex_bufs[i].n_verts = tb->n_verts;
+		dest->tex_bufs[i].index_offset = 0;
+
+		dest->indices[i].assign(tb->get_index(), tb->get_index() + tb->n_verts);
+	}
+}
+
+/**
+ * Set up the octants of pm from the open cache, in place of model_octant_create().
+ *
+ * @return true if they were set up, false if they still need creating
+ */
+bool model_cache_load_octants(polymodel *pm)
+{
+	int i, j;
+	CFILE *fp = Model_cache_files[pm->id % MAX_POLYGON_MODELS];
+
+	// model_octant_create() fixes up the face centers of older POFs as it goes
+	if ( (fp == NULL) || (pm->version < 2003) )
+		return false;
+
+	ubyte *data = (ubyte *)cf_returndata(fp);
+	model_cache_octant *oct = (model_cache_octant *)(model_cache_get_submodels(pm) + pm->n_models);
+	bsp_info *detail = &pm->submodel[pm->detail[0]];
+
+	// check the offsets still land in this model before any pointers are made from them
+	for (i = 0; i < MODEL_CACHE_OCTANTS; i++) {
+		int *vert_offset = (int *)(data + oct[i].vert_offset);
+		int *shield_index = (int *)(data + oct[i].shield_tri_offset);
+
+		for (j = 0; j < oct[i].nverts; j++) {
+			if ( (vert_offset[j] < 0) || (vert_offset[j] + (int)sizeof(vec3d) > detail->bsp_data_size) )
+				return false;
+		}
+
+		for (j = 0; j < oct[i].nshield_tris; j++) {
+			if ( (shield_index[j] < 0) || (shield_index[j] >= pm->shield.ntris) )
+				return false;
+		}
+	}
+
+	for (i = 0; i < MODEL_CACHE_OCTANTS; i++) {
+		model_octant *octant = &pm->octants[i];
+		int *vert_offset = (int *)(data + oct[i].vert_offset);
+		int *shield_index = (int *)(data + oct[i].shield_tri_offset);
+
+		octant->min = oct[i].min;
+		octant->max = oct[i].max;
+
+		octant->nverts = oct[i].nverts;
+		octant->verts = NULL;
+
+		if (octant->nverts > 0) {
+			octant->verts = (vec3d **)vm_malloc(sizeof(vec3d *) * octant->nverts);
+
+			for (j = 0; j < octant->nverts; j++)
+				octant->verts[j] = (vec3d *)(detail->bsp_data + vert_offset[j]);
+		}
+
+		octant->nshield_tris = oct[i].nshield_tris;
+		octant->shield_tris = NULL;
+
+		if (octant->nshield_tris > 0) {
+			octant->shield_tris = (shield_tri **)vm_malloc(sizeof(shield_tri *) * octant->nshield_tris);
+
+			for (j = 0; j < octant->nshield_tris; j++)
+				octant->shield_tris[j] = &pm->shield.tris[shield_index[j]];
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Point the submodels of pm at the collision trees stored in the open cache.
+ *
+ * @return true if every submodel has a tree, false if the trees still need building
+ */
+bool model_cache_load_collision(polymodel *pm)
+{
+	int i;
+	CFILE *fp = Model_cache_files[pm->id % MAX_POLYGON_MODELS];
+
+	if (fp == NULL)
+		return false;
+
+	ubyte *data = (ubyte *)cf_returndata(fp);
+	model_cache_submodel *sub = model_cache_get_submodels(pm);
+
+	for (i = 0; i < pm->n_models; i++) {
+		pm->submodel[i].collision_tree_index = model_create_bsp_collision_tree();
+		bsp_collision_tree *tree = model_get_bsp_collision_tree(pm->submodel[i].collision_tree_index);
+
+		tree->mapped = true;
+
+		tree->n_verts = sub[i].n_verts;
+		tree->point_list = sub[i].n_verts ? (vec3d *)(data + sub[i].point_offset) : NULL;
+		tree->n_nodes = sub[i].n_nodes;
+		tree->node_list = sub[i].n_nodes ? (bsp_collision_node *)(data + sub[i].node_offset) : NULL;
+		tree->n_leaves = sub[i].n_leaves;
+		tree->leaf_list = sub[i].n_leaves ? (bsp_collision_leaf *)(data + sub[i].leaf_offset) : NULL;
+		tree->vert_list = sub[i].n_tmap_verts ? (model_tmap_vert *)(data + sub[i].tmap_vert_offset) : NULL;
+
+		tree->bvh_node_list = NULL;
+		tree->n_bvh_nodes = 0;
+		tree->bvh_poly_list = NULL;
+		tree->n_bvh_polys = 0;
+		tree->bvh_point_list = NULL;
+		tree->bvh_uv_list = NULL;
+		tree->bvh_tri_block_list = NULL;
+		tree->bvh_tri_poly_list = NULL;
+		tree->n_bvh_tri_blocks = 0;
+	}
+
+	return true;
+}
+
+// lays out one array of the file, returning where it goes
+static int model_cache_place(int *offset, int count, int elem_size)
+{
+	int start = *offset;
+
+	*offset = model_cache_align(*offset + count * elem_size);
+
+	return start;
+}
+
+// writes one array at the offset model_cache_place() gave it
+static void model_cache_write(CFILE *fp, int offset, const void *buf, int count, int elem_size)
+{
+	static const ubyte pad[MODEL_CACHE_ALIGN] = { 0 };
+
+	Assert( (offset >= cftell(fp)) && (offset - cftell(fp) < MODEL_CACHE_ALIGN) );
+
+	cfwrite(pad, 1, offset - cftell(fp), fp);
+
+	if (count > 0)
+		cfwrite(buf, elem_size, count, fp);
+}
+
+/**
+ * Write the collision trees, vertex buffers and octants of a freshly loaded model to its cache file.
+ */
+void model_cache_save(polymodel *pm, uint checksum)
+{
+	char filename[MAX_FILENAME_LEN];
+	CFILE *fp;
+	int i, j, offset;
+	model_cache_header hdr;
+	SCP_vector<model_cache_submodel> sub;
+	model_cache_octant oct[MODEL_CACHE_OCTANTS];
+	SCP_vector<int> oct_data[MODEL_CACHE_OCTANTS * 2];
+	bsp_info *detail = &pm->submodel[pm->detail[0]];
+
+	model_cache_filename(filename, sizeof(filename), pm);
+
+	model_cache_fill_header(&hdr, pm, checksum);
+
+	if ( (hdr.vertex_flags & MODEL_CACHE_VERTS) && ((int)Model_cache_buffers.size() != pm->n_models) ) {
+		mprintf(("Model cache '%s' not written, the vertex buffers weren't kept\n", filename));
+		Model_cache_buffers.clear();
+		return;
+	}
+
+	sub.resize(pm->n_models);
+	memset(&sub[0], 0, sizeof(model_cache_submodel) * pm->n_models);
+	memset(oct, 0, sizeof(oct));
+
+	// pointers into the bsp data and the shield become offsets and indexes
+	for (i = 0; i < MODEL_CACHE_OCTANTS; i++) {
+		model_octant *octant = &pm->octants[i];
+
+		oct[i].min = octant->min;
+		oct[i].max = octant->max;
+		oct[i].nverts = octant->nverts;
+		oct[i].nshield_tris = octant->nshield_tris;
+
+		for (j = 0; j < octant->nverts; j++)
+			oct_data[i * 2].push_back( (int)((ubyte *)octant->verts[j] - detail->bsp_data) );
+
+		for (j = 0; j < octant->nshield_tris; j++)
+			oct_data[i * 2 + 1].push_back( (int)(octant->shield_tris[j] - pm->shield.tris) );
+	}
+
+	offset = model_cache_align(sizeof(model_cache_header) + sizeof(model_cache_submodel) * pm->n_models + sizeof(model_cache_octant) * MODEL_CACHE_OCTANTS);
+
+	for (i = 0; i < pm->n_models; i++) {
+		bsp_collision_tree *tree = model_get_bsp_collision_tree(pm->submodel[i].collision_tree_index);
+
+		sub[i].n_verts = tree->n_verts;
+		sub[i].n_nodes = tree->n_nodes;
+		sub[i].n_leaves = tree->n_leaves;
+		sub[i].n_tmap_verts = model_cache_count_tmap_verts(tree);
+
+		sub[i].point_offset = model_cache_place(&offset, sub[i].n_verts, sizeof(vec3d));
+		sub[i].node_offset = model_cache_place(&offset, sub[i].n_nodes, sizeof(bsp_collision_node));
+		sub[i].leaf_offset = model_cache_place(&offset, sub[i].n_leaves, sizeof(bsp_collision_leaf));
+		sub[i].tmap_vert_offset = model_cache_place(&offset, sub[i].n_tmap_verts, sizeof(model_tmap_vert));
+
+		if ( !(hdr.vertex_flags & MODEL_CACHE_VERTS) )
+			continue;
+
+		model_cache_vertex_data *vd = &Model_cache_buffers[i];
+
+		sub[i].n_buffer_verts = (int)vd->verts.size();
+		sub[i].n_tex_bufs = (int)vd->tex_bufs.size();
+		sub[i].n_outline_verts = (int)pm->submodel[i].n_verts_outline;
+
+		sub[i].buffer_vert_offset = model_cache_place(&offset, sub[i].n_buffer_verts, sizeof(vertex));
+		sub[i].buffer_norm_offset = model_cache_place(&offset, sub[i].n_buffer_verts, sizeof(vec3d));
+		sub[i].buffer_tsb_offset = model_cache_place(&offset, (hdr.vertex_flags & MODEL_CACHE_TSB) ? sub[i].n_buffer_verts : 0, sizeof(tsb_t));
+		sub[i].buffer_id_offset = model_cache_place(&offset, (hdr.vertex_flags & MODEL_CACHE_MODEL_ID) ? sub[i].n_buffer_verts : 0, sizeof(int));
+		sub[i].tex_buf_offset = model_cache_place(&offset, sub[i].n_tex_bufs, sizeof(model_cache_tex_buf));
+
+		for (j = 0; j < sub[i].n_tex_bufs; j++)
+			vd->tex_bufs[j].index_offset = model_cache_place(&offset, vd->tex_bufs[j].n_verts, sizeof(uint));
+
+		sub[i].outline_offset = model_cache_place(&offset, sub[i].n_outline_verts, sizeof(vertex));
+	}
+
+	for (i = 0; i < MODEL_CACHE_OCTANTS; i++) {
+		oct[i].vert_offset = model_cache_place(&offset, oct[i].nverts, sizeof(int));
+		oct[i].shield_tri_offset = model_cache_place(&offset, oct[i].nshield_tris, sizeof(int));
+	}
+
+	fp = cfopen(filename, "wb", CFILE_NORMAL, CF_TYPE_CACHE);
+	if (fp == NULL) {
+		mprintf(("Unable to write model cache '%s'\n", filename));
+		Model_cache_buffers.clear();
+		return;
+	}
+
+	cfwrite(&hdr, sizeof(model_cache_header), 1, fp);
+	cfwrite(&sub[0], sizeof(model_cache_submodel), pm->n_models, fp);
+	cfwrite(oct, sizeof(model_cache_octant), MODEL_CACHE_OCTANTS, fp);
+
+	for (i = 0; i < pm->n_models; i++) {
+		bsp_collision_tree *tree = model_get_bsp_collision_tree(pm->submodel[i].collision_tree_index);
+
+		model_cache_write(fp, sub[i].point_offset, tree->point_list, sub[i].n_verts, sizeof(vec3d));
+		model_cache_write(fp, sub[i].node_offset, tree->node_list, sub[i].n_nodes, sizeof(bsp_collision_node));
+		model_cache_write(fp, sub[i].leaf_offset, tree->leaf_list, sub[i].n_leaves, sizeof(bsp_collision_leaf));
+		model_cache_write(fp, sub[i].tmap_vert_offset, tree->vert_list, sub[i].n_tmap_verts, sizeof(model_tmap_vert));
+
+		if ( !(hdr.vertex_flags & MODEL_CACHE_VERTS) )
+			continue;
+
+		model_cache_vertex_data *vd = &Model_cache_buffers[i];
+
+		if (sub[i].n_buffer_verts > 0) {
+			model_cache_write(fp, sub[i].buffer_vert_offset, &vd->verts[0], sub[i].n_buffer_verts, sizeof(vertex));
+			model_cache_write(fp, sub[i].buffer_norm_offset, &vd->norms[0], sub[i].n_buffer_verts, sizeof(vec3d));
+
+			Assert( (vd->norms.size() == vd->verts.size()) && (!(hdr.vertex_flags & MODEL_CACHE_TSB) || (vd->tsbs.size() == vd->verts.size()))
+				&& (!(hdr.vertex_flags & MODEL_CACHE_MODEL_ID) || (vd->model_ids.size() == vd->verts.size())) );
+
+			if (hdr.vertex_flags & MODEL_CACHE_TSB)
+				model_cache_write(fp, sub[i].buffer_tsb_offset, &vd->tsbs[0], sub[i].n_buffer_verts, sizeof(tsb_t));
+
+			if (hdr.vertex_flags & MODEL_CACHE_MODEL_ID)
+				model_cache_write(fp, sub[i].buffer_id_offset, &vd->model_ids[0], sub[i].n_buffer_verts, sizeof(int));
+		}
+
+		if (sub[i].n_tex_bufs > 0) {
+			model_cache_write(fp, sub[i].tex_buf_offset, &vd->tex_bufs[0], sub[i].n_tex_bufs, sizeof(model_cache_tex_buf));
+
+			for (j = 0; j < sub[i].n_tex_bufs; j++)
+				model_cache_write(fp, vd->tex_bufs[j].index_offset, vd->indices[j].empty() ? NULL : &vd->indices[j][0], vd->tex_bufs[j].n_verts, sizeof(uint));
+		}
+
+		model_cache_write(fp, sub[i].outline_offset, pm->submodel[i].outline_buffer, sub[i].n_outline_verts, sizeof(vertex));
+	}
+
+	for (i = 0; i < MODEL_CACHE_OCTANTS; i++) {
+		model_cache_write(fp, oct[i].vert_offset, oct[i].nverts ? &oct_data[i * 2][0] : NULL, oct[i].nverts, sizeof(int));
+		model_cache_write(fp, oct[i].shield_tri_offset, oct[i].nshield_tris ? &oct_data[i * 2 + 1][0] : NULL, oct[i].nshield_tris, sizeof(int));
+	}
+
+	// end on the aligned size, like every array
+	model_cache_write(fp, offset, NULL, 0, 1);
+
+	cfclose(fp);
+
+	Model_cache_buffers.clear();
+
+	nprintf(("Model", "Wrote model cache '%s' (%d bytes)\n", filename, offset));
+}
+
+/**
+ * Close the cache mapping a model's collision trees point into.  The trees must be removed first.
+ */
+void model_cache_release(polymodel *pm)
+{
+	int num = pm->id % MAX_POLYGON_MODELS;
+
+	if (Model_cache_files[num] != NULL) {
+		cfclose(Model_cache_files[num]);
+		Model_cache_files[num] = NULL;
 	}
 }
 
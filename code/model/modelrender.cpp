@@ -363,6 +363,8 @@ void draw_list::reset()
 	Current_textures[TM_HEIGHT_TYPE] = -1;
 	Current_textures[TM_MISC_TYPE] = -1;
 
+	Current_screen_size = -1.0f;
+
 	Clip_planes.clear();
 	Render_states.clear();
 	Render_elements.clear();
@@ -757,6 +759,16 @@ void draw_list::set_texture(int texture_type, int texture_handle)
 	Assert(texture_type < TM_NUM_TYPES);
 
 	Current_textures[texture_type] = texture_handle;
+
+	if ( texture_handle >= 0 ) {
+		bm_residency_touch(texture_handle, Current_screen_size);
+	}
+}
+
+// roughly how many pixels across the model being queued is, for the texture residency manager
+void draw_list::set_screen_size(float pixels)
+{
+	Current_screen_size = pixels;
 }
 
 void draw_list::set_cull_mode(int mode)
@@ -2766,6 +2778,12 @@ void model_render_queue(model_render_params *interp, draw_list *scene, int model
 	float depth = model_render_determine_depth(objnum, model_num, orient, pos, interp->get_detail_level_lock());
 	int detail_level = model_render_determine_detail(depth, objnum, model_num, orient, pos, model_flags, interp->get_detail_level_lock());
 
+	if ( Cmdline_texture_budget > 0 ) {
+		float dist = MAX(vm_vec_dist_quick(pos, &Eye_position) - pm->rad, 1.0f);
+
+		scene->set_screen_size(2.0f * pm->rad * Canv_w2 * Matrix_scale.xyz.x / dist);
+	}
+
 	// If we're rendering attached weapon models, check against the ships' tabled Weapon Model Draw Distance (which defaults to 200)
 	if ( model_flags & MR_ATTACHED_MODEL && shipp != NULL ) {
 		if (depth > Ship_info[shipp->ship_info_index].weapon_model_draw_distance) {
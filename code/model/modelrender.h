@@ -310,6 +310,7 @@ class draw_list
 	int Current_blend_filter;
 	float Current_alpha;
 	int Current_depth_mode;
+	float Current_screen_size;
 
 	int Current_set_clip_plane;
 	light_indexing_info Current_lights_set;
@@ -341,6 +342,7 @@ public:
 	void set_clip_plane();
 	void set_thrust_scale(float scale = -1.0f);
 	void set_texture(int texture_type, int texture_handle);
+	void set_screen_size(float pixels);
 	void set_depth_mode(int depth_set);
 	void set_blend_filter(int filter, float alpha);
 	void set_texture_addressing(int addressing);
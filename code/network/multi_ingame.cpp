@@ -1044,6 +1044,7 @@ void process_ingame_ships_packet( ubyte *data, header *hinfo )
 
 		// assign any common data
 		strcpy_s(Ships[ship_num].ship_name, ship_name);
+		Ship_lookup_generation++;
 		Ships[ship_num].flags = sflags;
 		Ships[ship_num].flags2 = sflags2;
 		Ships[ship_num].team = team;
@@ -1262,6 +1263,7 @@ void process_ingame_wings_packet( ubyte *data, header *hinfo )
 				// the parse_wing_create_ships call.
 				shipp = &Ships[shipnum];
 				wing_bash_ship_name(shipp->ship_name, wingp->name, which_one + 1);
+				Ship_lookup_generation++;
 				nprintf(("Network", "Created %s\n", shipp->ship_name));
 
 				objp = &Objects[shipp->objnum];
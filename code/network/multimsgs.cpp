@@ -8219,6 +8219,7 @@ void process_variable_update_packet( ubyte *data, header *hinfo)
 	if ( (variable_index >= 0) && (variable_index < sexp_variable_count()) )
 	{
 		strcpy_s(Sexp_variables[variable_index].text, value); 
+		Sexp_variable_generation++;
 	}	
 
 	// send the packet on to all clients. 
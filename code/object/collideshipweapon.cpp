@@ -120,50 +120,20 @@ void ship_weapon_do_hit_stuff(object *pship_obj, object *weapon_obj, vec3d *worl
 
 extern int Framecount;
 
-int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float time_limit = 0.0f, int *next_hit = NULL)
+/**
+ * Finds where a weapon crosses a ship's shield and hull, without acting on it.
+ *
+ * This only reads game state, so it can also be run ahead of time on a worker
+ * thread (see ship_weapon_prefetch_collision)
+ */
+static void ship_weapon_find_impacts(object *ship_objp, object *weapon_objp, vec3d *weapon_end_pos, mc_info *mc_shield_out, int *shield_collision_out, mc_info *mc_hull_out, int *hull_collision_out)
 {
 	mc_info mc, mc_shield, mc_hull;
-	ship	*shipp;
-	ship_info *sip;
-	weapon	*wp;
-	weapon_info	*wip;
-
-	Assert( ship_objp != NULL );
-	Assert( ship_objp->type == OBJ_SHIP );
-	Assert( ship_objp->instance >= 0 );
-
-	shipp = &Ships[ship_objp->instance];
-	sip = &Ship_info[shipp->ship_info_index];
-
-	Assert( weapon_objp != NULL );
-	Assert( weapon_objp->type == OBJ_WEAPON );
-	Assert( weapon_objp->instance >= 0 );
-
-	wp = &Weapons[weapon_objp->instance];
-	wip = &Weapon_info[wp->weapon_info_index];
-
-
-	Assert( shipp->objnum == OBJ_INDEX(ship_objp));
-
-	// Make ships that are warping in not get collision detection done
-	if ( shipp->flags & SF_ARRIVING ) return 0;
-	
-	//	Return information for AI to detect incoming fire.
-	//	Could perhaps be done elsewhere at lower cost --MK, 11/7/97
-	float	dist = vm_vec_dist_quick(&ship_objp->pos, &weapon_objp->pos);
-	if (dist < weapon_objp->phys_info.speed) {
-		update_danger_weapon(ship_objp, weapon_objp);
-	}
-
-	int	valid_hit_occurred = 0;				// If this is set, then hitpos is set
-	int	quadrant_num = -1;
+	ship	*shipp = &Ships[ship_objp->instance];
+	ship_info *sip = &Ship_info[shipp->ship_info_index];
+	weapon	*wp = &Weapons[weapon_objp->instance];
 	polymodel *pm = model_get(sip->model_num);
 
-	//	total time is flFrametime + time_limit (time_limit used to predict collisions into the future)
-	vec3d weapon_end_pos;
-	vm_vec_scale_add( &weapon_end_pos, &weapon_objp->pos, &weapon_objp->phys_info.vel, time_limit );
-
-
 	// Goober5000 - I tried to make collision code here much saner... here begin the (major) changes
 	mc_info_init(&mc);
 
@@ -174,7 +144,7 @@ int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float ti
 	mc.orient = &ship_objp->orient;
 	mc.pos = &ship_objp->pos;
 	mc.p0 = &weapon_objp->last_pos;
-	mc.p1 = &weapon_end_pos;
+	mc.p1 = weapon_end_pos;
 	mc.lod = sip->collision_lod;
 	memcpy(&mc_shield, &mc, sizeof(mc_info));
 	memcpy(&mc_hull, &mc, sizeof(mc_info));
@@ -198,7 +168,6 @@ int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float ti
 	// will absorb it when it hits the hull instead.  This has no fancy graphical effect, though.
 	// Someone should make one.
 
-	// check both kinds of collisions
 	int shield_collision = 0;
 	int hull_collision = 0;
 
@@ -221,13 +190,13 @@ int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float ti
 			// range, then some part of the currently checked range needs to be
 			// ignored
 			if (weapon_flown_for < min_weapon_span) {
-				vm_vec_sub(&shield_ignored_until, &weapon_end_pos, &wp->start_pos);
+				vm_vec_sub(&shield_ignored_until, weapon_end_pos, &wp->start_pos);
 				vm_vec_normalize(&shield_ignored_until);
 				vm_vec_scale(&shield_ignored_until, min_weapon_span);
 				vm_vec_add2(&shield_ignored_until, &wp->start_pos);
 			}
 
-			float this_range = vm_vec_dist(&weapon_objp->last_pos, &weapon_end_pos);
+			float this_range = vm_vec_dist(&weapon_objp->last_pos, weapon_end_pos);
 
 			// The range during which the weapon is not allowed to collide with the
 			// shield, except if it actually hits the hull
@@ -251,7 +220,7 @@ int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float ti
 
 				shield_collision = model_collide(&mc_shield);
 
-				mc_shield.p1 = &weapon_end_pos;
+				mc_shield.p1 = weapon_end_pos;
 				mc_shield.hit_dist = mc_shield.hit_dist * (ignored_range / this_range);
 			}
 
@@ -261,7 +230,7 @@ int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float ti
 			if (!shield_collision && weapon_flown_for + this_range > min_weapon_span) {
 				mc_shield.p0 = &shield_ignored_until;
 
-				mc_shield.p1 = &weapon_end_pos;
+				mc_shield.p1 = weapon_end_pos;
 
 				mc_shield.radius = sip->auto_shield_spread;
 
@@ -280,7 +249,7 @@ int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float ti
 				// relative to the values we used, not the values the rest of
 				// the code expects; this fixes that
 				mc_shield.p0 = &weapon_objp->last_pos;
-				mc_shield.p1 = &weapon_end_pos;
+				mc_shield.p1 = weapon_end_pos;
 				mc_shield.hit_dist = (ignored_range + (active_range * mc_shield.hit_dist)) / this_range;
 			}
 
@@ -344,6 +313,60 @@ int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float ti
 		hull_collision = model_collide(&mc_hull);
 	}
 
+	memcpy(mc_shield_out, &mc_shield, sizeof(mc_info));
+	memcpy(mc_hull_out, &mc_hull, sizeof(mc_info));
+	*shield_collision_out = shield_collision;
+	*hull_collision_out = hull_collision;
+}
+
+int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float time_limit = 0.0f, int *next_hit = NULL)
+{
+	mc_info mc, mc_shield, mc_hull;
+	ship	*shipp;
+	ship_info *sip;
+	weapon	*wp;
+	weapon_info	*wip;
+
+	Assert( ship_objp != NULL );
+	Assert( ship_objp->type == OBJ_SHIP );
+	Assert( ship_objp->instance >= 0 );
+
+	shipp = &Ships[ship_objp->instance];
+	sip = &Ship_info[shipp->ship_info_index];
+
+	Assert( weapon_objp != NULL );
+	Assert( weapon_objp->type == OBJ_WEAPON );
+	Assert( weapon_objp->instance >= 0 );
+
+	wp = &Weapons[weapon_objp->instance];
+	wip = &Weapon_info[wp->weapon_info_index];
+
+
+	Assert( shipp->objnum == OBJ_INDEX(ship_objp));
+
+	// Make ships that are warping in not get collision detection done
+	if ( shipp->flags & SF_ARRIVING ) return 0;
+	
+	//	Return information for AI to detect incoming fire.
+	//	Could perhaps be done elsewhere at lower cost --MK, 11/7/97
+	float	dist = vm_vec_dist_quick(&ship_objp->pos, &weapon_objp->pos);
+	if (dist < weapon_objp->phys_info.speed) {
+		update_danger_weapon(ship_objp, weapon_objp);
+	}
+
+	int	valid_hit_occurred = 0;				// If this is set, then hitpos is set
+	int	quadrant_num = -1;
+
+	//	total time is flFrametime + time_limit (time_limit used to predict collisions into the future)
+	vec3d weapon_end_pos;
+	vm_vec_scale_add( &weapon_end_pos, &weapon_objp->pos, &weapon_objp->phys_info.vel, time_limit );
+
+	// check both kinds of collisions
+	int shield_collision = 0;
+	int hull_collision = 0;
+
+	ship_weapon_find_impacts(ship_objp, weapon_objp, &weapon_end_pos, &mc_shield, &shield_collision, &mc_hull, &hull_collision);
+
 	if (shield_collision) {
 		// pick out the shield quadrant
 		quadrant_num = get_quadrant(&mc_shield.hit_point, ship_objp);
@@ -461,6 +484,27 @@ int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float ti
 }
 
 
+/**
+ * Whether a laser is close enough to a big ship for check_inside_radius_for_big_ships() to take over
+ */
+static bool ship_weapon_inside_big_ship_radius(object *ship, object *weapon_obj)
+{
+	ship_info *sip = &Ship_info[Ships[ship->instance].ship_info_index];
+
+	if ( (sip->flags & (SIF_BIG_SHIP | SIF_HUGE_SHIP)) && (Weapon_info[Weapons[weapon_obj->instance].weapon_info_index].subtype == WP_LASER) ) {
+		// Check when within ~1.1 radii.  
+		// This allows good transition between sphere checking (leaving the laser about 200 ms from radius) and checking
+		// within the sphere with little time between.  There may be some time for "small" big ships
+		// Note: culling ships with auto spread shields seems to waste more performance than it saves,
+		// so we're not doing that here
+		if ( !(sip->flags2 & SIF2_AUTO_SPREAD_SHIELDS) && vm_vec_dist_squared(&ship->pos, &weapon_obj->pos) < (1.2f*ship->radius*ship->radius) ) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * Checks ship-weapon collisions.  
  * @param pair obj_pair pointer to the two objects. pair->a is ship and pair->b is weapon.
@@ -475,8 +519,6 @@ int collide_ship_weapon( obj_pair * pair )
 	Assert( ship->type == OBJ_SHIP );
 	Assert( weapon_obj->type == OBJ_WEAPON );
 
-	ship_info *sip = &Ship_info[Ships[ship->instance].ship_info_index];
-
 	// Don't check collisions for player if past first warpout stage.
 	if ( Player->control_mode > PCM_WARPOUT_STAGE1)	{
 		if ( ship == Player_obj )
@@ -490,15 +532,8 @@ int collide_ship_weapon( obj_pair * pair )
 	// If it does hit, don't check the pair until about 200 ms before collision.  
 	// If it does not hit and is within error tolerance, cull the pair.
 
-	if ( (sip->flags & (SIF_BIG_SHIP | SIF_HUGE_SHIP)) && (Weapon_info[Weapons[weapon_obj->instance].weapon_info_index].subtype == WP_LASER) ) {
-		// Check when within ~1.1 radii.  
-		// This allows good transition between sphere checking (leaving the laser about 200 ms from radius) and checking
-		// within the sphere with little time between.  There may be some time for "small" big ships
-		// Note: culling ships with auto spread shields seems to waste more performance than it saves,
-		// so we're not doing that here
-		if ( !(sip->flags2 & SIF2_AUTO_SPREAD_SHIELDS) && vm_vec_dist_squared(&ship->pos, &weapon_obj->pos) < (1.2f*ship->radius*ship->radius) ) {
-			return check_inside_radius_for_big_ships( ship, weapon_obj, pair );
-		}
+	if ( ship_weapon_inside_big_ship_radius(ship, weapon_obj) ) {
+		return check_inside_radius_for_big_ships( ship, weapon_obj, pair );
 	}
 
 	did_hit = ship_weapon_check_collision( ship, weapon_obj );
@@ -539,15 +574,14 @@ float estimate_ship_speed_upper_limit( object *ship, float time )
 #define ERROR_STD	2	
 
 /**
- * When inside radius of big ship, check if we can cull collision pair determine the time when pair should next be checked
- * @return 1 if pair can be culled
- * @return 0 if pair can not be culled
+ * How far into the future check_inside_radius_for_big_ships() has to look
+ * @param time_to_max_error set to the time after which the estimate is no longer within tolerance
  */
-int check_inside_radius_for_big_ships( object *ship, object *weapon_obj, obj_pair *pair )
+static float big_ship_check_limit_time( object *ship, object *weapon_obj, float *time_to_max_error )
 {
 	vec3d error_vel;		// vel perpendicular to laser
 	float error_vel_mag;	// magnitude of error_vel
-	float time_to_max_error, time_to_exit_sphere;
+	float time_to_exit_sphere;
 	float ship_speed_at_exit_sphere, error_at_exit_sphere;	
 	float max_error = (float) ERROR_STD / 150.0f * ship->radius;
 	if (max_error < 2)
@@ -562,7 +596,7 @@ int check_inside_radius_for_big_ships( object *ship, object *weapon_obj, obj_pai
 	error_vel_mag += 0.5f * (ship->phys_info.max_vel.xyz.z - error_vel_mag)*(time_to_exit_sphere/ship->phys_info.forward_accel_time_const);
 	// error_vel_mag is now average velocity over period
 	error_at_exit_sphere = error_vel_mag * time_to_exit_sphere;
-	time_to_max_error = max_error / error_at_exit_sphere * time_to_exit_sphere;
+	*time_to_max_error = max_error / error_at_exit_sphere * time_to_exit_sphere;
 
 	// find the minimum time we can safely check into the future.
 	// limited by (1) time to exit sphere (2) time to weapon expires
@@ -575,6 +609,19 @@ int check_inside_radius_for_big_ships( object *ship, object *weapon_obj, obj_pai
 		limit_time = Weapons[weapon_obj->instance].lifeleft;
 	}
 
+	return limit_time;
+}
+
+/**
+ * When inside radius of big ship, check if we can cull collision pair determine the time when pair should next be checked
+ * @return 1 if pair can be culled
+ * @return 0 if pair can not be culled
+ */
+int check_inside_radius_for_big_ships( object *ship, object *weapon_obj, obj_pair *pair )
+{
+	float time_to_max_error;
+	float limit_time = big_ship_check_limit_time( ship, weapon_obj, &time_to_max_error );
+
 	// Note:  when estimated hit time is less than 200 ms, look at every frame
 	int hit_time;	// estimated time of hit in ms
 
@@ -608,3 +655,32 @@ int check_inside_radius_for_big_ships( object *ship, object *weapon_obj, obj_pai
 		}
 	}
 }
+
+/**
+ * Runs the model checks collide_ship_weapon() is about to make for this pair and records them into
+ * entries (see model_collide_memo_record).  Only reads game state, so several pairs can be prefetched
+ * on worker threads at once.
+ */
+void ship_weapon_prefetch_collision(object *ship_objp, object *weapon_objp, SCP_vector<mc_memo_entry> *entries)
+{
+	mc_info mc_shield, mc_hull;
+	int shield_collision, hull_collision;
+	float time_limit = 0.0f;
+	vec3d weapon_end_pos;
+
+	if ( Ships[ship_objp->instance].flags & SF_ARRIVING ) {
+		return;
+	}
+
+	if ( ship_weapon_inside_big_ship_radius(ship_objp, weapon_objp) ) {
+		float time_to_max_error;
+
+		time_limit = big_ship_check_limit_time( ship_objp, weapon_objp, &time_to_max_error );
+	}
+
+	vm_vec_scale_add( &weapon_end_pos, &weapon_objp->pos, &weapon_objp->phys_info.vel, time_limit );
+
+	model_collide_memo_record(entries);
+	ship_weapon_find_impacts(ship_objp, weapon_objp, &weapon_end_pos, &mc_shield, &shield_collision, &mc_hull, &hull_collision);
+	model_collide_memo_record(NULL);
+}
@@ -9,7 +9,9 @@
 
 
 
+#include "debugconsole/console.h"
 #include "globalincs/linklist.h"
+#include "globalincs/workerpool.h"
 #include "io/timer.h"
 #include "object/objcollide.h"
 #include "object/object.h"
@@ -18,6 +20,8 @@
 #include "weapon/beam.h"
 #include "weapon/weapon.h"
 
+#include <algorithm>
+
 
 
 //#define MAX_PAIRS 10000	//	Bumped back to 10,000 by WMC
@@ -51,21 +55,69 @@ public:
 	int signature_a;
 	int signature_b;
 	int next_check_time;
+	int (*check_collision)( obj_pair *pair );
+	int last_frame;			// broadphase frame the pair was last seen on
 	bool initialized;
 
 	// we need to define a constructor because the hash map can
 	// implicitly insert an object when we use the [] operator
 	collider_pair()
-		: a(NULL), b(NULL), signature_a(-1), signature_b(-1), next_check_time(-1), initialized(false)
+		: a(NULL), b(NULL), signature_a(-1), signature_b(-1), next_check_time(-1), check_collision(NULL), last_frame(0), initialized(false)
 	{}
 };
 
-SCP_unordered_map<uint, collider_pair> Collision_cached_pairs;
+// Cached pairs are keyed on the signatures of both objects.  Signatures are never reused
+// within a mission, so an entry always refers to the same two objects and whatever it
+// learned about them (e.g. from weapon_will_never_hit()) stays valid from frame to frame.
+SCP_unordered_map<ulonglong, collider_pair> Collision_cached_pairs;
+
+#define COLLISION_CACHE_PRUNE_INTERVAL	64		// frames between sweeps for stale cached pairs
+#define COLLISION_CACHE_MAX_AGE			32		// frames a pair may go unseen before it is dropped
+
+static int Collision_cache_frame = 0;
+
+// spatial hash broadphase (see obj_grid_collide())
+#define COLLISION_GRID_LEVELS		12			// number of cell sizes, each level doubles the last
+#define COLLISION_GRID_BASE_SIZE	32.0f		// edge length of the cells on level 0
+#define COLLISION_GRID_OVERSIZED	COLLISION_GRID_LEVELS	// level for objects too big for the largest cells
+#define COLLISION_GRID_COORD_BITS	20
+
+typedef struct collider_grid_info {
+	int level;			// -1 if not linked into the grid
+	int cell[3];		// cell coordinates of the box center on the above level
+	float min[3];		// bounding box the object was last binned with
+	float max[3];
+} collider_grid_info;
+
+int Collision_broadphase = COLLISION_BROADPHASE_SORT;
+
+static collider_grid_info Collision_grid_info[MAX_OBJECTS];
+static SCP_unordered_map<ulonglong, SCP_vector<int> > Collision_grid_cells;
+static SCP_vector<int> Collision_grid_oversized;
+static int Collision_grid_level_count[COLLISION_GRID_LEVELS];
+static bool Collision_grid_built = false;
+
+// when non-NULL, broadphase pairs are recorded here instead of being collided
+static SCP_vector<std::pair<int, int> > *Collision_pair_capture = NULL;
+
+// comparison stats for the "collision_broadphase compare" debug command
+static int Collision_compare_frames = 0;
+static int Collision_compare_sort_us = 0;
+static int Collision_compare_grid_us = 0;
+static int Collision_compare_sort_pairs = 0;
+static int Collision_compare_grid_pairs = 0;
+static int Collision_compare_missed = 0;
 
 struct checkobject;
 extern checkobject CheckObjects[MAX_OBJECTS];
 
 extern int Cmdline_old_collision_sys;
+extern int Cmdline_collision_grid;
+extern int Cmdline_mt_collisions;
+
+static void obj_grid_link(int objnum);
+static void obj_grid_unlink(int objnum);
+static void obj_grid_collide();
 
 void obj_pairs_close()
 {
@@ -1066,7 +1118,7 @@ int collide_remove_weapons( )
 			opp = opp->next;
 		}
 	} else {
-		SCP_unordered_map<uint, collider_pair>::iterator it;
+		SCP_unordered_map<ulonglong, collider_pair>::iterator it;
 		collider_pair *pair_obj;
 
 		for ( it = Collision_cached_pairs.begin(); it != Collision_cached_pairs.end(); ++it ) {
@@ -1177,6 +1229,10 @@ void obj_add_collider(int obj_index)
 
 	Collision_sort_list.push_back(obj_index);
 
+	if ( Collision_grid_built ) {
+		obj_grid_link(obj_index);
+	}
+
 	objp->flags &= ~OF_NOT_IN_COLL;	
 }
 
@@ -1196,6 +1252,10 @@ void obj_remove_collider(int obj_index)
 		}
 	}
 
+	if ( Collision_grid_built ) {
+		obj_grid_unlink(obj_index);
+	}
+
 	Objects[obj_index].flags |= OF_NOT_IN_COLL;	
 }
 
@@ -1203,17 +1263,532 @@ void obj_reset_colliders()
 {
 	Collision_sort_list.clear();
 	Collision_cached_pairs.clear();
+
+	obj_grid_reset();
+
+	if ( Cmdline_collision_grid ) {
+		Collision_broadphase = COLLISION_BROADPHASE_GRID;
+	}
 }
 
 void obj_collide_retime_cached_pairs(int checkdly)
 {
-	SCP_unordered_map<uint, collider_pair>::iterator it;
+	SCP_unordered_map<ulonglong, collider_pair>::iterator it;
 
 	for ( it = Collision_cached_pairs.begin(); it != Collision_cached_pairs.end(); ++it ) {
 		it->second.next_check_time = timestamp(checkdly);
 	}
 }
 
+static inline ulonglong obj_collide_pair_key(object *A, object *B)
+{
+	uint sig_a = (uint)A->signature;
+	uint sig_b = (uint)B->signature;
+
+	if ( sig_a > sig_b ) {
+		return ((ulonglong)sig_b << 32) | sig_a;
+	}
+
+	return ((ulonglong)sig_a << 32) | sig_b;
+}
+
+// Drops cached pairs whose objects have died or that have not come out of the
+// broadphase for a while, so the cache only holds pairs that are actually close.
+static void obj_collide_prune_cached_pairs()
+{
+	SCP_unordered_map<ulonglong, collider_pair>::iterator it;
+
+	for ( it = Collision_cached_pairs.begin(); it != Collision_cached_pairs.end(); ) {
+		collider_pair *pair_obj = &it->second;
+
+		if ( (pair_obj->a->signature != pair_obj->signature_a) || (pair_obj->b->signature != pair_obj->signature_b)
+			|| ((Collision_cache_frame - pair_obj->last_frame) > COLLISION_CACHE_MAX_AGE) ) {
+			it = Collision_cached_pairs.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+// Hands a broadphase pair to the narrow phase, or records it when comparing broadphases
+static void obj_broadphase_emit_pair(int objnum_a, int objnum_b)
+{
+	if ( Collision_pair_capture != NULL ) {
+		Collision_pair_capture->push_back(std::make_pair(objnum_a, objnum_b));
+		return;
+	}
+
+	obj_collide_pair(&Objects[objnum_a], &Objects[objnum_b]);
+}
+
+static ulonglong obj_grid_cell_key(int level, int x, int y, int z)
+{
+	const ulonglong mask = (1 << COLLISION_GRID_COORD_BITS) - 1;
+
+	// coordinates wrap, so very distant cells may share a bucket; the box test weeds those out
+	return ((ulonglong)level << (3 * COLLISION_GRID_COORD_BITS))
+		| (((ulonglong)x & mask) << (2 * COLLISION_GRID_COORD_BITS))
+		| (((ulonglong)y & mask) << COLLISION_GRID_COORD_BITS)
+		| ((ulonglong)z & mask);
+}
+
+static float obj_grid_cell_size(int level)
+{
+	return COLLISION_GRID_BASE_SIZE * (float)(1 << level);
+}
+
+static int obj_grid_cell_coord(float pos, float cell_size)
+{
+	const float limit = (float)(1 << (COLLISION_GRID_COORD_BITS - 1));
+	float coord = floorf(pos / cell_size);
+
+	CLAMP(coord, -limit, limit);
+
+	return (int)coord;
+}
+
+// Fills in the bounding box of the object and picks the level and cell it belongs in.
+// An object lives on the smallest level whose cells are at least as big as its box, so
+// two overlapping objects are always in neighbouring cells on the larger one's level.
+static void obj_grid_bin(int objnum, collider_grid_info *info)
+{
+	int axis;
+	float extent = 0.0f;
+
+	for ( axis = 0; axis < 3; axis++ ) {
+		info->min[axis] = obj_get_collider_endpoint(objnum, axis, true);
+		info->max[axis] = obj_get_collider_endpoint(objnum, axis, false);
+
+		extent = MAX(extent, info->max[axis] - info->min[axis]);
+	}
+
+	info->level = 0;
+
+	while ( obj_grid_cell_size(info->level) < extent ) {
+		if ( ++info->level == COLLISION_GRID_OVERSIZED ) {
+			return;
+		}
+	}
+
+	float cell_size = obj_grid_cell_size(info->level);
+
+	for ( axis = 0; axis < 3; axis++ ) {
+		info->cell[axis] = obj_grid_cell_coord((info->min[axis] + info->max[axis]) * 0.5f, cell_size);
+	}
+}
+
+static void obj_grid_insert(int objnum, collider_grid_info *info)
+{
+	if ( info->level == COLLISION_GRID_OVERSIZED ) {
+		Collision_grid_oversized.push_back(objnum);
+	} else {
+		Collision_grid_cells[obj_grid_cell_key(info->level, info->cell[0], info->cell[1], info->cell[2])].push_back(objnum);
+		Collision_grid_level_count[info->level]++;
+	}
+}
+
+static void obj_grid_remove(int objnum, collider_grid_info *info)
+{
+	SCP_vector<int> *list;
+	size_t i;
+
+	if ( info->level == COLLISION_GRID_OVERSIZED ) {
+		list = &Collision_grid_oversized;
+	} else {
+		SCP_unordered_map<ulonglong, SCP_vector<int> >::iterator cell;
+
+		cell = Collision_grid_cells.find(obj_grid_cell_key(info->level, info->cell[0], info->cell[1], info->cell[2]));
+
+		if ( cell == Collision_grid_cells.end() ) {
+			Int3();
+			return;
+		}
+
+		list = &cell->second;
+		Collision_grid_level_count[info->level]--;
+	}
+
+	for ( i = 0; i < list->size(); ++i ) {
+		if ( (*list)[i] == objnum ) {
+			(*list)[i] = list->back();
+			list->pop_back();
+			break;
+		}
+	}
+}
+
+static void obj_grid_link(int objnum)
+{
+	collider_grid_info *info = &Collision_grid_info[objnum];
+
+	if ( info->level >= 0 ) {
+		return;
+	}
+
+	obj_grid_bin(objnum, info);
+	obj_grid_insert(objnum, info);
+}
+
+static void obj_grid_unlink(int objnum)
+{
+	collider_grid_info *info = &Collision_grid_info[objnum];
+
+	if ( info->level < 0 ) {
+		return;
+	}
+
+	obj_grid_remove(objnum, info);
+	info->level = -1;
+}
+
+// Re-bins a linked object after it moved.  Most objects stay in the same cell from one
+// frame to the next, in which case only the cached bounding box is refreshed.
+static void obj_grid_update(int objnum)
+{
+	collider_grid_info *info = &Collision_grid_info[objnum];
+	collider_grid_info moved;
+
+	Assert( info->level >= 0 );
+
+	obj_grid_bin(objnum, &moved);
+
+	if ( (moved.level == info->level) && ((moved.level == COLLISION_GRID_OVERSIZED)
+		|| ((moved.cell[0] == info->cell[0]) && (moved.cell[1] == info->cell[1]) && (moved.cell[2] == info->cell[2]))) ) {
+		memcpy(info->min, moved.min, sizeof(info->min));
+		memcpy(info->max, moved.max, sizeof(info->max));
+		return;
+	}
+
+	obj_grid_remove(objnum, info);
+	*info = moved;
+	obj_grid_insert(objnum, info);
+}
+
+void obj_grid_reset()
+{
+	int i;
+
+	for ( i = 0; i < MAX_OBJECTS; i++ ) {
+		Collision_grid_info[i].level = -1;
+	}
+
+	for ( i = 0; i < COLLISION_GRID_LEVELS; i++ ) {
+		Collision_grid_level_count[i] = 0;
+	}
+
+	Collision_grid_cells.clear();
+	Collision_grid_oversized.clear();
+	Collision_grid_built = false;
+}
+
+static inline bool obj_grid_boxes_overlap(collider_grid_info *a, collider_grid_info *b)
+{
+	return (a->min[0] <= b->max[0]) && (b->min[0] <= a->max[0])
+		&& (a->min[1] <= b->max[1]) && (b->min[1] <= a->max[1])
+		&& (a->min[2] <= b->max[2]) && (b->min[2] <= a->max[2]);
+}
+
+/**
+ * Broadphase using a persistent hierarchical spatial hash.
+ *
+ * Colliders stay linked into the grid between frames and are only moved to another
+ * bucket when their bounding box center crosses a cell boundary.  Each object checks
+ * the 27 cells around it on its own level and on every larger level; objects on its
+ * own level are only paired once by comparing object numbers.  Pairs whose boxes
+ * overlap go to obj_collide_pair(), same as with the sort and sweep.
+ */
+static void obj_grid_collide()
+{
+	size_t i, j;
+	int level, max_level, x, y, z;
+
+	if ( !Collision_grid_built ) {
+		for ( i = 0; i < Collision_sort_list.size(); ++i ) {
+			obj_grid_link(Collision_sort_list[i]);
+		}
+
+		Collision_grid_built = true;
+	} else {
+		for ( i = 0; i < Collision_sort_list.size(); ++i ) {
+			obj_grid_update(Collision_sort_list[i]);
+		}
+	}
+
+	for ( max_level = COLLISION_GRID_LEVELS - 1; max_level >= 0; max_level-- ) {
+		if ( Collision_grid_level_count[max_level] > 0 ) {
+			break;
+		}
+	}
+
+	for ( i = 0; i < Collision_sort_list.size(); ++i ) {
+		int objnum = Collision_sort_list[i];
+		collider_grid_info *info = &Collision_grid_info[objnum];
+
+		// oversized objects are tested against everything further down
+		if ( info->level == COLLISION_GRID_OVERSIZED ) {
+			continue;
+		}
+
+		float center[3];
+
+		for ( x = 0; x < 3; x++ ) {
+			center[x] = (info->min[x] + info->max[x]) * 0.5f;
+		}
+
+		for ( level = info->level; level <= max_level; level++ ) {
+			if ( Collision_grid_level_count[level] == 0 ) {
+				continue;
+			}
+
+			float cell_size = obj_grid_cell_size(level);
+			int cx = obj_grid_cell_coord(center[0], cell_size);
+			int cy = obj_grid_cell_coord(center[1], cell_size);
+			int cz = obj_grid_cell_coord(center[2], cell_size);
+
+			for ( x = cx - 1; x <= cx + 1; x++ ) {
+				for ( y = cy - 1; y <= cy + 1; y++ ) {
+					for ( z = cz - 1; z <= cz + 1; z++ ) {
+						SCP_unordered_map<ulonglong, SCP_vector<int> >::iterator cell = Collision_grid_cells.find(obj_grid_cell_key(level, x, y, z));
+
+						if ( cell == Collision_grid_cells.end() ) {
+							continue;
+						}
+
+						for ( j = 0; j < cell->second.size(); ++j ) {
+							int other = cell->second[j];
+
+							if ( (level == info->level) && (other <= objnum) ) {
+								continue;
+							}
+
+							if ( obj_grid_boxes_overlap(info, &Collision_grid_info[other]) ) {
+								obj_broadphase_emit_pair(objnum, other);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// anything bigger than the largest cells is checked against every other collider
+	for ( i = 0; i < Collision_grid_oversized.size(); ++i ) {
+		int objnum = Collision_grid_oversized[i];
+
+		for ( j = 0; j < Collision_sort_list.size(); ++j ) {
+			int other = Collision_sort_list[j];
+
+			if ( (Collision_grid_info[other].level == COLLISION_GRID_OVERSIZED) && (other <= objnum) ) {
+				continue;
+			}
+
+			if ( obj_grid_boxes_overlap(&Collision_grid_info[objnum], &Collision_grid_info[other]) ) {
+				obj_broadphase_emit_pair(objnum, other);
+			}
+		}
+	}
+}
+
+static void obj_sort_and_sweep();
+
+// Runs both broadphases on the same frame, reports pairs the grid failed to find and
+// then collides the pairs from the sort and sweep so gameplay is unaffected.
+static void obj_compare_broadphases()
+{
+	SCP_vector<std::pair<int, int> > sort_pairs;
+	SCP_vector<std::pair<int, int> > grid_pairs;
+	size_t i;
+	int start;
+
+	Collision_pair_capture = &sort_pairs;
+	start = timer_get_microseconds();
+	obj_sort_and_sweep();
+	Collision_compare_sort_us += timer_get_microseconds() - start;
+
+	Collision_pair_capture = &grid_pairs;
+	start = timer_get_microseconds();
+	obj_grid_collide();
+	Collision_compare_grid_us += timer_get_microseconds() - start;
+
+	Collision_pair_capture = NULL;
+
+	Collision_compare_frames++;
+	Collision_compare_sort_pairs += (int)sort_pairs.size();
+	Collision_compare_grid_pairs += (int)grid_pairs.size();
+
+	// pairs come out in either order, so compare them with the lower object number first
+	for ( i = 0; i < grid_pairs.size(); ++i ) {
+		if ( grid_pairs[i].first > grid_pairs[i].second ) {
+			std::swap(grid_pairs[i].first, grid_pairs[i].second);
+		}
+	}
+
+	std::sort(grid_pairs.begin(), grid_pairs.end());
+
+	// the sort and sweep also hands over some pairs that only overlap on one axis, so
+	// only pairs with overlapping boxes have to show up in the grid results
+	for ( i = 0; i < sort_pairs.size(); ++i ) {
+		std::pair<int, int> pair(MIN(sort_pairs[i].first, sort_pairs[i].second), MAX(sort_pairs[i].first, sort_pairs[i].second));
+
+		if ( !obj_grid_boxes_overlap(&Collision_grid_info[pair.first], &Collision_grid_info[pair.second]) ) {
+			continue;
+		}
+
+		if ( !std::binary_search(grid_pairs.begin(), grid_pairs.end(), pair) ) {
+			Collision_compare_missed++;
+			nprintf(("collision", "Grid broadphase missed pair %d:%d\n", pair.first, pair.second));
+		}
+	}
+
+	for ( i = 0; i < sort_pairs.size(); ++i ) {
+		obj_collide_pair(&Objects[sort_pairs[i].first], &Objects[sort_pairs[i].second]);
+	}
+}
+
+DCF(collision_broadphase, "Selects the collision broadphase (sort, grid or compare)")
+{
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: collision_broadphase [sort|grid|compare]\n");
+		dc_printf("[sort]    -- sort and sweep over all colliders each frame (default)\n");
+		dc_printf("[grid]    -- persistent spatial hash grid\n");
+		dc_printf("[compare] -- run both each frame and collect timing and pair statistics\n");
+		dc_printf("with no parameters, prints the current mode and comparison stats\n");
+		return;
+	}
+
+	if (dc_optional_string("sort")) {
+		Collision_broadphase = COLLISION_BROADPHASE_SORT;
+		obj_grid_reset();
+	} else if (dc_optional_string("grid")) {
+		Collision_broadphase = COLLISION_BROADPHASE_GRID;
+	} else if (dc_optional_string("compare")) {
+		Collision_broadphase = COLLISION_BROADPHASE_COMPARE;
+		Collision_compare_frames = 0;
+		Collision_compare_sort_us = Collision_compare_grid_us = 0;
+		Collision_compare_sort_pairs = Collision_compare_grid_pairs = 0;
+		Collision_compare_missed = 0;
+	}
+
+	const char *modes[] = { "sort", "grid", "compare" };
+	dc_printf("Collision broadphase is: %s\n", modes[Collision_broadphase]);
+
+	if (Collision_compare_frames > 0) {
+		dc_printf("Compared %d frames\n", Collision_compare_frames);
+		dc_printf("  sort: %d us/frame, %d pairs/frame\n", Collision_compare_sort_us / Collision_compare_frames, Collision_compare_sort_pairs / Collision_compare_frames);
+		dc_printf("  grid: %d us/frame, %d pairs/frame\n", Collision_compare_grid_us / Collision_compare_frames, Collision_compare_grid_pairs / Collision_compare_frames);
+		dc_printf("  overlapping pairs missed by grid: %d\n", Collision_compare_missed);
+	}
+}
+
+// Multithreaded narrow phase (-mt_collisions)
+//
+// The broadphase pairs for the frame are gathered up front.  The model checks the
+// ship:weapon pairs are going to need are then run on the worker pool and handed to
+// the model_collide() memo, after which every pair goes through obj_collide_pair() on
+// this thread in the order the broadphase produced it.  Damage, effects, script hooks
+// and the pair cache are therefore updated in exactly the same order no matter how
+// many threads there are, and the memo only hands back a result when the query and
+// the model state match what the worker saw.
+
+#define COLLISION_PREFETCH_BATCH	8		// pairs handed to a worker at a time
+
+typedef struct collision_prefetch_job {
+	object *ship_objp;
+	object *weapon_objp;
+	SCP_vector<mc_memo_entry> entries;
+} collision_prefetch_job;
+
+static SCP_vector<std::pair<int, int> > Collision_batch_pairs;
+static SCP_vector<collision_prefetch_job> Collision_prefetch_jobs;
+
+DCF_BOOL(mt_collisions, Cmdline_mt_collisions)
+
+static void obj_collide_prefetch_job(void *data, int index)
+{
+	collision_prefetch_job *job = &((collision_prefetch_job *)data)[index];
+
+	ship_weapon_prefetch_collision(job->ship_objp, job->weapon_objp, &job->entries);
+}
+
+// Whether obj_collide_pair() will run the ship:weapon check for these two this frame
+static bool obj_collide_wants_prefetch(object *A, object *B, object **ship_objp, object **weapon_objp)
+{
+	if ( (A->type == OBJ_SHIP) && (B->type == OBJ_WEAPON) ) {
+		*ship_objp = A;
+		*weapon_objp = B;
+	} else if ( (A->type == OBJ_WEAPON) && (B->type == OBJ_SHIP) ) {
+		*ship_objp = B;
+		*weapon_objp = A;
+	} else {
+		return false;
+	}
+
+	if ( !(A->flags & OF_COLLIDES) || !(B->flags & OF_COLLIDES) ) {
+		return false;
+	}
+
+	SCP_unordered_map<ulonglong, collider_pair>::iterator it = Collision_cached_pairs.find(obj_collide_pair_key(A, B));
+
+	if ( (it != Collision_cached_pairs.end()) && it->second.initialized ) {
+		if ( (it->second.next_check_time == -1) || !timestamp_elapsed(it->second.next_check_time) ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void obj_collide_batched()
+{
+	size_t i, j;
+	size_t num_jobs = 0;
+
+	Collision_batch_pairs.clear();
+	Collision_pair_capture = &Collision_batch_pairs;
+
+	if ( Collision_broadphase == COLLISION_BROADPHASE_GRID ) {
+		obj_grid_collide();
+	} else {
+		obj_sort_and_sweep();
+	}
+
+	Collision_pair_capture = NULL;
+
+	for ( i = 0; i < Collision_batch_pairs.size(); ++i ) {
+		object *ship_objp, *weapon_objp;
+
+		if ( !obj_collide_wants_prefetch(&Objects[Collision_batch_pairs[i].first], &Objects[Collision_batch_pairs[i].second], &ship_objp, &weapon_objp) ) {
+			continue;
+		}
+
+		if ( num_jobs == Collision_prefetch_jobs.size() ) {
+			Collision_prefetch_jobs.push_back(collision_prefetch_job());
+		}
+
+		collision_prefetch_job *job = &Collision_prefetch_jobs[num_jobs++];
+
+		job->ship_objp = ship_objp;
+		job->weapon_objp = weapon_objp;
+		job->entries.clear();
+	}
+
+	if ( num_jobs > 0 ) {
+		worker_pool_run(obj_collide_prefetch_job, &Collision_prefetch_jobs[0], (int)num_jobs, COLLISION_PREFETCH_BATCH);
+
+		for ( i = 0; i < num_jobs; ++i ) {
+			for ( j = 0; j < Collision_prefetch_jobs[i].entries.size(); ++j ) {
+				model_collide_memo_add(&Collision_prefetch_jobs[i].entries[j]);
+			}
+		}
+	}
+
+	for ( i = 0; i < Collision_batch_pairs.size(); ++i ) {
+		obj_collide_pair(&Objects[Collision_batch_pairs[i].first], &Objects[Collision_batch_pairs[i].second]);
+	}
+
+	model_collide_memo_clear();
+}
+
 void obj_sort_and_collide()
 {
 	if (Cmdline_dis_collisions)
@@ -1222,6 +1797,32 @@ void obj_sort_and_collide()
 	if ( !(Game_detail_flags & DETAIL_FLAG_COLLISION) )
 		return;
 
+	if ( (++Collision_cache_frame % COLLISION_CACHE_PRUNE_INTERVAL) == 0 ) {
+		obj_collide_prune_cached_pairs();
+	}
+
+	if ( Cmdline_mt_collisions && (worker_pool_num_threads() > 0) && (Collision_broadphase != COLLISION_BROADPHASE_COMPARE) ) {
+		obj_collide_batched();
+		return;
+	}
+
+	switch ( Collision_broadphase ) {
+	case COLLISION_BROADPHASE_GRID:
+		obj_grid_collide();
+		break;
+
+	case COLLISION_BROADPHASE_COMPARE:
+		obj_compare_broadphases();
+		break;
+
+	default:
+		obj_sort_and_sweep();
+		break;
+	}
+}
+
+static void obj_sort_and_sweep()
+{
 	SCP_vector<int> sort_list_y;
 	SCP_vector<int> sort_list_z;
 
@@ -1266,7 +1867,7 @@ void obj_find_overlap_colliders(SCP_vector<int> *overlap_list_out, SCP_vector<in
 				}
 				
 				if ( collide ) {
-					obj_collide_pair(&Objects[(*list)[i]], &Objects[overlappers[j]]);
+					obj_broadphase_emit_pair((*list)[i], overlappers[j]);
 				}
 			} else {
 				overlappers[j] = overlappers.back();
@@ -1374,6 +1975,24 @@ void obj_quicksort_colliders(SCP_vector<int> *list, int left, int right, int axi
 	}
 }
 
+// Runs the narrow phase check for a cached pair and remembers when it has to be checked next
+static void obj_collide_cached_pair(collider_pair *collision_info)
+{
+	obj_pair new_pair;
+
+	new_pair.a = collision_info->a;
+	new_pair.b = collision_info->b;
+	new_pair.check_collision = collision_info->check_collision;
+	new_pair.next_check_time = collision_info->next_check_time;
+
+	if ( collision_info->check_collision(&new_pair) ) {
+		// don't have to check ever again
+		collision_info->next_check_time = -1;
+	} else {
+		collision_info->next_check_time = new_pair.next_check_time;
+	}
+}
+
 void obj_collide_pair(object *A, object *B)
 {
 	uint ctype;
@@ -1389,13 +2008,40 @@ void obj_collide_pair(object *A, object *B)
 	
 	if ((A->flags & OF_IMMOBILE) && (B->flags & OF_IMMOBILE)) return;	// Two immobile objects will never collide with each other
 
-	// Make sure you're not checking a parent with it's kid or vicy-versy
+	// Make sure you're not checking a parent with it's kid or vicy-versy.  This goes ahead of the
+	// cache, since parent_sig can change after a pair has been cached.
 //	if ( A->parent_sig == B->signature && !(A->type == OBJ_SHIP && B->type == OBJ_DEBRIS) ) return;
 //	if ( B->parent_sig == A->signature && !(A->type == OBJ_DEBRIS && B->type == OBJ_SHIP) ) return;
 	if ( reject_obj_pair_on_parent(A,B) ) {
 		return;
 	}
 
+	collider_pair *collision_info = NULL;
+	bool is_beam_pair = (A->type == OBJ_BEAM) || (B->type == OBJ_BEAM);
+
+	// beams get their early out checks every frame, everything else goes through the cache
+	if ( !is_beam_pair ) {
+		SCP_unordered_map<ulonglong, collider_pair>::iterator it = Collision_cached_pairs.find(obj_collide_pair_key(A, B));
+
+		if ( (it != Collision_cached_pairs.end()) && it->second.initialized ) {
+			collision_info = &it->second;
+			collision_info->last_frame = Collision_cache_frame;
+
+			// this pair has already been sorted out on an earlier frame, so skip straight
+			// to the timestamp check without redoing the type dispatch or culling
+			if ( collision_info->next_check_time == -1 ) {
+				return;
+			}
+
+			if ( !timestamp_elapsed(collision_info->next_check_time) ) {
+				return;
+			}
+
+			obj_collide_cached_pair(collision_info);
+			return;
+		}
+	}
+
 	Assert( A->type < 127 );
 	Assert( B->type < 127 );
 
@@ -1539,50 +2185,31 @@ void obj_collide_pair(object *A, object *B)
 		B = tmp;
 	}
 
-	collider_pair *collision_info = NULL;
-	bool valid = false;
-	uint key = (OBJ_INDEX(A) << 12) + OBJ_INDEX(B);
+	obj_pair new_pair;
 
-	collision_info = &Collision_cached_pairs[key];
+	if ( is_beam_pair ) {
+		new_pair.a = A;
+		new_pair.b = B;
+		new_pair.check_collision = check_collision;
+		new_pair.next_check_time = timestamp(0);
 
-	if ( collision_info->initialized ) {
-		// make sure we're referring to the correct objects in case the original pair was deleted
-		if ( collision_info->signature_a == collision_info->a->signature && 
-			collision_info->signature_b == collision_info->b->signature ) {
-			valid = true;
-		} else {
-			collision_info->a = A;
-			collision_info->b = B;
-			collision_info->signature_a = A->signature;
-			collision_info->signature_b = B->signature;
-			collision_info->next_check_time = timestamp(0);
-		}
-	} else {
-		collision_info->a = A;
-		collision_info->b = B;
-		collision_info->signature_a = A->signature;
-		collision_info->signature_b = B->signature;
-		collision_info->initialized = true;
-		collision_info->next_check_time = timestamp(0);
+		check_collision(&new_pair);
+		return;
 	}
 
-	if ( valid &&  A->type != OBJ_BEAM ) {
-		// if this signature is valid, make the necessary checks to see if we need to collide check
-		if ( collision_info->next_check_time == -1 ) {
-			return;
-		} else {
-			if ( !timestamp_elapsed(collision_info->next_check_time) ) {
-				return;
-			}
-		}
-	} else {
-		//if ( A->type == OBJ_BEAM ) {
-			//if(beam_collide_early_out(A, B)){
-				//collision_info->next_check_time = -1;
-				//return;
-			//}
-		//}
+	collision_info = &Collision_cached_pairs[obj_collide_pair_key(A, B)];
+
+	collision_info->a = A;
+	collision_info->b = B;
+	collision_info->signature_a = A->signature;
+	collision_info->signature_b = B->signature;
+	collision_info->check_collision = check_collision;
+	collision_info->last_frame = Collision_cache_frame;
+	collision_info->initialized = true;
+	collision_info->next_check_time = timestamp(0);
 
+	// first time we see this pair, so see if it can be culled for good
+	{
 		// only check debris:weapon collisions for player
 		if (check_collision == collide_debris_weapon) {
 			// weapon is B
@@ -1641,17 +2268,5 @@ void obj_collide_pair(object *A, object *B)
 		}
 	}
 
-	obj_pair new_pair;	
-
-	new_pair.a = A;
-	new_pair.b = B;
-	new_pair.check_collision = check_collision;
-	new_pair.next_check_time = collision_info->next_check_time;
-
-	if ( check_collision(&new_pair) ) {
-		// don't have to check ever again
-		collision_info->next_check_time = -1;
-	} else {
-		collision_info->next_check_time = new_pair.next_check_time;
-	}
+	obj_collide_cached_pair(collision_info);
 }
@@ -17,6 +17,7 @@
 class object;
 struct CFILE;
 struct mc_info;
+struct mc_memo_entry;
 
 // used for ship:ship and ship:debris
 typedef struct collision_info_struct {
@@ -68,6 +69,13 @@ typedef struct obj_pair	{
 
 extern int collision_type;
 
+// broadphase used by obj_sort_and_collide()
+#define COLLISION_BROADPHASE_SORT		0	// sorts all colliders along each axis every frame
+#define COLLISION_BROADPHASE_GRID		1	// persistent hierarchical spatial hash
+#define COLLISION_BROADPHASE_COMPARE	2	// runs both and reports differences, collides with the sort results
+
+extern int Collision_broadphase;
+
 #define SUBMODEL_NO_ROT_HIT	0
 #define SUBMODEL_ROT_HIT		1
 void set_hit_struct_info(collision_info_struct *hit, mc_info *mc, int submodel_rot_hit);
@@ -79,6 +87,7 @@ void obj_add_pair( object *A, object *B, int check_time = -1, int add_to_end = 0
 void obj_add_collider(int obj_index);
 void obj_remove_collider(int obj_index);
 void obj_reset_colliders();
+void obj_grid_reset();
 
 void obj_check_all_collisions();
 void obj_sort_and_collide();
@@ -117,6 +126,7 @@ int collide_weapon_weapon( obj_pair * pair );
 // Returns 1 if all future collisions between these can be ignored
 // CODE is locatated in CollideShipWeapon.cpp
 int collide_ship_weapon( obj_pair * pair );
+void ship_weapon_prefetch_collision(object *ship_objp, object *weapon_objp, SCP_vector<mc_memo_entry> *entries);
 void ship_weapon_do_hit_stuff(object *pship_obj, object *weapon_obj, vec3d *world_hitpos, vec3d *hitpos, int quadrant_num, int submodel_num = -1);
 
 // Checks debris-weapon collisions.  pair->a is debris and pair->b is weapon.
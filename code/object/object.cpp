@@ -1173,7 +1173,7 @@ void obj_move_all_post(object *objp, float frametime)
 		case OBJ_WEAPON:
 		{
 			if ( !physics_paused )
-				weapon_process_post( objp, frametime );
+				PROFILE("Weapons", weapon_process_post( objp, frametime ));
 
 			// Cast light
 			if ( Detail.lighting > 2 ) {
@@ -1503,7 +1503,8 @@ void obj_move_all(float frametime)
 	// do pre-collision stuff for beam weapons
 	beam_move_all_pre();
 
-	profile_begin("Collision Detection");
+	static int collision_zone = profile_register_zone("Collision Detection");
+	profile_begin(collision_zone);
 	if ( Collisions_enabled ) {
 		if ( Cmdline_old_collision_sys ) {
 			obj_check_all_collisions();
@@ -1511,7 +1512,7 @@ void obj_move_all(float frametime)
 			obj_sort_and_collide();
 		}
 	}
-	profile_end("Collision Detection");
+	profile_end(collision_zone);
 
 	turret_swarm_check_validity();
 
@@ -381,9 +381,10 @@ void obj_render_queue_all()
 			}
 
 			objp->flags |= OF_WAS_RENDERED;
-			profile_begin("Queue Render");
+			static int queue_render_zone = profile_register_zone("Queue Render");
+			profile_begin(queue_render_zone);
 			obj_queue_render(objp, &scene);
-			profile_end("Queue Render");
+			profile_end(queue_render_zone);
 		}
 	}
 
@@ -30,6 +30,7 @@
 #include "globalincs/systemvars.h"
 #include "cfile/cfilesystem.h"
 #include "globalincs/globals.h"
+#include "globalincs/workerpool.h"
 #include "parse/parselo.h"
 
 
@@ -98,6 +99,9 @@ int Log_debug_output_to_file = 1;
 FILE *Log_fp = NULL;
 char *FreeSpace_logfilename = NULL;
 
+// worker jobs log too, and printing can add to OutwndFilter
+static worker_mutex *Outwnd_lock = NULL;
+
 SCP_string safe_string;
 
 
@@ -376,7 +380,8 @@ void outwnd_printf(const char *id, const char *format, ...)
 	outwnd_print(id, temp.c_str());
 }
 
-void outwnd_print(const char *id, const char *tmp)
+// the part of outwnd_print() done under Outwnd_lock
+static void outwnd_print_locked(const char *id, const char *tmp)
 {
 	const char *sptr;
 	char *dptr;
@@ -392,10 +397,10 @@ void outwnd_print(const char *id, const char *tmp)
 	if (Outwnd_no_filter_file == 1) {
 		Outwnd_no_filter_file = 2;
 
-		outwnd_print( "general", "==========================================================================\n" );
-		outwnd_print( "general", "DEBUG SPEW: No debug_filter.cfg found, so only general, error, and warning\n" );
-		outwnd_print( "general", "categories can be shown and no debug_filter.cfg info will be saved.\n" );
-		outwnd_print( "general", "==========================================================================\n" );
+		outwnd_print_locked( "general", "==========================================================================\n" );
+		outwnd_print_locked( "general", "DEBUG SPEW: No debug_filter.cfg found, so only general, error, and warning\n" );
+		outwnd_print_locked( "general", "categories can be shown and no debug_filter.cfg info will be saved.\n" );
+		outwnd_print_locked( "general", "==========================================================================\n" );
 	}
 
 	uint outwnd_size = OutwndFilter.size();
@@ -510,6 +515,13 @@ void outwnd_print(const char *id, const char *tmp)
 	}
 }
 
+void outwnd_print(const char *id, const char *tmp)
+{
+	worker_mutex_lock(Outwnd_lock);
+	outwnd_print_locked(id, tmp);
+	worker_mutex_unlock(Outwnd_lock);
+}
+
 LRESULT CALLBACK outwnd_handler(HWND hwnd,UINT msg,WPARAM wParam, LPARAM lParam)
 {
 	switch(msg)	{
@@ -1166,6 +1178,9 @@ void outwnd_init(int display_under_freespace_window)
 {
 	if (outwnd_inited)
 		return;
+
+	if (Outwnd_lock == NULL)
+		Outwnd_lock = worker_mutex_create();
 /*
 	if (Cmdline_debug_window) {
  		hOutputThread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)outwnd_thread, (LPVOID)display_under_freespace_window, 0, &OutputThreadID);
@@ -1329,6 +1344,9 @@ void outwnd_close()
 	}
 
 	outwnd_inited = false;
+
+	worker_mutex_destroy(Outwnd_lock);
+	Outwnd_lock = NULL;
 }
 
 void safe_point_print(const char *format, ...)
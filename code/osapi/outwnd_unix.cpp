@@ -24,6 +24,7 @@
 #include "cfile/cfilesystem.h"
 #include "globalincs/systemvars.h"
 #include "globalincs/globals.h"
+#include "globalincs/workerpool.h"
 #include "parse/parselo.h"
 
 
@@ -56,6 +57,9 @@ int Log_debug_output_to_file = 1;
 FILE *Log_fp = NULL;
 char *FreeSpace_logfilename = "fs2_open.log";
 
+// worker jobs log too, and printing can add to OutwndFilter
+static worker_mutex *Outwnd_lock = NULL;
+
 SCP_string safe_string;
 
 
@@ -180,7 +184,8 @@ void outwnd_printf(const char *id, const char *format, ...)
 	outwnd_print(id, temp.c_str());
 }
 
-void outwnd_print(const char *id, const char *tmp)
+// the part of outwnd_print() done under Outwnd_lock
+static void outwnd_print_locked(const char *id, const char *tmp)
 {
 	uint i;
 
@@ -198,10 +203,10 @@ void outwnd_print(const char *id, const char *tmp)
 	if (Outwnd_no_filter_file == 1) {
 		Outwnd_no_filter_file = 2;
 
-		outwnd_print( "general", "==========================================================================\n" );
-		outwnd_print( "general", "DEBUG SPEW: No debug_filter.cfg found, so only general, error, and warning\n" );
-		outwnd_print( "general", "categories can be shown and no debug_filter.cfg info will be saved.\n" );
-		outwnd_print( "general", "==========================================================================\n" );
+		outwnd_print_locked( "general", "==========================================================================\n" );
+		outwnd_print_locked( "general", "DEBUG SPEW: No debug_filter.cfg found, so only general, error, and warning\n" );
+		outwnd_print_locked( "general", "categories can be shown and no debug_filter.cfg info will be saved.\n" );
+		outwnd_print_locked( "general", "==========================================================================\n" );
 	}
 
 	for (i = 0; i < OutwndFilter.size(); i++) {
@@ -239,11 +244,21 @@ void outwnd_print(const char *id, const char *tmp)
 	}
 }
 
+void outwnd_print(const char *id, const char *tmp)
+{
+	worker_mutex_lock(Outwnd_lock);
+	outwnd_print_locked(id, tmp);
+	worker_mutex_unlock(Outwnd_lock);
+}
+
 
 void outwnd_init(int display_under_freespace_window)
 {
 	outwnd_inited = true;
 
+	if (Outwnd_lock == NULL)
+		Outwnd_lock = worker_mutex_create();
+
 	char pathname[MAX_PATH_LEN];
     
     /* Set where the log file is going to go */
@@ -292,6 +307,9 @@ void outwnd_close()
 	}
 
 	outwnd_inited = false;
+
+	worker_mutex_destroy(Outwnd_lock);
+	Outwnd_lock = NULL;
 }
 
 void safe_point_print(const char *format, ...)
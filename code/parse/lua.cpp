@@ -6,6 +6,7 @@
 #include "cmdline/cmdline.h"
 #include "cutscene/movie.h"
 #include "debris/debris.h"
+#include "debugconsole/console.h"
 #include "external_dll/trackirpublic.h"
 #include "freespace2/freespace.h"
 #include "gamesequence/gamesequence.h"
@@ -251,6 +252,8 @@ const size_t INVALID_ID = (size_t) -1; // Use -1 to get highest possible unsigne
 //*************************Helper function declarations*********************
 //WMC - Sets object handle with proper type
 int ade_set_object_with_breed(lua_State *L, int obj_idx);
+//Sets object handle, reusing the one made for the object earlier in the frame
+static int ade_set_object_handle(lua_State *L, ade_obj<object_h> &lib, int obj_idx, ODATA_SIG_TYPE odata_sig = ODATA_SIG_DEFAULT);
 
 //**********Handles
 /*ade_obj<int> l_Camera("camera", "Camera handle");
@@ -8967,6 +8970,7 @@ ADE_VIRTVAR(Name, l_Ship, "string", "Ship name", "string", "Ship name, or empty
 
 	if(ADE_SETTING_VAR && s != NULL) {
 		strncpy(shipp->ship_name, s, sizeof(shipp->ship_name)-1);
+		Ship_lookup_generation++;
 	}
 
 	return ade_set_args(L, "s", shipp->ship_name);
@@ -11958,6 +11962,10 @@ ADE_FUNC(getSoundentry, l_Audio, "string/number", "Return a sound entry matching
 	}
 }
 
+//Sound files loaded by scripts, one per file name, so that loading the same file again doesn't
+//take another reference to it
+static SCP_vector<game_snd> Script_soundfiles;
+
 ADE_FUNC(loadSoundfile, l_Audio, "string filename", "Loads the specified sound file", "soundfile", "A soundfile handle")
 {
 	char* fileName = NULL;
@@ -11965,9 +11973,20 @@ ADE_FUNC(loadSoundfile, l_Audio, "string filename", "Loads the specified sound f
 	if (!ade_get_args(L, "s", &fileName))
 		return ade_set_error(L, "o", l_Soundfile.Set(-1));
 
-	game_snd tmp_gs;
-	strcpy_s( tmp_gs.filename, fileName );
-	int n = snd_load( &tmp_gs, 0 );
+	size_t idx;
+	for (idx = 0; idx < Script_soundfiles.size(); idx++)
+	{
+		if (!stricmp(Script_soundfiles[idx].filename, fileName))
+			break;
+	}
+
+	if (idx == Script_soundfiles.size())
+	{
+		Script_soundfiles.push_back(game_snd());
+		strcpy_s( Script_soundfiles[idx].filename, fileName );
+	}
+
+	int n = snd_load( &Script_soundfiles[idx], 0 );
 
 	return ade_set_error(L, "o", l_Soundfile.Set(n));
 }
@@ -14692,7 +14711,7 @@ ADE_INDEXER(l_Mission_Ships, "number Index/string Name", "Gets ship", "ship", "S
 
 	if(idx > -1)
 	{
-		return ade_set_args(L, "o", l_Ship.Set(object_h(&Objects[Ships[idx].objnum]), Objects[Ships[idx].objnum].signature));
+		return ade_set_object_handle(L, l_Ship, Ships[idx].objnum, Objects[Ships[idx].objnum].signature);
 	}
 	else
 	{
@@ -14707,7 +14726,7 @@ ADE_INDEXER(l_Mission_Ships, "number Index/string Name", "Gets ship", "ship", "S
 					continue;
 
 				if(count == idx) {
-					return ade_set_args(L, "o", l_Ship.Set(object_h(&Objects[Ships[i].objnum]), Objects[Ships[i].objnum].signature));
+					return ade_set_object_handle(L, l_Ship, Ships[i].objnum, Objects[Ships[i].objnum].signature);
 				}
 
 				count++;
@@ -15759,6 +15778,56 @@ ADE_FUNC(playCutscene, l_Testing, NULL, "Forces a cutscene by the specified file
 }
 
 // *************************Helper functions*********************
+//Object handles made this frame, so scripts that look up the same objects over and over
+//(ie going through mn.Ships every frame) don't make a new userdata every time.
+//The handles themselves are kept in a registry table, by object number.
+struct ade_object_handle
+{
+	int frame;
+	int sig;
+	uint lib_idx;
+	ODATA_SIG_TYPE odata_sig;
+};
+
+static ade_object_handle Ade_object_handles[MAX_OBJECTS];
+static int Ade_object_handles_frame = 1;
+static int Ade_object_handles_ref = LUA_NOREF;
+
+static int ade_set_object_handle(lua_State *L, ade_obj<object_h> &lib, int obj_idx, ODATA_SIG_TYPE odata_sig)
+{
+	object *objp = &Objects[obj_idx];
+	ade_object_handle *ohp = &Ade_object_handles[obj_idx];
+
+	if(Ade_object_handles_ref == LUA_NOREF)
+		return ade_set_args(L, "o", lib.Set(object_h(objp), odata_sig));
+
+	if(ohp->frame == Ade_object_handles_frame && ohp->sig == objp->signature && ohp->lib_idx == lib.GetIdx() && ohp->odata_sig == odata_sig)
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, Ade_object_handles_ref);
+		lua_rawgeti(L, -1, obj_idx);
+		lua_remove(L, -2);
+
+		if(lua_isuserdata(L, -1))
+			return 1;
+
+		lua_pop(L, 1);
+	}
+
+	int rtn = ade_set_args(L, "o", lib.Set(object_h(objp), odata_sig));
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, Ade_object_handles_ref);
+	lua_pushvalue(L, -2);
+	lua_rawseti(L, -2, obj_idx);
+	lua_pop(L, 1);
+
+	ohp->frame = Ade_object_handles_frame;
+	ohp->sig = objp->signature;
+	ohp->lib_idx = lib.GetIdx();
+	ohp->odata_sig = odata_sig;
+
+	return rtn;
+}
+
 //WMC - This should be used anywhere that an 'object' is set, so
 //that scripters can get access to as much relevant data to that
 //object as possible.
@@ -15773,19 +15842,19 @@ int ade_set_object_with_breed(lua_State *L, int obj_idx)
 	switch(objp->type)
 	{
 		case OBJ_SHIP:
-			return ade_set_args(L, "o", l_Ship.Set(object_h(objp)));
+			return ade_set_object_handle(L, l_Ship, obj_idx);
 		case OBJ_ASTEROID:
-			return ade_set_args(L, "o", l_Asteroid.Set(object_h(objp)));
+			return ade_set_object_handle(L, l_Asteroid, obj_idx);
 		case OBJ_DEBRIS:
-			return ade_set_args(L, "o", l_Debris.Set(object_h(objp)));
+			return ade_set_object_handle(L, l_Debris, obj_idx);
 		case OBJ_WAYPOINT:
-			return ade_set_args(L, "o", l_Waypoint.Set(object_h(objp)));
+			return ade_set_object_handle(L, l_Waypoint, obj_idx);
 		case OBJ_WEAPON:
-			return ade_set_args(L, "o", l_Weapon.Set(object_h(objp)));
+			return ade_set_object_handle(L, l_Weapon, obj_idx);
 		case OBJ_BEAM:
-			return ade_set_args(L, "o", l_Beam.Set(object_h(objp)));
+			return ade_set_object_handle(L, l_Beam, obj_idx);
 		default:
-			return ade_set_args(L, "o", l_Object.Set(object_h(objp)));
+			return ade_set_object_handle(L, l_Object, obj_idx);
 	}
 }
 
@@ -15862,13 +15931,113 @@ static int ade_return_hack(lua_State *L)
 
 	return num;
 }
+//Lua allocator. Small blocks (userdata handles, strings, closures) come from per size
+//free lists carved out of big chunks, rather than going to the heap one at a time;
+//everything else goes to the heap like Lua's own allocator.
+//The chunks are never given back, the free lists only grow as big as the most
+//small blocks Lua had at once.
+#define ADE_POOL_GRANULARITY	16
+#define ADE_POOL_MAX_SIZE		128
+#define ADE_POOL_NUM_SIZES		(ADE_POOL_MAX_SIZE / ADE_POOL_GRANULARITY)
+#define ADE_POOL_CHUNK_SIZE		(64 * 1024)
+
+static void *Ade_pool_free[ADE_POOL_NUM_SIZES];
+static char *Ade_pool_chunk = NULL;
+static size_t Ade_pool_chunk_left = 0;
+
+static void *ade_pool_alloc(size_t size)
+{
+	size_t sc = (size - 1) / ADE_POOL_GRANULARITY;
+	size_t block_size = (sc + 1) * ADE_POOL_GRANULARITY;
+	void *ptr = Ade_pool_free[sc];
+
+	if(ptr != NULL)
+	{
+		Ade_pool_free[sc] = *(void **)ptr;
+		return ptr;
+	}
+
+	if(Ade_pool_chunk_left < block_size)
+	{
+		//WMC - whatever is left of the old chunk is too small for this block, but
+		//it's at most ADE_POOL_MAX_SIZE bytes
+		Ade_pool_chunk = (char *)malloc(ADE_POOL_CHUNK_SIZE);
+		Ade_pool_chunk_left = (Ade_pool_chunk != NULL) ? ADE_POOL_CHUNK_SIZE : 0;
+
+		if(Ade_pool_chunk == NULL)
+			return NULL;
+	}
+
+	ptr = Ade_pool_chunk;
+	Ade_pool_chunk += block_size;
+	Ade_pool_chunk_left -= block_size;
+
+	return ptr;
+}
+
+static void ade_pool_release(void *ptr, size_t size)
+{
+	size_t sc = (size - 1) / ADE_POOL_GRANULARITY;
+
+	*(void **)ptr = Ade_pool_free[sc];
+	Ade_pool_free[sc] = ptr;
+}
+
+//Lua always gives the old size of the block, so the blocks don't need a header
+static void *ade_lua_alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	bool old_pooled = (ptr != NULL) && (osize <= ADE_POOL_MAX_SIZE);
+	bool new_pooled = (nsize <= ADE_POOL_MAX_SIZE);
+
+	if(nsize == 0)
+	{
+		if(old_pooled)
+			ade_pool_release(ptr, osize);
+		else
+			free(ptr);
+
+		return NULL;
+	}
+
+	if(ptr != NULL && !old_pooled && !new_pooled)
+		return realloc(ptr, nsize);
+
+	//Still fits in the same size of block
+	if(old_pooled && new_pooled && ((osize - 1) / ADE_POOL_GRANULARITY) == ((nsize - 1) / ADE_POOL_GRANULARITY))
+		return ptr;
+
+	void *new_ptr = new_pooled ? ade_pool_alloc(nsize) : malloc(nsize);
+
+	if(new_ptr == NULL)
+		return NULL;
+
+	if(ptr != NULL)
+	{
+		memcpy(new_ptr, ptr, MIN(osize, nsize));
+
+		if(old_pooled)
+			ade_pool_release(ptr, osize);
+		else
+			free(ptr);
+	}
+
+	return new_ptr;
+}
+
+static int ade_lua_panic(lua_State *L)
+{
+	Error(LOCATION, "Unprotected error in Lua: %s", lua_tostring(L, -1));
+
+	return 0;
+}
+
 //Inits LUA
 //Note that "libraries" must end with a {NULL, NULL}
 //element
 int script_state::CreateLuaState()
 {
 	mprintf(("LUA: Opening LUA state...\n"));
-	lua_State *L = lua_open();
+	lua_State *L = lua_newstate(ade_lua_alloc, NULL);
 
 	if(L == NULL)
 	{
@@ -15876,6 +16045,8 @@ int script_state::CreateLuaState()
 		return 0;
 	}
 
+	lua_atpanic(L, ade_lua_panic);
+
 	//*****INITIALIZE AUXILIARY LIBRARIES
 	mprintf(("LUA: Initializing base Lua libraries...\n"));
 	luaL_openlibs(L);
@@ -15931,6 +16102,18 @@ int script_state::CreateLuaState()
 		lua_setglobal(L, Enumerations[i].name);
 	}
 
+	//*****TAKE OVER GARBAGE COLLECTION
+	if(Cmdline_lua_gc_budget > 0)
+	{
+		mprintf(("LUA: Collecting garbage for up to %d us per frame\n", Cmdline_lua_gc_budget));
+		lua_gc(L, LUA_GCSTOP, 0);
+	}
+
+	//*****INITIALIZE OBJECT HANDLE CACHE
+	lua_newtable(L);
+	Ade_object_handles_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	memset(Ade_object_handles, 0, sizeof(Ade_object_handles));
+
 	//*****ASSIGN LUA SESSION
 	mprintf(("ADE: Assigning Lua session...\n"));
 	SetLuaSession(L);
@@ -15938,9 +16121,170 @@ int script_state::CreateLuaState()
 	return 1;
 }
 
+//With -lua_gc_budget, Lua's collector is stopped and ade_gc_do_frame() runs it in steps at
+//the end of each frame, for at most the budget, instead of whenever an allocation happens
+//to cross the threshold. A cycle starts once the heap has doubled since the last one
+//finished, like Lua's default pause.
+#define ADE_GC_STEP_KB			16			//work done by each lua_gc step, in KB allocated
+#define ADE_GC_MIN_THRESHOLD_KB	1024
+
+static bool Ade_gc_collecting = false;
+static int Ade_gc_threshold_kb = ADE_GC_MIN_THRESHOLD_KB;
+
+//Ends a collection cycle; the next one starts when the heap has doubled
+static void ade_gc_cycle_done(lua_State *L)
+{
+	Ade_gc_collecting = false;
+	Ade_gc_threshold_kb = MAX(lua_gc(L, LUA_GCCOUNT, 0) * 2, ADE_GC_MIN_THRESHOLD_KB);
+}
+
+static void ade_gc_do_frame(lua_State *L)
+{
+	uint gc_time = 0;
+
+	if(Cmdline_lua_gc_budget > 0)
+	{
+		uint start = timer_get_high_res_microseconds();
+
+		if(!Ade_gc_collecting && lua_gc(L, LUA_GCCOUNT, 0) >= Ade_gc_threshold_kb)
+			Ade_gc_collecting = true;
+
+		while(Ade_gc_collecting)
+		{
+			if(lua_gc(L, LUA_GCSTEP, ADE_GC_STEP_KB))
+				ade_gc_cycle_done(L);
+
+			gc_time = timer_get_high_res_microseconds() - start;
+
+			if(gc_time >= (uint)Cmdline_lua_gc_budget)
+				break;
+		}
+
+		//A step lets Lua collect by itself again, so stop it until the next frame. If the budget
+		//isn't keeping up with the garbage, leave it running rather than let the heap grow forever.
+		if(lua_gc(L, LUA_GCCOUNT, 0) < (Ade_gc_threshold_kb * 2))
+			lua_gc(L, LUA_GCSTOP, 0);
+		else
+			lua_gc(L, LUA_GCRESTART, 0);
+	}
+
+	profile_counter_set("Lua heap (KB)", lua_gc(L, LUA_GCCOUNT, 0));
+	profile_counter_set("Lua GC (us)", (int)gc_time, Cmdline_lua_gc_budget);
+}
+
 void script_state::EndLuaFrame()
 {
 	memcpy(NextDrawStringPos, NextDrawStringPosInitial, sizeof(NextDrawStringPos));
+
+	//Object handles are only reused within a frame
+	Ade_object_handles_frame++;
+
+	if(LuaState != NULL)
+		ade_gc_do_frame(LuaState);
+}
+
+//Called while a mission loads, where a long pause doesn't matter
+void script_state::CollectGarbage()
+{
+	if(LuaState == NULL)
+		return;
+
+	uint start = timer_get_high_res_microseconds();
+
+	lua_gc(LuaState, LUA_GCCOLLECT, 0);
+
+	if(Cmdline_lua_gc_budget > 0)
+	{
+		ade_gc_cycle_done(LuaState);
+		lua_gc(LuaState, LUA_GCSTOP, 0);
+	}
+
+	mprintf(("LUA: Collected garbage in %u us, %d KB in use\n", timer_get_high_res_microseconds() - start, lua_gc(LuaState, LUA_GCCOUNT, 0)));
+}
+
+//Scripting calls timed by lua_bench. Each runs in a loop with 'ship' set to the first ship
+//of the mission and 'sig' to its signature; the empty one is the cost of the loop itself.
+static const char *Ade_bench_snippets[] = {
+	"",
+	"local t = mn.getMissionTime()",
+	"local c = #mn.Ships",
+	"local s = mn.Ships[1]",
+	"local o = mn.getObjectFromSignature(sig)",
+	"local p = ship.Position",
+	"local h = ship.HitpointsLeft",
+	"local v = ba.createVector(1, 2, 3)",
+};
+
+static int Num_ade_bench_snippets = sizeof(Ade_bench_snippets) / sizeof(Ade_bench_snippets[0]);
+
+DCF(lua_bench, "Times common scripting calls against the current mission")
+{
+	int iterations = 10000;
+
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: lua_bench [iterations]\n");
+		dc_printf("Runs each of a set of scripting calls [iterations] times (default 10000) and prints\n");
+		dc_printf("the time and Lua memory allocated per call. Needs a mission with at least one ship.\n");
+		return;
+	}
+
+	dc_maybe_stuff_int(&iterations);
+
+	lua_State *L = Script_system.GetLuaSession();
+
+	if (L == NULL) {
+		dc_printf("Scripting isn't running\n");
+		return;
+	}
+
+	if (!(Game_mode & GM_IN_MISSION) || ship_get_num_ships() <= 0) {
+		dc_printf("Load a mission with at least one ship first\n");
+		return;
+	}
+
+	iterations = MAX(iterations, 1);
+
+	for (int i = 0; i < Num_ade_bench_snippets; i++) {
+		SCP_string code = "local n = ...\nlocal ship = mn.Ships[1]\nlocal sig = ship:getSignature()\nfor i = 1, n do\n";
+		code += Ade_bench_snippets[i];
+		code += "\nend\n";
+
+		int stack_start = lua_gettop(L);
+
+		lua_pushcfunction(L, ade_friendly_error);
+
+		if (luaL_loadbuffer(L, code.c_str(), code.size(), "lua_bench")) {
+			dc_printf("%s: %s\n", Ade_bench_snippets[i], lua_tostring(L, -1));
+			lua_settop(L, stack_start);
+			continue;
+		}
+
+		lua_pushnumber(L, iterations);
+
+		//Start from a clean heap, and don't let the collector run during the loop, so the
+		//memory numbers are just what the calls allocated
+		lua_gc(L, LUA_GCCOLLECT, 0);
+		lua_gc(L, LUA_GCSTOP, 0);
+
+		int mem_start = (lua_gc(L, LUA_GCCOUNT, 0) * 1024) + lua_gc(L, LUA_GCCOUNTB, 0);
+		uint time_start = timer_get_high_res_microseconds();
+
+		int err = lua_pcall(L, 1, 0, stack_start + 1);
+
+		uint time = timer_get_high_res_microseconds() - time_start;
+		int mem = (lua_gc(L, LUA_GCCOUNT, 0) * 1024) + lua_gc(L, LUA_GCCOUNTB, 0) - mem_start;
+
+		lua_gc(L, LUA_GCRESTART, 0);
+		lua_settop(L, stack_start);
+
+		if (err) {
+			dc_printf("%s: failed\n", Ade_bench_snippets[i]);
+			continue;
+		}
+
+		dc_printf("%-44s %10.1f ns %8.1f bytes\n", (*Ade_bench_snippets[i] != '\0') ? Ade_bench_snippets[i] : "(empty loop)",
+			(time * 1000.0) / iterations, (float)mem / iterations);
+	}
 }
 
 //*************************Lua functions*************************
@@ -253,6 +253,87 @@ bool ConditionedHook::AddAction(script_action *sa)
 	return true;
 }
 
+//Looks up what a condition's name refers to the first time the condition is checked, so
+//running a hook compares indices rather than strings.  Ship and weapon classes can't be
+//looked up when scripting.tbl is parsed, since it's parsed before ships.tbl and weapons.tbl.
+static int script_condition_index(script_condition *scp)
+{
+	int idx = -1;
+
+	if(scp->data_index != CONDITION_UNRESOLVED)
+		return scp->data_index;
+
+	switch(scp->condition_type)
+	{
+		case CHC_STATE:
+			idx = gameseq_get_state_idx(scp->data.name);
+			break;
+		case CHC_SHIPTYPE:
+			if(Ship_types.empty())
+				return -1;
+			idx = ship_type_name_lookup(scp->data.name);
+			break;
+		case CHC_SHIPCLASS:
+			if(Ship_info.empty())
+				return -1;
+			idx = ship_info_lookup(scp->data.name);
+			break;
+		case CHC_WEAPONCLASS:
+			if(Num_weapon_types <= 0)
+				return -1;
+			idx = weapon_info_lookup(scp->data.name);
+			break;
+		case CHC_OBJECTTYPE:
+			for(int i = 0; i < MAX_OBJECT_TYPES; i++)
+			{
+				if(!stricmp(Object_type_names[i], scp->data.name))
+				{
+					idx = i;
+					break;
+				}
+			}
+			break;
+		case CHC_ACTION:
+			for(int i = 0; i < CCFG_MAX; i++)
+			{
+				if(!stricmp(Control_config[i].text, scp->data.name))
+				{
+					idx = i;
+					break;
+				}
+			}
+			break;
+		case CHC_VERSION:
+			{
+				// Goober5000: I'm going to assume scripting doesn't care about SVN revision
+				char buf[32];
+				sprintf(buf, "%i.%i.%i", FS_VERSION_MAJOR, FS_VERSION_MINOR, FS_VERSION_BUILD);
+				idx = stricmp(buf, scp->data.name) ? 0 : 1;
+
+				//In case some people are lazy and say "3.7" instead of "3.7.0" or something
+				if(!idx && FS_VERSION_BUILD == 0)
+				{
+					sprintf(buf, "%i.%i", FS_VERSION_MAJOR, FS_VERSION_MINOR);
+					idx = stricmp(buf, scp->data.name) ? 0 : 1;
+				}
+				break;
+			}
+		case CHC_APPLICATION:
+			if(Fred_running)
+				idx = (!stricmp("FRED2_Open", scp->data.name) || !stricmp("FRED2Open", scp->data.name) || !stricmp("FRED 2", scp->data.name) || !stricmp("FRED", scp->data.name)) ? 1 : 0;
+			else
+				idx = (!stricmp("FS2_Open", scp->data.name) || !stricmp("FS2Open", scp->data.name) || !stricmp("Freespace 2", scp->data.name) || !stricmp("Freespace", scp->data.name)) ? 1 : 0;
+			break;
+		default:
+			//compared by name every time
+			return CONDITION_UNRESOLVED;
+	}
+
+	scp->data_index = idx;
+
+	return idx;
+}
+
 bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 {
 	uint i;
@@ -268,7 +349,7 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 			case CHC_STATE:
 				if(gameseq_get_depth() < 0)
 					return false;
-				if(stricmp(GS_state_text[gameseq_get_state(0)], scp->data.name))
+				if(gameseq_get_state(0) != script_condition_index(scp))
 					return false;
 				break;
 			case CHC_SHIPTYPE:
@@ -277,12 +358,13 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 				sip = &Ship_info[Ships[objp->instance].ship_info_index];
 				if(sip->class_type < 0)
 					return false;
-				if(stricmp(Ship_types[sip->class_type].name, scp->data.name))
+				if(sip->class_type != script_condition_index(scp))
 					return false;
+				break;
 			case CHC_SHIPCLASS:
 				if(objp == NULL || objp->type != OBJ_SHIP)
 					return false;
-				if(stricmp(Ship_info[Ships[objp->instance].ship_info_index].name, scp->data.name))
+				if(Ships[objp->instance].ship_info_index != script_condition_index(scp))
 					return false;
 				break;
 			case CHC_SHIP:
@@ -318,15 +400,19 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 				}
 			case CHC_WEAPONCLASS:
 				{
+					int wi = script_condition_index(scp);
+					if (wi < 0)
+						return false;
+
 					if (action == CHA_COLLIDEWEAPON) {
-						if (stricmp(Weapon_info[more_data].name, scp->data.name) != 0)
+						if (more_data != wi)
 							return false;
 					} else if (!(action == CHA_ONWPSELECTED || action == CHA_ONWPDESELECTED || action == CHA_ONWPEQUIPPED || action == CHA_ONWPFIRED || action == CHA_ONTURRETFIRED )) {
 						if(objp == NULL || (objp->type != OBJ_WEAPON && objp->type != OBJ_BEAM))
 							return false;
-						else if (( objp->type == OBJ_WEAPON) && (stricmp(Weapon_info[Weapons[objp->instance].weapon_info_index].name, scp->data.name) != 0 ))
+						else if (( objp->type == OBJ_WEAPON) && (Weapons[objp->instance].weapon_info_index != wi))
 							return false;
-						else if (( objp->type == OBJ_BEAM) && (stricmp(Weapon_info[Beams[objp->instance].weapon_info_index].name, scp->data.name) != 0 ))
+						else if (( objp->type == OBJ_BEAM) && (Beams[objp->instance].weapon_info_index != wi))
 							return false;
 					} else if(objp == NULL || objp->type != OBJ_SHIP) {
 						return false;
@@ -337,8 +423,8 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 						bool primary = false, secondary = false, prev_primary = false, prev_secondary = false;
 						switch (action) {
 							case CHA_ONWPSELECTED:
-								primary = stricmp(Weapon_info[shipp->weapons.primary_bank_weapons[shipp->weapons.current_primary_bank]].name, scp->data.name) == 0;
-								secondary = stricmp(Weapon_info[shipp->weapons.secondary_bank_weapons[shipp->weapons.current_secondary_bank]].name, scp->data.name) == 0;
+								primary = shipp->weapons.primary_bank_weapons[shipp->weapons.current_primary_bank] == wi;
+								secondary = shipp->weapons.secondary_bank_weapons[shipp->weapons.current_secondary_bank] == wi;
 								
 								if (!(primary || secondary))
 									return false;
@@ -348,10 +434,10 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 								
 								break;
 							case CHA_ONWPDESELECTED:
-								primary = stricmp(Weapon_info[shipp->weapons.primary_bank_weapons[shipp->weapons.current_primary_bank]].name, scp->data.name) == 0;
-								prev_primary = stricmp(Weapon_info[shipp->weapons.primary_bank_weapons[shipp->weapons.previous_primary_bank]].name, scp->data.name) == 0;
-								secondary = stricmp(Weapon_info[shipp->weapons.secondary_bank_weapons[shipp->weapons.current_secondary_bank]].name, scp->data.name) == 0;
-								prev_secondary = stricmp(Weapon_info[shipp->weapons.secondary_bank_weapons[shipp->weapons.previous_secondary_bank]].name, scp->data.name) == 0;
+								primary = shipp->weapons.primary_bank_weapons[shipp->weapons.current_primary_bank] == wi;
+								prev_primary = shipp->weapons.primary_bank_weapons[shipp->weapons.previous_primary_bank] == wi;
+								secondary = shipp->weapons.secondary_bank_weapons[shipp->weapons.current_secondary_bank] == wi;
+								prev_secondary = shipp->weapons.secondary_bank_weapons[shipp->weapons.previous_secondary_bank] == wi;
 
 								if ((shipp->flags & SF_PRIMARY_LINKED) && prev_primary && (Weapon_info[shipp->weapons.primary_bank_weapons[shipp->weapons.previous_primary_bank]].wi_flags3 & WIF3_NOLINK))
 									return true;
@@ -376,7 +462,7 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 								bool equipped = false;
 								for(int j = 0; j < MAX_SHIP_PRIMARY_BANKS; j++) {
 									if (!equipped && (shipp->weapons.primary_bank_weapons[j] >= 0) && (shipp->weapons.primary_bank_weapons[j] < MAX_WEAPON_TYPES) ) {
-										if ( !stricmp(Weapon_info[shipp->weapons.primary_bank_weapons[j]].name, scp->data.name) ) {
+										if ( shipp->weapons.primary_bank_weapons[j] == wi ) {
 											equipped = true;
 											break;
 										}
@@ -386,7 +472,7 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 								if (!equipped) {
 									for(int j = 0; j < MAX_SHIP_SECONDARY_BANKS; j++) {
 										if (!equipped && (shipp->weapons.secondary_bank_weapons[j] >= 0) && (shipp->weapons.secondary_bank_weapons[j] < MAX_WEAPON_TYPES) ) {
-											if ( !stricmp(Weapon_info[shipp->weapons.secondary_bank_weapons[j]].name, scp->data.name) ) {
+											if ( shipp->weapons.secondary_bank_weapons[j] == wi ) {
 												equipped = true;
 												break;
 											}
@@ -401,11 +487,11 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 							}
 							case CHA_ONWPFIRED: {
 								if (more_data == 1) {
-									primary = stricmp(Weapon_info[shipp->weapons.primary_bank_weapons[shipp->weapons.current_primary_bank]].name, scp->data.name) == 0;
+									primary = shipp->weapons.primary_bank_weapons[shipp->weapons.current_primary_bank] == wi;
 									secondary = false;
 								} else {
 									primary = false;
-									secondary = stricmp(Weapon_info[shipp->weapons.secondary_bank_weapons[shipp->weapons.current_secondary_bank]].name, scp->data.name) == 0;
+									secondary = shipp->weapons.secondary_bank_weapons[shipp->weapons.current_secondary_bank] == wi;
 								}
 
 								if ((shipp->flags & SF_PRIMARY_LINKED) && primary && (Weapon_info[shipp->weapons.primary_bank_weapons[shipp->weapons.current_primary_bank]].wi_flags3 & WIF3_NOLINK))
@@ -416,22 +502,22 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 								break;
 							}
 							case CHA_ONTURRETFIRED: {
-								if (! (stricmp(Weapon_info[shipp->last_fired_turret->last_fired_weapon_info_index].name, scp->data.name) == 0))
+								if (shipp->last_fired_turret->last_fired_weapon_info_index != wi)
 									return false;
 								break;
 							}
 							case CHA_PRIMARYFIRE: {
-								if (stricmp(Weapon_info[shipp->weapons.primary_bank_weapons[shipp->weapons.current_primary_bank]].name, scp->data.name))
+								if (shipp->weapons.primary_bank_weapons[shipp->weapons.current_primary_bank] != wi)
 									return false;
 								break;
 							}
 							case CHA_SECONDARYFIRE: {
-								if (stricmp(Weapon_info[shipp->weapons.secondary_bank_weapons[shipp->weapons.current_secondary_bank]].name, scp->data.name))
+								if (shipp->weapons.secondary_bank_weapons[shipp->weapons.current_secondary_bank] != wi)
 									return false;
 								break;
 							}
 							case CHA_BEAMFIRE: {
-								if (!(stricmp(Weapon_info[more_data].name, scp->data.name) == 0))
+								if (more_data != wi)
 									return false;
 								break;
 							}
@@ -443,7 +529,7 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 			case CHC_OBJECTTYPE:
 				if(objp == NULL)
 					return false;
-				if(stricmp(Object_type_names[objp->type], scp->data.name))
+				if(objp->type != script_condition_index(scp))
 					return false;
 				break;
 			case CHC_KEYPRESS:
@@ -465,44 +551,15 @@ bool ConditionedHook::ConditionsValid(int action, object *objp, int more_data)
 
 					int action_index = more_data;
 
-					if (action_index <= 0 || stricmp(scp->data.name, Control_config[action_index].text))
+					if (action_index <= 0 || action_index != script_condition_index(scp))
 						return false;
 					break;
 				}
 			case CHC_VERSION:
-				{
-					// Goober5000: I'm going to assume scripting doesn't care about SVN revision
-					char buf[32];
-					sprintf(buf, "%i.%i.%i", FS_VERSION_MAJOR, FS_VERSION_MINOR, FS_VERSION_BUILD);
-					if(stricmp(buf, scp->data.name))
-					{
-						//In case some people are lazy and say "3.7" instead of "3.7.0" or something
-						if(FS_VERSION_BUILD == 0)
-						{
-							sprintf(buf, "%i.%i", FS_VERSION_MAJOR, FS_VERSION_MINOR);
-							if(stricmp(buf, scp->data.name))
-								return false;
-						}
-						else
-						{
-							return false;
-						}
-					}
-					break;
-				}
 			case CHC_APPLICATION:
-				{
-					if(Fred_running)
-					{
-						if(stricmp("FRED2_Open", scp->data.name) && stricmp("FRED2Open", scp->data.name) && stricmp("FRED 2", scp->data.name) && stricmp("FRED", scp->data.name))
-							return false;
-					}
-					else
-					{
-						if(stricmp("FS2_Open", scp->data.name) && stricmp("FS2Open", scp->data.name) && stricmp("Freespace 2", scp->data.name) && stricmp("Freespace", scp->data.name))
-							return false;
-					}
-				}
+				if(script_condition_index(scp) <= 0)
+					return false;
+				break;
 			default:
 				break;
 		}
@@ -924,8 +981,14 @@ int script_state::RunBytecode(script_hook &hd, char format, void *data)
 int script_state::RunCondition(int action, char format, void *data, object *objp, int more_data)
 {
 	int num = 0;
-	for(SCP_vector<ConditionedHook>::iterator chp = ConditionalHooks.begin(); chp != ConditionalHooks.end(); ++chp) 
+
+	if(action < 0 || action > CHA_LAST)
+		return 0;
+
+	//only the hooks that have this action
+	for(SCP_vector<int>::iterator ii = ActionHooks[action].begin(); ii != ActionHooks[action].end(); ++ii)
 	{
+		ConditionedHook *chp = &ConditionalHooks[*ii];
 		if(chp->ConditionsValid(action, objp, more_data))
 		{
 			chp->Run(this, action, format, data);
@@ -938,8 +1001,12 @@ int script_state::RunCondition(int action, char format, void *data, object *objp
 bool script_state::IsConditionOverride(int action, object *objp)
 {
 	//bool b = false;
-	for(SCP_vector<ConditionedHook>::iterator chp = ConditionalHooks.begin(); chp != ConditionalHooks.end(); ++chp)
+	if(action < 0 || action > CHA_LAST)
+		return false;
+
+	for(SCP_vector<int>::iterator ii = ActionHooks[action].begin(); ii != ActionHooks[action].end(); ++ii)
 	{
+		ConditionedHook *chp = &ConditionalHooks[*ii];
 		if(chp->ConditionsValid(action, objp))
 		{
 			if(chp->IsOverride(this, action))
@@ -1362,6 +1429,10 @@ bool script_state::ParseCondition(const char *filename)
 				break;
 		}
 
+		//these don't depend on any other tables, so look them up now
+		if(condition == CHC_STATE || condition == CHC_OBJECTTYPE || condition == CHC_ACTION || condition == CHC_VERSION)
+			script_condition_index(&sct);
+
 		if(chp == NULL)
 		{
 			ConditionalHooks.push_back(ConditionedHook());
@@ -1381,6 +1452,8 @@ bool script_state::ParseCondition(const char *filename)
 
 	flag_def_list *action;
 	bool actions_added = false;
+	bool has_action[CHA_LAST+1];
+	memset(has_action, 0, sizeof(has_action));
 	for(action = script_parse_action(); action != NULL; action = script_parse_action())
 	{
 		script_action sat;
@@ -1397,7 +1470,10 @@ bool script_state::ParseCondition(const char *filename)
 
 		//Add the action
 		if(chp->AddAction(&sat))
+		{
 			actions_added = true;
+			has_action[sat.action_type] = true;
+		}
 	}
 
 	if(!actions_added)
@@ -1407,6 +1483,12 @@ bool script_state::ParseCondition(const char *filename)
 		return false;
 	}
 
+	for(int i = 0; i <= CHA_LAST; i++)
+	{
+		if(has_action[i])
+			ActionHooks[i].push_back((int)ConditionalHooks.size() - 1);
+	}
+
 	return true;
 }
 
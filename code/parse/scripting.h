@@ -80,6 +80,11 @@ struct image_desc
 #define CHA_AFTERBURNEND    37
 #define CHA_BEAMFIRE        38
 
+#define CHA_LAST			CHA_BEAMFIRE
+
+//What a condition's name was resolved to, see script_condition::data_index
+#define CONDITION_UNRESOLVED	-2
+
 // management stuff
 void scripting_state_init();
 void scripting_state_close();
@@ -93,9 +98,13 @@ public:
 	{
 		char name[CONDITION_LENGTH];
 	} data;
+	//The name looked up once rather than compared on every run: a ship class, ship type,
+	//weapon class, game state, object type or control index, or 1/0 for conditions that
+	//can't change while the game is running.  -1 if nothing matches the name.
+	int data_index;
 
 	script_condition()
-		: condition_type(CHC_NONE)
+		: condition_type(CHC_NONE), data_index(CONDITION_UNRESOLVED)
 	{
 		memset(data.name, 0, sizeof(data.name));
 	}
@@ -141,6 +150,7 @@ private:
 	//Utility variables
 	SCP_vector<image_desc> ScriptImages;
 	SCP_vector<ConditionedHook> ConditionalHooks;
+	SCP_vector<int> ActionHooks[CHA_LAST+1];	//indices into ConditionalHooks, by the actions each hook has
 
 private:
 
@@ -206,6 +216,7 @@ public:
 
 	//*****Other functions
 	void EndFrame();
+	void CollectGarbage();
 };
 
 
@@ -845,6 +845,7 @@ sexp_node *Sexp_nodes = NULL;
 
 sexp_variable Sexp_variables[MAX_SEXP_VARIABLES];
 sexp_variable Block_variables[MAX_SEXP_VARIABLES];			// used for compatibility with retail. 
+int Sexp_variable_generation = 0;								// bumped whenever a Sexp_variable is added or changed
 
 int Num_special_expl_blocks;
 
@@ -1167,6 +1168,9 @@ int alloc_sexp(char *text, int type, int subtype, int first, int rest)
 	Sexp_nodes[node].value = SEXP_UNKNOWN;
 	Sexp_nodes[node].flags = SNF_DEFAULT_VALUE;	// Goober5000
 	Sexp_nodes[node].op_index = NO_OPERATOR_INDEX_DEFINED;
+	Sexp_nodes[node].handle_type = SEXP_HANDLE_NONE;
+	Sexp_nodes[node].handle_index = -1;
+	Sexp_nodes[node].handle_subsys = NULL;
 
 	return node;
 }
@@ -1882,7 +1886,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 					return SEXP_CHECK_TYPE_MISMATCH;
 				}
 
-				if (ship_name_lookup(CTEXT(node), 0) < 0)
+				if (sexp_ship_lookup(node, 0) < 0)
 				{
 					if (Fred_running || !mission_parse_get_arrival_ship(CTEXT(node)))
 					{
@@ -1900,7 +1904,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 
 				if (stricmp(CTEXT(node), SEXP_NONE_STRING))		// none is okay
 				{
-					if (ship_name_lookup(CTEXT(node), 1) < 0)
+					if (sexp_ship_lookup(node, 1) < 0)
 					{
 						if (Fred_running || !mission_parse_get_arrival_ship(CTEXT(node)))
 						{
@@ -1917,7 +1921,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 					return SEXP_CHECK_TYPE_MISMATCH;
 				}
 
-				if (ship_name_lookup(CTEXT(node), 1) < 0) {
+				if (sexp_ship_lookup(node, 1) < 0) {
 					if (Fred_running || !mission_parse_get_arrival_ship(CTEXT(node)))
 					{
 						if (type == OPF_SHIP)
@@ -1942,7 +1946,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 					return SEXP_CHECK_TYPE_MISMATCH;
 				}
 
-				if (wing_name_lookup(CTEXT(node), 1) < 0){
+				if (sexp_wing_lookup(node, 1) < 0){
 					return SEXP_CHECK_INVALID_WING;
 				}
 
@@ -1965,7 +1969,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 				}
 
 				// all of these have ships and wings in common
-				if (ship_name_lookup(CTEXT(node), 1) >= 0 || wing_name_lookup(CTEXT(node), 1) >= 0) {
+				if (sexp_ship_lookup(node, 1) >= 0 || sexp_wing_lookup(node, 1) >= 0) {
 					break;
 				}
 				// also check arrival list if we're running the game
@@ -2252,7 +2256,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 						valid = 1;
 					}
 
-					if (ship_name_lookup(CTEXT(node), 1) >= 0)
+					if (sexp_ship_lookup(node, 1) >= 0)
 					{
 						valid = 1;
 					}
@@ -2414,9 +2418,9 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 						break;
 					}
 
-					ship_num = ship_name_lookup(CTEXT(Sexp_nodes[op_node].rest), 1);	// Goober5000 - include players
+					ship_num = sexp_ship_lookup(Sexp_nodes[op_node].rest, 1);	// Goober5000 - include players
 					if (ship_num < 0) {
-						w = wing_name_lookup(CTEXT(Sexp_nodes[op_node].rest));
+						w = sexp_wing_lookup(Sexp_nodes[op_node].rest);
 						if (w < 0) {
 							if (bad_node){
 								*bad_node = Sexp_nodes[op_node].rest;
@@ -2444,7 +2448,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 					}
 
 					if ((z == OP_AI_DOCK) && (Sexp_nodes[node].rest >= 0)) {
-						ship2 = ship_name_lookup(CTEXT(Sexp_nodes[node].rest), 1);	// Goober5000 - include players
+						ship2 = sexp_ship_lookup(Sexp_nodes[node].rest, 1);	// Goober5000 - include players
 						if ((ship_num < 0) || !ship_docking_valid(ship_num, ship2)){
 							return SEXP_CHECK_DOCKING_NOT_ALLOWED;
 						}
@@ -2650,7 +2654,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 					}
 
 					// look for the ship this goal is being assigned to
-					ship_num = ship_name_lookup(CTEXT(Sexp_nodes[z].rest), 1);
+					ship_num = sexp_ship_lookup(Sexp_nodes[z].rest, 1);
 					if (ship_num < 0) {
 						if (bad_node)
 							*bad_node = Sexp_nodes[z].rest;
@@ -2689,7 +2693,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 						ship_num = ship_name_lookup(Sexp_nodes[z].text, 1);
 					}
 					else {
-						ship_num = ship_name_lookup(CTEXT(Sexp_nodes[op_node].rest), 1);
+						ship_num = sexp_ship_lookup(Sexp_nodes[op_node].rest, 1);
 					}
 
 					if (ship_num < 0) {
@@ -2718,7 +2722,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 				if (*CTEXT(node) != '#') {  // not a manual source?
 					if ( stricmp(CTEXT(node), "<any wingman>"))  
 						if ( stricmp(CTEXT(node), "<none>") ) // not a special token?
-							if ((ship_name_lookup(CTEXT(node), TRUE) < 0) && (wing_name_lookup(CTEXT(node), 1) < 0))  // is it in the mission?
+							if ((sexp_ship_lookup(node, TRUE) < 0) && (sexp_wing_lookup(node, 1) < 0))  // is it in the mission?
 								if (Fred_running || !mission_parse_get_arrival_ship(CTEXT(node)))
 									return SEXP_CHECK_INVALID_MSG_SOURCE;
 				}
@@ -3926,7 +3930,7 @@ player * get_player_from_ship_node(int node, bool test_respawns)
 	
 	Assert (node != -1);
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 
 	// singleplayer
 	if (!(Game_mode & GM_MULTIPLAYER)){	
@@ -3969,7 +3973,7 @@ ship * sexp_get_ship_from_node(int node)
 	int sindex;
 	ship *shipp = NULL;
 
-	sindex = ship_name_lookup( CTEXT(node) );
+	sindex = sexp_ship_lookup(node);
 
 	if (sindex < 0) {
 		return shipp;
@@ -9461,7 +9465,7 @@ int sexp_is_ship_class(int n)
 	while (n != -1)
 	{
 		// get ship
-		ship_num = ship_name_lookup(CTEXT(n));
+		ship_num = sexp_ship_lookup(n);
 
 		// we can't do anything with ships that aren't present
 		if (ship_num < 0)
@@ -9494,7 +9498,7 @@ int sexp_is_ship_type(int n)
 	while (n != -1)
 	{
 		// get ship
-		ship_num = ship_name_lookup(CTEXT(n));
+		ship_num = sexp_ship_lookup(n);
 
 		// we can't do anything with ships that aren't present
 		if (ship_num < 0)
@@ -9596,7 +9600,7 @@ void sexp_change_ai_class(int n)
 
 	// find ship
 	n = CDR(n);
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_lookup(n);
 	n = CDR(n);
 
 	// we can't do anything with ships that aren't present
@@ -10581,7 +10585,7 @@ void sexp_set_explosion_option(int node)
 	shockwave_create_info *sci;
 
 	// get ship
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_lookup(n);
 	if (ship_num < 0)
 		return;
 
@@ -11136,7 +11140,7 @@ void sexp_self_destruct(int node)
 
 	for (n = node; n != -1; n = CDR(n))	{
 		// get the ship
-		ship_num = ship_name_lookup(CTEXT(n));
+		ship_num = sexp_ship_lookup(n);
 
 		// if it still exists, destroy it
 		if (ship_num >= 0) {
@@ -11569,7 +11573,7 @@ void sexp_destroy_subsys_instantly (int n)
 		return;
 	}
 
-	shipnum = ship_name_lookup(CTEXT(n));
+	shipnum = sexp_ship_lookup(n);
 	// if no ship, then return immediately.
 	if ( shipnum == -1 ){
 		return;
@@ -11948,7 +11952,7 @@ void sexp_jettison_cargo(int n)
 		for (; n != -1; n = CDR(n))
 		{
 			// make sure ship exists
-			ship_index = ship_name_lookup(CTEXT(n));
+			ship_index = sexp_ship_lookup(n);
 			if (ship_index < 0)
 				continue;
 
@@ -12452,7 +12456,7 @@ void sexp_change_player_score(int node)
 	node = CDR(node);
 
 	if(!(Game_mode & GM_MULTIPLAYER)){
-		if ( (sindex = ship_name_lookup(CTEXT(node))) == -1) {
+		if ( (sindex = sexp_ship_lookup(node)) == -1) {
 			Warning(LOCATION, "Invalid shipname '%s' passed to sexp_change_player_score!", CTEXT(node));
 			return;
 		}
@@ -13582,7 +13586,7 @@ void sexp_set_persona (int node)
 
 	// now loop through the list of ships
 	for ( ; node >= 0; node = CDR(node) ) {
-		sindex = ship_name_lookup( CTEXT(node) );
+		sindex = sexp_ship_lookup(node);
 
 		if (sindex < 0) {
 			continue;
@@ -14191,7 +14195,7 @@ void sexp_ships_visible(int n, bool visible)
 	// we also have to add any escort ships that were made visible
 	for (; n >= 0; n = CDR(n))
 	{
-		int shipnum = ship_name_lookup(CTEXT(n));
+		int shipnum = sexp_ship_lookup(n);
 		if (shipnum < 0)
 			continue;
 
@@ -14214,7 +14218,7 @@ void sexp_ships_stealthy(int n, bool stealthy)
 	{
 		for (; n >= 0; n = CDR(n))
 		{
-			int shipnum = ship_name_lookup(CTEXT(n));
+			int shipnum = sexp_ship_lookup(n);
 			if (shipnum < 0)
 				continue;
 
@@ -14234,7 +14238,7 @@ void sexp_friendly_stealth_invisible(int n, bool invisible)
 	{
 		for (; n >= 0; n = CDR(n))
 		{
-			int shipnum = ship_name_lookup(CTEXT(n));
+			int shipnum = sexp_ship_lookup(n);
 			if (shipnum < 0)
 				continue;
 
@@ -14297,7 +14301,7 @@ void sexp_ship_deal_with_subsystem_flag(int node, int ss_flag, bool sendit = fal
 		else
 		{
 			// get the subsystem
-			ss = ship_get_subsys(shipp, CTEXT(node));
+			ss = sexp_subsys_lookup(shipp, node);
 			if(ss == NULL)
 			{
 				node = CDR(node);
@@ -14372,7 +14376,7 @@ void sexp_ship_tag( int n, int tag )
 		return;
 
 	// get the ship num
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_lookup(n);
 	if ( ship_num < 0 )
 		return;
 
@@ -14645,7 +14649,7 @@ void sexp_weapon_create(int n)
 	parent_objnum = -1;
 	if (stricmp(CTEXT(n), SEXP_NONE_STRING))
 	{
-		int parent_ship = ship_name_lookup(CTEXT(n));
+		int parent_ship = sexp_ship_lookup(n);
 
 		if (parent_ship >= 0)
 			parent_objnum = Ships[parent_ship].objnum;
@@ -14697,7 +14701,7 @@ void sexp_weapon_create(int n)
 	target_objnum = -1;
 	if (n >= 0)
 	{
-		int target_ship = ship_name_lookup(CTEXT(n));
+		int target_ship = sexp_ship_lookup(n);
 
 		if (target_ship >= 0)
 			target_objnum = Ships[target_ship].objnum;
@@ -14709,7 +14713,7 @@ void sexp_weapon_create(int n)
 	if (n >= 0)
 	{
 		if (target_objnum >= 0)
-			targeted_ss = ship_get_subsys(&Ships[Objects[target_objnum].instance], CTEXT(n));
+			targeted_ss = sexp_subsys_lookup(&Ships[Objects[target_objnum].instance], n);
 
 		n = CDR(n);
 	}
@@ -15011,7 +15015,7 @@ void sexp_ship_change_callsign(int node)
 
 	while ( node >= 0 )
 	{
-		sindex = ship_name_lookup(CTEXT(node));
+		sindex = sexp_ship_lookup(node);
 		if (sindex >= 0) 
 		{
 			shipp = &Ships[sindex];
@@ -15162,7 +15166,7 @@ int sexp_targeted(int node)
 		return SEXP_CANT_EVAL;
 	}
 
-	z = ship_name_lookup(CTEXT(node), 1);
+	z = sexp_ship_lookup(node, 1);
 	if ((z < 0) || !Player_ai || (Ships[z].objnum != Player_ai->target_objnum)){
 		return SEXP_FALSE;
 	}
@@ -15257,7 +15261,7 @@ int sexp_primaries_depleted(int node)
 	ship *shipp;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0) {
 		return SEXP_FALSE;
 	}
@@ -15299,7 +15303,7 @@ int sexp_secondaries_depleted(int node)
 	ship *shipp;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0) {
 		return SEXP_FALSE;
 	}
@@ -15594,7 +15598,7 @@ int sexp_shield_recharge_pct(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -15611,7 +15615,7 @@ int sexp_engine_recharge_pct(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -15628,7 +15632,7 @@ int sexp_weapon_recharge_pct(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -15651,7 +15655,7 @@ int sexp_get_ets_value(int node)
 	ets_type = CTEXT(node);
 	node = CDR(node);
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0) {
 		return SEXP_FALSE;
 	}
@@ -15692,7 +15696,7 @@ void sexp_set_ets_values(int node)
 
 	// apply ETS settings to specified ships
 	for ( ; node != -1; node = CDR(node)) {
-		sindex = ship_name_lookup(CTEXT(node));
+		sindex = sexp_ship_lookup(node);
 
 		if (sindex >= 0 && validate_ship_ets_indxes(sindex, ets_idx)) {
 			Ships[sindex].engine_recharge_index = ets_idx[ENGINES];
@@ -15732,7 +15736,7 @@ int sexp_shield_quad_low(int node)
 	object *objp;
 
 	// get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return SEXP_FALSE;
 	}
@@ -15773,7 +15777,7 @@ int sexp_primary_ammo_pct(int node)
 	int ret = 0;
 
 	// get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0)
 	{
 		return 0;
@@ -15844,7 +15848,7 @@ int sexp_secondary_ammo_pct(int node)
 	int ret = 0;
 
 	// get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -15892,7 +15896,7 @@ int sexp_get_primary_ammo(int node)
 	int check;
 
 	// get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0)
 	{
 		return 0;
@@ -15946,7 +15950,7 @@ void sexp_set_primary_ammo (int node)
 	int rearm_limit = 0;
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0) 
 	{
 		return ;
@@ -16050,7 +16054,7 @@ int sexp_get_secondary_ammo (int node)
 	int check ;
 
 	// Get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0) 
 	{
 		return 0;
@@ -16094,7 +16098,7 @@ void sexp_set_secondary_ammo (int node)
 	int rearm_limit;
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0) 
 	{
 		return ;
@@ -16190,7 +16194,7 @@ void sexp_set_weapon (int node, bool primary)
 	Assert (node != -1);
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0) 
 	{
 		return ;
@@ -16364,7 +16368,7 @@ void sexp_change_subsystem_name(int node)
 	Assert (node != -1);
 
 	// Check that a ship has been supplied
-	ship_index = ship_name_lookup(CTEXT(node));
+	ship_index = sexp_ship_lookup(node);
 	if (ship_index < 0) {
 		return;
 	}
@@ -16389,7 +16393,7 @@ void sexp_change_subsystem_name(int node)
 	while (node >= 0) {
 
 		//Get the new subsystem name
-		subsystem_to_rename = ship_get_subsys(&Ships[ship_index], CTEXT(node));
+		subsystem_to_rename = sexp_subsys_lookup(&Ships[ship_index], node);
 		if (subsystem_to_rename != NULL) {
 			ship_subsys_set_name(subsystem_to_rename, new_name); 
 	
@@ -16439,7 +16443,7 @@ void sexp_change_ship_class(int n)
 	// all ships in the sexp
 	for ( ; n != -1; n = CDR(n))
 	{
-		ship_num = ship_name_lookup(CTEXT(n), 1);
+		ship_num = sexp_ship_lookup(n, 1);
 
 		// If the ship hasn't arrived we still want the ability to change its class.
 		if (ship_num == -1)
@@ -16624,7 +16628,7 @@ void sexp_ship_copy_damage(int node)
 	p_object *target_pobjp;
 
 	// source ship must be present
-	source_shipnum = ship_name_lookup(CTEXT(node));
+	source_shipnum = sexp_ship_lookup(node);
 	if (source_shipnum < 0)
 		return;
 
@@ -16632,7 +16636,7 @@ void sexp_ship_copy_damage(int node)
 	for (n = CDR(node); n != -1; n = CDR(n))
 	{
 		// maybe it's present in-mission
-		target_shipnum = ship_name_lookup(CTEXT(n));
+		target_shipnum = sexp_ship_lookup(n);
 		if (target_shipnum >= 0)
 		{
 			ship_copy_damage(&Ships[target_shipnum], &Ships[source_shipnum]);
@@ -16660,7 +16664,7 @@ void sexp_activate_deactivate_glow_points(int n, bool activate)
 
 	for ( ; n != -1; n = CDR(n))
 	{
-		sindex = ship_name_lookup(CTEXT(n), 1);
+		sindex = sexp_ship_lookup(n, 1);
 		if (sindex >= 0)
 		{
 			for (i = 0; i < Ships[sindex].glow_point_bank_active.size(); i++)
@@ -16674,7 +16678,7 @@ void sexp_activate_deactivate_glow_point_bank(int n, bool activate)
 {
 	int sindex, num;
 
-	sindex = ship_name_lookup(CTEXT(n), 1);
+	sindex = sexp_ship_lookup(n, 1);
 	if (sindex >= 0)
 	{
 		for ( n = CDR(n); n != -1; n = CDR(n))
@@ -16696,7 +16700,7 @@ void sexp_activate_deactivate_glow_maps(int n, int activate)
 
 	for ( ; n != -1; n = CDR(n))
 	{
-		sindex = ship_name_lookup(CTEXT(n), 1);
+		sindex = sexp_ship_lookup(n, 1);
 		if (sindex >= 0)
 		{
 			shipp = &Ships[sindex];
@@ -16876,7 +16880,7 @@ void sexp_beam_fire(int node, bool at_coords)
 	fire_info.accuracy = 0.000001f;							// this will guarantee a hit
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(n));
+	sindex = sexp_ship_lookup(n);
 	n = CDR(n);
 	if (sindex < 0) {
 		return;
@@ -16887,7 +16891,7 @@ void sexp_beam_fire(int node, bool at_coords)
 	fire_info.shooter = &Objects[Ships[sindex].objnum];
 
 	// get the subsystem
-	fire_info.turret = ship_get_subsys(&Ships[sindex], CTEXT(n));
+	fire_info.turret = sexp_subsys_lookup(&Ships[sindex], n);
 	n = CDR(n);
 	if (fire_info.turret == NULL) {
 		return;
@@ -16906,7 +16910,7 @@ void sexp_beam_fire(int node, bool at_coords)
 		fire_info.target_subsys = NULL;
 	} else {
 		// get the target
-		sindex = ship_name_lookup(CTEXT(n));
+		sindex = sexp_ship_lookup(n);
 		n = CDR(n);
 		if (sindex < 0) {
 			return;
@@ -16919,7 +16923,7 @@ void sexp_beam_fire(int node, bool at_coords)
 		// see if the optional subsystem can be found	
 		fire_info.target_subsys = NULL;
 		if (n >= 0) {
-			fire_info.target_subsys = ship_get_subsys(&Ships[sindex], CTEXT(n));
+			fire_info.target_subsys = sexp_subsys_lookup(&Ships[sindex], n);
 			n = CDR(n);
 		}
 	}
@@ -17003,7 +17007,7 @@ void sexp_beam_floating_fire(int n)
 	fire_info.shooter = NULL;
 	if (stricmp(CTEXT(n), SEXP_NONE_STRING))
 	{
-		sindex = ship_name_lookup(CTEXT(n));
+		sindex = sexp_ship_lookup(n);
 
 		if (sindex >= 0)
 			fire_info.shooter = &Objects[Ships[sindex].objnum];
@@ -17026,7 +17030,7 @@ void sexp_beam_floating_fire(int n)
 	sindex = -1;
 	if (stricmp(CTEXT(n), SEXP_NONE_STRING))
 	{
-		sindex = ship_name_lookup(CTEXT(n));
+		sindex = sexp_ship_lookup(n);
 
 		if (sindex >= 0)
 			fire_info.target = &Objects[Ships[sindex].objnum];
@@ -17039,7 +17043,7 @@ void sexp_beam_floating_fire(int n)
 	{
 		if (stricmp(CTEXT(n), SEXP_NONE_STRING)) {
 			if (sindex >= 0)
-				fire_info.target_subsys = ship_get_subsys(&Ships[sindex], CTEXT(n));
+				fire_info.target_subsys = sexp_subsys_lookup(&Ships[sindex], n);
 		}
 
 		n = CDR(n);
@@ -17080,7 +17084,7 @@ void sexp_beam_free(int node)
 	ship_subsys *turret = NULL;	
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17091,7 +17095,7 @@ void sexp_beam_free(int node)
 	node = CDR(node);
 	for ( ; node >= 0; node = CDR(node) ) {
 		// get the subsystem
-		turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+		turret = sexp_subsys_lookup(&Ships[sindex], node);
 		if(turret == NULL){
 			continue;
 		}
@@ -17111,7 +17115,7 @@ void sexp_set_thrusters(int node)
 	node = CDR(node);
 
 	for(; node >= 0; node = CDR(node)) {
-		int sindex = ship_name_lookup(CTEXT(node));
+		int sindex = sexp_ship_lookup(node);
 		
 		if (sindex < 0) {
 			continue;
@@ -17135,7 +17139,7 @@ void sexp_beam_free_all(int node)
 
 	for (int n = node; n >= 0; n = CDR(n)) {
 		// get the firing ship
-		sindex = ship_name_lookup( CTEXT(n) );
+		sindex = sexp_ship_lookup(n);
 
 		if (sindex < 0) {
 			continue;
@@ -17168,7 +17172,7 @@ void sexp_beam_lock(int node)
 	ship_subsys *turret = NULL;	
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17179,7 +17183,7 @@ void sexp_beam_lock(int node)
 	node = CDR(node);
 	for ( ; node >= 0; node = CDR(node) ) {
 		// get the subsystem
-		turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+		turret = sexp_subsys_lookup(&Ships[sindex], node);
 		if(turret == NULL){
 			continue;
 		}
@@ -17196,7 +17200,7 @@ void sexp_beam_lock_all(int node)
 
 	for (int n = node; n >= 0; n = CDR(n)) {
 		// get the firing ship
-		sindex = ship_name_lookup( CTEXT(n) );
+		sindex = sexp_ship_lookup(n);
 
 		if (sindex < 0) {
 			continue;
@@ -17227,7 +17231,7 @@ void sexp_turret_free(int node)
 	ship_subsys *turret = NULL;	
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17238,7 +17242,7 @@ void sexp_turret_free(int node)
 	node = CDR(node);
 	for ( ; node >= 0; node = CDR(node) ) {
 		// get the subsystem
-		turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+		turret = sexp_subsys_lookup(&Ships[sindex], node);
 		if(turret == NULL){
 			continue;
 		}
@@ -17259,7 +17263,7 @@ void sexp_turret_free_all(int node)
 
 	for (int n = node; n >= 0; n = CDR(n)) {
 		// get the firing ship
-		sindex = ship_name_lookup( CTEXT(n) );
+		sindex = sexp_ship_lookup(n);
 
 		if (sindex < 0) {
 			continue;
@@ -17291,7 +17295,7 @@ void sexp_turret_lock(int node)
 	ship_subsys *turret = NULL;	
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17302,7 +17306,7 @@ void sexp_turret_lock(int node)
 	node = CDR(node);
 	for ( ; node >= 0; node = CDR(node) ) {
 		// get the subsystem
-		turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+		turret = sexp_subsys_lookup(&Ships[sindex], node);
 		if(turret == NULL){
 			continue;
 		}
@@ -17319,7 +17323,7 @@ void sexp_turret_lock_all(int node)
 
 	for (int n = node; n >= 0; n = CDR(n)) {
 		// get the firing ship
-		sindex = ship_name_lookup( CTEXT(n) );
+		sindex = sexp_ship_lookup(n);
 
 		if (sindex < 0) {
 			continue;
@@ -17350,7 +17354,7 @@ void sexp_turret_tagged_only_all(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17377,7 +17381,7 @@ void sexp_turret_tagged_clear_all(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17406,14 +17410,14 @@ void sexp_turret_change_weapon(int node)
 	ship_weapon *swp = NULL;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0 || Ships[sindex].objnum < 0){
 		return;
 	}
 
 	//Get subsystem
 	node = CDR(node);
-	turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+	turret = sexp_subsys_lookup(&Ships[sindex], node);
 	if(turret == NULL){
 		return;
 	}
@@ -17496,7 +17500,7 @@ void sexp_set_armor_type(int node)
 	ship_info *sip = NULL;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0) {
 		return;
 	}
@@ -17540,7 +17544,7 @@ void sexp_set_armor_type(int node)
 		else 
 		{
 			// get the subsystem
-			ss = ship_get_subsys(&Ships[sindex], CTEXT(node));
+			ss = sexp_subsys_lookup(&Ships[sindex], node);
 			if(ss == NULL){
 				node = CDR(node);
 				continue;
@@ -17644,7 +17648,7 @@ void sexp_ship_set_damage_type(int node)
 	while(node != -1)
 	{
 		// get the ship
-		sindex = ship_name_lookup(CTEXT(node));
+		sindex = sexp_ship_lookup(node);
 		if(sindex >= 0) 
 		{
 			shipp = &Ships[sindex];
@@ -17750,7 +17754,7 @@ void sexp_turret_set_target_order(int node)
 	int i;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17760,7 +17764,7 @@ void sexp_turret_set_target_order(int node)
 
 	//Get turret subsys
 	node = CDR(node);
-	turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+	turret = sexp_subsys_lookup(&Ships[sindex], node);
 	if(turret == NULL){
 		return;
 	}
@@ -17794,7 +17798,7 @@ void sexp_turret_set_direction_preference(int node)
 	ship_subsys *turret = NULL;	
 	
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17810,7 +17814,7 @@ void sexp_turret_set_direction_preference(int node)
 	//Set range
 	while(node != -1){
 		// get the subsystem
-		turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+		turret = sexp_subsys_lookup(&Ships[sindex], node);
 		if(turret == NULL){
 			node = CDR(node);
 			continue;
@@ -17838,7 +17842,7 @@ void sexp_turret_set_rate_of_fire(int node)
 	ship_subsys *turret = NULL;	
 	
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17854,7 +17858,7 @@ void sexp_turret_set_rate_of_fire(int node)
 	//Set rof
 	while(node != -1){
 		// get the subsystem
-		turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+		turret = sexp_subsys_lookup(&Ships[sindex], node);
 		if(turret == NULL){
 			node = CDR(node);
 			continue;
@@ -17877,7 +17881,7 @@ void sexp_turret_set_optimum_range(int node)
 	ship_subsys *turret = NULL;	
 	
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17893,7 +17897,7 @@ void sexp_turret_set_optimum_range(int node)
 	//Set range
 	while(node != -1){
 		// get the subsystem
-		turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+		turret = sexp_subsys_lookup(&Ships[sindex], node);
 		if(turret == NULL){
 			node = CDR(node);
 			continue;
@@ -17918,7 +17922,7 @@ void sexp_turret_set_target_priorities(int node)
 	int j;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17928,7 +17932,7 @@ void sexp_turret_set_target_priorities(int node)
 
 	//Get turret subsys
 	node = CDR(node);
-	turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+	turret = sexp_subsys_lookup(&Ships[sindex], node);
 	if(turret == NULL){
 		return;
 	}
@@ -17974,7 +17978,7 @@ void sexp_ship_turret_target_order(int node)
 	int new_target_order[NUM_TURRET_ORDER_TYPES];
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18023,7 +18027,7 @@ int sexp_get_turret_primary_ammo(int node)
 	ship_weapon *swp;
 	int bank, check, ammo_left = 0;
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0) {
 		return 0;
 	}
@@ -18033,7 +18037,7 @@ int sexp_get_turret_primary_ammo(int node)
 
 	node = CDR(node);
 
-	turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+	turret = sexp_subsys_lookup(&Ships[sindex], node);
 	if (turret == NULL) {
 		return 0;
 	}
@@ -18080,7 +18084,7 @@ void sexp_set_turret_primary_ammo(int node)
 	int requested_weapons;
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0)
 	{
 		return;
@@ -18178,7 +18182,7 @@ int sexp_get_turret_secondary_ammo(int node)
 	ship_weapon *swp;
 	int bank, check, ammo_left = 0;
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0) {
 		return 0;
 	}
@@ -18188,7 +18192,7 @@ int sexp_get_turret_secondary_ammo(int node)
 
 	node = CDR(node);
 
-	turret = ship_get_subsys(&Ships[sindex], CTEXT(node));
+	turret = sexp_subsys_lookup(&Ships[sindex], node);
 	if (turret == NULL) {
 		return 0;
 	}
@@ -18227,7 +18231,7 @@ void sexp_set_turret_secondary_ammo(int node)
 	int requested_weapons;
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if (sindex < 0)
 	{
 		return;
@@ -18320,7 +18324,7 @@ void sexp_set_subsys_rotation_lock_free(int node, int locked)
 	ship_subsys *rotate;
 
 	// get the ship
-	ship_num = ship_name_lookup(CTEXT(node));
+	ship_num = sexp_ship_lookup(node);
 	if (ship_num < 0)
 		return;
 	
@@ -18333,7 +18337,7 @@ void sexp_set_subsys_rotation_lock_free(int node, int locked)
 	for ( ; node >= 0; node = CDR(node) )
 	{
 		// get the rotating subsystem
-		rotate = ship_get_subsys(&Ships[ship_num], CTEXT(node));
+		rotate = sexp_subsys_lookup(&Ships[ship_num], node);
 		if (rotate == NULL)
 			continue;
 
@@ -18366,7 +18370,7 @@ void sexp_reverse_rotating_subsystem(int node)
 	ship_subsys *rotate;
 
 	// get the ship
-	ship_num = ship_name_lookup(CTEXT(node));
+	ship_num = sexp_ship_lookup(node);
 	if (ship_num < 0)
 		return;
 	
@@ -18379,7 +18383,7 @@ void sexp_reverse_rotating_subsystem(int node)
 	for ( ; node >= 0; node = CDR(node) )
 	{
 		// get the rotating subsystem
-		rotate = ship_get_subsys(&Ships[ship_num], CTEXT(node));
+		rotate = sexp_subsys_lookup(&Ships[ship_num], node);
 		if (rotate == NULL)
 			continue;
 
@@ -18398,7 +18402,7 @@ void sexp_rotating_subsys_set_turn_time(int node)
 	ship_subsys *rotate;
 
 	// get the ship
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_lookup(n);
 	if (ship_num < 0)
 		return;
 	if (Ships[ship_num].objnum < 0)
@@ -18406,7 +18410,7 @@ void sexp_rotating_subsys_set_turn_time(int node)
 	n = CDR(n);
 
 	// get the rotating subsystem
-	rotate = ship_get_subsys(&Ships[ship_num], CTEXT(n));
+	rotate = sexp_subsys_lookup(&Ships[ship_num], n);
 	if (rotate == NULL)
 		return;
 	n = CDR(n);
@@ -18432,7 +18436,7 @@ void sexp_trigger_submodel_animation(int node)
 	bool instant;
 
 	// get the ship
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_lookup(n);
 	if (ship_num < 0)
 		return;
 	if (Ships[ship_num].objnum < 0)
@@ -18473,7 +18477,7 @@ void sexp_trigger_submodel_animation(int node)
 	// do we narrow it to a specific subsystem?
 	if (n >= 0)
 	{
-		ship_subsys *ss = ship_get_subsys(&Ships[ship_num], CTEXT(n));
+		ship_subsys *ss = sexp_subsys_lookup(&Ships[ship_num], n);
 		if (ss == NULL)
 		{
 			Warning(LOCATION, "Subsystem \"%s\" not found on ship \"%s\"!", CTEXT(n), CTEXT(node));
@@ -18493,7 +18497,7 @@ void sexp_turret_tagged_specific(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18504,7 +18508,7 @@ void sexp_turret_tagged_specific(int node)
 	node = CDR(node);
 	for ( ; node >= 0; node = CDR(node) ) {
 		// get the subsystem
-		subsys = ship_get_subsys(&Ships[sindex], CTEXT(node));
+		subsys = sexp_subsys_lookup(&Ships[sindex], node);
 		if(subsys == NULL){
 			continue;
 		}
@@ -18520,7 +18524,7 @@ void sexp_turret_tagged_clear_specific(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18531,7 +18535,7 @@ void sexp_turret_tagged_clear_specific(int node)
 	node = CDR(node);
 	for ( ; node >= 0; node = CDR(node) ) {
 		// get the subsystem
-		subsys = ship_get_subsys(&Ships[sindex], CTEXT(node));
+		subsys = sexp_subsys_lookup(&Ships[sindex], node);
 		if(subsys == NULL){
 			continue;
 		}
@@ -18547,7 +18551,7 @@ void sexp_add_remove_escort(int node)
 	int flag;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18618,7 +18622,7 @@ void sexp_damage_escort_list(int node)
 		if ( mission_log_get_time(LOG_SHIP_DEPARTED, CTEXT(n), NULL, NULL) || mission_log_get_time(LOG_SHIP_DESTROYED, CTEXT(n), NULL, NULL) || mission_log_get_time(LOG_SELF_DESTRUCTED, CTEXT(n), NULL, NULL) )
 			continue;
 
-		shipnum=ship_name_lookup(CTEXT(n));
+		shipnum=sexp_ship_lookup(n);
 		
 		//it may be dead
 		if (shipnum < 0)
@@ -19077,7 +19081,7 @@ void sexp_awacs_set_radius(int node)
 	ship_subsys *awacs;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -19086,7 +19090,7 @@ void sexp_awacs_set_radius(int node)
 	}	
 
 	// get the awacs subsystem
-	awacs = ship_get_subsys(&Ships[sindex], CTEXT(CDR(node)));
+	awacs = sexp_subsys_lookup(&Ships[sindex], CDR(node));
 	if(awacs == NULL){
 		return;
 	}
@@ -19551,7 +19555,7 @@ int sexp_is_tagged(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return SEXP_FALSE;
 	}
@@ -19623,7 +19627,7 @@ int sexp_is_player (int node)
 	int standard_check = is_sexp_true(node);
 
 	if (!(Game_mode & GM_MULTIPLAYER)){	
-		sindex = ship_name_lookup(CTEXT(CDR(node)));
+		sindex = sexp_ship_lookup(CDR(node));
 
 		// There can only be one player ship in singleplayer so if more than one ship is specifed the sexp is false
 		if (CDDR(node) < 0 ) {
@@ -19650,7 +19654,7 @@ int sexp_is_player (int node)
 			// reset the netplayer index
 			np_index = -1; 
 
-			sindex = ship_name_lookup(CTEXT(node));
+			sindex = sexp_ship_lookup(node);
 			if(sindex >= 0){
 				if(Ships[sindex].objnum >= 0) {
 					// try and find the player
@@ -19782,7 +19786,7 @@ int sexp_return_player_data(int node, int type)
 	player *p = NULL;
 	p_object *p_objp;
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 
 	if(Game_mode & GM_MULTIPLAYER){			
 		if(sindex >= 0){
@@ -19883,7 +19887,7 @@ int sexp_num_type_kills(int node)
 	player *p = NULL;
 
 	// get the ship we're interested in
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -19938,7 +19942,7 @@ int sexp_num_class_kills(int node)
 	player *p = NULL;
 
 	// get the ship we're interested in
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -19986,7 +19990,7 @@ void sexp_subsys_set_random(int node)
 	ship *shipp;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -20061,7 +20065,7 @@ int sexp_is_secondary_selected(int node)
 	ship *shipp;
 
 	// lookup ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return SEXP_FALSE;
 	}
@@ -20092,7 +20096,7 @@ int sexp_is_primary_selected(int node)
 	ship *shipp;
 
 	// lookup ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 	if(sindex < 0){
 		return SEXP_FALSE;
 	}
@@ -22239,7 +22243,7 @@ void sexp_script_eval_multi(int node)
 				}
 				// otherwise notify the clients
 				else {
-					sindex = ship_name_lookup(CTEXT(node));
+					sindex = sexp_ship_lookup(node);
 					multi_send_ship(sindex);
 				}
 			}
@@ -22294,7 +22298,7 @@ void sexp_force_glide(int node)
 	int sindex;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_lookup(node);
 
 	if (sindex < 0) {
 		return;
@@ -22370,7 +22374,7 @@ int sexp_is_in_box(int n)
 	object* reference_ship_obj = NULL;
 	if (n != -1)
 	{
-		int sindex = ship_name_lookup(CTEXT(n));
+		int sindex = sexp_ship_lookup(n);
 
 		if (sindex < 0 || Ships[sindex].objnum < 0)
 			return SEXP_FALSE;
@@ -22402,7 +22406,7 @@ int sexp_is_in_box(int n)
 int sexp_is_in_mission(int node)
 {
 	for (int n = node; n != -1; n = CDR(n))
-		if (ship_name_lookup(CTEXT(n)) < 0)
+		if (sexp_ship_lookup(n) < 0)
 			return SEXP_FALSE;
 
 	return SEXP_TRUE;
@@ -22603,7 +22607,7 @@ void sexp_call_ssm_strike(int node) {
 		return;
 
 	for (int n = node; n != -1; n = CDR(n)) {
-		int ship_num = ship_name_lookup(CTEXT(n));
+		int ship_num = sexp_ship_lookup(n);
 		// don't do anything if the ship isn't there
 		if (ship_num >= 0) {
 			int obj_num = Ships[ship_num].objnum;
@@ -22661,6 +22665,187 @@ bool ship_class_unchanged(int ship_index)
 	return false;
 }
 
+/**
+ * Whether a delay argument is a literal zero, in which case the delayed status operators
+ * don't depend on the mission time at all
+ */
+static bool sexp_dependency_literal_zero(int node)
+{
+	if (node < 0)
+		return false;
+
+	if ((SEXP_NODE_TYPE(node) != SEXP_ATOM) || (Sexp_nodes[node].subtype != SEXP_ATOM_NUMBER) || (Sexp_nodes[node].type & SEXP_FLAG_VARIABLE))
+		return false;
+
+	return atoi(Sexp_nodes[node].text) == 0;
+}
+
+/**
+ * The SEXP_DEP_* state read by a plain number or string argument
+ */
+static int sexp_dependency_atom(int node)
+{
+	if (Sexp_nodes[node].type & SEXP_FLAG_VARIABLE)
+		return SEXP_DEP_VARIABLES;
+
+	// the special argument is different for every pass of a when-argument
+	if (!strcmp(Sexp_nodes[node].text, SEXP_ARGUMENT_STRING))
+		return SEXP_DEP_UNTRACKED;
+
+	return 0;
+}
+
+/**
+ * The SEXP_DEP_* state read by the name arguments of a status operator
+ */
+static int sexp_dependency_args(int node)
+{
+	int deps = 0;
+
+	for ( ; node != -1; node = CDR(node))
+	{
+		if (Sexp_nodes[node].first != -1)
+			return SEXP_DEP_UNTRACKED;
+
+		deps |= sexp_dependency_atom(node);
+	}
+
+	return deps;
+}
+
+static int sexp_dependency_tree(int node)
+{
+	int op_num, deps, n;
+
+	if (node == -1)
+		return 0;
+
+	// a list just wraps its operator
+	if (Sexp_nodes[node].first != -1)
+		return sexp_dependency_tree(CAR(node));
+
+	if (Sexp_nodes[node].subtype != SEXP_ATOM_OPERATOR)
+		return sexp_dependency_atom(node);
+
+	op_num = get_operator_const(node);
+	n = CDR(node);
+
+	switch (op_num)
+	{
+		// pure functions of their arguments
+		case OP_TRUE:
+		case OP_FALSE:
+		case OP_AND:
+		case OP_OR:
+		case OP_NOT:
+		case OP_XOR:
+		case OP_EQUALS:
+		case OP_NOT_EQUAL:
+		case OP_GREATER_THAN:
+		case OP_LESS_THAN:
+		case OP_GREATER_OR_EQUAL:
+		case OP_LESS_OR_EQUAL:
+		case OP_STRING_EQUALS:
+		case OP_STRING_GREATER_THAN:
+		case OP_STRING_LESS_THAN:
+		case OP_PLUS:
+		case OP_MINUS:
+		case OP_MUL:
+		case OP_DIV:
+		case OP_MOD:
+		case OP_ABS:
+		case OP_MIN:
+		case OP_MAX:
+			deps = 0;
+			for ( ; n != -1; n = CDR(n))
+			{
+				deps |= sexp_dependency_tree(n);
+				if (deps & SEXP_DEP_UNTRACKED)
+					break;
+			}
+			return deps;
+
+		// these only look at the mission log and at which ships and wings are present
+		case OP_IS_DESTROYED:
+		case OP_HAS_ARRIVED:
+		case OP_HAS_DEPARTED:
+		case OP_IS_DISABLED:
+		case OP_IS_DISARMED:
+		case OP_IS_SUBSYSTEM_DESTROYED:
+		case OP_GOAL_INCOMPLETE:
+			return SEXP_DEP_MISSION_LOG | SEXP_DEP_SHIPS | sexp_dependency_args(n);
+
+		// ...and so do their delayed versions, as long as there isn't a delay to wait out
+		case OP_IS_DESTROYED_DELAY:
+		case OP_HAS_ARRIVED_DELAY:
+		case OP_HAS_DEPARTED_DELAY:
+		case OP_IS_DISABLED_DELAY:
+		case OP_IS_DISARMED_DELAY:
+			if (!sexp_dependency_literal_zero(n))
+				return SEXP_DEP_UNTRACKED;
+			return SEXP_DEP_MISSION_LOG | SEXP_DEP_SHIPS | sexp_dependency_args(CDR(n));
+
+		case OP_IS_SUBSYSTEM_DESTROYED_DELAY:
+			if (!sexp_dependency_literal_zero(CDDR(n)))
+				return SEXP_DEP_UNTRACKED;
+			return SEXP_DEP_MISSION_LOG | SEXP_DEP_SHIPS | sexp_dependency_args(n);
+
+		case OP_GOAL_TRUE_DELAY:
+		case OP_GOAL_FALSE_DELAY:
+			if (!sexp_dependency_literal_zero(CDR(n)))
+				return SEXP_DEP_UNTRACKED;
+			return SEXP_DEP_MISSION_LOG | sexp_dependency_args(n);
+
+		// anything else might read the clock, object positions, random numbers, etc.
+		default:
+			return SEXP_DEP_UNTRACKED;
+	}
+}
+
+/**
+ * Work out which game state an event or goal formula reads, as SEXP_DEP_* flags.
+ *
+ * If the formula evaluated false and none of that state has changed since, evaluating it
+ * again is guaranteed to give false again.  Formulas built from operators that aren't known
+ * to be side-effect free (or that read things like the mission time or object positions)
+ * return SEXP_DEP_UNTRACKED and must always be evaluated.
+ */
+int sexp_query_dependencies(int node)
+{
+	if (node < 0)
+		return SEXP_DEP_UNTRACKED;
+
+	while (Sexp_nodes[node].first != -1)
+		node = CAR(node);
+
+	// when only performs its actions once its condition is true, and then the event is true
+	// and gets evaluated again anyway, so only the condition matters
+	if ((Sexp_nodes[node].subtype == SEXP_ATOM_OPERATOR) && (get_operator_const(node) == OP_WHEN))
+		return sexp_dependency_tree(CDR(node));
+
+	return sexp_dependency_tree(node);
+}
+
+/**
+ * A value that changes whenever any of the given SEXP_DEP_* state changes
+ */
+int sexp_dependency_stamp(int dependencies)
+{
+	int stamp = 0;
+
+	Assert(!(dependencies & SEXP_DEP_UNTRACKED));
+
+	// every counter only ever goes up, so their sum changes whenever one of them does
+	if (dependencies & SEXP_DEP_MISSION_LOG)
+		stamp += Mission_log_generation;
+	if (dependencies & SEXP_DEP_SHIPS)
+		stamp += Ship_lookup_generation;
+	if (dependencies & SEXP_DEP_VARIABLES)
+		stamp += Sexp_variable_generation;
+
+	return stamp;
+}
+
 // Goober5000 - needed because any nonzero integer value is "true"
 int is_sexp_true(int cur_node, int referenced_node)
 {
@@ -28896,6 +29081,173 @@ char *CTEXT(int n)
 }
 
 
+/**
+ * Whether the name in this node can be resolved once and remembered.  Variables and the
+ * special argument can stand for a different name every time they are evaluated, and
+ * FRED renames things out from under the sexps, so those always get looked up by name.
+ */
+static bool sexp_node_handle_cacheable(int node)
+{
+	if (Fred_running)
+		return false;
+
+	if (Sexp_nodes[node].handle_type == SEXP_HANDLE_NEVER)
+		return false;
+
+	if ((Sexp_nodes[node].type & SEXP_FLAG_VARIABLE) || !strcmp(Sexp_nodes[node].text, SEXP_ARGUMENT_STRING))
+	{
+		Sexp_nodes[node].handle_type = SEXP_HANDLE_NEVER;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Same as ship_name_lookup(CTEXT(node), inc_players), but remembers the result in the node.
+ *
+ * A found ship stays valid for as long as its object does; a failed lookup stays valid until
+ * a ship is created, renamed or deleted, all of which bump Ship_lookup_generation.
+ */
+int sexp_ship_lookup(int node, int inc_players)
+{
+	sexp_node *snp;
+	int handle_type = inc_players ? SEXP_HANDLE_SHIP_OR_PLAYER_START : SEXP_HANDLE_SHIP;
+	int shipnum;
+
+	Assertion(node >= 0 && node < Num_sexp_nodes, "Passed an out-of-range node index (%d) to sexp_ship_lookup!", node);
+
+	if (!sexp_node_handle_cacheable(node))
+		return ship_name_lookup(CTEXT(node), inc_players);
+
+	snp = &Sexp_nodes[node];
+
+	if ((snp->handle_type == handle_type) && (snp->handle_generation == Ship_lookup_generation))
+	{
+		if (snp->handle_index < 0)
+			return -1;
+
+		shipnum = snp->handle_index;
+		if ((Ships[shipnum].objnum >= 0) && (Objects[Ships[shipnum].objnum].signature == snp->handle_signature))
+			return shipnum;
+	}
+
+	shipnum = ship_name_lookup(snp->text, inc_players);
+
+	snp->handle_type = handle_type;
+	snp->handle_index = shipnum;
+	snp->handle_signature = (shipnum >= 0) ? Objects[Ships[shipnum].objnum].signature : 0;
+	snp->handle_generation = Ship_lookup_generation;
+	snp->handle_subsys = NULL;
+
+	return shipnum;
+}
+
+/**
+ * Same as wing_name_lookup(CTEXT(node), ignore_count), but remembers the result in the node.
+ */
+int sexp_wing_lookup(int node, int ignore_count)
+{
+	sexp_node *snp;
+	int handle_type = ignore_count ? SEXP_HANDLE_WING_IGNORE_COUNT : SEXP_HANDLE_WING;
+	int wingnum;
+
+	Assertion(node >= 0 && node < Num_sexp_nodes, "Passed an out-of-range node index (%d) to sexp_wing_lookup!", node);
+
+	if (!sexp_node_handle_cacheable(node))
+		return wing_name_lookup(CTEXT(node), ignore_count);
+
+	snp = &Sexp_nodes[node];
+
+	// a wing's ship count changes whenever one of its ships is created or deleted, so the
+	// generation check also covers a wing emptying out or a new wave arriving
+	if ((snp->handle_type == handle_type) && (snp->handle_generation == Ship_lookup_generation))
+	{
+		if (snp->handle_index < 0)
+			return -1;
+
+		wingnum = snp->handle_index;
+		if (ignore_count ? Wings[wingnum].wave_count : Wings[wingnum].current_count)
+			return wingnum;
+	}
+
+	wingnum = wing_name_lookup(snp->text, ignore_count);
+
+	snp->handle_type = handle_type;
+	snp->handle_index = wingnum;
+	snp->handle_signature = 0;
+	snp->handle_generation = Ship_lookup_generation;
+	snp->handle_subsys = NULL;
+
+	return wingnum;
+}
+
+/**
+ * Same as ship_get_subsys(shipp, CTEXT(node)), but remembers the result in the node.
+ */
+ship_subsys *sexp_subsys_lookup(ship *shipp, int node)
+{
+	sexp_node *snp;
+	ship_subsys *ss;
+	int shipnum;
+
+	Assertion(node >= 0 && node < Num_sexp_nodes, "Passed an out-of-range node index (%d) to sexp_subsys_lookup!", node);
+	Assert(shipp != NULL);
+
+	if ((shipp->objnum < 0) || !sexp_node_handle_cacheable(node))
+		return ship_get_subsys(shipp, CTEXT(node));
+
+	snp = &Sexp_nodes[node];
+	shipnum = SHIP_INDEX(shipp);
+
+	// subsystem lists are only ever rebuilt through ship_subsystems_delete, which bumps the generation
+	if ((snp->handle_type == SEXP_HANDLE_SUBSYS) && (snp->handle_generation == Ship_lookup_generation)
+		&& (snp->handle_index == shipnum) && (snp->handle_signature == Objects[shipp->objnum].signature))
+	{
+		return snp->handle_subsys;
+	}
+
+	ss = ship_get_subsys(shipp, snp->text);
+
+	snp->handle_type = SEXP_HANDLE_SUBSYS;
+	snp->handle_index = shipnum;
+	snp->handle_signature = Objects[shipp->objnum].signature;
+	snp->handle_generation = Ship_lookup_generation;
+	snp->handle_subsys = ss;
+
+	return ss;
+}
+
+/**
+ * Resolve the ship and wing names in every loaded sexp up front, so the first evaluation
+ * of each event doesn't pay for the name searches.  Variables and special arguments are
+ * marked so they are never cached.
+ */
+void sexp_resolve_handles()
+{
+	int i, resolved = 0;
+
+	if (Fred_running)
+		return;
+
+	for (i = 0; i < Num_sexp_nodes; i++)
+	{
+		if (Sexp_nodes[i].type == SEXP_NOT_USED)
+			continue;
+		if (SEXP_NODE_TYPE(i) != SEXP_ATOM || Sexp_nodes[i].subtype != SEXP_ATOM_STRING)
+			continue;
+		if (!sexp_node_handle_cacheable(i))
+			continue;
+
+		if (sexp_ship_lookup(i) >= 0)
+			resolved++;
+		else if (sexp_wing_lookup(i) >= 0)
+			resolved++;
+	}
+
+	nprintf(("SEXP", "Resolved %d sexp ship and wing names at mission load\n", resolved));
+}
+
 /**
  * Set all Sexp_variables to type uninitialized
  */
@@ -28905,6 +29257,8 @@ void init_sexp_vars()
 		Sexp_variables[i].type = SEXP_VARIABLE_NOT_USED;
 		Block_variables[i].type = SEXP_VARIABLE_NOT_USED;
 	}
+
+	Sexp_variable_generation++;
 }
 
 /**
@@ -28945,6 +29299,7 @@ int sexp_add_variable(const char *text, const char *var_name, int type, int inde
 		strcpy_s(Sexp_variables[index].variable_name, var_name);
 		Sexp_variables[index].type &= ~SEXP_VARIABLE_NOT_USED;
 		Sexp_variables[index].type = (type | SEXP_VARIABLE_SET);
+		Sexp_variable_generation++;
 	}
 
 	return index;
@@ -28957,6 +29312,7 @@ void sexp_add_array_block_variable(int index, bool is_numeric)
 
 	strcpy_s(Sexp_variables[index].text, "");
 	strcpy_s(Sexp_variables[index].variable_name, "variable array block");
+	Sexp_variable_generation++;
 
 	if (is_numeric)
 		Sexp_variables[index].type = SEXP_VARIABLE_NUMBER | SEXP_VARIABLE_SET;
@@ -28991,6 +29347,7 @@ void sexp_modify_variable(char *text, int index, bool sexp_callback)
 		strcpy_s(Sexp_variables[index].text, text);
 	}
 	Sexp_variables[index].type |= SEXP_VARIABLE_MODIFIED;
+	Sexp_variable_generation++;
 
 	// do multi_callback_here
 	// if we're called from the sexp code send a SEXP packet (more efficient) 
@@ -29026,6 +29383,7 @@ void multi_sexp_modify_variable()
 		}
 
 		strcpy_s(Sexp_variables[variable_index].text, value);
+		Sexp_variable_generation++;
 	}	
 }
 
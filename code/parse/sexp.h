@@ -823,6 +823,22 @@ class waypoint_list;
 // #define CTEXT(n)	(Sexp_nodes[n].text)
 char *CTEXT(int n);
 
+// Same as ship_name_lookup(), wing_name_lookup() and ship_get_subsys() on CTEXT(node), but the result is
+// remembered in the node until ships are created, renamed or deleted
+int sexp_ship_lookup(int node, int inc_players = 0);
+int sexp_wing_lookup(int node, int ignore_count = 0);
+ship_subsys *sexp_subsys_lookup(ship *shipp, int node);
+void sexp_resolve_handles();
+
+// game state a formula can depend on, see sexp_query_dependencies()
+#define SEXP_DEP_MISSION_LOG	(1<<0)
+#define SEXP_DEP_SHIPS			(1<<1)		// ships and wings being created, renamed or deleted
+#define SEXP_DEP_VARIABLES		(1<<2)
+#define SEXP_DEP_UNTRACKED		(1<<3)		// reads something else, so always has to be evaluated
+
+int sexp_query_dependencies(int node);
+int sexp_dependency_stamp(int dependencies);
+
 // added by Goober5000
 #define CDDR(n)		CDR(CDR(n))
 #define CDDDR(n)	CDR(CDDR(n))
@@ -1032,8 +1048,24 @@ typedef struct sexp_node {
 	int	rest;						// index into Sexp_nodes of rest of parameters
 	int	value;					// known to be true, known to be false, or not known
 	int flags;					// Goober5000
+
+	// what the sexp_*_lookup() functions last resolved this node's name to, so the
+	// same argument doesn't get searched for by name every time it's evaluated
+	int	handle_type;				// SEXP_HANDLE_*
+	int	handle_index;				// ship or wing index, -1 if nothing by that name was found
+	int	handle_signature;			// object signature of the ship (or the subsystem's ship)
+	int	handle_generation;			// Ship_lookup_generation when the handle was resolved
+	ship_subsys *handle_subsys;
 } sexp_node;
 
+#define SEXP_HANDLE_NONE					0	// not resolved yet
+#define SEXP_HANDLE_NEVER					1	// a variable or special argument, which can name something different each time
+#define SEXP_HANDLE_SHIP					2
+#define SEXP_HANDLE_SHIP_OR_PLAYER_START	3
+#define SEXP_HANDLE_WING					4
+#define SEXP_HANDLE_WING_IGNORE_COUNT		5
+#define SEXP_HANDLE_SUBSYS					6
+
 // Goober5000
 #define SNF_ARGUMENT_VALID		(1<<0)
 #define SNF_ARGUMENT_SELECT		(1<<1)
@@ -1080,6 +1112,7 @@ extern sexp_node *Sexp_nodes;
 
 extern sexp_variable Sexp_variables[MAX_SEXP_VARIABLES];
 extern sexp_variable Block_variables[MAX_SEXP_VARIABLES];
+extern int Sexp_variable_generation;
 
 extern sexp_oper Operators[];
 extern int Num_operators;
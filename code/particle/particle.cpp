@@ -447,12 +447,13 @@ void particle_render_all()
 		}
 	}
 
-	profile_begin("Batch Render");
+	static int batch_render_zone = profile_register_zone("Batch Render");
+	profile_begin(batch_render_zone);
 	if (render_batch) {
 		geometry_batch_render(Geometry_shader_buffer_object);
 		batch_render_all(Particle_buffer_object);
 	}
-	profile_end("Batch Render");
+	profile_end(batch_render_zone);
 }
 
 
@@ -9,7 +9,8 @@
 #include "png.h"
 #include "pngutils/pngutils.h"
 
-CFILE *png_file = NULL;
+// per thread, so that textures can be decoded on the worker pool while loading
+static SCP_THREAD_LOCAL CFILE *png_file = NULL;
 
 //copy/pasted from libpng
 void png_scp_read_data(png_structp png_ptr, png_bytep data, png_size_t length)
@@ -160,6 +160,8 @@ int	Player_ship_class;	// needs to be player specific, move to player structure
 #define		MAX_SHIP_OBJS	MAX_SHIPS			// max number of ships tracked in ship list
 ship_obj		Ship_objs[MAX_SHIP_OBJS];		// array used to store ship object indexes
 ship_obj		Ship_obj_list;							// head of linked list of ship_obj structs
+int			Ship_obj_list_version = 0;				// changes whenever a ship is added to or removed from Ship_obj_list
+int			Ship_lookup_generation = 0;				// changes whenever a ship is created, renamed or deleted
 
 SCP_vector<ship_info>	Ship_info;
 reinforcements	Reinforcements[MAX_REINFORCEMENTS];
@@ -454,6 +456,8 @@ void ship_obj_list_init()
 	for ( i = 0; i < MAX_SHIP_OBJS; i++ ) {
 		ship_obj_list_reset_slot(i);
 	}
+
+	Ship_obj_list_version++;
 }
 
 /**
@@ -477,6 +481,7 @@ int ship_obj_list_add(int objnum)
 	Ship_objs[i].objnum = objnum;
 	list_append(&Ship_obj_list, &Ship_objs[i]);
 	Ship_objs[i].flags |= SHIP_OBJ_USED;
+	Ship_obj_list_version++;
 
 	return i;
 }
@@ -490,6 +495,7 @@ void ship_obj_list_remove(int index)
 	Assert(index >= 0 && index < MAX_SHIP_OBJS);
 	list_remove( Ship_obj_list, &Ship_objs[index]);	
 	ship_obj_list_reset_slot(index);
+	Ship_obj_list_version++;
 }
 
 /**
@@ -5218,6 +5224,7 @@ void ship_level_init()
 		Ships[i].ship_name[0] = '\0';
 		Ships[i].objnum = -1;
 	}
+	Ship_lookup_generation++;
 
 	Num_wings = 0;
 	for (i = 0; i < MAX_WINGS; i++ )
@@ -7545,6 +7552,8 @@ void ship_end_render_cockpit_display(int cockpit_display_num)
 
 void ship_subsystems_delete(ship *shipp)
 {
+	Ship_lookup_generation++;
+
 	if ( NOT_EMPTY(&shipp->subsys_list) )
 	{
 		ship_subsys *systemp, *temp;
@@ -7581,6 +7590,7 @@ void ship_delete( object * obj )
 	// on ship back to the free list for other ships to use.
 	ship_subsystems_delete(&Ships[num]);
 	shipp->objnum = -1;
+	Ship_lookup_generation++;
 
 	if (shipp->shield_integrity != NULL) {
 		vm_free(shipp->shield_integrity);
@@ -9354,7 +9364,7 @@ void ship_process_post(object * obj, float frametime)
 		// Goober5000 - player may want to use AI
 		if ( (Ships[num].ai_index >= 0) && (!(obj->flags & OF_PLAYER_SHIP) || Player_use_ai) ){
 			if (!physics_paused && !ai_paused){
-				ai_process( obj, Ships[num].ai_index, frametime );
+				PROFILE("AI", ai_process( obj, Ships[num].ai_index, frametime ));
 			}
 		}
 	}			
@@ -9774,6 +9784,9 @@ int ship_create(matrix *orient, vec3d *pos, int ship_type, char *ship_name)
 	ship_set_default_weapons(shipp, sip);	//	Moved up here because ship_set requires that weapon info be valid.  MK, 4/28/98
 	ship_set(n, objnum, ship_type);
 
+	// the ship is only visible to lookups once ship_set has given it its object
+	Ship_lookup_generation++;
+
 	init_ai_object(objnum);
 	ai_clear_ship_goals( &Ai_info[Ships[n].ai_index] );		// only do this one here.  Can't do it in init_ai because it might wipe out goals in mission file
 
@@ -12678,6 +12691,71 @@ void wing_bash_ship_name(char *ship_name, const char *wing_name, int index)
 		sprintf(ship_name, NOX("%s %d"), wing_name, index);
 }
 
+// Case-insensitive name indexes for the wing, ship and ship class lookups below.  Each maps a
+// lowercased name to the lowest index carrying it and is rebuilt lazily once the array it covers
+// has changed.  A hit is always re-checked against the array, so a stale entry can only cost a
+// fallback to the linear scan.
+typedef SCP_unordered_map<SCP_string, int> ship_name_index;
+
+static ship_name_index Wing_name_index;
+static int Wing_name_index_count = -1;
+static int Wing_name_index_generation = -1;
+
+static ship_name_index Ship_name_index;
+static int Ship_name_index_generation = -1;
+
+static ship_name_index Ship_info_name_index;
+static size_t Ship_info_name_index_count = 0;
+
+static void ship_name_index_key(SCP_string &key, const char *name)
+{
+	key = name;
+
+	for (SCP_string::iterator ch = key.begin(); ch != key.end(); ++ch)
+		*ch = (char)tolower(*ch);
+}
+
+// Adds name -> index unless a lower index already holds the name.
+static void ship_name_index_add(ship_name_index &index, const char *name, int idx)
+{
+	SCP_string key;
+
+	ship_name_index_key(key, name);
+	index.insert(std::make_pair(key, idx));
+}
+
+// Returns the indexed slot for name, or -1 if no slot carries it.
+static int ship_name_index_find(const ship_name_index &index, const char *name)
+{
+	SCP_string key;
+	ship_name_index::const_iterator it;
+
+	ship_name_index_key(key, name);
+
+	it = index.find(key);
+	if (it == index.end())
+		return -1;
+
+	return it->second;
+}
+
+// Wing names are filled in before Num_wings is bumped, and Num_wings is only reset at level init,
+// which also bumps Ship_lookup_generation.
+static void wing_name_index_update()
+{
+	int i;
+
+	if ((Wing_name_index_count == Num_wings) && (Wing_name_index_generation == Ship_lookup_generation))
+		return;
+
+	Wing_name_index.clear();
+	for (i = 0; i < Num_wings; i++)
+		ship_name_index_add(Wing_name_index, Wings[i].name, i);
+
+	Wing_name_index_count = Num_wings;
+	Wing_name_index_generation = Ship_lookup_generation;
+}
+
 /**
  * Return the object index of the ship with name *name.
  */
@@ -12688,6 +12766,18 @@ int wing_name_lookup(const char *name, int ignore_count)
 	if (name == NULL)
 		return -1;
 
+	if ( !Fred_running ) {
+		wing_name_index_update();
+
+		i = ship_name_index_find(Wing_name_index, name);
+		if (i < 0)
+			return -1;
+
+		// the lowest wing with this name is the one the scan below would find, provided it passes the count test
+		if (ignore_count ? Wings[i].wave_count : Wings[i].current_count)
+			return i;
+	}
+
 	if ( Fred_running )
 		wing_limit = MAX_WINGS;
 	else
@@ -12714,6 +12804,12 @@ int wing_name_lookup(const char *name, int ignore_count)
 int wing_lookup(const char *name)
 {
    int idx;
+
+	if ( !Fred_running ) {
+		wing_name_index_update();
+		return ship_name_index_find(Wing_name_index, name);
+	}
+
 	for(idx=0;idx<Num_wings;idx++)
 		if(stricmp(Wings[idx].name,name)==0)
 		   return idx;
@@ -12726,6 +12822,21 @@ int wing_lookup(const char *name)
  */
 int ship_info_lookup_sub(const char *token)
 {
+	int idx;
+
+	// Ship_info only grows while the tables are parsed (each new entry is named as soon as it is
+	// pushed) and is only emptied by ship_close(), so new entries can simply be appended
+	if (Ship_info_name_index_count > Ship_info.size()) {
+		Ship_info_name_index.clear();
+		Ship_info_name_index_count = 0;
+	}
+	for (; Ship_info_name_index_count < Ship_info.size(); Ship_info_name_index_count++)
+		ship_name_index_add(Ship_info_name_index, Ship_info[Ship_info_name_index_count].name, (int)Ship_info_name_index_count);
+
+	idx = ship_name_index_find(Ship_info_name_index, token);
+	if ((idx >= 0) && !stricmp(token, Ship_info[idx].name))
+		return idx;
+
 	for (auto it = Ship_info.cbegin(); it != Ship_info.cend(); ++it)
 		if (!stricmp(token, it->name))
 			return std::distance(Ship_info.cbegin(), it);
@@ -12872,17 +12983,25 @@ int ship_info_lookup(const char *token)
 	return ship_info_lookup_sub(name);
 }
 
-/**
- * Return the ship index of the ship with name *name.
- */
-int ship_name_lookup(const char *name, int inc_players)
+// The index covers every ship slot with a live object, whatever its type, so a miss is final.
+static void ship_name_index_update()
 {
-	int	i;
+	int i;
 
-	// bogus
-	if(name == NULL){
-		return -1;
-	}
+	if (Ship_name_index_generation == Ship_lookup_generation)
+		return;
+
+	Ship_name_index.clear();
+	for (i = 0; i < MAX_SHIPS; i++)
+		if (Ships[i].objnum >= 0)
+			ship_name_index_add(Ship_name_index, Ships[i].ship_name, i);
+
+	Ship_name_index_generation = Ship_lookup_generation;
+}
+
+static int ship_name_lookup_linear(const char *name, int inc_players)
+{
+	int	i;
 
 	for (i=0; i<MAX_SHIPS; i++){
 		if (Ships[i].objnum >= 0){
@@ -12898,6 +13017,77 @@ int ship_name_lookup(const char *name, int inc_players)
 	return -1;
 }
 
+/**
+ * Return the ship index of the ship with name *name.
+ */
+int ship_name_lookup(const char *name, int inc_players)
+{
+	int	i;
+
+	// bogus
+	if(name == NULL){
+		return -1;
+	}
+
+	// FRED renames ships in place without telling anyone
+	if (Fred_running)
+		return ship_name_lookup_linear(name, inc_players);
+
+	ship_name_index_update();
+
+	i = ship_name_index_find(Ship_name_index, name);
+	if (i < 0)
+		return -1;
+
+	// an OBJ_START ship skipped for !inc_players may shadow a later ship of the same name
+	if ((Ships[i].objnum >= 0) && !stricmp(name, Ships[i].ship_name)
+		&& (Objects[Ships[i].objnum].type == OBJ_SHIP || (Objects[Ships[i].objnum].type == OBJ_START && inc_players)))
+		return i;
+
+	return ship_name_lookup_linear(name, inc_players);
+}
+
+DCF(ship_lookup_bench, "Times indexed against linear ship name lookups over the ships in the mission (optional: number of passes)")
+{
+	int passes = 1000;
+	int i, pass, found, names[MAX_SHIPS], num_names = 0;
+	uint start, linear_us, indexed_us;
+
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: ship_lookup_bench [passes]\n");
+		dc_printf("Looks up every live ship by name [passes] times (default 1000), first with the\n");
+		dc_printf("linear scan and then through the name index, and prints the time taken by each.\n");
+		return;
+	}
+
+	dc_maybe_stuff_int(&passes);
+	passes = MAX(passes, 1);
+
+	for (i = 0; i < MAX_SHIPS; i++)
+		if (Ships[i].objnum >= 0)
+			names[num_names++] = i;
+
+	if (num_names == 0) {
+		dc_printf("No ships to look up.\n");
+		return;
+	}
+
+	found = 0;
+	start = timer_get_high_res_microseconds();
+	for (pass = 0; pass < passes; pass++)
+		for (i = 0; i < num_names; i++)
+			found += (ship_name_lookup_linear(Ships[names[i]].ship_name, 1) >= 0);
+	linear_us = timer_get_high_res_microseconds() - start;
+
+	start = timer_get_high_res_microseconds();
+	for (pass = 0; pass < passes; pass++)
+		for (i = 0; i < num_names; i++)
+			found -= (ship_name_lookup(Ships[names[i]].ship_name, 1) >= 0);
+	indexed_us = timer_get_high_res_microseconds() - start;
+
+	dc_printf("%d lookups of %d ships: linear %u us, indexed %u us%s\n", passes * num_names, num_names, linear_us, indexed_us, found ? " (results differ!)" : "");
+}
+
 int ship_type_name_lookup(const char *name)
 {
 	// bogus
@@ -14149,6 +14339,8 @@ void ship_close()
 
 	// free info from parsed table data
 	Ship_info.clear();
+	Ship_info_name_index.clear();
+	Ship_info_name_index_count = 0;
 
 	for (i = 0; i < (int)Ship_types.size(); i++) {
 		Ship_types[i].ai_actively_pursues.clear();
@@ -1482,6 +1482,7 @@ typedef struct ship_obj {
 	int			flags, objnum;
 } ship_obj;
 extern ship_obj Ship_obj_list;
+extern int Ship_obj_list_version;
 
 typedef struct engine_wash_info
 {
@@ -1663,6 +1664,10 @@ void parse_ship_particle_effect(ship_info* sip, particle_effect* pe, char *id_st
 
 extern int ship_info_lookup(const char *name = NULL);
 extern int ship_name_lookup(const char *name, int inc_players = 0);	// returns the index into Ship array of name
+
+// Bumped whenever a ship is created, renamed or deleted, or has its subsystems rebuilt, so anything
+// remembering the result of a name lookup knows to look again
+extern int Ship_lookup_generation;
 extern int ship_type_name_lookup(const char *name);
 
 extern int wing_lookup(const char *name);
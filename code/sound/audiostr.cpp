@@ -12,6 +12,7 @@
 
 #include "cfile/cfile.h"
 #include "globalincs/pstypes.h"
+#include "globalincs/workerpool.h"
 #include "io/timer.h"
 #include "sound/acm.h"
 #include "sound/audiostr.h"
@@ -45,6 +46,18 @@ ubyte *Compressed_service_buffer = NULL;	// Used to read in compressed data duri
 
 #define AS_HIGHEST_MAX	999999999	// max uncompressed filesize supported is 999 meg
 
+// Streams are decoded on a background thread.  Each AudioStream has a ring of decoded pieces
+// which AudioStream::Decode() fills on the decode thread and AudioStream::FillBuffers() empties
+// into the OpenAL buffers.  Each side only ever writes its own end of the ring, so it needs no
+// lock.  A stream keeps its ring topped up while it's cued but not playing, so the next pattern
+// or track already has its first couple of seconds decoded when it's started.
+#define AS_RING_SLOTS	8
+
+static worker_queue *Audiostream_decode_queue = NULL;
+
+static volatile long Audiostream_underruns = 0;		// times a playing stream ran out of decoded data
+static volatile long Audiostream_decode_us = 0;		// time spent decoding streams, in microseconds
+
 // Globalize the list of audio extensions for use in several sound related files
 const char *audio_ext_list[] = { ".ogg", ".wav" };
 const int NUM_AUDIO_EXT = sizeof(audio_ext_list) / sizeof(char*);
@@ -208,7 +221,6 @@ public:
 	WAVEFORMATEX m_wfmt;					// format of wave file used by Direct Sound
 	WAVEFORMATEX *m_pwfmt_original;	// foramt of wave file from actual wave source
 	uint m_total_uncompressed_bytes_read;
-	uint m_max_uncompressed_bytes_to_read;
 	uint m_bits_per_sample_uncompressed;
 
 protected:
@@ -254,6 +266,7 @@ public:
 	float	Get_Default_Volume() { return m_lDefaultVolume; }
 	uint	Get_Samples_Committed(void);
 	int	Is_looping() { return m_bLooping; }
+	void	Decode(void);
 	int	status;
 	int	type;
 	bool paused_via_sexp_or_script;
@@ -261,8 +274,10 @@ public:
 
 protected:
 	void Cue (void);
-	bool WriteWaveData (uint cbSize, uint *num_bytes_written, int service = 1);
-	uint GetMaxWriteSize (void);
+	void QueueDecode (void);
+	void WaitDecode (void);
+	void FreeRing (void);
+	void FillBuffers (void);
 	bool ServiceBuffer (void);
 	static bool TimerCallback (ptr_u dwUser);
 	bool PlaybackDone(void);
@@ -291,6 +306,20 @@ protected:
 	bool	m_bPastLimit;			// flag to show we've played past the number of bytes requred
 	float	m_lDefaultVolume;
 
+	// ring of decoded pieces, see AudioStream::Decode()
+	ubyte	*m_ring_data[AS_RING_SLOTS];
+	int		m_ring_size[AS_RING_SLOTS];	// bytes in each piece, -1 marks the end of the file
+	uint	m_ring_slot_size;
+	volatile long m_ring_head;			// next slot to decode into, only written by Decode()
+	volatile long m_ring_tail;			// next slot to queue on the source, only written by FillBuffers()
+	volatile long m_decode_queued;		// a Decode() job is queued or running
+	bool	m_decode_done;				// Decode() has reached the end of the file
+
+	ALuint	m_free_buffers[MAX_STREAM_BUFFERS];	// buffers not queued on the source
+	int		m_num_free_buffers;
+	uint	m_bytes_committed;			// bytes queued on the source since the stream was cued
+	uint	m_max_bytes_to_commit;		// sample cutoff, in bytes
+
 	CRITICAL_SECTION write_lock;
 };
 
@@ -392,7 +421,6 @@ void WaveFile::Init(void)
 	m_nDataSize = 0;
 	m_nBytesPlayed = 0;
 	m_total_uncompressed_bytes_read = 0;
-	m_max_uncompressed_bytes_to_read = AS_HIGHEST_MAX;
 	m_al_format = AL_FORMAT_MONO8;
 
 	memset(&m_wFilename, 0, MAX_FILENAME_LEN);
@@ -442,7 +470,6 @@ bool WaveFile::Open(char *pszFilename, bool keep_ext)
 	char filename[MAX_FILENAME_LEN];
 
 	m_total_uncompressed_bytes_read = 0;
-	m_max_uncompressed_bytes_to_read = AS_HIGHEST_MAX;
 
 	// NOTE: we assume that the extension has already been stripped off if it was supposed to be!!
 	strcpy_s( filename, pszFilename );
@@ -715,7 +742,6 @@ bool WaveFile::Cue (void)
 	int rval;
 
 	m_total_uncompressed_bytes_read = 0;
-	m_max_uncompressed_bytes_to_read = AS_HIGHEST_MAX;
 
 	if (m_wave_format == OGG_FORMAT_VORBIS) {
 		rval = (int)ov_raw_seek(&m_snd_info.vorbis_file, m_data_offset);
@@ -1070,6 +1096,18 @@ void AudioStream::Init_Data ()
 
 	memset(m_buffer_ids, 0, sizeof(m_buffer_ids));
 	m_source_id = 0;
+
+	memset(m_ring_data, 0, sizeof(m_ring_data));
+	memset(m_ring_size, 0, sizeof(m_ring_size));
+	m_ring_slot_size = 0;
+	m_ring_head = 0;
+	m_ring_tail = 0;
+	m_decode_queued = 0;
+	m_decode_done = false;
+
+	m_num_free_buffers = 0;
+	m_bytes_committed = 0;
+	m_max_bytes_to_commit = AS_HIGHEST_MAX;
 }
 
 // Create
@@ -1125,9 +1163,20 @@ bool AudioStream::Create (char *pszFilename)
 					OpenAL_ErrorPrint( alSource3i(m_source_id, AL_AUXILIARY_SEND_FILTER, AL_EFX_aux_id, 0, AL_FILTER_NULL) );
 				}
 
-				// Cue for playback
+				for (int ib = 0; ib < MAX_STREAM_BUFFERS; ib++)
+					m_free_buffers[ib] = m_buffer_ids[ib];
+
+				m_num_free_buffers = MAX_STREAM_BUFFERS;
+
+				// ADPCM and float conversions can come out a little bigger than asked for
+				m_ring_slot_size = MIN(m_cbBufSize * 2, BIGBUF_SIZE);
+
+				for (int is = 0; is < AS_RING_SLOTS; is++)
+					m_ring_data[is] = (ubyte *)vm_malloc(m_ring_slot_size);
+
+				// Cue for playback, which starts the decode thread on it
 				Cue();
-				Snd_sram += (m_cbBufSize * MAX_STREAM_BUFFERS);
+				Snd_sram += (m_cbBufSize * MAX_STREAM_BUFFERS) + (m_ring_slot_size * AS_RING_SLOTS);
 			}
 			else {
 				// Error opening file
@@ -1172,6 +1221,9 @@ bool AudioStream::Destroy (void)
 	// Stop playback
 	Stop ();
 
+	// the decode thread may still be reading the file
+	WaitDecode();
+
 	OpenAL_ErrorPrint( alGetSourcei(m_source_id, AL_BUFFERS_PROCESSED, &buffers_processed) );
 
 	while (buffers_processed) {
@@ -1184,7 +1236,9 @@ bool AudioStream::Destroy (void)
 	OpenAL_ErrorPrint( alDeleteSources(1, &m_source_id) );
 	OpenAL_ErrorPrint( alDeleteBuffers(MAX_STREAM_BUFFERS, m_buffer_ids) );
 
-	Snd_sram -= (m_cbBufSize * MAX_STREAM_BUFFERS);
+	Snd_sram -= (m_cbBufSize * MAX_STREAM_BUFFERS) + (m_ring_slot_size * AS_RING_SLOTS);
+
+	FreeRing();
 
 	// Delete WaveFile object
 	if (m_pwavefile) {
@@ -1200,100 +1254,135 @@ bool AudioStream::Destroy (void)
 	return fRtn;
 }
 
-// WriteWaveData
+static void audiostream_decode_job(void *data, int /*index*/)
+{
+	((AudioStream *)data)->Decode();
+}
+
+// Decode
 //
-// Writes wave data to sound buffer. This is a helper method used by Create and
-// ServiceBuffer; it's not exposed to users of the AudioStream class.
-bool AudioStream::WriteWaveData (uint size, uint *num_bytes_written, int service)
+// Runs on the decode thread.  Decodes pieces into the free slots of the ring until it's full or
+// the file has been read, publishing each one as it's done.
+void AudioStream::Decode (void)
 {
-	bool fRtn = true;
-	ubyte *uncompressed_wave_data;
+	uint start = timer_get_high_res_microseconds();
 
-	*num_bytes_written = 0;
+	// the service buffers are scratch space for WaveFile::Read()
+	ENTER_CRITICAL_SECTION(Global_service_lock);
 
-	if ( size == 0 || m_bReadingDone ) {
-		return fRtn;
-	}
+	while ( !m_decode_done && ((m_ring_head - m_ring_tail) < AS_RING_SLOTS) ) {
+		int slot = m_ring_head % AS_RING_SLOTS;
+		int num_bytes_read = m_pwavefile->Read(Wavedata_service_buffer, m_cbBufSize, 1);
 
-	if ( (m_buffer_ids[0] == 0) || !m_pwavefile ) {
-		return fRtn;
-	}
+		if (num_bytes_read < 0) {
+			m_ring_size[slot] = -1;
+			m_decode_done = true;
+		} else {
+			Assert( (uint)num_bytes_read <= m_ring_slot_size );
+			num_bytes_read = MIN((uint)num_bytes_read, m_ring_slot_size);
 
-	if ( service ) {
-		ENTER_CRITICAL_SECTION(Global_service_lock);
-	}
-		    
-	if ( service ) {
-		uncompressed_wave_data = Wavedata_service_buffer;
-	} else {
-		uncompressed_wave_data = Wavedata_load_buffer;
+			memcpy(m_ring_data[slot], Wavedata_service_buffer, num_bytes_read);
+			m_ring_size[slot] = num_bytes_read;
+		}
+
+		// the piece has to be there before the service side can see the slot
+		worker_memory_barrier();
+		m_ring_head++;
 	}
 
-	int num_bytes_read = 0;
+	LEAVE_CRITICAL_SECTION(Global_service_lock);
 
-	if ( !service ) {
-		for (int ib = 0; ib < MAX_STREAM_BUFFERS; ib++) {
-			num_bytes_read = m_pwavefile->Read(uncompressed_wave_data, m_cbBufSize, service);
+	worker_atomic_add(&Audiostream_decode_us, (long)(timer_get_high_res_microseconds() - start));
 
-			if (num_bytes_read < 0) {
-				m_bReadingDone = 1;
-			} else if (num_bytes_read > 0) {
-				OpenAL_ErrorCheck( alBufferData(m_buffer_ids[ib], m_pwavefile->GetALFormat(), uncompressed_wave_data, num_bytes_read, m_pwavefile->m_wfmt.nSamplesPerSec), { fRtn = false; goto ErrorExit; } );
-				OpenAL_ErrorCheck( alSourceQueueBuffers(m_source_id, 1, &m_buffer_ids[ib]), { fRtn = false; goto ErrorExit; } );
+	worker_memory_barrier();
+	m_decode_queued = 0;
+}
 
-				*num_bytes_written += num_bytes_read;
-			}
-		}
-	} else {
-		ALint buffers_processed = 0;
-		OpenAL_ErrorPrint( alGetSourcei(m_source_id, AL_BUFFERS_PROCESSED, &buffers_processed) );
+// QueueDecode
+//
+// Hands the stream to the decode thread if there's room in its ring and it isn't there already
+void AudioStream::QueueDecode (void)
+{
+	if ( m_decode_queued || m_decode_done || !m_pwavefile )
+		return;
 
-		while (buffers_processed) {
-			ALuint buffer_id = 0;
-			OpenAL_ErrorPrint( alSourceUnqueueBuffers(m_source_id, 1, &buffer_id) );
+	if ( (m_ring_head - m_ring_tail) >= AS_RING_SLOTS )
+		return;
 
-			num_bytes_read = m_pwavefile->Read(uncompressed_wave_data, m_cbBufSize, service);
+	m_decode_queued = 1;
+	worker_memory_barrier();
 
-			if (num_bytes_read < 0) {
-				m_bReadingDone = 1;
-			} else if (num_bytes_read > 0) {
-				OpenAL_ErrorPrint( alBufferData(buffer_id, m_pwavefile->GetALFormat(), uncompressed_wave_data, num_bytes_read, m_pwavefile->m_wfmt.nSamplesPerSec) );
-				OpenAL_ErrorPrint( alSourceQueueBuffers(m_source_id, 1, &buffer_id) );
+	worker_queue_push(Audiostream_decode_queue, audiostream_decode_job, this);
+}
 
-				*num_bytes_written += num_bytes_read;
-			}
+// WaitDecode
+//
+// Waits for the decode thread to be done with this stream, so the wave file can be touched
+void AudioStream::WaitDecode (void)
+{
+	worker_queue_wait(Audiostream_decode_queue, this);
+}
 
-			buffers_processed--;
+void AudioStream::FreeRing (void)
+{
+	for (int is = 0; is < AS_RING_SLOTS; is++) {
+		if ( m_ring_data[is] ) {
+			vm_free(m_ring_data[is]);
+			m_ring_data[is] = NULL;
 		}
 	}
-
-ErrorExit:
-
-	if ( service ) {
-		LEAVE_CRITICAL_SECTION(Global_service_lock);
-	}
-    
-	return (fRtn);
 }
 
-// GetMaxWriteSize
+// FillBuffers
 //
-// Helper function to calculate max size of sound buffer write operation, i.e. how much
-// free space there is in buffer.
-uint AudioStream::GetMaxWriteSize (void)
+// Queues decoded pieces from the ring into the OpenAL buffers the source is done with, then
+// asks the decode thread to refill the ring.
+void AudioStream::FillBuffers (void)
 {
-	uint dwMaxSize = m_cbBufSize;
-	ALint n, q;
+	ALint buffers_processed = 0;
+
+	if ( (m_buffer_ids[0] == 0) || !m_pwavefile )
+		return;
+
+	ENTER_CRITICAL_SECTION( write_lock );
+
+	OpenAL_ErrorPrint( alGetSourcei(m_source_id, AL_BUFFERS_PROCESSED, &buffers_processed) );
+
+	while (buffers_processed) {
+		ALuint buffer_id = 0;
+		OpenAL_ErrorPrint( alSourceUnqueueBuffers(m_source_id, 1, &buffer_id) );
+
+		Assert( m_num_free_buffers < MAX_STREAM_BUFFERS );
+		m_free_buffers[m_num_free_buffers++] = buffer_id;
+
+		buffers_processed--;
+	}
+
+	while ( (m_num_free_buffers > 0) && !m_bReadingDone && (m_ring_tail != m_ring_head) ) {
+		int slot = m_ring_tail % AS_RING_SLOTS;
+
+		// don't look at the piece before the slot was published
+		worker_memory_barrier();
 
-	OpenAL_ErrorCheck( alGetSourcei(m_source_id, AL_BUFFERS_PROCESSED, &n), return 0 );
+		if (m_ring_size[slot] < 0) {
+			m_bReadingDone = true;
+		} else if (m_ring_size[slot] > 0) {
+			ALuint buffer_id = m_free_buffers[--m_num_free_buffers];
 
-	OpenAL_ErrorCheck( alGetSourcei(m_source_id, AL_BUFFERS_QUEUED, &q), return 0 );
+			OpenAL_ErrorPrint( alBufferData(buffer_id, m_pwavefile->GetALFormat(), m_ring_data[slot], m_ring_size[slot], m_pwavefile->m_wfmt.nSamplesPerSec) );
+			OpenAL_ErrorPrint( alSourceQueueBuffers(m_source_id, 1, &buffer_id) );
 
-	if (!n && (q >= MAX_STREAM_BUFFERS)) //all buffers queued
-		dwMaxSize = 0;
+			m_bytes_committed += m_ring_size[slot];
+		}
+
+		// and be done with it before handing the slot back
+		worker_memory_barrier();
+		m_ring_tail++;
+	}
 
-	//	nprintf(("Alan","Max write size: %d\n", dwMaxSize));
-	return (dwMaxSize);
+	QueueDecode();
+
+	LEAVE_CRITICAL_SECTION( write_lock );
 }
 
 #define VOLUME_ATTENUATION_BEFORE_CUTOFF			0.03f
@@ -1349,56 +1438,53 @@ bool AudioStream::ServiceBuffer (void)
 		}
 	}
 
-	// All of sound not played yet, send more data to buffer
-	uint dwFreeSpace = GetMaxWriteSize ();
+	// All of sound not played yet, send whatever the decode thread has ready
+	FillBuffers();
 
-	// Determine free space in sound buffer
-	if (dwFreeSpace) {
+	if ( m_bytes_committed >= m_max_bytes_to_commit ) {
+		m_fade_timer_id = timer_get_milliseconds() + 1700;		// start fading 1.7 seconds from now
+		m_finished_id = timer_get_milliseconds() + 2000;		// 2 seconds left to play out buffer
+		m_max_bytes_to_commit = AS_HIGHEST_MAX;
+	}
 
-		// Some wave data remains, but not enough to fill free space
-		// Send wave data to buffer, fill remainder of free space with silence
-		uint num_bytes_written;
+	if ( (m_fade_timer_id>0) && ((uint)timer_get_milliseconds() > m_fade_timer_id) ) {
+		m_fade_timer_id = 0;
+		Fade_and_Stop();
+	}
 
-		if (WriteWaveData (dwFreeSpace, &num_bytes_written) == true) {
-//			nprintf(("Alan","Num bytes written: %d\n", num_bytes_written));
+	if ( (m_finished_id>0) && ((uint)timer_get_milliseconds() > m_finished_id) ) {
+		m_finished_id = 0;
+		m_bPastLimit = true;
+	}
 
-			if ( m_pwavefile->m_total_uncompressed_bytes_read >= m_pwavefile->m_max_uncompressed_bytes_to_read ) {
-				m_fade_timer_id = timer_get_milliseconds() + 1700;		// start fading 1.7 seconds from now
-				m_finished_id = timer_get_milliseconds() + 2000;		// 2 seconds left to play out buffer
-				m_pwavefile->m_max_uncompressed_bytes_to_read = AS_HIGHEST_MAX;
-			}
+	// the source stops by itself if it plays out everything queued before the decode
+	// thread catches up, so start it again now that there's more
+	if ( m_fPlaying && !m_bReadingDone ) {
+		ALint state = 0, queued = 0;
 
-			if ( (m_fade_timer_id>0) && ((uint)timer_get_milliseconds() > m_fade_timer_id) ) {
-				m_fade_timer_id = 0;
-				Fade_and_Stop();
-			}
+		OpenAL_ErrorPrint( alGetSourcei(m_source_id, AL_SOURCE_STATE, &state) );
+		OpenAL_ErrorPrint( alGetSourcei(m_source_id, AL_BUFFERS_QUEUED, &queued) );
 
-			if ( (m_finished_id>0) && ((uint)timer_get_milliseconds() > m_finished_id) ) {
-				m_finished_id = 0;
-				m_bPastLimit = true;
-			}
+		if ( (state == AL_STOPPED) && (queued > 0) ) {
+			worker_atomic_add(&Audiostream_underruns, 1);
+			OpenAL_ErrorPrint( alSourcePlay(m_source_id) );
+		}
+	}
 
-			if ( PlaybackDone() ) {
-				if ( m_bDestroy_when_faded == true ) {
-					LEAVE_CRITICAL_SECTION( write_lock );
+	if ( PlaybackDone() ) {
+		if ( m_bDestroy_when_faded == true ) {
+			LEAVE_CRITICAL_SECTION( write_lock );
 
-					Destroy();
-					// Reset reentrancy semaphore
+			Destroy();
+			// Reset reentrancy semaphore
 
-					return false;
-				}
-				// All of sound has played, stop playback or loop again
-				if ( m_bLooping && !m_bFade) {
-					Play(m_lVolume, m_bLooping);
-				} else {
-					Stop_and_Rewind();
-				}
-			}
+			return false;
 		}
-		else {
-			// Error writing wave data
-			fRtn = false;
-			Int3(); 
+		// All of sound has played, stop playback or loop again
+		if ( m_bLooping && !m_bFade) {
+			Play(m_lVolume, m_bLooping);
+		} else {
+			Stop_and_Rewind();
 		}
 	}
 
@@ -1410,9 +1496,9 @@ bool AudioStream::ServiceBuffer (void)
 // Cue
 void AudioStream::Cue (void)
 {
-	uint num_bytes_written;
-
 	if (!m_fCued) {
+		ENTER_CRITICAL_SECTION( write_lock );
+
 		m_bFade = false;
 		m_fade_timer_id = 0;
 		m_finished_id = 0;
@@ -1424,24 +1510,35 @@ void AudioStream::Cue (void)
 
 		// Reset buffer ptr
 		m_cbBufOffset = 0;
+		m_bytes_committed = 0;
+		m_max_bytes_to_commit = AS_HIGHEST_MAX;
+		m_bReadingDone = false;
+
+		// the decode thread has to be done with the file before it's rewound
+		WaitDecode();
 
 		// Reset file ptr, etc
 		m_pwavefile->Cue ();
 
+		m_ring_head = 0;
+		m_ring_tail = 0;
+		m_decode_done = false;
+
 		// Unqueue all buffers
-		ALint buffers_processed = 0;
-		OpenAL_ErrorPrint( alGetSourcei(m_source_id, AL_BUFFERS_PROCESSED, &buffers_processed) );
+		OpenAL_ErrorPrint( alSourceStop(m_source_id) );
+		OpenAL_ErrorPrint( alSourcei(m_source_id, AL_BUFFER, 0) );
 
-		while (buffers_processed) {
-			ALuint buffer_id = 0;
-			OpenAL_ErrorPrint( alSourceUnqueueBuffers(m_source_id, 1, &buffer_id) );
-			buffers_processed--;
-		}
+		for (int ib = 0; ib < MAX_STREAM_BUFFERS; ib++)
+			m_free_buffers[ib] = m_buffer_ids[ib];
+
+		m_num_free_buffers = MAX_STREAM_BUFFERS;
 
-		// Fill buffer with wave data
-		WriteWaveData (m_cbBufSize, &num_bytes_written, 0);
+		// start decoding from the top, Play() queues the first pieces
+		QueueDecode();
 
 		m_fCued = true;
+
+		LEAVE_CRITICAL_SECTION( write_lock );
 	}
 }
 
@@ -1464,6 +1561,13 @@ void AudioStream::Play (float volume, int looping)
 		else
 			m_bLooping = 0;
 
+		// don't start the source on an empty queue.  The first piece has usually been decoded
+		// long ago, and if not (a voice message played as soon as it's opened) it won't be long.
+		if ( (m_num_free_buffers == MAX_STREAM_BUFFERS) && (m_ring_head == m_ring_tail) )
+			WaitDecode();
+
+		FillBuffers();
+
 		OpenAL_ErrorPrint( alSourcePlay(m_source_id) );
 
 		m_nTimeStarted = timer_get_milliseconds();
@@ -1494,7 +1598,7 @@ void AudioStream::Set_Sample_Cutoff(unsigned int sample_cutoff)
 	if ( m_pwavefile == NULL )
 		return;
 
-	m_pwavefile->m_max_uncompressed_bytes_to_read = ((sample_cutoff * m_pwavefile->m_wfmt.wBitsPerSample) / 8);
+	m_max_bytes_to_commit = ((sample_cutoff * m_pwavefile->m_wfmt.wBitsPerSample) / 8);
 }
 
 uint AudioStream::Get_Samples_Committed(void)
@@ -1502,7 +1606,7 @@ uint AudioStream::Get_Samples_Committed(void)
 	if ( m_pwavefile == NULL )
 		return 0;
 
-	return ((m_pwavefile->m_total_uncompressed_bytes_read * 8) / m_pwavefile->m_wfmt.wBitsPerSample);
+	return ((m_bytes_committed * 8) / m_pwavefile->m_wfmt.wBitsPerSample);
 }
 
 
@@ -1574,6 +1678,9 @@ void AudioStream::Stop_and_Rewind (void)
 
 	m_fCued = false;	// this will cause wave file to start from beginning
 	m_bReadingDone = false;
+
+	// rewind now rather than when it's next played, so the start is decoded by then
+	Cue();
 }
 
 // Set_Volume
@@ -1653,6 +1760,10 @@ void audiostream_init()
 
 	INITIALIZE_CRITICAL_SECTION( Global_service_lock );
 
+	Audiostream_decode_queue = worker_queue_create();
+	Audiostream_underruns = 0;
+	Audiostream_decode_us = 0;
+
 	Audiostream_inited = 1;
 }
 
@@ -1672,6 +1783,9 @@ void audiostream_close()
 		}
 	}
 
+	worker_queue_destroy(Audiostream_decode_queue);
+	Audiostream_decode_queue = NULL;
+
 	// free global buffers
 	if ( Wavedata_load_buffer ) {
 		vm_free(Wavedata_load_buffer);
@@ -2002,3 +2116,13 @@ void audiostream_unpause_all(bool via_sexp_or_script)
 		audiostream_unpause(i, via_sexp_or_script);
 	}
 }
+
+int audiostream_get_underruns()
+{
+	return (int)Audiostream_underruns;
+}
+
+uint audiostream_get_decode_time()
+{
+	return (uint)Audiostream_decode_us;
+}
@@ -102,4 +102,10 @@ void audiostream_unpause(int i, bool via_sexp_or_script = false);	// unpause a p
 void audiostream_pause_all(bool via_sexp_or_script = false);	// pause all audio streams											
 void audiostream_unpause_all(bool via_sexp_or_script = false);	// unpause all audio streams
 
+// number of times a playing stream ran dry waiting on the decode thread
+int audiostream_get_underruns();
+
+// total time the decode thread has spent decoding streams, in microseconds
+uint audiostream_get_decode_time();
+
 #endif // _AUDIOSTR_H
@@ -46,6 +46,22 @@ static int MAX_CHANNELS;		// initialized properly in ds_init_channels()
 channel *Channels = NULL;
 static int channel_next_sig = 1;
 
+// Channel allocation.  A channel is free (on Channel_free), taken (handed out by ds_get_free_channel()
+// but its sound not started yet) or playing.  Playing channels are counted per snd_id, and the ones that
+// may be preempted are kept in a binary heap with the least important sound on top, so starting a sound
+// never has to walk every channel asking OpenAL for its state.  Sounds that end on their own are only
+// noticed by ds_channel_reap_all() and ds_channel_reap_sound(), which run when the counts get in the way.
+#define CHANNEL_FREE		0
+#define CHANNEL_TAKEN		1
+#define CHANNEL_PLAYING		2
+
+static SCP_vector<int> Channel_state;
+static SCP_vector<int> Channel_free;
+static SCP_vector<int> Channel_heap;
+static SCP_vector<int> Channel_heap_pos;		// index of each channel in Channel_heap, -1 if not in it
+static SCP_map<int, int> Channel_instances;		// snd_id -> number of channels playing it
+static bool Channel_reaped = false;				// ds_channel_reap_all() has run from ds_get_free_channel() this frame
+
 const int BUFFER_BUMP = 50;
 SCP_vector<sound_buffer> sound_buffers;
 
@@ -658,45 +674,32 @@ int ds_get_sid()
 }
 
 /**
- * @brief Load a secondary buffer with sound data.
- * @details The sounds data for game sounds are stored in the DirectSound secondary buffers, 
- * and are duplicated as needed and placed in the Channels[] array to be played.
- * 
- * @param sid Pointer to software id for sound ( output parm)
- * @param final_size Pointer to storage to receive uncompressed sound size (output parm)
+ * @brief Convert parsed sound data into PCM that OpenAL can take.
+ * @details This only touches the given ::sound_info and its file, so it can be run on the worker
+ * pool; the OpenAL side of loading is left to ds_upload_buffer().
+ *
+ * @param dec Receives the converted data, release it with ds_free_decoded()
  * @param header Pointer to a WAVEFORMATEX structure
  * @param si ::sound_info structure, contains details on the sound format
  * @param flags	Buffer properties ( DS_HARDWARE , DS_3D )
  *
- * @return 1 if sound effect could not loaded into a secondary buffer, 0 if sound effect successfully loaded into a secondary buffer
- *
- * NOTE: this function is slow, especially when sounds are loaded into hardware.  Don't call this
- * function from within gameplay.
+ * @return -1 if the sound could not be converted, 0 otherwise
  */
-int ds_load_buffer(int *sid, int *final_size, void *header, sound_info *si, int flags)
+int ds_decode_buffer(ds_decoded_sound *dec, void *header, sound_info *si, int flags)
 {
-	Assert( final_size != NULL );
+	Assert( dec != NULL );
 	Assert( header != NULL );
 
+	dec->data = NULL;
+	dec->buffer = NULL;
+
 	if (si == NULL) {
 		Int3();
 		return -1;
 	}
 
-	// All sounds are required to have a software buffer
-	*sid = ds_get_sid();
-	if ( *sid == -1 ) {
-		nprintf(("Sound","SOUND ==> No more sound buffers available\n"));
-		return -1;
-	}
-
-	ALuint pi;
-	OpenAL_ErrorCheck( alGenBuffers (1, &pi), return -1 );
-
-	ALenum format;
 	ALsizei size;
 	ALint bits, bps, n_channels = si->n_channels;
-	ALuint frequency;
 	ALvoid *data = NULL;
 	int sign, byte_order = 0, section, last_section = -1;
 
@@ -962,47 +965,292 @@ int ds_load_buffer(int *sid, int *final_size, void *header, sound_info *si, int
 		nprintf(("Sound", "SOUND ==> Converted 3D sound from stereo to mono\n"));
 	}
 
+	dec->data = (ubyte *)data;
+	dec->buffer = (mono_buffer != nullptr) ? mono_buffer : convert_buffer;
+	dec->size = size;
+	dec->bits = bits;
+	dec->n_channels = n_channels;
+	dec->bps = bps;
+
+	return 0;
+}
+
+/**
+ * Free the data of a sound converted by ds_decode_buffer()
+ */
+void ds_free_decoded(ds_decoded_sound *dec)
+{
+	if (dec->buffer != NULL) {
+		vm_free(dec->buffer);
+	}
+
+	dec->buffer = NULL;
+	dec->data = NULL;
+}
+
+/**
+ * @brief Load converted sound data into a new OpenAL buffer.
+ *
+ * @param sid Pointer to software id for sound ( output parm)
+ * @param final_size Pointer to storage to receive uncompressed sound size (output parm)
+ * @param dec Sound data from ds_decode_buffer(), still owned by the caller
+ * @param si ::sound_info structure, updated to describe the converted data
+ *
+ * @return -1 if the sound could not be loaded, 0 otherwise
+ */
+int ds_upload_buffer(int *sid, int *final_size, ds_decoded_sound *dec, sound_info *si)
+{
+	Assert( final_size != NULL );
+	Assert( dec != NULL );
+
 	// format is now in pcm
-	frequency = si->sample_rate;
-	format = openal_get_format(bits, n_channels);
+	ALuint frequency = si->sample_rate;
+	ALenum format = openal_get_format(dec->bits, dec->n_channels);
 
 	if (format == AL_INVALID_VALUE) {
-		if (convert_buffer) {
-			vm_free(convert_buffer);
-		}
 		return -1;
 	}
 
-	Snd_sram += size;
+	// All sounds are required to have a software buffer
+	*sid = ds_get_sid();
+	if ( *sid == -1 ) {
+		nprintf(("Sound","SOUND ==> No more sound buffers available\n"));
+		return -1;
+	}
+
+	ALuint pi;
+	OpenAL_ErrorCheck( alGenBuffers (1, &pi), return -1 );
+
+	OpenAL_ErrorCheck( alBufferData(pi, format, dec->data, dec->size, frequency), return -1 );
+
+	Snd_sram += dec->size;
 
 	if (final_size) {
-		*final_size = size;
+		*final_size = dec->size;
 	}
 
-	OpenAL_ErrorCheck( alBufferData(pi, format, data, size, frequency), { if (convert_buffer) vm_free(convert_buffer); return -1; } );
-
 	sound_buffers[*sid].buf_id = pi;
 	sound_buffers[*sid].channel_id = -1;
 	sound_buffers[*sid].frequency = frequency;
-	sound_buffers[*sid].bits_per_sample = bits;
-	sound_buffers[*sid].nchannels = n_channels;
-	sound_buffers[*sid].nseconds = size / bps;
-	sound_buffers[*sid].nbytes = size;
+	sound_buffers[*sid].bits_per_sample = dec->bits;
+	sound_buffers[*sid].nchannels = dec->n_channels;
+	sound_buffers[*sid].nseconds = dec->size / dec->bps;
+	sound_buffers[*sid].nbytes = dec->size;
 
 	// update sound_info struct with any changed data
-	si->bits = bits;
-	si->n_channels = n_channels;
-	si->size = size;
-	si->n_block_align = (bits / 8) * n_channels;
-	si->avg_bytes_per_sec = bps;
+	si->bits = dec->bits;
+	si->n_channels = dec->n_channels;
+	si->size = dec->size;
+	si->n_block_align = (dec->bits / 8) * dec->n_channels;
+	si->avg_bytes_per_sec = dec->bps;
+
+	return 0;
+}
+
+/**
+ * @brief Load a secondary buffer with sound data.
+ * @details The sounds data for game sounds are stored in the DirectSound secondary buffers, 
+ * and are duplicated as needed and placed in the Channels[] array to be played.
+ * 
+ * @param sid Pointer to software id for sound ( output parm)
+ * @param final_size Pointer to storage to receive uncompressed sound size (output parm)
+ * @param header Pointer to a WAVEFORMATEX structure
+ * @param si ::sound_info structure, contains details on the sound format
+ * @param flags	Buffer properties ( DS_HARDWARE , DS_3D )
+ *
+ * @return 1 if sound effect could not loaded into a secondary buffer, 0 if sound effect successfully loaded into a secondary buffer
+ *
+ * NOTE: this function is slow, especially when sounds are loaded into hardware.  Don't call this
+ * function from within gameplay.
+ */
+int ds_load_buffer(int *sid, int *final_size, void *header, sound_info *si, int flags)
+{
+	ds_decoded_sound dec;
+	int rc;
 
-	if ( convert_buffer ) {
-		vm_free( convert_buffer );
+	if ( ds_decode_buffer(&dec, header, si, flags) == -1 ) {
+		return -1;
 	}
-	if ( mono_buffer != nullptr ) {
-		vm_free( mono_buffer );
+
+	rc = ds_upload_buffer(sid, final_size, &dec, si);
+
+	ds_free_decoded(&dec);
+
+	return rc;
+}
+
+/**
+ * Whether a playing channel may be stopped to make room for another sound.
+ *
+ * @param same_sound True if the new sound is another instance of the one on the channel
+ */
+static bool ds_channel_preemptible(const channel *chp, bool same_sound)
+{
+	// looping sounds are never preempted, and neither are ambient sounds in enhanced mode
+	if ( chp->looping || (chp->is_ambient && !Cmdline_no_enhanced_sound) ) {
+		return false;
 	}
-	return 0;
+
+	// a playing voice message can only make way for another instance of itself
+	return same_sound || !chp->is_voice_msg;
+}
+
+/**
+ * Whether channel a should be stopped before channel b.  Lowest priority goes first (note that a
+ * higher priority value means lower priority), then lowest volume, then the oldest sound.  Retail
+ * mode leaves every channel at the same priority, so only volume and age count there.
+ */
+static bool ds_channel_less_important(int a, int b)
+{
+	const channel *ca = &Channels[a];
+	const channel *cb = &Channels[b];
+
+	if (ca->priority != cb->priority) {
+		return ca->priority > cb->priority;
+	}
+
+	if (ca->vol != cb->vol) {
+		return ca->vol < cb->vol;
+	}
+
+	return ca->sig < cb->sig;
+}
+
+static void ds_channel_heap_swap(int pos_a, int pos_b)
+{
+	int a = Channel_heap[pos_a];
+	int b = Channel_heap[pos_b];
+
+	Channel_heap[pos_a] = b;
+	Channel_heap[pos_b] = a;
+	Channel_heap_pos[b] = pos_a;
+	Channel_heap_pos[a] = pos_b;
+}
+
+static void ds_channel_heap_up(int pos)
+{
+	while (pos > 0) {
+		int parent = (pos - 1) / 2;
+
+		if ( !ds_channel_less_important(Channel_heap[pos], Channel_heap[parent]) ) {
+			break;
+		}
+
+		ds_channel_heap_swap(pos, parent);
+		pos = parent;
+	}
+}
+
+static void ds_channel_heap_down(int pos)
+{
+	int count = (int)Channel_heap.size();
+
+	for (;;) {
+		int child = (pos * 2) + 1;
+
+		if (child >= count) {
+			break;
+		}
+
+		if ( ((child + 1) < count) && ds_channel_less_important(Channel_heap[child + 1], Channel_heap[child]) ) {
+			child++;
+		}
+
+		if ( !ds_channel_less_important(Channel_heap[child], Channel_heap[pos]) ) {
+			break;
+		}
+
+		ds_channel_heap_swap(pos, child);
+		pos = child;
+	}
+}
+
+static void ds_channel_heap_remove(int i)
+{
+	int pos = Channel_heap_pos[i];
+
+	if (pos < 0) {
+		return;
+	}
+
+	int last = (int)Channel_heap.size() - 1;
+
+	if (pos != last) {
+		ds_channel_heap_swap(pos, last);
+	}
+
+	Channel_heap.pop_back();
+	Channel_heap_pos[i] = -1;
+
+	if (pos < last) {
+		ds_channel_heap_down(pos);
+		ds_channel_heap_up(pos);
+	}
+}
+
+/**
+ * Reset the channel allocator, with every channel free
+ */
+static void ds_channel_alloc_init()
+{
+	int i;
+
+	Channel_state.assign(MAX_CHANNELS, CHANNEL_FREE);
+	Channel_heap_pos.assign(MAX_CHANNELS, -1);
+	Channel_heap.clear();
+	Channel_heap.reserve(MAX_CHANNELS);
+	Channel_instances.clear();
+	Channel_reaped = false;
+
+	// hand out the low channels first, like the old linear search did
+	Channel_free.clear();
+	Channel_free.reserve(MAX_CHANNELS);
+
+	for (i = MAX_CHANNELS - 1; i >= 0; i--) {
+		Channel_free.push_back(i);
+	}
+}
+
+/**
+ * Book a channel that ds_get_free_channel() handed out as playing, once its sound has started
+ */
+static void ds_channel_start(int i)
+{
+	Assert( Channel_state[i] == CHANNEL_TAKEN );
+
+	Channel_state[i] = CHANNEL_PLAYING;
+	Channel_instances[Channels[i].snd_id]++;
+
+	if ( ds_channel_preemptible(&Channels[i], false) ) {
+		Channel_heap.push_back(i);
+		Channel_heap_pos[i] = (int)Channel_heap.size() - 1;
+		ds_channel_heap_up(Channel_heap_pos[i]);
+	}
+}
+
+/**
+ * Return a channel to the free list.  Must be called before the channel's snd_id is cleared.
+ */
+static void ds_channel_release(int i)
+{
+	if ( Channel_state.empty() || (Channel_state[i] == CHANNEL_FREE) ) {
+		return;
+	}
+
+	if (Channel_state[i] == CHANNEL_PLAYING) {
+		ds_channel_heap_remove(i);
+
+		SCP_map<int, int>::iterator it = Channel_instances.find(Channels[i].snd_id);
+
+		if (it != Channel_instances.end()) {
+			if (--it->second <= 0) {
+				Channel_instances.erase(it);
+			}
+		}
+	}
+
+	Channel_state[i] = CHANNEL_FREE;
+	Channel_free.push_back(i);
 }
 
 /**
@@ -1017,6 +1265,8 @@ void ds_init_channels()
 	} catch (std::bad_alloc) {
 		Error(LOCATION, "Unable to allocate " SIZE_T_ARG " bytes for %d audio channels.", sizeof(channel) * MAX_CHANNELS, MAX_CHANNELS);
 	}
+
+	ds_channel_alloc_init();
 }
 
 /**
@@ -1254,6 +1504,8 @@ void ds_close_channel(int i)
 
 		OpenAL_ErrorPrint( alDeleteSources(1, &Channels[i].source_id) );
 
+		ds_channel_release(i);
+
 		if (Channels[i].sid >= 0) {
 			sound_buffers[Channels[i].sid].channel_id = -1;
 		}
@@ -1279,6 +1531,8 @@ void ds_close_channel_fast(int i)
 			OpenAL_ErrorPrint( alSource3i(Channels[i].source_id, AL_AUXILIARY_SEND_FILTER, AL_EFFECTSLOT_NULL, 0, AL_FILTER_NULL) );
 		}
 
+		ds_channel_release(i);
+
 		if (Channels[i].sid >= 0) {
 			sound_buffers[Channels[i].sid].channel_id = -1;
 		}
@@ -1351,6 +1605,12 @@ void ds_close()
 	delete [] Channels;
 	Channels = NULL;
 
+	Channel_state.clear();
+	Channel_free.clear();
+	Channel_heap.clear();
+	Channel_heap_pos.clear();
+	Channel_instances.clear();
+
 	alcMakeContextCurrent(NULL);	// hangs on me for some reason
 
 	if (ds_sound_context != NULL) {
@@ -1366,299 +1626,232 @@ void ds_close()
 
 
 /**
- * Find a free channel to play a sound on.  If no free channels exists, free up one based on volume levels.
- * This is the original retail version of ds_get_free_channel().
- *
- * @param new_volume Volume for sound to play at
- * @param snd_id Which kind of sound to play
- * @param priority ::DS_MUST_PLAY, ::DS_LIMIT_ONE, ::DS_LIMIT_TWO, ::DS_LIMIT_THREE
+ * Take a channel off the free list, creating its OpenAL source if need be
  *
- * @returns	Channel number to play sound on, or -1 if no channel could be found
- *
- * NOTE: snd_id is needed since we limit the number of concurrent samples
+ * @returns	Channel number, or -1 if no channel is free
  */
-int ds_get_free_channel_retail(float new_volume, int snd_id, int priority)
-{
-	int			i, first_free_channel, limit = 100;
-	int			instance_count;	// number of instances of sound already playing
-	int			lowest_vol_index = -1, lowest_instance_vol_index = -1;
-	float		lowest_vol = 1.0f, lowest_instance_vol = 1.0f;
-	channel		*chp;
-	int status;
-
-	instance_count = 0;
-	first_free_channel = -1;
-
-	// determine the limit of concurrent instances of this sound
-	switch (priority) {
-		case DS_MUST_PLAY:
-			limit = 100;
-		break;
+static int ds_channel_take()
+{
+	if (Channel_free.empty()) {
+		return -1;
+	}
 
-		case DS_LIMIT_ONE:
-			limit = 1;
-		break;
+	int i = Channel_free.back();
 
-		case DS_LIMIT_TWO:
-			limit = 2;
-		break;
+	if (Channels[i].source_id == 0) {
+		OpenAL_ErrorCheck( alGenSources(1, &Channels[i].source_id), return -1 );
+	}
 
-		case DS_LIMIT_THREE:
-			limit = 3;
-		break;
+	Channel_free.pop_back();
+	Channel_state[i] = CHANNEL_TAKEN;
 
-		default:
-			Int3();			// get Alan
-			limit = 100;
-		break;
-	}
+	return i;
+}
 
-	// Look for a channel to use to play this sample
-	for ( i = 0; i < MAX_CHANNELS; i++ ) {
-		chp = &Channels[i];
+/**
+ * Free every channel whose sound has finished playing.  Also reclaims channels that were handed out
+ * but whose sound then failed to start.
+ */
+static void ds_channel_reap_all()
+{
+	int i;
+	ALint status;
 
-		// source not created yet
-		if (chp->source_id == 0) {
-			if (first_free_channel == -1) {
-				first_free_channel = i;
-			}
+	for (i = 0; i < MAX_CHANNELS; i++) {
+		if (Channel_state[i] == CHANNEL_TAKEN) {
+			ds_channel_release(i);
 			continue;
 		}
 
-		// source not bound to a buffer
-		if (chp->sid == -1) {
-			if (first_free_channel == -1) {
-				first_free_channel = i;
-			}
+		if (Channel_state[i] != CHANNEL_PLAYING) {
 			continue;
 		}
 
-		OpenAL_ErrorCheck( alGetSourcei(chp->source_id, AL_SOURCE_STATE, &status), continue );
+		OpenAL_ErrorCheck( alGetSourcei(Channels[i].source_id, AL_SOURCE_STATE, &status), continue );
 
 		if ( (status == AL_INITIAL) || (status == AL_STOPPED) ) {
 			ds_close_channel_fast(i);
-
-			if (first_free_channel == -1) {
-				first_free_channel = i;
-			}
-			continue;
-		} else {
-			if ( chp->snd_id == snd_id ) {
-				instance_count++;
-				if ( (chp->vol < lowest_instance_vol) && (chp->looping == FALSE) ) {
-					lowest_instance_vol = chp->vol;
-					lowest_instance_vol_index = i;
-				}
-			} else if ( chp->is_voice_msg ) {
-				// a playing voice message is not allowed to be preempted.
-			} else if ( (chp->vol < lowest_vol) && (chp->looping == FALSE) ) {
-				lowest_vol_index = i;
-				lowest_vol = chp->vol;
-			}
 		}
 	}
+}
 
-	// If we've exceeded the limit, then maybe stop the duplicate if it is lower volume
-	if ( (instance_count >= limit) && (lowest_instance_vol_index >= 0) ) {
-		// If there is a lower volume duplicate, stop it.... otherwise, don't play the sound
-		if (lowest_instance_vol <= new_volume) {
-			ds_close_channel_fast(lowest_instance_vol_index);
-			first_free_channel = lowest_instance_vol_index;
-		} else {
-			// NOTE: yes we are preventing the sound from playing even if
-			// there is an available channel because we are over the limit
-			// requested by the rest of the engine, which means if we do
-			// not honour its request to limit the count then the engine
-			// will trip itself up by using all channels without having
-			// the intention of actually doing so.  This means we get
-			// very loud sounds, missing more important sounds, etc.
-			// Effectivly the problem is the rest of the engine assumes
-			// it is still stuck in the 90s with a sound card that only has
-			// <=16 channels so we need to give it a sound card that
-			// has 16 channels (though we are actually allowing 32 channels
-			// just because we can).
-			first_free_channel = -1;
+/**
+ * Free the channels playing snd_id whose sound has finished
+ */
+static void ds_channel_reap_sound(int snd_id)
+{
+	int i;
+	ALint status;
+
+	for (i = 0; i < MAX_CHANNELS; i++) {
+		if ( (Channel_state[i] != CHANNEL_PLAYING) || (Channels[i].snd_id != snd_id) ) {
+			continue;
 		}
-	} else if (first_free_channel == -1) {
-		// there is no limit barrier to play the sound, but we have run out of channels
-		// stop the lowest volume instance to play our sound if priority demands it
-		if ( (lowest_vol_index != -1) && (priority == DS_MUST_PLAY) ) {
-			// Check if the lowest volume playing is less than the volume of the requested sound.
-			// If so, then we are going to trash the lowest volume sound.
-			if ( Channels[lowest_vol_index].vol <= new_volume ) {
-				ds_close_channel_fast(lowest_vol_index);
-				first_free_channel = lowest_vol_index;
-			}
+
+		OpenAL_ErrorCheck( alGetSourcei(Channels[i].source_id, AL_SOURCE_STATE, &status), continue );
+
+		if ( (status == AL_INITIAL) || (status == AL_STOPPED) ) {
+			ds_close_channel_fast(i);
 		}
 	}
+}
 
-	if ( (first_free_channel >= 0) && (Channels[first_free_channel].source_id == 0) ) {
-		OpenAL_ErrorCheck( alGenSources(1, &Channels[first_free_channel].source_id), return -1 );
-	}
-	return first_free_channel;
+/**
+ * Number of channels playing snd_id, counting ones that may have finished but not been reaped yet
+ */
+static unsigned int ds_channel_instances(int snd_id)
+{
+	SCP_map<int, int>::iterator it = Channel_instances.find(snd_id);
+
+	return (it == Channel_instances.end()) ? 0 : (unsigned int)it->second;
 }
 
 /**
- * Find a free channel to play a sound on.  If no free channels exists, free up one based on priority and volume levels.
- * Special version for enhanced mode.
- *
- * @param new_volume Volume for sound to play at
- * @param snd_id Which kind of sound to play
- * @param enhanced_priority Priority level, see EnhancedSoundPriority enum in gamesnd.h
- * @param enhanced_limit Per-sound concurrency limit
- *
- * @returns	Channel number to play sound on, or -1 if no channel could be found
+ * Find the playing instance of snd_id that should make way for a new one
  *
- * NOTE: snd_id is needed since we limit the number of concurrent samples
+ * @returns	Channel number, or -1 if every instance is protected
  */
-int ds_get_free_channel_enhanced(float new_volume, int snd_id, int enhanced_priority, unsigned int enhanced_limit)
-{
-	int			i, first_free_channel;
-	int			instance_count;	// number of instances of sound already playing
-	// least important means lowest volume among lowest priority
-	// note that higher priority value means lower priority
-	int			least_important_index = -1, least_important_instance_index = -1;
-	float		least_important_vol = 1.1f, least_important_instance_vol = 1.1f;
-	int			least_important_priority = -1, least_important_instance_priority = -1;
-	channel		*chp;
-	int status;
-
-	instance_count = 0;
-	first_free_channel = -1;
-
-	// Look for a channel to use to play this sample
-	for ( i = 0; i < MAX_CHANNELS; i++ ) {
-		chp = &Channels[i];
+static int ds_channel_least_important_instance(int snd_id)
+{
+	int i, least_important = -1;
 
-		// source not created yet
-		if (chp->source_id == 0) {
-			if (first_free_channel == -1) {
-				first_free_channel = i;
-			}
+	for (i = 0; i < MAX_CHANNELS; i++) {
+		if ( (Channel_state[i] != CHANNEL_PLAYING) || (Channels[i].snd_id != snd_id) ) {
 			continue;
 		}
 
-		// source not bound to a buffer
-		if (chp->sid == -1) {
-			if (first_free_channel == -1) {
-				first_free_channel = i;
-			}
+		if ( !ds_channel_preemptible(&Channels[i], true) ) {
 			continue;
 		}
 
-		OpenAL_ErrorCheck( alGetSourcei(chp->source_id, AL_SOURCE_STATE, &status), continue );
-
-		if ( (status == AL_INITIAL) || (status == AL_STOPPED) ) {
-			ds_close_channel_fast(i);
-
-			if (first_free_channel == -1) {
-				first_free_channel = i;
-			}
-			continue;
-		} else {
-			if ( chp->snd_id == snd_id ) {
-				instance_count++;
-
-				// looping or ambient soudns can't be preempted
-				if ((chp->looping == FALSE) && !chp->is_ambient)
-				{
-					if (chp->priority > least_important_instance_priority) {
-						least_important_instance_vol = chp->vol;
-						least_important_instance_priority = chp->priority;
-						least_important_instance_index = i;
-					} else if ((chp->priority == least_important_instance_priority)
-						 && (chp->vol < least_important_instance_vol)) {
-						least_important_instance_vol = chp->vol;
-						least_important_instance_priority = chp->priority;
-						least_important_instance_index = i;
-					}
-				}
-			} else if ( chp->is_voice_msg || (chp->looping == TRUE) || chp->is_ambient ) {
-				// a playing voice message, looping sound, or ambient sound is not allowed to be preempted.
-			} else if ( (chp->priority > least_important_priority) ) {
-				least_important_index = i;
-				least_important_vol = chp->vol;
-				least_important_priority = chp->priority;
-			} else if ( (chp->priority == least_important_priority) && (chp->vol < least_important_vol) ) {
-				least_important_index = i;
-				least_important_vol = chp->vol;
-				least_important_priority = chp->priority;
-			}
-		}
-	}
-
-	// If we've exceeded the limit, then stop the least important duplicate if it is lower or equal volume
-	// otherwise, don't play the sound
-	if ( ((unsigned int)instance_count >= enhanced_limit) && (least_important_instance_index >= 0) ) {
-		if (least_important_instance_vol <= new_volume) {
-			ds_close_channel_fast(least_important_instance_index);
-			first_free_channel =least_important_instance_index;
-		} else {
-			// don't exceed per-sound concurrency limits, even if there are spare channels
-			first_free_channel = -1;
-		}
-	} else if (first_free_channel == -1) {
-		// we haven't reached the limit, but we have run out of channels
-		// attempt to stop the least important sound to play our sound if priority demands it
-		if ( (least_important_index != -1)) {
-			// Check if the priority difference is great enough (must play or at least 2 levels away)
-			// and if the least important sound's volume playing is less than or equal to the volume of the requested sound.
-			// If so, then we are going to trash the least important sound.
-			if ( (enhanced_priority == SND_ENHANCED_PRIORITY_MUST_PLAY) || (Channels[least_important_index].priority - enhanced_priority >= 2)) {
-				if ( Channels[least_important_index].vol <= new_volume ) {
-					ds_close_channel_fast(least_important_index);
-					first_free_channel = least_important_index;
-				}
-			}
+		if ( (least_important < 0) || ds_channel_less_important(i, least_important) ) {
+			least_important = i;
 		}
 	}
 
-	if ( (first_free_channel >= 0) && (Channels[first_free_channel].source_id == 0) ) {
-		OpenAL_ErrorCheck( alGenSources(1, &Channels[first_free_channel].source_id), return -1 );
-	}
-	return first_free_channel;
+	return least_important;
 }
 
 /**
- * Generic function for getting a free channel
- *  If enhanced soudn is used, set priority to the computed priority.
- *  Returns -1 if no free channel could be found.
+ * Whether a new sound is important enough to stop the one playing on a channel
  */
+static bool ds_channel_outranks(int victim, int priority, int enhanced_priority)
+{
+	if (Cmdline_no_enhanced_sound) {
+		return (priority == DS_MUST_PLAY);
+	}
+
+	// must play or at least 2 levels away
+	return (enhanced_priority == SND_ENHANCED_PRIORITY_MUST_PLAY) || (Channels[victim].priority - enhanced_priority >= 2);
+}
 
 /**
- * Find a free channel to play a sound on.  If no free channels exists, free up one based on volume levels.
- * This is the new generic version of ds_get_free_channel().
+ * Find a free channel to play a sound on.  If no free channels exists, free up one based on priority and volume levels.
+ *
+ * In retail mode the instance limit comes from the retail priority and only ::DS_MUST_PLAY sounds may stop
+ * other sounds; in enhanced mode the limit and priority come from the sound's EnhancedSoundData.
  *
  * @param new_volume Volume for sound to play at
  * @param snd_id Which kind of sound to play
  * @param priority From retail :DS_MUST_PLAY, ::DS_LIMIT_ONE, ::DS_LIMIT_TWO, ::DS_LIMIT_THREE
  * @param enhanced_priority Output param that's updated with correct priority if enhanced sound is enabled
  *
- * @returns	Channel number to play sound on, or -1 if no channel could be found
+ * @returns	Channel number to play sound on, or -1 if no channel could be found.  The caller must call
+ *			ds_channel_start() on it once the sound is playing.
  *
  * NOTE: snd_id is needed since we limit the number of concurrent samples
  */
-int ds_get_free_channel(float volume, int snd_id, int priority, int & enhanced_priority, const EnhancedSoundData & enhanced_sound_data)
+int ds_get_free_channel(float new_volume, int snd_id, int priority, int & enhanced_priority, const EnhancedSoundData & enhanced_sound_data)
 {
-	int first_free_channel = -1;
-	unsigned int enhanced_limit = 0;
+	unsigned int limit;
+	int victim;
 
 	if (!Cmdline_no_enhanced_sound) {
 		enhanced_priority = enhanced_sound_data.priority;
-		enhanced_limit = enhanced_sound_data.limit;
+		limit = enhanced_sound_data.limit;
 
 		// exception: if retail priority is must play, we assume it's for a good reason
 		// and thus follow suit with enhanced sound
 		if (priority == DS_MUST_PLAY) {
 			enhanced_priority = SND_ENHANCED_PRIORITY_MUST_PLAY;
 		}
+	} else {
+		switch (priority) {
+			case DS_MUST_PLAY:
+				limit = 100;
+			break;
+
+			case DS_LIMIT_ONE:
+				limit = 1;
+			break;
+
+			case DS_LIMIT_TWO:
+				limit = 2;
+			break;
+
+			case DS_LIMIT_THREE:
+				limit = 3;
+			break;
+
+			default:
+				Int3();			// get Alan
+				limit = 100;
+			break;
+		}
+	}
+
+	// If we've reached the limit, then maybe stop the least important duplicate if it is lower or equal volume.
+	// The count may include instances that have finished, so check those first.
+	if (ds_channel_instances(snd_id) >= limit) {
+		ds_channel_reap_sound(snd_id);
+
+		if (ds_channel_instances(snd_id) >= limit) {
+			victim = ds_channel_least_important_instance(snd_id);
+
+			if (victim >= 0) {
+				if (Channels[victim].vol > new_volume) {
+					// NOTE: yes we are preventing the sound from playing even if
+					// there is an available channel because we are over the limit
+					// requested by the rest of the engine, which means if we do
+					// not honour its request to limit the count then the engine
+					// will trip itself up by using all channels without having
+					// the intention of actually doing so.  This means we get
+					// very loud sounds, missing more important sounds, etc.
+					return -1;
+				}
+
+				ds_close_channel_fast(victim);
+
+				return ds_channel_take();
+			}
+		}
+	}
+
+	// out of channels; see if any sounds have finished since we last looked, but only once per frame
+	// so that a burst of sounds against full channels doesn't query every source each time
+	if ( Channel_free.empty() && !Channel_reaped ) {
+		ds_channel_reap_all();
+		Channel_reaped = true;
+	}
 
-		first_free_channel = ds_get_free_channel_enhanced(volume, snd_id, enhanced_priority, enhanced_limit);
-	} else { // enhanced sound is off
-		first_free_channel = ds_get_free_channel_retail(volume, snd_id, priority);
+	if ( !Channel_free.empty() ) {
+		return ds_channel_take();
 	}
 
-	return first_free_channel;
+	// still out of channels, so stop the least important sound if this one outranks it and is at least as loud
+	if (Channel_heap.empty()) {
+		return -1;
+	}
+
+	victim = Channel_heap[0];
+
+	if ( !ds_channel_outranks(victim, priority, enhanced_priority) || (Channels[victim].vol > new_volume) ) {
+		return -1;
+	}
+
+	ds_close_channel_fast(victim);
+
+	return ds_channel_take();
 }
 
 /**
@@ -1741,12 +1934,10 @@ int ds_play_easy(int sid, float volume)
 		return -1;
 	}
 
-	int ch_idx = -1;
-	if (!Cmdline_no_enhanced_sound) {
-		ds_get_free_channel_enhanced(volume, -1, SND_ENHANCED_PRIORITY_MUST_PLAY, SND_ENHANCED_MAX_LIMIT);
-	} else {
-		ds_get_free_channel_retail(volume, -1, DS_MUST_PLAY);
-	}
+	int enhanced_priority = SND_ENHANCED_PRIORITY_INVALID;
+	EnhancedSoundData enhanced_sound_data(SND_ENHANCED_PRIORITY_MUST_PLAY, SND_ENHANCED_MAX_LIMIT);
+
+	int ch_idx = ds_get_free_channel(volume, -1, DS_MUST_PLAY, enhanced_priority, enhanced_sound_data);
 
 	if (ch_idx < 0) {
 		return -1;
@@ -1762,6 +1953,12 @@ int ds_play_easy(int sid, float volume)
 	}
 
 	Channels[ch_idx].sid = sid;
+	Channels[ch_idx].snd_id = -1;
+	Channels[ch_idx].vol = volume;
+	Channels[ch_idx].looping = FALSE;
+	Channels[ch_idx].priority = enhanced_priority;
+	Channels[ch_idx].is_voice_msg = false;
+	Channels[ch_idx].is_ambient = false;
 
 	OpenAL_ErrorPrint( alSourcef(source_id, AL_GAIN, volume) );
 
@@ -1775,6 +1972,8 @@ int ds_play_easy(int sid, float volume)
 
 	OpenAL_ErrorPrint( alSourcePlay(source_id) );
 
+	ds_channel_start(ch_idx);
+
 	return 0;
 }
 
@@ -1859,6 +2058,8 @@ int ds_play(int sid, int snd_id, int priority, const EnhancedSoundData * enhance
 		channel_next_sig = 1;
 	}
 
+	ds_channel_start(ch_idx);
+
 	return Channels[ch_idx].sig;
 }
 
@@ -2106,6 +2307,8 @@ int ds3d_play(int sid, int snd_id, vec3d *pos, vec3d *vel, float min, float max,
 		channel_next_sig = 1;
 	}
 
+	ds_channel_start(channel_id);
+
 	return Channels[channel_id].sig;
 }
 
@@ -2612,6 +2815,9 @@ void ds_do_frame()
 	int i;
 	channel *cp = NULL;
 
+	// let ds_get_free_channel() look for finished sounds again if it runs out of channels
+	Channel_reaped = false;
+
 	for (i = 0; i < MAX_CHANNELS; i++) {
 		cp = &Channels[i];
 		Assert( cp != NULL );
@@ -59,6 +59,16 @@ typedef struct sound_info {
 	ubyte *data;
 } sound_info;
 
+// PCM data ready to be handed to OpenAL, see ds_decode_buffer()
+typedef struct ds_decoded_sound {
+	ubyte *data;
+	ubyte *buffer;		// allocation backing data, NULL if data points into the sound_info
+	int size;
+	int bits;
+	int n_channels;
+	int bps;
+} ds_decoded_sound;
+
 extern int ds_initialized;
 
 int ds_init();
@@ -66,6 +76,9 @@ void ds_close();
 int ds_parse_sound(CFILE *fp, ubyte **dest, uint *dest_size, WAVEFORMATEX **header, bool ogg = false, OggVorbis_File *ovf = NULL);
 int ds_parse_sound_info(char *real_filename, sound_info *s_info);
 int ds_load_buffer(int *sid, int *final_size, void *header, sound_info *si, int flags);
+int ds_decode_buffer(ds_decoded_sound *dec, void *header, sound_info *si, int flags);
+int ds_upload_buffer(int *sid, int *final_size, ds_decoded_sound *dec, sound_info *si);
+void ds_free_decoded(ds_decoded_sound *dec);
 void ds_unload_buffer(int sid);
 int ds_play(int sid, int snd_id, int priority, const EnhancedSoundData * enhanced_sound_data, float volume, float pan, int looping, bool is_voice_msg = false);
 int ds_get_channel(int sig);
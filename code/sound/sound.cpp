@@ -16,7 +16,10 @@
 #include "gamesnd/gamesnd.h"
 #include "globalincs/alphacolors.h"
 #include "globalincs/pstypes.h"
+#include "globalincs/systemvars.h"
 #include "globalincs/vmallocator.h"
+#include "globalincs/workerpool.h"
+#include "io/timer.h"
 #include "osapi/osapi.h"
 #include "render/3d.h"
 #include "sound/acm.h"
@@ -44,10 +47,30 @@ typedef struct sound	{
 	sound_info		info;
 	int				uncompressed_size;		// size (in bytes) of sound (uncompressed)
 	int				duration;
+	int				ref_count;				// game sounds that have loaded this one and not unloaded it
+	SCP_string		cache_key;				// Sound_cache key this sound was loaded under
+	int				cache_flags;			// SND_CACHE_* keys of this sound in Sound_cache
 } sound;
 
 SCP_vector<sound> Sounds;
 
+// Where the data of a game sound lives, as found by snd_locate()
+typedef struct snd_source {
+	char	filename[MAX_FILENAME_LEN];		// with the extension that was found
+	char	fullpath[MAX_PATH];
+	int		ext;							// index into audio_ext_list[]
+	int		size;
+	int		offset;
+	bool	use_3d;
+} snd_source;
+
+// Game sounds that resolve to the same file, converted the same way, share one Sounds[] entry.
+// Sound_cache maps "<path>:<offset>:2d" (or ":3d") to the entry that holds it.
+#define SND_CACHE_2D		(1<<0)
+#define SND_CACHE_3D		(1<<1)
+
+static SCP_map<SCP_string, int> Sound_cache;
+
 int Sound_enabled = FALSE;				// global flag to turn sound on/off
 int Snd_sram;								// mem (in bytes) used up by storing sounds in system memory
 float Master_sound_volume = 1.0f;	// range is 0 -> 1, used for non-music sound fx
@@ -114,6 +137,7 @@ int ds_priority(int priority)
 void snd_clear()
 {
 	Sounds.clear();
+	Sound_cache.clear();
 
 	// reset how much storage sounds are taking up in memory
 	Snd_sram = 0;
@@ -264,88 +288,295 @@ void snd_spew_debug_info()
 	gr_printf_no_resize(sx, sy, "Total sounds : %d\n", game_sounds + interface_sounds + message_sounds);
 }
 
-// ---------------------------------------------------------------------------------------
-// snd_load() 
-//
-// Load a sound into memory and prepare it for playback.  The sound will reside in memory as
-// a single instance, and can be played multiple times simultaneously.  Through the magic of
-// DirectSound, only 1 copy of the sound is used.
-//
-// parameters:		gs							=> file of sound to load
-//						allow_hardware_load	=> whether to try to allocate in hardware
-//
-// returns:			success => index of sound in Sounds[] array
-//						failure => -1
-//
-//int snd_load( char *filename, int hardware, int use_ds3d, int *sig)
-int snd_load( game_snd *gs, int allow_hardware_load )
+// Fills in where the data of a game sound lives.  Returns false if no file was found.
+static bool snd_locate( game_snd *gs, snd_source *src )
 {
-	int				type;
-	sound_info		*si;
-	sound			*snd;
-	WAVEFORMATEX	*header = NULL;
-	int				rc, FileSize, FileOffset;
-	char			fullpath[MAX_PATH];
-	char			filename[MAX_FILENAME_LEN];
-	size_t			n;
+	int rc;
 
+	// strip the extension from the filename and try to open any extension
+	strcpy_s( src->filename, gs->filename );
+	char *p = strrchr(src->filename, '.');
+	if ( p ) *p = 0;
 
-	if ( !ds_initialized )
-		return -1;
+	rc = cf_find_file_location_ext(src->filename, NUM_AUDIO_EXT, audio_ext_list, CF_TYPE_ANY, sizeof(src->fullpath) - 1, src->fullpath, &src->size, &src->offset);
 
-	if ( !VALID_FNAME(gs->filename) )
-		return -1;
+	if (rc < 0)
+		return false;
+
+	// ok, we got it, so set the proper filename for logging purposes
+	strcat_s( src->filename, audio_ext_list[rc] );
+
+	src->ext = rc;
+	src->use_3d = (gs->flags & GAME_SND_USE_DS3D) != 0;
+
+	return true;
+}
+
+// The Sound_cache key of a source converted for 2D or 3D playback
+static SCP_string snd_cache_key( const snd_source *src, bool use_3d )
+{
+	char key[MAX_PATH + 32];
+
+	snprintf(key, sizeof(key), "%s:%d:%s", src->fullpath, src->offset, use_3d ? "3d" : "2d");
+
+	return SCP_string(key);
+}
+
+// Finds the Sounds[] slot for a game sound.  Returns the index of a compatible copy that is
+// already loaded (and sets *loaded), otherwise a free slot to load it into.
+static int snd_find_slot( const snd_source *src, bool *loaded )
+{
+	SCP_map<SCP_string, int>::iterator it;
+	size_t n;
+
+	*loaded = false;
+
+	it = Sound_cache.find( snd_cache_key(src, src->use_3d) );
+
+	// NOTE: this will allow a duplicate 3D entry if 2D stereo entry exists,
+	//       but will not load a duplicate 2D entry to get stereo if 3D
+	//       version already loaded
+	if ( (it == Sound_cache.end()) && !src->use_3d )
+		it = Sound_cache.find( snd_cache_key(src, true) );
+
+	if ( it != Sound_cache.end() ) {
+		*loaded = true;
+		return it->second;
+	}
 
 	for (n = 0; n < Sounds.size(); n++) {
-		if ( !(Sounds[n].flags & SND_F_USED) ) {
+		if ( !(Sounds[n].flags & SND_F_USED) )
 			break;
-		} else if ( !stricmp( Sounds[n].filename, gs->filename) ) {
-			// extra check: make sure the sound is actually loaded in a compatible way (2D vs. 3D)
-			//
-			// NOTE: this will allow a duplicate 3D entry if 2D stereo entry exists,
-			//       but will not load a duplicate 2D entry to get stereo if 3D
-			//       version already loaded
-			if ( (Sounds[n].info.n_channels == 1) || !(gs->flags & GAME_SND_USE_DS3D) ) {
-				return (int)n;
-			}
-		}
 	}
 
 	if ( n == Sounds.size() ) {
 		sound new_sound;
 		new_sound.sid = -1;
 		new_sound.flags = 0;
+		new_sound.ref_count = 0;
+		new_sound.cache_flags = 0;
 
 		Sounds.push_back( new_sound );
 	}
 
-	snd = &Sounds[n];
+	return (int)n;
+}
 
-	si = &snd->info;
+// Hands out another reference to an already loaded sound, unless gs already holds one
+static int snd_add_ref( game_snd *gs, int n )
+{
+	if ( (gs->id != n) || (gs->id_sig != Sounds[n].sig) )
+		Sounds[n].ref_count++;
 
-	si->data = NULL;
-	si->size = 0;
+	gs->id_sig = Sounds[n].sig;
+	gs->id = n;
 
-	// strip the extension from the filename and try to open any extension
-	strcpy_s( filename, gs->filename );
-	char *p = strrchr(filename, '.');
-	if ( p ) *p = 0;
+	return n;
+}
 
-	rc = cf_find_file_location_ext(filename, NUM_AUDIO_EXT, audio_ext_list, CF_TYPE_ANY, sizeof(fullpath) - 1, fullpath, &FileSize, &FileOffset);
+// Makes a freshly loaded sound findable by snd_find_slot().  A mono sound plays the same in 2D and
+// 3D, so it serves both unless the other kind is already loaded.
+static void snd_cache_insert( int n, const snd_source *src )
+{
+	sound *snd = &Sounds[n];
 
-	if (rc < 0)
-		return -1;
+	snd->cache_key = snd_cache_key(src, src->use_3d);
+	snd->cache_flags = src->use_3d ? SND_CACHE_3D : SND_CACHE_2D;
+
+	Sound_cache[snd->cache_key] = n;
+
+	if (snd->info.n_channels == 1) {
+		SCP_string other = snd_cache_key(src, !src->use_3d);
+
+		if ( Sound_cache.find(other) == Sound_cache.end() ) {
+			Sound_cache[other] = n;
+			snd->cache_flags |= SND_CACHE_2D | SND_CACHE_3D;
+		}
+	}
+}
+
+static void snd_cache_remove( int n )
+{
+	sound *snd = &Sounds[n];
+	SCP_string base;
+	int i;
+
+	if ( !snd->cache_flags )
+		return;
+
+	// the key minus its trailing "2d" or "3d"
+	base = snd->cache_key.substr(0, snd->cache_key.size() - 2);
+
+	for (i = 0; i < 2; i++) {
+		if ( !(snd->cache_flags & (1<<i)) )
+			continue;
+
+		SCP_map<SCP_string, int>::iterator it = Sound_cache.find( base + ((i == 0) ? "2d" : "3d") );
+
+		if ( (it != Sound_cache.end()) && (it->second == n) )
+			Sound_cache.erase(it);
+	}
+
+	snd->cache_key.clear();
+	snd->cache_flags = 0;
+}
+
+// ---------------------------------------------------------------------------------------
+// Decoded sound cache
+//
+// With -sound_cache the PCM that OGG files convert to is written to data/cache, named after the
+// checksum of the OGG and whether it was converted for 3D, and later loads of the same data read
+// it back instead of decoding again.  WAV files are PCM (or nearly) already, so they aren't cached.
+
+#define SND_CACHE_FILE_ID			0x31435053		// "SPC1"
+#define SND_CACHE_FILE_VERSION		1
+#define SND_CACHE_BYTE_ORDER		0x01020304
+
+typedef struct snd_cache_header {
+	int id;
+	int version;
+	int byte_order;
+	uint checksum;			// of the source file
+	int source_size;
+	int use_3d;
+	int quality;			// Ds_sound_quality and Ds_float_supported, which pick the bit depth
+	int float_supported;
+
+	int format;				// of the source file
+	int sample_rate;
+	int bits;
+	int n_channels;
+	int bps;
+	int size;
+} snd_cache_header;
+
+static void snd_cache_filename( char *out, size_t out_size, const snd_source *src, uint checksum )
+{
+	snprintf(out, out_size, "%08x%s.pcm", checksum, src->use_3d ? "_3d" : "");
+}
+
+// Reads the converted sound for src from its cache file.  On success dec owns the sound data.
+static bool snd_cache_read( const snd_source *src, uint checksum, sound_info *si, ds_decoded_sound *dec )
+{
+	char filename[MAX_FILENAME_LEN];
+	snd_cache_header hdr;
+	CFILE *fp;
+
+	snd_cache_filename(filename, sizeof(filename), src, checksum);
+
+	fp = cfopen(filename, "rb", CFILE_NORMAL, CF_TYPE_CACHE);
+
+	if (fp == NULL)
+		return false;
+
+	if ( (cfread(&hdr, sizeof(snd_cache_header), 1, fp) != 1) || (hdr.id != SND_CACHE_FILE_ID)
+		|| (hdr.version != SND_CACHE_FILE_VERSION) || (hdr.byte_order != SND_CACHE_BYTE_ORDER)
+		|| (hdr.checksum != checksum) || (hdr.source_size != src->size) || (hdr.use_3d != (int)src->use_3d)
+		|| (hdr.quality != Ds_sound_quality) || (hdr.float_supported != Ds_float_supported)
+		|| (hdr.size <= 0) || (hdr.bps <= 0) || (cfilelength(fp) != (int)sizeof(snd_cache_header) + hdr.size) ) {
+		nprintf(("Sound", "SOUND => Decoded sound cache '%s' is stale, rebuilding\n", filename));
+		cfclose(fp);
+		return false;
+	}
+
+	dec->buffer = (ubyte *)vm_malloc_q(hdr.size);
+
+	if (dec->buffer == NULL) {
+		cfclose(fp);
+		return false;
+	}
+
+	if ( cfread(dec->buffer, hdr.size, 1, fp) != 1 ) {
+		vm_free(dec->buffer);
+		dec->buffer = NULL;
+		cfclose(fp);
+		return false;
+	}
+
+	cfclose(fp);
+
+	dec->data = dec->buffer;
+	dec->size = hdr.size;
+	dec->bits = hdr.bits;
+	dec->n_channels = hdr.n_channels;
+	dec->bps = hdr.bps;
+
+	si->format = hdr.format;
+	si->sample_rate = hdr.sample_rate;
+	si->bits = hdr.bits;
+	si->n_channels = hdr.n_channels;
+	si->avg_bytes_per_sec = hdr.bps;
+	si->n_block_align = (hdr.bits / 8) * hdr.n_channels;
+	si->size = hdr.size;
+
+	return true;
+}
+
+static void snd_cache_write( const snd_source *src, uint checksum, const sound_info *si, const ds_decoded_sound *dec )
+{
+	char filename[MAX_FILENAME_LEN];
+	snd_cache_header hdr;
+	CFILE *fp;
+
+	snd_cache_filename(filename, sizeof(filename), src, checksum);
+
+	memset(&hdr, 0, sizeof(snd_cache_header));
+
+	hdr.id = SND_CACHE_FILE_ID;
+	hdr.version = SND_CACHE_FILE_VERSION;
+	hdr.byte_order = SND_CACHE_BYTE_ORDER;
+	hdr.checksum = checksum;
+	hdr.source_size = src->size;
+	hdr.use_3d = (int)src->use_3d;
+	hdr.quality = Ds_sound_quality;
+	hdr.float_supported = Ds_float_supported;
+	hdr.format = si->format;
+	hdr.sample_rate = si->sample_rate;
+	hdr.bits = dec->bits;
+	hdr.n_channels = dec->n_channels;
+	hdr.bps = dec->bps;
+	hdr.size = dec->size;
+
+	fp = cfopen(filename, "wb", CFILE_NORMAL, CF_TYPE_CACHE);
+
+	if (fp == NULL) {
+		nprintf(("Sound", "SOUND => Unable to write decoded sound cache '%s'\n", filename));
+		return;
+	}
+
+	cfwrite(&hdr, sizeof(snd_cache_header), 1, fp);
+	cfwrite(dec->data, dec->size, 1, fp);
+
+	cfclose(fp);
+}
+
+// Reads the file of a game sound and converts it to PCM.  This doesn't touch Sounds[] or OpenAL,
+// so snd_load_batch() runs it on the worker pool.  On success dec owns the sound data.
+static int snd_decode( const snd_source *src, sound_info *si, ds_decoded_sound *dec )
+{
+	int				type;
+	WAVEFORMATEX	*header = NULL;
+	int				rc;
+	uint			checksum = 0;
+	bool			use_cache;
+
+	si->data = NULL;
+	si->size = 0;
 
 	// open the file
-	CFILE *fp = cfopen_special(fullpath, "rb", FileSize, FileOffset);
+	CFILE *fp = cfopen_special(src->fullpath, "rb", src->size, src->offset);
 
-	// ok, we got it, so set the proper filename for logging purposes
-	strcat_s(filename, audio_ext_list[rc]);
+	nprintf(("Sound", "SOUND => Loading '%s'\n", src->filename));
 
-	nprintf(("Sound", "SOUND => Loading '%s'\n", filename));
+	use_cache = Cmdline_sound_cache && (src->ext == 0) && (fp != NULL) && cf_chksum_long(fp, &checksum);
+
+	if ( use_cache && snd_cache_read(src, checksum, si, dec) ) {
+		cfclose(fp);
+		return 0;
+	}
 
 	// ds_parse_sound() will do a NULL check on fp for us
-	if ( ds_parse_sound(fp, &si->data, &si->size, &header, (rc == 0), &si->ogg_info) == -1 ) {
+	if ( ds_parse_sound(fp, &si->data, &si->size, &header, (src->ext == 0), &si->ogg_info) == -1 ) {
 		nprintf(("Sound", "SOUND ==> Could not read sound file!\n"));
 
 		if (fp != NULL) {
@@ -365,76 +596,282 @@ int snd_load( game_snd *gs, int allow_hardware_load )
 
 	type = 0;
 
-	if (gs->flags & GAME_SND_USE_DS3D) {
+	if (src->use_3d) {
 		type |= DS_3D;
 	}
 
-	rc = ds_load_buffer(&snd->sid, &snd->uncompressed_size, header, si, type);
-
-	// NOTE: "si" values can change once loaded in the buffer
-	snd->duration = fl2i(1000.0f * ((si->size / (si->bits/8.0f)) / si->sample_rate / si->n_channels));
+	rc = ds_decode_buffer(dec, header, si, type);
 
 	// free the header if needed
 	if (header != NULL)
 		vm_free(header);
 
+	// PCM is used as read, so in that case the file data goes along with dec
+	if ( (rc == 0) && (dec->buffer == NULL) ) {
+		dec->buffer = si->data;
+		si->data = NULL;
+	}
+
 	// we don't need to keep si->data around anymore, this should be NULL for OGG files
 	if (si->data != NULL) {
 		vm_free(si->data);
 		si->data = NULL;
  	}
+
+	if ( (rc == 0) && use_cache ) {
+		snd_cache_write(src, checksum, si, dec);
+	}
  
 	// make sure the file handle is closed
 	if (fp != NULL)
 		cfclose(fp);
 
+	return rc;
+}
+
+// Puts a sound converted by snd_decode() into Sounds[n] and hands it to OpenAL
+static int snd_upload( game_snd *gs, int n, const snd_source *src, sound_info *si, ds_decoded_sound *dec )
+{
+	sound *snd = &Sounds[n];
+	int rc;
+
+	snd->info = *si;
+	si = &snd->info;
+
+	rc = ds_upload_buffer(&snd->sid, &snd->uncompressed_size, dec, si);
+
+	// NOTE: "si" values can change once loaded in the buffer
+	snd->duration = fl2i(1000.0f * ((si->size / (si->bits/8.0f)) / si->sample_rate / si->n_channels));
+
+	ds_free_decoded(dec);
+
 	if ( rc == -1 ) {
-		nprintf(("Sound", "SOUND ==> Failed to load '%s'\n", filename));
+		nprintf(("Sound", "SOUND ==> Failed to load '%s'\n", src->filename));
 		return -1;
 	}
 
 	strncpy( snd->filename, gs->filename, MAX_FILENAME_LEN );
 	snd->flags = SND_F_USED;
+	snd->ref_count = 0;
 
 	snd->sig = snd_next_sig++;
 	if (snd_next_sig < 0 ) snd_next_sig = 1;
-	gs->id_sig = snd->sig;
-	gs->id = (int)n;
 
-//	nprintf(("Sound", "SOUND ==> Finished loading '%s'\n", filename));
+	snd_cache_insert(n, src);
 
-	return (int)n;
+//	nprintf(("Sound", "SOUND ==> Finished loading '%s'\n", src->filename));
+
+	return snd_add_ref(gs, n);
 }
 
 // ---------------------------------------------------------------------------------------
-// snd_unload() 
+// snd_load() 
 //
-// Unload a sound from memory.  This will release the storage, and the sound must be re-loaded via
-// sound_load() before it can be played again.
+// Load a sound into memory and prepare it for playback.  The sound will reside in memory as
+// a single instance, and can be played multiple times simultaneously.  Through the magic of
+// DirectSound, only 1 copy of the sound is used.  Game sounds that resolve to the same file
+// share that copy, which stays loaded until each of them has called snd_unload().  Loading a
+// game sound that's already loaded doesn't take another reference, so it still only needs the one
+// snd_unload().
 //
-int snd_unload( int n )
+// parameters:		gs							=> file of sound to load
+//						allow_hardware_load	=> whether to try to allocate in hardware
+//
+// returns:			success => index of sound in Sounds[] array
+//						failure => -1
+//
+//int snd_load( char *filename, int hardware, int use_ds3d, int *sig)
+int snd_load( game_snd *gs, int allow_hardware_load )
 {
-	if (!ds_initialized)
-		return 0;
+	sound_info		si;
+	ds_decoded_sound	dec;
+	snd_source		src;
+	bool			loaded;
+	int				n;
 
-	if ( (n < 0) || ((size_t)n >= Sounds.size()) ) {
-		return 0;
+
+	if ( !ds_initialized )
+		return -1;
+
+	if ( !VALID_FNAME(gs->filename) )
+		return -1;
+
+	if ( !snd_locate(gs, &src) )
+		return -1;
+
+	n = snd_find_slot(&src, &loaded);
+
+	if ( loaded )
+		return snd_add_ref(gs, n);
+
+	if ( snd_decode(&src, &si, &dec) == -1 )
+		return -1;
+
+	return snd_upload(gs, n, &src, &si, &dec);
+}
+
+typedef struct snd_staged {
+	game_snd			*gs;
+	snd_source			src;
+	sound_info			info;
+	ds_decoded_sound	dec;
+	int					rc;
+} snd_staged;
+
+static void snd_load_batch_job(void *data, int index)
+{
+	snd_staged *st = &(*(SCP_vector<snd_staged> *)data)[index];
+
+	st->rc = snd_decode(&st->src, &st->info, &st->dec);
+}
+
+// ---------------------------------------------------------------------------------------
+// snd_load_batch() 
+//
+// Same as calling snd_load() on each of the given sounds and storing the result in its id, but
+// each file is only read once however many of the sounds use it, and with -mt_loading the files
+// are read and converted on the worker pool.  Only the OpenAL side of loading is left for the
+// main thread.
+//
+void snd_load_batch( game_snd **sounds, int count )
+{
+	SCP_vector<snd_staged> staged;
+	SCP_vector<game_snd *> shared;
+	SCP_map<SCP_string, int> staged_keys;
+	snd_source src;
+	uint start, decode_us;
+	bool loaded;
+	int i, n;
+
+	if ( !ds_initialized ) {
+		for (i = 0; i < count; i++)
+			sounds[i]->id = -1;
+
+		return;
 	}
 
+	for (i = 0; i < count; i++) {
+		game_snd *gs = sounds[i];
+
+		if ( !VALID_FNAME(gs->filename) || !snd_locate(gs, &src) ) {
+			gs->id = -1;
+			continue;
+		}
+
+		// nothing to read for the ones already in memory
+		n = snd_find_slot(&src, &loaded);
+
+		if ( loaded ) {
+			snd_add_ref(gs, n);
+			continue;
+		}
+
+		gs->id = -1;
+
+		// or for ones that an earlier entry of the batch will load
+		if ( !staged_keys.insert(std::make_pair(snd_cache_key(&src, src.use_3d), (int)staged.size())).second ) {
+			shared.push_back(gs);
+			continue;
+		}
+
+		snd_staged st;
+		st.gs = gs;
+		st.src = src;
+		st.rc = -1;
+
+		staged.push_back(st);
+	}
+
+	start = timer_get_high_res_microseconds();
+
+	if ( Cmdline_mt_loading ) {
+		worker_pool_run(snd_load_batch_job, &staged, (int)staged.size());
+	} else {
+		for (i = 0; i < (int)staged.size(); i++)
+			snd_load_batch_job(&staged, i);
+	}
+
+	decode_us = timer_get_high_res_microseconds() - start;
+	start = timer_get_high_res_microseconds();
+
+	for (i = 0; i < (int)staged.size(); i++) {
+		snd_staged *st = &staged[i];
+
+		if ( st->rc == -1 )
+			continue;
+
+		// an earlier entry of the batch may have loaded a mono copy that does for this one too
+		n = snd_find_slot(&st->src, &loaded);
+
+		if ( loaded ) {
+			ds_free_decoded(&st->dec);
+			snd_add_ref(st->gs, n);
+			continue;
+		}
+
+		snd_upload(st->gs, n, &st->src, &st->info, &st->dec);
+	}
+
+	for (i = 0; i < (int)shared.size(); i++) {
+		snd_locate(shared[i], &src);
+
+		n = snd_find_slot(&src, &loaded);
+
+		if ( loaded )
+			snd_add_ref(shared[i], n);
+	}
+
+	load_stats_add(LOAD_STATS_SOUNDS, (int)staged.size(), Cmdline_mt_loading ? decode_us : 0,
+		timer_get_high_res_microseconds() - start + (Cmdline_mt_loading ? 0 : decode_us));
+}
+
+// Releases the storage of Sounds[n], however many references to it are left
+static void snd_free_slot( int n )
+{
 	ds_unload_buffer(Sounds[n].sid);
 
 	if (Sounds[n].sid != -1) {
 		Snd_sram -= Sounds[n].uncompressed_size;
 	}
 
+	snd_cache_remove(n);
+
 	//If this sound is at the end of the array, we might as well get rid of it
 	if ( (size_t)n == Sounds.size()-1 ) {
 		Sounds.pop_back();
 	} else {
 		Sounds[n].sid = -1;
 		Sounds[n].flags &= ~SND_F_USED;
+		Sounds[n].ref_count = 0;
+	}
+}
+
+// ---------------------------------------------------------------------------------------
+// snd_unload() 
+//
+// Unload a sound from memory.  This will release the storage once every game sound that loaded
+// it has unloaded it, and the sound must be re-loaded via sound_load() before it can be played again.
+//
+int snd_unload( int n )
+{
+	if (!ds_initialized)
+		return 0;
+
+	if ( (n < 0) || ((size_t)n >= Sounds.size()) ) {
+		return 0;
+	}
+
+	if ( !(Sounds[n].flags & SND_F_USED) ) {
+		return 0;
 	}
 
+	// still in use by another game sound
+	if ( --Sounds[n].ref_count > 0 ) {
+		return 1;
+	}
+
+	snd_free_slot(n);
+
 	return 1;
 }
 
@@ -447,7 +884,7 @@ int snd_unload( int n )
 void snd_unload_all()
 {
 	while ( !Sounds.empty() ) {
-		snd_unload( Sounds.size()-1 );
+		snd_free_slot( Sounds.size()-1 );
 	}
 }
 
@@ -1422,6 +1859,15 @@ void snd_do_frame()
 	}
 
 	ds_do_frame();
+
+	if ( audiostream_is_inited() ) {
+		static uint last_decode_time = 0;
+		uint decode_time = audiostream_get_decode_time();
+
+		profile_counter_set("Stream underruns", audiostream_get_underruns());
+		profile_counter_set("Stream decode (us)", (int)(decode_time - last_decode_time));
+		last_decode_time = decode_time;
+	}
 }
 
 // return the number of samples per pre-defined measure in a piece of audio
@@ -2457,9 +2457,30 @@ int beam_collide_ship(obj_pair *pair)
 	mc_hull_exit.flags |= MC_CHECK_MODEL;
 
 	// check all three kinds of collisions
-	int shield_collision = (pm->shield.ntris > 0) ? model_collide(&mc_shield) : 0;
-	int hull_enter_collision = model_collide(&mc_hull_enter);
-	int hull_exit_collision = (beam_will_tool_target(b, ship_objp)) ? model_collide(&mc_hull_exit) : 0;
+	mc_info *queries[3];
+	int results[3];
+	int num_queries = 0;
+	int shield_query = -1, hull_enter_query, hull_exit_query = -1;
+
+	if (pm->shield.ntris > 0) {
+		shield_query = num_queries;
+		queries[num_queries++] = &mc_shield;
+	}
+
+	hull_enter_query = num_queries;
+	queries[num_queries++] = &mc_hull_enter;
+
+	if (beam_will_tool_target(b, ship_objp)) {
+		hull_exit_query = num_queries;
+		queries[num_queries++] = &mc_hull_exit;
+	}
+
+	// the entry and exit checks run down the same line, so they get traced together
+	model_collide_batch(queries, results, num_queries);
+
+	int shield_collision = (shield_query >= 0) ? results[shield_query] : 0;
+	int hull_enter_collision = results[hull_enter_query];
+	int hull_exit_collision = (hull_exit_query >= 0) ? results[hull_exit_query] : 0;
 
     // If we have a range less than the "far" range, check if the ray actually hit within the range
     if (b->range < BEAM_FAR_LENGTH
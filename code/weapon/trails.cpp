@@ -469,10 +469,11 @@ void trail_render( trail * trailp )
 	if ( (nv % 2) != 1 )
 		Warning( LOCATION, "even number of verts in trail render\n" );
 
-	profile_begin("Trail Draw");
+	static int trail_draw_zone = profile_register_zone("Trail Draw");
+	profile_begin(trail_draw_zone);
 	gr_set_bitmap( ti->texture.bitmap_id, GR_ALPHABLEND_FILTER, GR_BITBLT_MODE_NORMAL, 1.0f );
 	gr_render(nv, Trail_v_list, TMAP_FLAG_TEXTURED | TMAP_FLAG_ALPHA | TMAP_FLAG_GOURAUD | TMAP_FLAG_RGB | TMAP_HTL_3D_UNLIT | TMAP_FLAG_TRISTRIP);
-	profile_end("Trail Draw");
+	profile_end(trail_draw_zone);
 }
 
 
@@ -24,6 +24,7 @@
 #include "cmdline/cmdline.h"
 #include "debugconsole/console.h"
 #include "globalincs/pstypes.h"
+#include "globalincs/workerpool.h"
 #include "parse/lua.h"
 
 bool env_enabled = false;
@@ -442,6 +443,7 @@ bool QueryPerformanceCounter(LARGE_INTEGER *pcount)
 
 #ifndef NDEBUG
 int TotalRam = 0;
+static worker_mutex *TotalRam_lock = NULL;		// worker jobs allocate too
 #endif
 
 int Watch_malloc = 0;
@@ -602,6 +604,9 @@ int vm_init(int min_heap_size)
 {
 #ifndef NDEBUG
 	TotalRam = 0;
+
+	if (TotalRam_lock == NULL)
+		TotalRam_lock = worker_mutex_create();
 #endif
 
 	return 1;
@@ -630,7 +635,9 @@ void *_vm_malloc( int size, int quiet )
 		fprintf( stdout, "Malloc %zu bytes [%s(%d)]\n", used_size, clean_filename(filename), line );
 	}
 
+	worker_mutex_lock(TotalRam_lock);
 	TotalRam += used_size;
+	worker_mutex_unlock(TotalRam_lock);
 #endif
 
 	return ptr;
@@ -667,7 +674,9 @@ void *_vm_realloc( void *ptr, int size, int quiet )
 		fprintf( stdout, "Realloc %zu bytes [%s(%d)]\n", used_size, clean_filename(filename), line );
 	}
 
+	worker_mutex_lock(TotalRam_lock);
 	TotalRam += (used_size - old_size);
+	worker_mutex_unlock(TotalRam_lock);
 #endif
 
 	return ret_ptr;
@@ -728,7 +737,9 @@ void _vm_free( void *ptr )
 	}
 
 #ifndef NDEBUG
+	worker_mutex_lock(TotalRam_lock);
 	TotalRam -= MALLOC_USABLE(ptr);
+	worker_mutex_unlock(TotalRam_lock);
 #endif // !NDEBUG
 
 	free(ptr);